@@ -22,6 +22,16 @@ Window {
             font.pixelSize: 85
             color: "white"
         }
+        Text {
+            id: energy
+            objectName: "myenergy"
+            text: myliveData.batteryLevel + " %  " + myliveData.packVoltage + " mV  " + myliveData.flashEnergy + " Ws"
+            anchors.top: name.bottom
+            anchors.horizontalCenter: parent.horizontalCenter
+            font.family: "Calibri Light"
+            font.pixelSize: 24
+            color: "white"
+        }
         MouseArea{
             anchors.fill: parent
             onPressed: {
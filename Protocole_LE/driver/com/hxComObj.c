@@ -58,9 +58,9 @@
 #include <string.h>
 
 #include "config/projConfig.h"
-#include "user/debug/debugTask.h"
 #include "lib/timer/timerDeamon.h"
 #include "driver/com/hxComObj.h"
+#include "driver/com/uartHal.h"
 #include "driver/com/uartRxObj.h"
 #include "driver/com/uartTxObj.h"
 
@@ -71,14 +71,14 @@
 #define FLAG_LB_RX_EARLY        0x01
 
 /**/
-#define TX_EN(self)     HWREG(self->hw.txEnBaseNPin + GPIO_O_DATA) = \
-                            (self->config & HX_CONF_TX_EN_NOT) ? 0 : 0xff
-#define TX_DIS(self)    HWREG(self->hw.txEnBaseNPin + GPIO_O_DATA) = \
-                            (self->config & HX_CONF_TX_EN_NOT) ? 0xff : 0
-#define RX_EN(self)     HWREG(self->hw.rxEnBaseNPin + GPIO_O_DATA) = \
-                            (self->config & HX_CONF_RX_EN_NOT) ? 0 : 0xff
-#define RX_DIS(self)    HWREG(self->hw.rxEnBaseNPin + GPIO_O_DATA) = \
-                            (self->config & HX_CONF_RX_EN_NOT) ? 0xff : 0
+#define TX_EN(self)     uartHal_set_pin(self->hw.txEnBaseNPin, \
+                            !(self->config & HX_CONF_TX_EN_NOT))
+#define TX_DIS(self)    uartHal_set_pin(self->hw.txEnBaseNPin, \
+                            (self->config & HX_CONF_TX_EN_NOT))
+#define RX_EN(self)     uartHal_set_pin(self->hw.rxEnBaseNPin, \
+                            !(self->config & HX_CONF_RX_EN_NOT))
+#define RX_DIS(self)    uartHal_set_pin(self->hw.rxEnBaseNPin, \
+                            (self->config & HX_CONF_RX_EN_NOT))
 
 /******************************************************************************
  * FILE SCOPE VARIABLES
@@ -140,9 +140,10 @@ void hxcom_set_callback(struct hxComObj *self, hxComCb_t cb, void *cbHandle)
  * 				prio		Active object priority.
  * 				config      Configuration like loop back. See CONF_X
  * 				            defines in header file.
- * 				uartBase	The base memory address of the UART module.
+ * 				port		The UART port, see uartHal.h.
  * 				txEnBaseNPin (GPIO_BASE | (GPIO_PIN<<2)) to switch
- * 				            transmitter on/off. Needed for RS485.
+ * 				            transmitter on/off. Needed for RS485. On the
+ * 				            host, a pin of uartHal.h, e.g. the RTS line.
  * 				rxEnBaseNPin (GPIO_BASE | (GPIO_PIN<<2)) to switch
  *                          receiver on/off. Optional.
  * 				timeout		The time [ms] waited for an answer before a
@@ -160,7 +161,7 @@ void hxcom_set_callback(struct hxComObj *self, hxComCb_t cb, void *cbHandle)
  * 				-1			event queue memory not assigned/allocated
  */
 int32_t hxcom_init(struct hxComObj *self, uint8_t prio, uint8_t config,
-                   uint32_t uartBase, uint32_t txEnBaseNPin, uint32_t rxEnBaseNPin,
+                   uint32_t port, uint32_t txEnBaseNPin, uint32_t rxEnBaseNPin,
                    uint16_t timeout, uint16_t txDelay,
                    hxComCb_t cb, void *cbHandle,
                    uint8_t eQueueLenHx, uint8_t eQueueLenRx, uint8_t eQueueLenTx)
@@ -178,9 +179,9 @@ int32_t hxcom_init(struct hxComObj *self, uint8_t prio, uint8_t config,
 	self->timing.timeout = timeout;
 	self->timing.txDelay = txDelay;
 	timerD_create_timer(1, 0, &self->timerId, NULL, NULL, NULL);
-	err = rx_init(&self->rxObj, prio, uartBase,
+	err = rx_init(&self->rxObj, prio, port,
 					(rxCb_t) &ao_post, self, eQueueLenRx);
-	err = tx_init(&self->txObj, prio, uartBase,
+	err = tx_init(&self->txObj, prio, port,
 					(txCb_t) &ao_post, self, eQueueLenTx);
 
 	/* Initial state and register to scheduler (does initial transition) */
@@ -0,0 +1,271 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: uartHal.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:	TM4C implementation of the UART HAL (uartHal.h). The
+ * 				functions access the UART registers directly, a port is the
+ * 				base address of the UART module.
+ *
+ * 				Interrupt handler
+ * 				-----------------
+ * 				The UART interrupt vector calls uartHal_isr() with its base
+ * 				address, e.g.:
+ *
+ * 					void uart1_isr(void)
+ * 					{
+ * 						uartHal_isr(UART1_BASE);
+ * 					}
+ *
+ * 				The handler clears the pending interrupts, masks RX and RX
+ * 				timeout and posts the events to the objects attached with
+ * 				uartHal_attach_rx()/uartHal_attach_tx() (done by rx_init()
+ * 				and tx_init()).
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config/projConfig.h"
+#include "driver/com/uartHal.h"
+#include "driver/com/uartRxObj.h"
+#include "driver/com/uartTxObj.h"
+#include "lib/stm/event.h"
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"  /* HWREG macro */
+#include "inc/hw_uart.h"
+#include "inc/hw_gpio.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+/* UART0 to UART7, 4k apart */
+#define UART_HAL_PORTS			8
+#define PORT_IDX(port)			(((port) - UART0_BASE) >> 12)
+
+/* objects attached to a port */
+struct uartHalPort{
+	struct ao *rx;
+	struct ao *tx;
+};
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static struct uartHalPort ports[UART_HAL_PORTS];
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Takes over the receiver or transmitter for interrupt driven operation,
+ * DMA is disabled.
+ *
+ * Argument:	port	UART base address.
+ * 				dir		UART_HAL_RX and/or UART_HAL_TX.
+ */
+void uartHal_claim(uint32_t port, uint32_t dir)
+{
+	if(dir & UART_HAL_RX)
+		HWREG(port + UART_O_DMACTL) &= ~(UART_DMACTL_DMAERR
+				| UART_DMACTL_RXDMAE);
+	if(dir & UART_HAL_TX)
+		HWREG(port + UART_O_DMACTL) &= ~UART_DMACTL_TXDMAE;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Attaches the object that gets the RX events of uartHal_isr().
+ *
+ * Argument:	port	UART base address.
+ * 				ao		RX object.
+ */
+void uartHal_attach_rx(uint32_t port, struct ao *ao)
+{
+	ports[PORT_IDX(port)].rx = ao;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Attaches the object that gets the TX events of uartHal_isr().
+ *
+ * Argument:	port	UART base address.
+ * 				ao		TX object.
+ */
+void uartHal_attach_tx(uint32_t port, struct ao *ao)
+{
+	ports[PORT_IDX(port)].tx = ao;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Argument:	port	UART base address.
+ * Return:		true if the RX FIFO is empty
+ */
+bool uartHal_rx_empty(uint32_t port)
+{
+	return HWREGBITW(port + UART_O_FR, 4);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Reads a character from the RX FIFO. The FIFO must not be empty.
+ *
+ * Argument:	port	UART base address.
+ * Return:		the character
+ */
+uint8_t uartHal_read(uint32_t port)
+{
+	return HWREG(port + UART_O_DR);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sets the RX FIFO level that triggers the RX interrupt.
+ *
+ * Argument:	port	UART base address.
+ * 				level	2, 4, 8, 12 or 14 characters.
+ */
+void uartHal_set_rx_level(uint32_t port, uint32_t level)
+{
+	uint32_t ifls;
+
+	switch(level){
+	case 2:
+		ifls = UART_IFLS_RX1_8;
+		break;
+	case 4:
+		ifls = UART_IFLS_RX2_8;
+		break;
+	case 8:
+		ifls = UART_IFLS_RX4_8;
+		break;
+	case 12:
+		ifls = UART_IFLS_RX6_8;
+		break;
+	default:
+		ifls = UART_IFLS_RX7_8;
+		break;
+	}
+	HWREG(port + UART_O_IFLS) &= ~UART_IFLS_RX_M;
+	HWREG(port + UART_O_IFLS) |= ifls;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Writes a character to the TX FIFO. The FIFO must not be full.
+ *
+ * Argument:	port	UART base address.
+ * 				chr		The character.
+ */
+void uartHal_write(uint32_t port, uint8_t chr)
+{
+	HWREG(port + UART_O_DR) = chr;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Argument:	port	UART base address.
+ * Return:		true while characters are transmitted
+ */
+bool uartHal_tx_busy(uint32_t port)
+{
+	return HWREGBITW(port + UART_O_FR, 3);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Argument:	port	UART base address.
+ * 				mask	UART_HAL_INT_X interrupts to unmask.
+ */
+void uartHal_int_enable(uint32_t port, uint32_t mask)
+{
+	HWREG(port + UART_O_IM) |= mask;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Argument:	port	UART base address.
+ * 				mask	UART_HAL_INT_X interrupts to mask.
+ */
+void uartHal_int_disable(uint32_t port, uint32_t mask)
+{
+	HWREG(port + UART_O_IM) &= ~mask;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Argument:	port	UART base address.
+ * 				mask	UART_HAL_INT_X interrupts to clear.
+ */
+void uartHal_int_clear(uint32_t port, uint32_t mask)
+{
+	HWREG(port + UART_O_ICR) = mask;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * The UART interrupt handler, see the description on top.
+ *
+ * Argument:	port	UART base address.
+ */
+void uartHal_isr(uint32_t port)
+{
+	struct uartHalPort *p = &ports[PORT_IDX(port)];
+	uint32_t mis;
+	struct event e;
+
+	mis = HWREG(port + UART_O_MIS);
+	HWREG(port + UART_O_ICR) = mis;
+	HWREG(port + UART_O_IM) &= ~(mis & (UART_HAL_INT_RX | UART_HAL_INT_RT));
+
+	if(p->rx != NULL){
+		if(mis & UART_HAL_INT_ERR){
+			e.sig = RX_ERROR_SIG;
+			e.data = (mis & UART_HAL_INT_ERR) >> UART_HAL_ERR_S;
+			ao_post(p->rx, &e);
+		}
+		if(mis & UART_HAL_INT_RX){
+			e.sig = RX_SIG;
+			ao_post(p->rx, &e);
+		}
+		if(mis & UART_HAL_INT_RT){
+			e.sig = RX_TIMEOUT_SIG;
+			ao_post(p->rx, &e);
+		}
+	}
+	if(p->tx != NULL && (mis & UART_HAL_INT_TX)){
+		e.sig = TX_SIG;
+		ao_post(p->tx, &e);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Drives a direction pin of the transceiver.
+ *
+ * Argument:	baseNPin	(GPIO_BASE | (GPIO_PIN<<2)), the address of the
+ * 							pin in the GPIO data register.
+ * 				level		true: high, false: low.
+ */
+void uartHal_set_pin(uint32_t baseNPin, bool level)
+{
+	HWREG(baseNPin + GPIO_O_DATA) = level ? 0xff : 0;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
@@ -0,0 +1,110 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: uartHal.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Hardware abstraction of the UART as used by the uartRxObj, the
+ * 		uartTxObj and the hxComObj: a 16 character RX and TX FIFO, the RX
+ * 		FIFO trigger level, the interrupt mask and the direction pins of a
+ * 		transceiver.
+ *
+ * 		There is one implementation per platform, the one to link is
+ * 		chosen by the build:
+ * 		 -	uartHal.c		TM4C UART registers, a port is the base
+ * 		 					address of the UART module (e.g. UART1_BASE).
+ * 		 -	uartHalHost.c	Linux tty (host build, see host.pri), a port is
+ * 		 					a number opened with uartHalHost_open().
+ * 		 -	sim/uartemu/uartHalEmu.c	Emulated UART in virtual time, to
+ * 		 					tune the FIFO parameters of the objects.
+ *
+ * 		Interrupts are delivered by uartHal_isr() on the target, called from
+ * 		the UART interrupt vector, and by a thread per port on the host. In
+ * 		both cases, the RX and TX objects attached to the port get the
+ * 		events RX_SIG, RX_TIMEOUT_SIG, RX_ERROR_SIG and TX_SIG. The RX and
+ * 		RX timeout interrupts are masked when they are delivered, the RX
+ * 		object unmasks them once it has read the FIFO.
+ *
+ *****************************************************************************/
+
+#ifndef DRIVER_COM_UARTHAL_H_
+#define DRIVER_COM_UARTHAL_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lib/stm/aok.h"
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+/* FIFO depth in characters, RX and TX. */
+#define UART_HAL_FIFO_LEN		16
+
+/* Interrupt sources, same bits as the IM/ICR registers of the TM4C UART. */
+#define UART_HAL_INT_RX			0x0010  /* RX FIFO level reached */
+#define UART_HAL_INT_TX			0x0020  /* TX FIFO empty, end of transmission */
+#define UART_HAL_INT_RT			0x0040  /* RX timeout */
+#define UART_HAL_INT_FE			0x0080  /* framing error */
+#define UART_HAL_INT_PE			0x0100  /* parity error */
+#define UART_HAL_INT_BE			0x0200  /* break error */
+#define UART_HAL_INT_OE			0x0400  /* overrun error */
+#define UART_HAL_INT_ERR		(UART_HAL_INT_FE | UART_HAL_INT_PE \
+									| UART_HAL_INT_BE | UART_HAL_INT_OE)
+
+/* Event data of RX_ERROR_SIG: the error interrupts shifted to the
+ * RX_INTERR_X values of uartRxObj.h. */
+#define UART_HAL_ERR_S			3
+
+/* Directions for uartHal_claim(). */
+#define UART_HAL_RX				0x01
+#define UART_HAL_TX				0x02
+
+#ifdef AOK_HOST
+/* Number of ports of the host implementation. */
+#define UART_HAL_HOST_PORTS		4
+
+/* Direction pins on the host: the modem control lines of a port. */
+#define UART_HAL_HOST_PIN_RTS(port)		(0x100u | (port))
+#define UART_HAL_HOST_PIN_DTR(port)		(0x200u | (port))
+#endif
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+/* setup */
+extern void uartHal_claim(uint32_t, uint32_t);
+extern void uartHal_attach_rx(uint32_t, struct ao *);
+extern void uartHal_attach_tx(uint32_t, struct ao *);
+/* FIFO */
+extern bool uartHal_rx_empty(uint32_t);
+extern uint8_t uartHal_read(uint32_t);
+extern void uartHal_set_rx_level(uint32_t, uint32_t);
+extern void uartHal_write(uint32_t, uint8_t);
+extern bool uartHal_tx_busy(uint32_t);
+/* interrupts */
+extern void uartHal_int_enable(uint32_t, uint32_t);
+extern void uartHal_int_disable(uint32_t, uint32_t);
+extern void uartHal_int_clear(uint32_t, uint32_t);
+extern void uartHal_isr(uint32_t);
+/* transceiver */
+extern void uartHal_set_pin(uint32_t, bool);
+
+#ifdef AOK_HOST
+extern int32_t uartHalHost_open(uint32_t, const char *, uint32_t);
+extern void uartHalHost_close(uint32_t);
+#endif
+
+
+#endif /* DRIVER_COM_UARTHAL_H_ */
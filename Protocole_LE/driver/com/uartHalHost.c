@@ -0,0 +1,692 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: uartHalHost.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:	Linux implementation of the UART HAL (uartHal.h), built
+ * 				instead of uartHal.c on the host (see host.pri). A port is a
+ * 				tty opened with uartHalHost_open(), e.g. /dev/ttymxc1.
+ *
+ * 				The 16 character FIFOs and the interrupt logic of the TM4C
+ * 				UART are emulated on top of the tty, so that the RX, TX and
+ * 				HX objects run unchanged:
+ * 				 -	The RX FIFO is filled from the tty, never beyond 16
+ * 				 	characters, the rest waits in the tty. Hence there is no
+ * 				 	overrun, the interrupt is thrown when the FIFO reaches
+ * 				 	the trigger level, either by received characters or by a
+ * 				 	new trigger level, and cleared when it is read below.
+ * 				 -	The RX timeout is thrown once the FIFO is not empty and
+ * 				 	no character came for 32 bit periods. While characters
+ * 				 	wait in the tty, the FIFO must also not have been read
+ * 				 	for RT_STALL_TIME, as the line is only held up by the
+ * 				 	reader (e.g. the RX object in rx_error). The characters
+ * 				 	waiting are then dropped with an overrun error, like the
+ * 				 	target drops what comes while its FIFO is full.
+ * 				 -	Characters written to the TX FIFO are passed to the tty
+ * 				 	right away. The TX interrupt (EOT) is thrown when the tty
+ * 				 	has sent everything, from the LSR of the UART if the
+ * 				 	driver supports TIOCSERGETLSR, from the output queue
+ * 				 	otherwise (e.g. a pty). It is not thrown earlier than one
+ * 				 	character time after the last write, like the shift
+ * 				 	register of the target, so a chunk written to the FIFO
+ * 				 	is not split.
+ * 				 -	Framing, parity, break and overrun errors are taken from
+ * 				 	the counters of the tty driver (TIOCGICOUNT).
+ *
+ * 				Each port is served by a thread of its own, started by
+ * 				uartHalHost_open(). It takes the role of the interrupt
+ * 				handler and calls uartHal_isr(), which posts the events to
+ * 				the attached objects like on the target. Unmasking a pending
+ * 				interrupt calls uartHal_isr() right away in the calling
+ * 				thread. The functions are thread safe.
+ *
+ * 				Direction pins are the modem control lines of a port, see
+ * 				UART_HAL_HOST_PIN_RTS() and UART_HAL_HOST_PIN_DTR().
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#define _GNU_SOURCE  /* ppoll */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <termios.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/serial.h>
+
+#include "config/projConfig.h"
+#include "driver/com/uartHal.h"
+#include "driver/com/uartRxObj.h"
+#include "driver/com/uartTxObj.h"
+#include "lib/stm/event.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define PIN_PORT_M				0x00ff
+#define PIN_RTS					0x0100
+#define PIN_DTR					0x0200
+
+/* RX timeout after 32 bit periods, a character is 10 bits */
+#define RT_CHR_TIME_X10			32
+/* RX timeout of a full FIFO with characters waiting in the tty [ns] */
+#define RT_STALL_TIME			5000000
+
+struct uartHalPort{
+	int fd;  /* tty, -1 if the port is closed */
+	int kickFd;  /* eventfd waking up the thread */
+	pthread_t thread;
+	pthread_mutex_t lock;
+	bool stop;
+	struct ao *rx;
+	struct ao *tx;
+	/* interrupt logic */
+	uint32_t im;  /* interrupt mask */
+	uint32_t ris;  /* raw interrupt status */
+	/* RX FIFO */
+	uint8_t rxFifo[UART_HAL_FIFO_LEN];
+	uint8_t rxHead;
+	uint8_t rxCount;
+	uint8_t rxLevel;  /* trigger level */
+	bool rxAbove;  /* rxCount >= rxLevel */
+	bool rtArmed;  /* characters came since the last RX timeout */
+	uint64_t lastRx;  /* time of the last character [ns] */
+	uint64_t lastRead;  /* time the FIFO was last read [ns] */
+	/* TX FIFO */
+	uint8_t txFifo[UART_HAL_FIFO_LEN];
+	uint8_t txCount;
+	bool txBusy;  /* characters written since the last EOT */
+	bool txLsr;  /* driver supports TIOCSERGETLSR */
+	uint64_t txEarliest;  /* EOT not before [ns] */
+	/**/
+	uint64_t chrTime;  /* time of a 10 bit character [ns] */
+	struct serial_icounter_struct icount;
+};
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static struct uartHalPort ports[UART_HAL_HOST_PORTS] = {
+	[0 ... UART_HAL_HOST_PORTS-1] = {
+		.fd = -1,
+		.kickFd = -1,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+	},
+};
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static uint64_t clock_ns(void);
+static bool to_speed(uint32_t, speed_t *);
+static void kick(struct uartHalPort *);
+static void rx_update(struct uartHalPort *);
+static void rx_fill(struct uartHalPort *, uint64_t);
+static void rx_errors(struct uartHalPort *);
+static void tx_flush(struct uartHalPort *, uint64_t);
+static void *port_thread(void *);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Return:		CLOCK_MONOTONIC in nanoseconds
+ */
+static uint64_t clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static bool to_speed(uint32_t baud, speed_t *speed)
+{
+	switch(baud){
+	case 9600:		*speed = B9600;		return true;
+	case 19200:		*speed = B19200;	return true;
+	case 38400:		*speed = B38400;	return true;
+	case 57600:		*speed = B57600;	return true;
+	case 115200:	*speed = B115200;	return true;
+	case 230400:	*speed = B230400;	return true;
+	case 460800:	*speed = B460800;	return true;
+	case 921600:	*speed = B921600;	return true;
+	default:		return false;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/* Wakes the thread of the port up. */
+static void kick(struct uartHalPort *p)
+{
+	const uint64_t one = 1;
+
+	if(write(p->kickFd, &one, sizeof(one)) < 0){
+		/* the counter can't overflow, the thread is woken up already */
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Updates the RX and RX timeout interrupt on a change of the FIFO level or
+ * of the trigger level. Port must be locked.
+ */
+static void rx_update(struct uartHalPort *p)
+{
+	bool above = p->rxCount >= p->rxLevel;
+
+	if(above && !p->rxAbove)
+		p->ris |= UART_HAL_INT_RX;
+	else if(!above)
+		p->ris &= ~UART_HAL_INT_RX;
+	p->rxAbove = above;
+	if(p->rxCount == 0)
+		p->ris &= ~UART_HAL_INT_RT;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Moves received characters from the tty to the RX FIFO, as many as fit.
+ * Port must be locked.
+ *
+ * Argument:	now		current time [ns]
+ */
+static void rx_fill(struct uartHalPort *p, uint64_t now)
+{
+	uint8_t buf[UART_HAL_FIFO_LEN];
+	uint32_t i;
+	ssize_t n;
+
+	while(p->rxCount < UART_HAL_FIFO_LEN){
+		n = read(p->fd, buf, UART_HAL_FIFO_LEN - p->rxCount);
+		if(n <= 0)
+			break;
+		for(i=0; i<(uint32_t) n; i++){
+			p->rxFifo[(p->rxHead + p->rxCount) % UART_HAL_FIFO_LEN] = buf[i];
+			p->rxCount++;
+		}
+		p->lastRx = now;
+		p->rtArmed = true;
+		rx_errors(p);
+	}
+	rx_update(p);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sets the error interrupts for the errors the tty driver counted since
+ * the last call. Port must be locked.
+ */
+static void rx_errors(struct uartHalPort *p)
+{
+	struct serial_icounter_struct ic;
+
+	if(ioctl(p->fd, TIOCGICOUNT, &ic) != 0)
+		return;
+	if(ic.frame != p->icount.frame)
+		p->ris |= UART_HAL_INT_FE;
+	if(ic.parity != p->icount.parity)
+		p->ris |= UART_HAL_INT_PE;
+	if(ic.brk != p->icount.brk)
+		p->ris |= UART_HAL_INT_BE;
+	if(ic.overrun != p->icount.overrun
+			|| ic.buf_overrun != p->icount.buf_overrun)
+		p->ris |= UART_HAL_INT_OE;
+	p->icount = ic;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Passes the TX FIFO to the tty and throws the TX interrupt once the tty
+ * has sent everything. Port must be locked.
+ *
+ * Argument:	now		current time [ns]
+ */
+static void tx_flush(struct uartHalPort *p, uint64_t now)
+{
+	unsigned int lsr;
+	int outq;
+	ssize_t n;
+
+	if(p->txCount){
+		n = write(p->fd, p->txFifo, p->txCount);
+		if(n > 0){
+			p->txCount -= n;
+			memmove(p->txFifo, p->txFifo + n, p->txCount);
+		}
+	}
+	if(!p->txBusy || p->txCount || now < p->txEarliest)
+		return;
+
+	if(p->txLsr){
+		if(ioctl(p->fd, TIOCSERGETLSR, &lsr) != 0 || !(lsr & TIOCSER_TEMT))
+			return;
+	}else if(ioctl(p->fd, TIOCOUTQ, &outq) == 0 && outq > 0){
+		return;
+	}
+	p->txBusy = false;
+	p->ris |= UART_HAL_INT_TX;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * The thread of a port, taking the role of the interrupt handler. It sleeps
+ * until the tty can be read or written, it is kicked, or until the next
+ * RX timeout or TX check is due.
+ */
+static void *port_thread(void *arg)
+{
+	struct uartHalPort *p = arg;
+	uint32_t port = p - ports;
+	struct pollfd fds[2];
+	struct timespec ts;
+	uint64_t now, due, count;
+	bool pending, stalled;
+	int waiting;
+
+	fds[1].fd = p->kickFd;
+	fds[1].events = POLLIN;
+	for(;;){
+		pthread_mutex_lock(&p->lock);
+		if(p->stop){
+			pthread_mutex_unlock(&p->lock);
+			break;
+		}
+		now = clock_ns();
+		rx_fill(p, now);
+		tx_flush(p, now);
+
+		/* RX timeout */
+		due = UINT64_MAX;
+		if(p->rtArmed && p->rxCount){
+			due = p->lastRx + RT_CHR_TIME_X10 * p->chrTime / 10;
+			stalled = p->rxCount == UART_HAL_FIFO_LEN
+					&& ioctl(p->fd, FIONREAD, &waiting) == 0 && waiting > 0;
+			if(stalled && due < p->lastRead + RT_STALL_TIME)
+				due = p->lastRead + RT_STALL_TIME;
+			if(now >= due){
+				if(stalled){
+					tcflush(p->fd, TCIFLUSH);
+					p->ris |= UART_HAL_INT_OE;
+				}
+				p->ris |= UART_HAL_INT_RT;
+				p->rtArmed = false;
+				due = UINT64_MAX;
+			}
+		}
+		/* next TX check */
+		if(p->txBusy && !p->txCount){
+			if(now < p->txEarliest)
+				count = p->txEarliest;
+			else
+				count = now + p->chrTime;
+			if(count < due)
+				due = count;
+		}
+
+		fds[0].fd = p->fd;
+		fds[0].events = (p->rxCount < UART_HAL_FIFO_LEN ? POLLIN : 0)
+						| (p->txCount ? POLLOUT : 0);
+		pending = (p->ris & p->im) != 0;
+		pthread_mutex_unlock(&p->lock);
+
+		if(pending)
+			uartHal_isr(port);
+
+		if(due != UINT64_MAX){
+			due = due > now ? due - now : 0;
+			ts.tv_sec = due / 1000000000u;
+			ts.tv_nsec = due % 1000000000u;
+		}
+		if(ppoll(fds, 2, due != UINT64_MAX ? &ts : NULL, NULL) < 0
+				&& errno != EINTR)
+			break;
+		if(fds[1].revents & POLLIN){
+			if(read(p->kickFd, &count, sizeof(count)) < 0){
+				/* nothing to clear, EAGAIN */
+			}
+		}
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Opens a tty raw, 8N1 without flow control, as a port and starts its
+ * thread. The UART configuration done by the object holder on the target.
+ *
+ * Argument:	port	0 to UART_HAL_HOST_PORTS-1.
+ * 				path	The tty, e.g. "/dev/ttymxc1".
+ * 				baud	Baud rate, 9600 to 921600.
+ * Return:		 0		success
+ * 				-1		port or baud rate invalid, or port open
+ * 				-2		tty can't be opened or configured, see errno
+ */
+int32_t uartHalHost_open(uint32_t port, const char *path, uint32_t baud)
+{
+	struct uartHalPort *p;
+	struct termios tio;
+	unsigned int lsr;
+	speed_t speed;
+
+	if(port >= UART_HAL_HOST_PORTS || !to_speed(baud, &speed))
+		return -1;
+	p = &ports[port];
+	if(p->fd >= 0)
+		return -1;
+
+	p->fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if(p->fd < 0)
+		return -2;
+	if(tcgetattr(p->fd, &tio) != 0)
+		goto fail;
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+	tio.c_cc[VMIN] = 1;
+	tio.c_cc[VTIME] = 0;
+	if(cfsetspeed(&tio, speed) != 0 || tcsetattr(p->fd, TCSANOW, &tio) != 0)
+		goto fail;
+	tcflush(p->fd, TCIOFLUSH);
+	p->kickFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(p->kickFd < 0)
+		goto fail;
+
+	p->stop = false;
+	p->im = 0;
+	p->ris = 0;
+	p->rxHead = 0;
+	p->rxCount = 0;
+	p->rxLevel = 8;
+	p->rxAbove = false;
+	p->rtArmed = false;
+	p->lastRead = 0;
+	p->txCount = 0;
+	p->txBusy = false;
+	p->txLsr = ioctl(p->fd, TIOCSERGETLSR, &lsr) == 0;
+	p->chrTime = 10000000000ull / baud;
+	memset(&p->icount, 0, sizeof(p->icount));
+	ioctl(p->fd, TIOCGICOUNT, &p->icount);
+	if(pthread_create(&p->thread, NULL, port_thread, p) != 0)
+		goto fail;
+	return 0;
+
+fail:
+	if(p->kickFd >= 0)
+		close(p->kickFd);
+	close(p->fd);
+	p->kickFd = -1;
+	p->fd = -1;
+	return -2;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Stops the thread of a port and closes its tty. The attached objects
+ * don't get any events anymore.
+ *
+ * Argument:	port	0 to UART_HAL_HOST_PORTS-1.
+ */
+void uartHalHost_close(uint32_t port)
+{
+	struct uartHalPort *p;
+
+	if(port >= UART_HAL_HOST_PORTS || ports[port].fd < 0)
+		return;
+	p = &ports[port];
+	pthread_mutex_lock(&p->lock);
+	p->stop = true;
+	pthread_mutex_unlock(&p->lock);
+	kick(p);
+	pthread_join(p->thread, NULL);
+	close(p->kickFd);
+	close(p->fd);
+	p->kickFd = -1;
+	p->fd = -1;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * There is no DMA on the host, nothing to take over.
+ */
+void uartHal_claim(uint32_t port, uint32_t dir)
+{
+	(void) port;
+	(void) dir;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+void uartHal_attach_rx(uint32_t port, struct ao *ao)
+{
+	pthread_mutex_lock(&ports[port].lock);
+	ports[port].rx = ao;
+	pthread_mutex_unlock(&ports[port].lock);
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+void uartHal_attach_tx(uint32_t port, struct ao *ao)
+{
+	pthread_mutex_lock(&ports[port].lock);
+	ports[port].tx = ao;
+	pthread_mutex_unlock(&ports[port].lock);
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+bool uartHal_rx_empty(uint32_t port)
+{
+	bool empty;
+
+	pthread_mutex_lock(&ports[port].lock);
+	empty = ports[port].rxCount == 0;
+	pthread_mutex_unlock(&ports[port].lock);
+	return empty;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Reads a character from the RX FIFO. Like the data register of the
+ * target, an empty FIFO reads 0. The thread is kicked to refill a FIFO
+ * that was full.
+ */
+uint8_t uartHal_read(uint32_t port)
+{
+	struct uartHalPort *p = &ports[port];
+	uint8_t chr = 0;
+	bool full;
+
+	pthread_mutex_lock(&p->lock);
+	full = p->rxCount == UART_HAL_FIFO_LEN;
+	if(p->rxCount){
+		chr = p->rxFifo[p->rxHead];
+		p->rxHead = (p->rxHead + 1) % UART_HAL_FIFO_LEN;
+		p->rxCount--;
+		p->lastRead = clock_ns();
+		rx_update(p);
+	}
+	pthread_mutex_unlock(&p->lock);
+	if(full)
+		kick(p);
+	return chr;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sets the RX trigger level. A FIFO already at the new level throws the
+ * RX interrupt.
+ */
+void uartHal_set_rx_level(uint32_t port, uint32_t level)
+{
+	struct uartHalPort *p = &ports[port];
+	bool pending;
+
+	pthread_mutex_lock(&p->lock);
+	p->rxLevel = level;
+	p->rxAbove = false;
+	rx_update(p);
+	pending = (p->ris & p->im) != 0;
+	pthread_mutex_unlock(&p->lock);
+	if(pending)
+		uartHal_isr(port);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Writes a character to the TX FIFO, a full FIFO drops it like on the
+ * target. The thread is kicked for the first character.
+ */
+void uartHal_write(uint32_t port, uint8_t chr)
+{
+	struct uartHalPort *p = &ports[port];
+	bool first;
+
+	pthread_mutex_lock(&p->lock);
+	first = p->txCount == 0;
+	if(p->txCount < UART_HAL_FIFO_LEN)
+		p->txFifo[p->txCount++] = chr;
+	p->txBusy = true;
+	p->txEarliest = clock_ns() + p->chrTime;
+	p->ris &= ~UART_HAL_INT_TX;
+	pthread_mutex_unlock(&p->lock);
+	if(first)
+		kick(p);
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+bool uartHal_tx_busy(uint32_t port)
+{
+	bool busy;
+
+	pthread_mutex_lock(&ports[port].lock);
+	busy = ports[port].txBusy;
+	pthread_mutex_unlock(&ports[port].lock);
+	return busy;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Unmasks interrupts, one already pending is handled right away.
+ */
+void uartHal_int_enable(uint32_t port, uint32_t mask)
+{
+	struct uartHalPort *p = &ports[port];
+	bool pending;
+
+	pthread_mutex_lock(&p->lock);
+	p->im |= mask;
+	pending = (p->ris & p->im) != 0;
+	pthread_mutex_unlock(&p->lock);
+	if(pending)
+		uartHal_isr(port);
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+void uartHal_int_disable(uint32_t port, uint32_t mask)
+{
+	pthread_mutex_lock(&ports[port].lock);
+	ports[port].im &= ~mask;
+	pthread_mutex_unlock(&ports[port].lock);
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+void uartHal_int_clear(uint32_t port, uint32_t mask)
+{
+	pthread_mutex_lock(&ports[port].lock);
+	ports[port].ris &= ~mask;
+	pthread_mutex_unlock(&ports[port].lock);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * The interrupt handler, called by the thread of the port. Same as on the
+ * target, see uartHal.c.
+ */
+void uartHal_isr(uint32_t port)
+{
+	struct uartHalPort *p = &ports[port];
+	struct ao *rx, *tx;
+	uint32_t mis;
+	struct event e;
+
+	pthread_mutex_lock(&p->lock);
+	mis = p->ris & p->im;
+	p->ris &= ~mis;
+	p->im &= ~(mis & (UART_HAL_INT_RX | UART_HAL_INT_RT));
+	rx = p->rx;
+	tx = p->tx;
+	pthread_mutex_unlock(&p->lock);
+
+	if(rx != NULL){
+		if(mis & UART_HAL_INT_ERR){
+			e.sig = RX_ERROR_SIG;
+			e.data = (mis & UART_HAL_INT_ERR) >> UART_HAL_ERR_S;
+			ao_post(rx, &e);
+		}
+		if(mis & UART_HAL_INT_RX){
+			e.sig = RX_SIG;
+			ao_post(rx, &e);
+		}
+		if(mis & UART_HAL_INT_RT){
+			e.sig = RX_TIMEOUT_SIG;
+			ao_post(rx, &e);
+		}
+	}
+	if(tx != NULL && (mis & UART_HAL_INT_TX)){
+		e.sig = TX_SIG;
+		ao_post(tx, &e);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Drives a modem control line of a port.
+ *
+ * Argument:	pin		UART_HAL_HOST_PIN_RTS(port) or
+ * 						UART_HAL_HOST_PIN_DTR(port).
+ * 				level	true: asserted, false: negated.
+ */
+void uartHal_set_pin(uint32_t pin, bool level)
+{
+	uint32_t port = pin & PIN_PORT_M;
+	int line;
+
+	if(port >= UART_HAL_HOST_PORTS || ports[port].fd < 0)
+		return;
+	line = (pin & PIN_RTS) ? TIOCM_RTS : TIOCM_DTR;
+	ioctl(ports[port].fd, level ? TIOCMBIS : TIOCMBIC, &line);
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
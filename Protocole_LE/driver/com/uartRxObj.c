@@ -63,12 +63,17 @@
  * 				 	receive buffer (any size).
  * 				 -	Make a static struct uartRxObj variable and assign the
  * 				 	memory and size of the receive buffer.
- * 				 -	Write the interrupt handler (copy it from somewhere).
+ * 				 -	Call uartHal_isr() from the interrupt handler (see
+ * 				 	uartHal.c), on the host open the port with
+ * 				 	uartHalHost_open().
  * 				 -	Configure and Enable the UART module. Most important:
  * 				 	set the FEN bit in the LCRH register to enable the FIFO.
  * 				 	Enable interrupts in the NVIC and also configure the I/O's.
  * 				 -	Call the rx_init function. RX, timeout and error
  * 				 	interrupts are unmasked and the FIFO level is set.
+ *
+ * 				The UART is accessed through the HAL (uartHal.h), hence the
+ * 				object runs on the target and on the host alike.
  * 
  *****************************************************************************/
 
@@ -80,27 +85,33 @@
 #include <stdlib.h>
 
 #include "config/projConfig.h"
-#include "user/debug/debugTask.h"
+#include "driver/com/uartHal.h"
 #include "driver/com/uartRxObj.h"
 #include "lib/prot/protocol.h"
 #include "lib/stm/event.h"
 #include "lib/crc/crc16Lookup.h"
 
-#include "inc/hw_types.h"  /* HWREG macro */
-#include "inc/hw_uart.h"
-
 /******************************************************************************
  * DEFINES & MACROS & TYPEDEFS
  *****************************************************************************/
+/* FIFO tuning, may be set by the build (e.g. sim/uartemu to try others):
+ * the RX FIFO level in rx_busy, the characters left on the FIFO when
+ * entering rx_eor and the RX FIFO level in rx_idle. The levels must be one
+ * of the uartHal_set_rx_level() values, FIFO_REMAINDER at least 3 (rx_eor
+ * reads nRemaining%4 and waits for the rest) and at most IDLE_RX_LEVEL-2. */
+#ifndef MAX_RX_BUF_DEPTH
 #define MAX_RX_BUF_DEPTH		14
+#endif
+#ifndef FIFO_REMAINDER
 #define FIFO_REMAINDER			4
+#endif
+#ifndef IDLE_RX_LEVEL
+#define IDLE_RX_LEVEL			8  /* RX FIFO level in rx_idle */
+#endif
 
-#define DISABLE_RX_INT			HWREG(self->uartBase + UART_O_IM) &= \
-																~UART_IM_RXIM
-#define ENABLE_RX_INT			HWREG(self->uartBase + UART_O_IM) |= \
-																UART_IM_RXIM
-#define ENABLE_TIMEOUT_INT		HWREG(self->uartBase + UART_O_IM) |= \
-																UART_IM_RTIM
+#define DISABLE_RX_INT			uartHal_int_disable(self->port, UART_HAL_INT_RX)
+#define ENABLE_RX_INT			uartHal_int_enable(self->port, UART_HAL_INT_RX)
+#define ENABLE_TIMEOUT_INT		uartHal_int_enable(self->port, UART_HAL_INT_RT)
 
 /******************************************************************************
  * FILE SCOPE VARIABLES
@@ -134,29 +145,22 @@ static void rx_error(struct uartRxObj *, struct event *);
  * Note that the main UART configuration must be done by the object holder
  * (e.g. the baudrate). Also make sure not to overwrite this configuration
  * and that the UART module is clocked before calling the rx_obj init.
+ * The object must be registered, as the interrupts post to it.
  *
  * Argument:	self	Reference to RX object.
  */
 void uart_rx_init(struct uartRxObj * self)
 {
-	HWREG(self->uartBase + UART_O_ICR) = 0
-				| UART_ICR_OEIC  /* UART Overrun Error */
-				| UART_ICR_BEIC  /* UART Break Error */
-				| UART_ICR_PEIC  /* UART Parity Error */
-				| UART_ICR_FEIC  /* UART Framing Error */
-				| UART_ICR_RTIC  /* UART Receive Time-Out */
-				| UART_ICR_RXIC  /* UART Receive */
-				| 0;
-	HWREG(self->uartBase + UART_O_IM) |= 0
-				| UART_IM_OEIM  /* UART Overrun Error */
-				| UART_IM_BEIM  /* UART Break Error */
-				| UART_IM_PEIM  /* UART Parity Error */
-				| UART_IM_FEIM  /* UART Framing Error */
-				| UART_IM_RTIM  /* UART Receive Time-Out */
-				| UART_IM_RXIM  /* UART Receive */
-				| 0;
-	HWREG(self->uartBase + UART_O_DMACTL) &= ~(UART_DMACTL_DMAERR
-			| UART_DMACTL_RXDMAE);
+	uartHal_claim(self->port, UART_HAL_RX);
+	uartHal_attach_rx(self->port, (struct ao *) self);
+	uartHal_int_clear(self->port, 0
+				| UART_HAL_INT_ERR  /* UART Overrun, Break, Parity, Framing */
+				| UART_HAL_INT_RT  /* UART Receive Time-Out */
+				| UART_HAL_INT_RX);  /* UART Receive */
+	uartHal_int_enable(self->port, 0
+				| UART_HAL_INT_ERR  /* UART Overrun, Break, Parity, Framing */
+				| UART_HAL_INT_RT  /* UART Receive Time-Out */
+				| UART_HAL_INT_RX);  /* UART Receive */
 }
 /*---------------------------------------------------------------------------*/
 
@@ -169,8 +173,8 @@ void clear_uart_rx_fifo(struct uartRxObj * self)
 {
 	volatile uint8_t rxChr;
 
-	while(!HWREGBITW(self->uartBase + UART_O_FR, 4)){
-		rxChr = HWREG(self->uartBase + UART_O_DR);
+	while(!uartHal_rx_empty(self->port)){
+		rxChr = uartHal_read(self->port);
 	}
 }
 /*---------------------------------------------------------------------------*/
@@ -191,14 +195,14 @@ void read_payload(struct uartRxObj * self, int32_t len)
 	volatile uint8_t rxChr;
 
 	if(len < 0){
-		while(!HWREGBITW(self->uartBase + UART_O_FR, 4)){
-			rxChr = HWREG(self->uartBase + UART_O_DR);
+		while(!uartHal_rx_empty(self->port)){
+			rxChr = uartHal_read(self->port);
 			crc16_ccitt_byte_calc(&self->dlink.crc, rxChr);
 			self->rxBuf.buf[self->rxBuf.pos++] = rxChr;
 		}
 	}else{
 		for(i=0; i<len; i++){
-			rxChr = HWREG(self->uartBase + UART_O_DR);
+			rxChr = uartHal_read(self->port);
 			crc16_ccitt_byte_calc(&self->dlink.crc, rxChr);
 			self->rxBuf.buf[self->rxBuf.pos++] = rxChr;
 		}
@@ -243,24 +247,23 @@ uint32_t rxObj_init_buffer(struct uartRxObj *self, uint8_t *buf, uint16_t len)
  *
  * Argument:	self		Reference to RX object.
  * 				prio		Active object priority.
- * 				uartBase	The base memory address of the UART module.
+ * 				port		The UART port, see uartHal.h.
  * 				cb			The callback function.
  * 				cbHandle	Handle passed with the callback function.
  * 				eQueueLen	Desired length of event queue.
  * Return:		 0			success
  * 				-1			event queue memory not assigned/allocated
  */
-int32_t rx_init(struct uartRxObj *self, uint8_t prio, uint32_t uartBase,
+int32_t rx_init(struct uartRxObj *self, uint8_t prio, uint32_t port,
 				rxCb_t cb, void *cbHandle, uint32_t eQueueLen)
 {
 	void *eQueueMem;
 
 	/* Top transition and action */
-	self->uartBase = uartBase;
+	self->port = port;
 	self->cb.func = cb;
 	self->cb.handle = cbHandle;
 	self->rxBuf.len = 0;
-	uart_rx_init(self);
 
 	/* Initial state and register to scheduler (does initial transition) */
     self->super.super.objType = OBJTYPE_RX_OBJ;
@@ -268,6 +271,7 @@ int32_t rx_init(struct uartRxObj *self, uint8_t prio, uint32_t uartBase,
 	ao_init_event_queue((struct ao *) self, eQueueMem, eQueueLen);
 	STM_SET_STATE(self, &rx_idle);
 	ao_register((struct ao *) self, prio, false);
+	uart_rx_init(self);
 	return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -293,14 +297,13 @@ void rx_idle(struct uartRxObj *self, struct event *e)
 	switch(e->sig){
 	case STATE_ENTRY_SIG:
 		clear_uart_rx_fifo(self);
-		HWREG(self->uartBase + UART_O_IFLS) &= ~UART_IFLS_RX_M;
-		HWREG(self->uartBase + UART_O_IFLS) |= UART_IFLS_RX4_8;
+		uartHal_set_rx_level(self->port, IDLE_RX_LEVEL);
 		break;
 	case STATE_EXIT_SIG:
 		break;
 	case RX_SIG:
-		preamble = HWREG(self->uartBase + UART_O_DR);
-		self->dlink.len = HWREG(self->uartBase + UART_O_DR);
+		preamble = uartHal_read(self->port);
+		self->dlink.len = uartHal_read(self->port);
 		tmpE.data = 0;
 		if(preamble != PREAMBLE)
 			tmpE.data = RX_ERR_PREAMBLEMISMATCH;
@@ -321,7 +324,8 @@ void rx_idle(struct uartRxObj *self, struct event *e)
 			}
 			self->dlink.crc = CRC16_CCITT_INIT_0000;
 			self->rxBuf.pos = 0;
-			read_payload(self, 2);  /* 8-2-2 = 4 remain */
+			/* FIFO_REMAINDER remain, 8-2-2 = 4 */
+			read_payload(self, IDLE_RX_LEVEL - 2 - FIFO_REMAINDER);
 			if((self->dlink.len + CRC_LEN - self->rxBuf.pos)
 					<= MAX_RX_BUF_DEPTH){
 				STM_STATE_TRAN(self, &rx_eor, e);
@@ -343,7 +347,7 @@ void rx_idle(struct uartRxObj *self, struct event *e)
 	case RX_ERROR_SIG:
 		/* RX FIFO empty? This is a strange case, because a faulty
 		   received character should also be stored on the FIFO! */
-		if(!HWREGBITW(self->uartBase + UART_O_FR, 4)){
+		if(!uartHal_rx_empty(self->port)){
 			if(self->cb.func != NULL){
 				tmpE.data = e->data;
 				tmpE.sig = RX_ERR_SIG;
@@ -371,14 +375,13 @@ void rx_busy(struct uartRxObj *self, struct event *e)
 	switch(e->sig){
 	case STATE_ENTRY_SIG:
 		DISABLE_RX_INT;
-		HWREG(self->uartBase + UART_O_IFLS) &= ~UART_IFLS_RX_M;
-		HWREG(self->uartBase + UART_O_IFLS) |= UART_IFLS_RX7_8;
+		uartHal_set_rx_level(self->port, MAX_RX_BUF_DEPTH);
 		ENABLE_RX_INT;
 		break;
 	case STATE_EXIT_SIG:
 		break;
 	case RX_SIG:
-		read_payload(self, 10);
+		read_payload(self, MAX_RX_BUF_DEPTH - FIFO_REMAINDER);
 		if((self->dlink.len + CRC_LEN - self->rxBuf.pos)
 				<= MAX_RX_BUF_DEPTH){
 			STM_STATE_TRAN(self, &rx_eor, e);
@@ -422,14 +425,13 @@ void rx_eor(struct uartRxObj *self, struct event *e)
 	switch(e->sig){
 	case STATE_ENTRY_SIG:
 		nRemaining = self->dlink.len + CRC_LEN - self->rxBuf.pos;
-		if(nRemaining == 4){
+		if(nRemaining <= FIFO_REMAINDER){
 			tmpE.sig = RX_SIG;
 			ao_post((struct ao *) self, &tmpE);
 		}else{
 			read_payload(self, (nRemaining & 0x3));
 			DISABLE_RX_INT;
-			HWREG(self->uartBase + UART_O_IFLS) &= ~UART_IFLS_RX_M;
-			HWREG(self->uartBase + UART_O_IFLS) |= nRemaining << 1;
+			uartHal_set_rx_level(self->port, nRemaining & ~0x3);
 			ENABLE_RX_INT;
 		}
 		break;
@@ -485,28 +487,19 @@ void rx_error(struct uartRxObj *self, struct event *e)
 {
 	switch(e->sig){
 	case STATE_ENTRY_SIG:
-		HWREG(self->uartBase + UART_O_IM) &= ~(0
-				| UART_IM_OEIM  /* UART Overrun Error */
-				| UART_IM_BEIM  /* UART Break Error */
-				| UART_IM_PEIM  /* UART Parity Error */
-				| UART_IM_FEIM  /* UART Framing Error */
-				| UART_IM_RXIM);  /* UART Receive */
+		uartHal_int_disable(self->port, 0
+				| UART_HAL_INT_ERR  /* UART Overrun, Break, Parity, Framing */
+				| UART_HAL_INT_RX);  /* UART Receive */
 		break;
 	case STATE_EXIT_SIG:
 		break;
 	case RX_TIMEOUT_SIG:
-		HWREG(self->uartBase + UART_O_ICR) = (0
-				| UART_IM_OEIM  /* UART Overrun Error */
-				| UART_IM_BEIM  /* UART Break Error */
-				| UART_IM_PEIM  /* UART Parity Error */
-				| UART_IM_FEIM  /* UART Framing Error */
-				| UART_IM_RXIM);  /* UART Receive */
-		HWREG(self->uartBase + UART_O_IM) |= (0
-				| UART_IM_OEIM  /* UART Overrun Error */
-				| UART_IM_BEIM  /* UART Break Error */
-				| UART_IM_PEIM  /* UART Parity Error */
-				| UART_IM_FEIM  /* UART Framing Error */
-				| UART_IM_RXIM);  /* UART Receive */
+		uartHal_int_clear(self->port, 0
+				| UART_HAL_INT_ERR  /* UART Overrun, Break, Parity, Framing */
+				| UART_HAL_INT_RX);  /* UART Receive */
+		uartHal_int_enable(self->port, 0
+				| UART_HAL_INT_ERR  /* UART Overrun, Break, Parity, Framing */
+				| UART_HAL_INT_RX);  /* UART Receive */
 		ENABLE_TIMEOUT_INT;
 		STM_STATE_TRAN(self, &rx_idle, e);
 		break;
@@ -74,7 +74,7 @@ struct uartRxObj{
 		void *handle;  /* handle passed to the callback function */
 	}cb;
 	struct ucBuffer rxBuf;
-	uint32_t uartBase;  /* base address of the UART port */
+	uint32_t port;  /* UART port, see uartHal.h */
 	struct{
 		uint16_t len;  /* data link layer field 'length' */
 		uint16_t crc;  /* data link layer field 'CRC' */
@@ -91,12 +91,17 @@
  * 				 	transmit buffer (any size).
  * 				 -	Make a static struct uartTxObj variable and assign the
  * 				 	memory and size of the buffer.
- * 				 -	Write the interrupt handler (copy it from somewhere).
+ * 				 -	Call uartHal_isr() from the interrupt handler (see
+ * 				 	uartHal.c), on the host open the port with
+ * 				 	uartHalHost_open().
  * 				 -	Configure and Enable the UART module. Most important:
  * 				 	set the FEN bit in the LCRH register to enable the FIFO
  * 				 	and set the EOT bit in the CTL register.
  * 				 	Enable interrupts in the NVIC and also configure the I/O's.
  * 				 -	Call the tx_init function. TX interrupt becomes unmasked.
+ *
+ * 				The UART is accessed through the HAL (uartHal.h), hence the
+ * 				object runs on the target and on the host alike.
  * 
  *****************************************************************************/
 
@@ -108,14 +113,12 @@
 #include <stdlib.h>
 
 #include "config/projConfig.h"
+#include "driver/com/uartHal.h"
 #include "driver/com/uartTxObj.h"
 #include "lib/prot/protocol.h"
 #include "lib/stm/event.h"
 #include "lib/crc/crc16Lookup.h"
 
-#include "inc/hw_types.h"  /* HWREG macro */
-#include "inc/hw_uart.h"
-
 /******************************************************************************
  * DEFINES & MACROS & TYPEDEFS
  *****************************************************************************/
@@ -123,6 +126,13 @@
 #define FLAGS_UARTBUSY_ERR        0x01
 #define FLAGS_TX_STOP             0x02
 
+/* Characters pushed onto the TX FIFO while more than a FIFO is left, may be
+ * set by the build (e.g. sim/uartemu). At most 15 (UART_HAL_FIFO_LEN-1) so
+ * the CRC isn't split, see tx_busy(). */
+#ifndef TX_CHUNK
+#define TX_CHUNK				15
+#endif
+
 /******************************************************************************
  * FILE SCOPE VARIABLES
  *****************************************************************************/
@@ -153,15 +163,17 @@ static void tx_eot(struct uartTxObj *, struct event *);
  * Note that the main UART configuration must be done by the object holder
  * (e.g. the baudrate, eot, ...). Also make sure not to overwrite this
  * configuration and that the UART module is clocked before calling the
- * tx_init function.
+ * tx_init function. The object must be registered, as the interrupt posts
+ * to it.
  *
  * Argument:	self	Reference to TX object.
  */
 void uart_tx_init(struct uartTxObj *self)
 {
-	HWREG(self->uartBase + UART_O_ICR) = UART_ICR_TXIC;
-	HWREG(self->uartBase + UART_O_IM) |= UART_IM_TXIM;
-	HWREG(self->uartBase + UART_O_DMACTL) &= ~UART_DMACTL_TXDMAE;
+	uartHal_claim(self->port, UART_HAL_TX);
+	uartHal_attach_tx(self->port, (struct ao *) self);
+	uartHal_int_clear(self->port, UART_HAL_INT_TX);
+	uartHal_int_enable(self->port, UART_HAL_INT_TX);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -183,7 +195,7 @@ void write_payload(struct uartTxObj *self, uint32_t len)
 	for(i=0; i<len; i++){
 		tmp = self->txBuf.buf[self->txBuf.pos++];
 		crc16_ccitt_byte_calc(&self->crc, tmp);
-		HWREG(self->uartBase + UART_O_DR) = tmp;
+		uartHal_write(self->port, tmp);
 	}
 }
 /*---------------------------------------------------------------------------*/
@@ -240,25 +252,24 @@ void txObj_set_buffered_unsent(struct uartTxObj *self)
  *
  * Argument:	self		Reference to TX object.
  * 				prio		Active object priority.
- * 				uartBase	The base memory address of the UART module.
+ * 				port		The UART port, see uartHal.h.
  * 				cb			The callback function.
  * 				cbHandle	Handle passed with the callback function.
  * 				eQueueLen	Desired length of event queue.
  * Return:		 0			success
  * 				-1			event queue memory not assigned/allocated
  */
-int32_t tx_init(struct uartTxObj *self, uint8_t prio, uint32_t uartBase,
+int32_t tx_init(struct uartTxObj *self, uint8_t prio, uint32_t port,
 				txCb_t cb, void *cbHandle, uint32_t eQueueLen)
 {
 	void *eQueueMem;
 
 	/* Top transition and action */
-	self->uartBase = uartBase;
+	self->port = port;
 	self->cb.func = cb;
 	self->cb.handle = cbHandle;
 	self->txBuf.len = 0;
 	self->flags = 0;
-	uart_tx_init(self);
 
 	/* Initial state and register to scheduler (does initial transition) */
     self->super.super.objType = OBJTYPE_TX_OBJ;
@@ -266,6 +277,7 @@ int32_t tx_init(struct uartTxObj *self, uint8_t prio, uint32_t uartBase,
 	ao_init_event_queue((struct ao *) self, eQueueMem, eQueueLen);
 	STM_SET_STATE(self, &tx_idle);
 	ao_register((struct ao *) self, prio, false);
+	uart_tx_init(self);
 	return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -300,15 +312,15 @@ void tx_idle(struct uartTxObj *self, struct event *e)
 				self->cb.func(self->cb.handle, &tmpE);
 			}
 		}else{  /* Okey, start transmission */
-			HWREG(self->uartBase + UART_O_DR) = PREAMBLE;
-			HWREG(self->uartBase + UART_O_DR) = nChr;
-			if(nChr <= (16-DLINK_H_LEN)){
+			uartHal_write(self->port, PREAMBLE);
+			uartHal_write(self->port, nChr);
+			if(nChr <= (UART_HAL_FIFO_LEN-DLINK_H_LEN)){
 				write_payload(self, nChr);
-				HWREG(self->uartBase + UART_O_DR) = self->crc >> 8;
-				HWREG(self->uartBase + UART_O_DR) = self->crc;
+				uartHal_write(self->port, self->crc >> 8);
+				uartHal_write(self->port, self->crc);
 				STM_STATE_TRAN(self, &tx_eot, e);
 			}else{
-				write_payload(self, 15-2);
+				write_payload(self, TX_CHUNK-2);
 				STM_STATE_TRAN(self, &tx_busy, e);
 			}
 		}
@@ -339,13 +351,13 @@ void tx_busy(struct uartTxObj *self, struct event *e)
 		break;
 	case TX_SIG:
 		nChr = self->txBuf.len-self->txBuf.pos;
-		if(nChr <= (16-CRC_LEN)){
+		if(nChr <= (UART_HAL_FIFO_LEN-CRC_LEN)){
 			write_payload(self, nChr);
-			HWREG(self->uartBase + UART_O_DR) = self->crc >> 8;
-			HWREG(self->uartBase + UART_O_DR) = self->crc;
+			uartHal_write(self->port, self->crc >> 8);
+			uartHal_write(self->port, self->crc);
 			STM_STATE_TRAN(self, &tx_eot, e);
 		}else{
-			write_payload(self, 15);
+			write_payload(self, TX_CHUNK);
 		}
 		break;
 	case TX_GO_SIG:
@@ -354,7 +366,7 @@ void tx_busy(struct uartTxObj *self, struct event *e)
 	case TX_STOP_SIG:
         self->flags |= FLAGS_TX_STOP;
     check_busy:
-        if(HWREGBITW(self->uartBase + UART_O_FR, 3)){  /* UART busy */
+        if(uartHal_tx_busy(self->port)){  /* UART busy */
             STM_STATE_TRAN(self, &tx_eot, e);
         }else{
             STM_STATE_TRAN(self, &tx_idle, e);
@@ -419,7 +431,7 @@ void tx_eot(struct uartTxObj *self, struct event *e)
     case TX_STOP_SIG:
         self->flags |= FLAGS_TX_STOP;
     check_busy:
-        if(HWREGBITW(self->uartBase + UART_O_FR, 3))  /* UART busy */
+        if(uartHal_tx_busy(self->port))  /* UART busy */
             break;
         STM_STATE_TRAN(self, &tx_idle, e);
         if(self->cb.func != NULL){
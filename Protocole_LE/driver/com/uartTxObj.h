@@ -67,7 +67,7 @@ struct uartTxObj{
 		void *handle;  /* handle passed to the callback function */
 	}cb;
 	struct ucBuffer txBuf;  /* the receive buffer */
-	uint32_t uartBase;  /* base address of the UART port */
+	uint32_t port;  /* UART port, see uartHal.h */
 	uint16_t crc;  /* storage for 16bit CRC */
 	uint8_t flags;  /* internal flags */
 };
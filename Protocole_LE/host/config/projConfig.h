@@ -0,0 +1,61 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: projConfig.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Project configuration of the Linux host build. It takes the place of
+ * 		the target's config/projConfig.h, the host/ directory has to be in
+ * 		the include path before the target configuration (see host.pri).
+ *
+ *****************************************************************************/
+
+#ifndef HOST_CONFIG_PROJCONFIG_H_
+#define HOST_CONFIG_PROJCONFIG_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lib/stm/aokHost.h"
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+/* Selects the Linux port of the active object kernel. */
+#ifndef AOK_HOST
+#define AOK_HOST
+#endif
+
+/* There is no interrupt mask on the host, the kernel's critical sections
+ * take a lock shared by all threads instead. */
+#define INT_GLOB_MASK_SET		aokHost_lock()
+#define INT_GLOB_MASK_CLEAR		aokHost_unlock()
+
+/* Object types (ao.objType) of the drivers built on the host. */
+enum{
+	OBJTYPE_NONE,
+	OBJTYPE_RX_OBJ,
+	OBJTYPE_TX_OBJ,
+	OBJTYPE_HX_OBJ,
+};
+
+/* First signal an object sends to others. The public signals of the
+ * objects must not overlap, since the HX object gets the ones of its RX
+ * and TX object. */
+#define RXOBJ_PUBLIC_SIG		0x0100
+#define TXOBJ_PUBLIC_SIG		0x0110
+#define HXCOMOBJ_PUBLIC_SIG		0x0120
+
+
+#endif /* HOST_CONFIG_PROJCONFIG_H_ */
@@ -0,0 +1,75 @@
+# Linux host build of the firmware libraries: the active object kernel and
+# the event queues run on top of the host port (lib/stm/aokHost.c) with the
+# host project configuration (host/config/projConfig.h). The timer deamon is
+# replaced by its timing wheel implementation (lib/timer/timerDeamonHost.c),
+# the event pool by its thread safe version (lib/stm/eventPoolHost.c).
+#
+# Include from a .pro file:
+#     include(path/to/Protocole_LE/host/host.pri)
+
+INCLUDEPATH += $$PWD $$PWD/..
+DEFINES += AOK_HOST
+LIBS += -lpthread
+
+HEADERS += \
+    $$PWD/config/projConfig.h \
+    $$PWD/../lib/stm/aok.h \
+    $$PWD/../lib/stm/aokHost.h \
+    $$PWD/../lib/stm/event.h \
+    $$PWD/../lib/mem/xQueue.h \
+    $$PWD/../lib/mem/set56.h \
+    $$PWD/../lib/mem/pool.h \
+    $$PWD/../lib/stm/eventPool.h \
+    $$PWD/../lib/timer/timerDeamon.h
+
+SOURCES += \
+    $$PWD/../lib/stm/aok.c \
+    $$PWD/../lib/stm/aokHost.c \
+    $$PWD/../lib/mem/xQueue.c \
+    $$PWD/../lib/mem/set56.c \
+    $$PWD/../lib/mem/pool.c \
+    $$PWD/../lib/stm/eventPoolHost.c \
+    $$PWD/../lib/timer/timerDeamonHost.c
+
+# Multi-core scheduler: ao_scheduler() runs a pool of worker threads
+# (lib/stm/aokSmp.c). Enable with CONFIG += aok_smp.
+aok_smp {
+    DEFINES += AOK_SMP
+    HEADERS += $$PWD/../lib/stm/aokSmp.h
+    SOURCES += $$PWD/../lib/stm/aokSmp.c
+}
+
+# Lock-free event queues (lib/mem/mpscQueue.c): ao_post() takes no lock and
+# may be called from any thread. Enable with CONFIG += aok_mpsc.
+aok_mpsc {
+    DEFINES += AOK_MPSC
+    HEADERS += $$PWD/../lib/mem/mpscQueue.h
+    SOURCES += $$PWD/../lib/mem/mpscQueue.c
+}
+
+# Scheduler for up to 4096 AOs: the waiting AOs are kept in a set4096,
+# scanned with clz instead of the log2lookup table. With aok_mpsc the set
+# is changed under the lock, only the event queues stay lock-free. Enable
+# with CONFIG += aok_set4096.
+aok_set4096 {
+    DEFINES += AOK_SET4096
+    HEADERS += $$PWD/../lib/mem/set4096.h
+}
+
+# UART drivers (driver/com) on a tty: the RX, TX and half duplex objects run
+# on the Linux implementation of the UART HAL (driver/com/uartHalHost.c).
+# Enable with CONFIG += uart_com, open the ports with uartHalHost_open().
+# The protocol libraries they use (lib/crc/crc16Lookup.c, lib/mem/ucBuffer.c)
+# are added by the project, like the other protocol sources.
+uart_com {
+    HEADERS += \
+        $$PWD/../driver/com/uartHal.h \
+        $$PWD/../driver/com/uartRxObj.h \
+        $$PWD/../driver/com/uartTxObj.h \
+        $$PWD/../driver/com/hxComObj.h
+    SOURCES += \
+        $$PWD/../driver/com/uartHalHost.c \
+        $$PWD/../driver/com/uartRxObj.c \
+        $$PWD/../driver/com/uartTxObj.c \
+        $$PWD/../driver/com/hxComObj.c
+}
@@ -0,0 +1,363 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: crc16Block.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO): PMULL folding for AArch64 targets. The i.MX6UL
+ *						(Cortex-A7, ARMv7) has no 64-bit polynomial multiply,
+ *						so it uses slicing-by-8.
+ *
+ ******************************************************************************
+ * Description:
+ * 		CRC16-CCITT (polynomial 0x1021, not reflected, no final xor) over a
+ * 		whole block, bit-exact with crc16_ccitt_byte_calc() and the
+ * 		CRC16_CCITT_TABLE:
+ *
+ * 			crc = crc16_ccitt_block(buf, len, CRC16_CCITT_INIT_0000);
+ *
+ * 		gives the same result as calling crc16_ccitt_byte_calc() for every
+ * 		byte, hence blocks can also be chained by passing the previous result
+ * 		as init value.
+ *
+ * 		Kernels
+ * 		-------
+ * 		The byte-wise routine has a serial dependency from one table lookup to
+ * 		the next. The slicing kernels look up 4 or 8 bytes independently in
+ * 		4 or 8 tables, where table k holds the CRC of a byte followed by k
+ * 		zero bytes:
+ *
+ * 			T[k][b] = b * x^(16+8k) mod P
+ *
+ * 		The CRC value is xor'ed onto the first two bytes of the step, the new
+ * 		CRC is the xor of all lookups.
+ *
+ * 		The CLMUL kernel folds 16 byte blocks with carry-less multiplication.
+ * 		A block A (a 128 bit polynomial, first byte being the most
+ * 		significant) followed by the block B is equivalent (mod P) to
+ *
+ * 			A.hi * (x^192 mod P) + A.lo * (x^128 mod P) + B
+ *
+ * 		which is again 128 bits wide since the constants have 16 bits. Four
+ * 		blocks are folded in parallel (x^576, x^512), then combined into one.
+ * 		The final 128 bits are reduced with the slicing kernel.
+ *
+ * 		The kernel is selected once at startup (CRC16_KERNEL_AUTO) and can be
+ * 		changed with crc16_ccitt_select(), e.g. for benchmarks.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "crc16Block.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC16_HAVE_CLMUL		1
+#include <immintrin.h>
+#else
+#define CRC16_HAVE_CLMUL		0
+#endif
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define CRC16_CCITT_POLY		0x1021
+
+/* Blocks shorter than this are not worth the setup of the folding kernel. */
+#define CLMUL_MIN_LEN			128
+
+typedef uint16_t (*crc16Block_t)(uint16_t, const uint8_t *, uint32_t);
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/* slicing tables, crcTable[0] equals the CRC16_CCITT_TABLE */
+static uint16_t crcTable[8][256];
+#if CRC16_HAVE_CLMUL
+static uint64_t foldK1;  /* x^192 mod P */
+static uint64_t foldK2;  /* x^128 mod P */
+static uint64_t foldK4Hi;  /* x^576 mod P */
+static uint64_t foldK4Lo;  /* x^512 mod P */
+#endif
+
+static enum crc16Kernel blockKernel;
+
+static const char * const kernelName[] = {
+	"byte", "slice4", "slice8", "clmul", "auto",
+};
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static void crc16_block_init(void) __attribute__((constructor));
+static uint16_t block_byte(uint16_t, const uint8_t *, uint32_t);
+static uint16_t block_slice4(uint16_t, const uint8_t *, uint32_t);
+static uint16_t block_slice8(uint16_t, const uint8_t *, uint32_t);
+#if CRC16_HAVE_CLMUL
+static uint64_t xpow_mod(uint32_t);
+static int32_t cpu_has_clmul(void);
+static uint16_t block_clmul(uint16_t, const uint8_t *, uint32_t);
+#endif
+
+/* kernel used by crc16_ccitt_block(), byte-wise until the tables are built */
+static crc16Block_t blockFunc = &block_byte;
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Builds the slicing tables and the folding constants and selects the
+ * fastest kernel. Runs before main().
+ */
+static void crc16_block_init(void)
+{
+	uint32_t i, k;
+	uint16_t v;
+
+	for(i=0; i<256; i++)
+		crcTable[0][i] = CRC16_CCITT_TABLE[i];
+	for(k=1; k<8; k++){
+		for(i=0; i<256; i++){
+			v = crcTable[k-1][i];
+			crcTable[k][i] = (uint16_t)(v << 8) ^ crcTable[0][v >> 8];
+		}
+	}
+#if CRC16_HAVE_CLMUL
+	foldK1 = xpow_mod(192);
+	foldK2 = xpow_mod(128);
+	foldK4Hi = xpow_mod(576);
+	foldK4Lo = xpow_mod(512);
+#endif
+	crc16_ccitt_select(CRC16_KERNEL_AUTO);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Reference kernel, same as crc16_ccitt_byte_calc() in a loop.
+ */
+static uint16_t block_byte(uint16_t crc, const uint8_t *p, uint32_t len)
+{
+	while(len--)
+		crc16_ccitt_byte_calc(&crc, *p++);
+	return crc;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Slicing-by-4 kernel.
+ */
+static uint16_t block_slice4(uint16_t crc, const uint8_t *p, uint32_t len)
+{
+	while(len >= 4){
+		crc ^= (uint16_t)(p[0] << 8 | p[1]);
+		crc = crcTable[3][crc >> 8] ^ crcTable[2][crc & 0xff]
+			^ crcTable[1][p[2]] ^ crcTable[0][p[3]];
+		p += 4;
+		len -= 4;
+	}
+	return block_byte(crc, p, len);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Slicing-by-8 kernel.
+ */
+static uint16_t block_slice8(uint16_t crc, const uint8_t *p, uint32_t len)
+{
+	while(len >= 8){
+		crc ^= (uint16_t)(p[0] << 8 | p[1]);
+		crc = crcTable[7][crc >> 8] ^ crcTable[6][crc & 0xff]
+			^ crcTable[5][p[2]] ^ crcTable[4][p[3]]
+			^ crcTable[3][p[4]] ^ crcTable[2][p[5]]
+			^ crcTable[1][p[6]] ^ crcTable[0][p[7]];
+		p += 8;
+		len -= 8;
+	}
+	return block_slice4(crc, p, len);
+}
+/*---------------------------------------------------------------------------*/
+
+#if CRC16_HAVE_CLMUL
+/*
+ * Computes x^n mod P.
+ */
+static uint64_t xpow_mod(uint32_t n)
+{
+	uint32_t v = 1;  /* x^0 */
+
+	while(n--){
+		v <<= 1;
+		if(v & 0x10000)
+			v ^= 0x10000 | CRC16_CCITT_POLY;
+	}
+	return v;
+}
+/*---------------------------------------------------------------------------*/
+
+static int32_t cpu_has_clmul(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Folds a 128 bit block by one block distance (k = x^192, x^128 mod P) or
+ * four block distances (x^576, x^512 mod P).
+ */
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i fold(__m128i a, __m128i k)
+{
+	return _mm_xor_si128(_mm_clmulepi64_si128(a, k, 0x11),
+							_mm_clmulepi64_si128(a, k, 0x00));
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Carry-less multiply folding kernel.
+ */
+__attribute__((target("pclmul,ssse3")))
+static uint16_t block_clmul(uint16_t crc, const uint8_t *p, uint32_t len)
+{
+	const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+										8, 9, 10, 11, 12, 13, 14, 15);
+	const __m128i k1 = _mm_set_epi64x((long long) foldK1,
+										(long long) foldK2);
+	const __m128i k4 = _mm_set_epi64x((long long) foldK4Hi,
+										(long long) foldK4Lo);
+	__m128i a0, a1, a2, a3;
+	uint8_t rest[16];
+
+	if(len < CLMUL_MIN_LEN)
+		return block_slice8(crc, p, len);
+
+#define LOAD(i)		_mm_shuffle_epi8(_mm_loadu_si128( \
+						(const __m128i *)(p + 16 * (i))), bswap)
+
+	/* the CRC so far is xor'ed onto the first two bytes */
+	a0 = _mm_xor_si128(LOAD(0), _mm_set_epi64x((long long)
+						((uint64_t) crc << 48), 0));
+	a1 = LOAD(1);
+	a2 = LOAD(2);
+	a3 = LOAD(3);
+	p += 64;
+	len -= 64;
+	while(len >= 64){
+		a0 = _mm_xor_si128(fold(a0, k4), LOAD(0));
+		a1 = _mm_xor_si128(fold(a1, k4), LOAD(1));
+		a2 = _mm_xor_si128(fold(a2, k4), LOAD(2));
+		a3 = _mm_xor_si128(fold(a3, k4), LOAD(3));
+		p += 64;
+		len -= 64;
+	}
+	a1 = _mm_xor_si128(fold(a0, k1), a1);
+	a2 = _mm_xor_si128(fold(a1, k1), a2);
+	a0 = _mm_xor_si128(fold(a2, k1), a3);
+	while(len >= 16){
+		a0 = _mm_xor_si128(fold(a0, k1), LOAD(0));
+		p += 16;
+		len -= 16;
+	}
+#undef LOAD
+
+	/* reduce the remaining 128 bits, then the tail */
+	_mm_storeu_si128((__m128i *) rest, _mm_shuffle_epi8(a0, bswap));
+	crc = block_slice8(0, rest, 16);
+	return block_slice8(crc, p, len);
+}
+/*---------------------------------------------------------------------------*/
+#endif
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Calculates the CRC over a block of bytes.
+ *
+ * Argument:	ptr		Pointer to the data.
+ * 				len		Number of bytes.
+ * 				init	Init value or CRC of the previous block.
+ * Return:		CRC
+ */
+uint16_t crc16_ccitt_block(const void *ptr, uint32_t len, uint16_t init)
+{
+	return blockFunc(init, (const uint8_t *) ptr, len);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Selects the kernel used by crc16_ccitt_block(). Not thread safe, meant to
+ * be called at startup or from benchmarks.
+ *
+ * Argument:	kernel	see enum crc16Kernel
+ * Return:		 0		success
+ * 				-1		kernel not supported by this CPU/build
+ */
+int32_t crc16_ccitt_select(enum crc16Kernel kernel)
+{
+	switch(kernel){
+	case CRC16_KERNEL_BYTE:
+		blockFunc = &block_byte;
+		break;
+	case CRC16_KERNEL_SLICE4:
+		blockFunc = &block_slice4;
+		break;
+	case CRC16_KERNEL_SLICE8:
+		blockFunc = &block_slice8;
+		break;
+	case CRC16_KERNEL_CLMUL:
+#if CRC16_HAVE_CLMUL
+		if(!cpu_has_clmul())
+			return -1;
+		blockFunc = &block_clmul;
+		break;
+#else
+		return -1;
+#endif
+	case CRC16_KERNEL_AUTO:
+		if(crc16_ccitt_select(CRC16_KERNEL_CLMUL) == 0)
+			return 0;
+		return crc16_ccitt_select(CRC16_KERNEL_SLICE8);
+	default:
+		return -1;
+	}
+	blockKernel = kernel;
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		kernel currently used by crc16_ccitt_block()
+ */
+enum crc16Kernel crc16_ccitt_kernel(void)
+{
+	return blockKernel;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		printable name of the kernel
+ */
+const char *crc16_ccitt_kernel_name(enum crc16Kernel kernel)
+{
+	if((uint32_t) kernel > CRC16_KERNEL_AUTO)
+		return "?";
+	return kernelName[kernel];
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
@@ -0,0 +1,50 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: crc16Block.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Block-wise CRC16-CCITT, see crc16Block.c.
+ *
+ *****************************************************************************/
+
+#ifndef CRC16BLOCK_H_
+#define CRC16BLOCK_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+
+#include "crc16Lookup.h"
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+/* Implementations behind crc16_ccitt_block(). */
+enum crc16Kernel{
+	CRC16_KERNEL_BYTE,  /* one table lookup per byte, CRC16_CCITT_TABLE */
+	CRC16_KERNEL_SLICE4,  /* 4 bytes per step */
+	CRC16_KERNEL_SLICE8,  /* 8 bytes per step */
+	CRC16_KERNEL_CLMUL,  /* carry-less multiply folding (x86 PCLMULQDQ) */
+	CRC16_KERNEL_AUTO,  /* fastest kernel supported by the CPU */
+};
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+extern uint16_t crc16_ccitt_block(const void *, uint32_t, uint16_t);
+extern int32_t crc16_ccitt_select(enum crc16Kernel);
+extern enum crc16Kernel crc16_ccitt_kernel(void);
+extern const char *crc16_ccitt_kernel_name(enum crc16Kernel);
+
+
+#endif /* CRC16BLOCK_H_ */
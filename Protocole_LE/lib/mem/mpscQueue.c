@@ -0,0 +1,331 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		:
+ * File			: mpscQueue.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Multi producer / single consumer variant of the xQueue, for queues
+ * 		any number of threads push to and one thread reads from on a host,
+ * 		e.g. the event queues of the AOs (AOK_MPSC, lib/stm/aok.c). Neither
+ * 		side takes a lock. The slots carry a sequence number telling whose
+ * 		turn it is (bounded queue of D. Vyukov):
+ * 			seq == pos				free, the producer of round pos may fill it
+ * 			seq == pos + 1			filled, the consumer may read it
+ * 			seq == pos + len		consumed, free for the next round
+ *
+ * 		A producer claims a slot by moving the head counter forward with a
+ * 		CAS, writes it and hands it over by storing the sequence number. The
+ * 		consumer only looks at the sequence number of the tail slot, so get,
+ * 		consume and empty are wait-free: no loop, no CAS.
+ *
+ * 		Differences to the spscQueue:
+ * 		 - The sequence numbers are kept in a separate array of len words,
+ * 		   given to mpscQueue_init().
+ * 		 - A slot claimed but not yet published blocks the slots behind it:
+ * 		   the consumer sees the queue empty until the slow producer is done,
+ * 		   even if later slots are published already. Anybody waiting for
+ * 		   the queue must therefore be told by every producer after its
+ * 		   publish, not only by the first one.
+ * 		 - mpscQueue_reserve() returns a ticket for mpscQueue_publish(), as
+ * 		   several slots may be reserved at once.
+ * 		 - mpscQueue_push_unique() checks the queued elements without a
+ * 		   lock. Unique pushes must be serialized among themselves by the
+ * 		   caller, plain pushes may run concurrently to them.
+ * 		 - The producers count rejected pushes and lost head claims, the
+ * 		   latter tells how contended the queue is.
+ *
+ * Example:
+ * 		static x_t myBuf[16];
+ * 		static uint32_t mySeq[16];
+ * 		static struct mpscQueue q;
+ *
+ * 		mpscQueue_init(&q, myBuf, mySeq, 16, sizeof(x_t));
+ *
+ * 		producers:	uint32_t ticket;
+ * 					x_t *p = mpscQueue_reserve(&q, &ticket);
+ * 					if(p){ fill(p); mpscQueue_publish(&q, ticket); }
+ * 		consumer:	x_t *p;
+ * 					while(!mpscQueue_get(&q, (void **) &p)){
+ * 						use(p);
+ * 						mpscQueue_consume(&q);
+ * 					}
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "lib/mem/mpscQueue.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define LOAD_ACQUIRE(x)			__atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(x, v)		__atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define LOAD_RELAXED(x)			__atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+#define SLOT(c, idx)			((void *)((uint8_t *)(c)->buffer + \
+									((idx) & (c)->mask) * (c)->bSize))
+#define SEQ(c, idx)				((c)->seq[(idx) & (c)->mask])
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Initialize the queue.
+ *
+ * Argument:	c			pointer to mpscQueue object
+ * 				buf			pointer to buffer memory
+ * 				seq			pointer to the sequence numbers, len words
+ * 				len			number of slots the buffer memory is reserved for
+ * 				slotSize	number of bytes for a single slot
+ * Return:		err		 0 success
+ * 						-1 the number of slots must be a power of two
+ */
+int32_t mpscQueue_init(struct mpscQueue *c, void *buf, uint32_t *seq,
+						uint32_t len, uint32_t slotSize)
+{
+	if(len == 0 || (len & (len - 1)))
+		return -1;
+	c->buffer = buf;
+	c->seq = seq;
+	c->mask = len - 1;
+	c->bSize = slotSize;
+	c->prod.nDropped = 0;
+	c->prod.nRetries = 0;
+	mpscQueue_reset(c);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Empties the queue. Nobody else may use the queue meanwhile.
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ */
+void mpscQueue_reset(struct mpscQueue *c)
+{
+	uint32_t i;
+
+	for(i=0; i<=c->mask; i++)
+		c->seq[i] = i;
+	c->prod.head = 0;
+	STORE_RELEASE(c->cons.tail, 0);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Claims the next free slot without adding it to the queue. The slot is
+ * added with mpscQueue_publish() once it has been written.
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ * 				ticket	set to the position of the slot, for the publish
+ * Return:		pointer to the slot, NULL if the queue is full
+ */
+void *mpscQueue_reserve(struct mpscQueue *c, uint32_t *ticket)
+{
+	uint32_t head = LOAD_RELAXED(c->prod.head);
+	int32_t dif;
+
+	while(1){
+		dif = (int32_t)(LOAD_ACQUIRE(SEQ(c, head)) - head);
+		if(dif == 0){
+			/* free, on failure head is reloaded by the CAS */
+			if(__atomic_compare_exchange_n(&c->prod.head, &head, head + 1,
+					false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+			__atomic_add_fetch(&c->prod.nRetries, 1, __ATOMIC_RELAXED);
+		}else if(dif < 0){
+			/* slot of the previous round not consumed yet */
+			__atomic_add_fetch(&c->prod.nDropped, 1, __ATOMIC_RELAXED);
+			return NULL;
+		}else{
+			/* claimed by another producer meanwhile */
+			head = LOAD_RELAXED(c->prod.head);
+		}
+	}
+	*ticket = head;
+	return SLOT(c, head);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Adds the slot returned by mpscQueue_reserve() to the queue.
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ * 				ticket	the ticket of the reserve
+ */
+void mpscQueue_publish(struct mpscQueue *c, uint32_t ticket)
+{
+	STORE_RELEASE(SEQ(c, ticket), ticket + 1);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Add element to the head of the queue.
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ * 				src 	pointer to data which will be copied into queue. Number
+ * 						of bytes to copy is held in c.bSize
+ * Return:		err		 0 success
+ * 						-1 buffer full
+ */
+int32_t mpscQueue_push(struct mpscQueue *c, const void *src)
+{
+	uint32_t ticket;
+	void *dest = mpscQueue_reserve(c, &ticket);
+
+	if(dest == NULL)
+		return -1;
+	memcpy(dest, src, c->bSize);
+	mpscQueue_publish(c, ticket);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Add element to the head of the queue unless an equal element is queued.
+ * The published slots are compared while the consumer may take them: an
+ * element only counts if its sequence number is the same before and after
+ * the compare. Elements still being pushed are not seen, hence unique pushes
+ * must be serialized by the caller.
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ * 				src 	pointer to data which will be copied into queue
+ * 				equal	compare function, NULL to compare all bytes
+ * Return:		err		 0 success
+ * 						-1 buffer full
+ * 						-2 an equal element is queued, nothing pushed
+ */
+int32_t mpscQueue_push_unique(struct mpscQueue *c, const void *src,
+								mpscQueueEqual_t equal)
+{
+	uint32_t pos = LOAD_ACQUIRE(c->cons.tail);
+	uint32_t head = LOAD_ACQUIRE(c->prod.head);
+	uint32_t s;
+	bool found;
+
+	/* the consumer may have gone a round meanwhile */
+	if(head - pos > c->mask + 1)
+		pos = head - (c->mask + 1);
+	for(; pos!=head; pos++){
+		s = LOAD_ACQUIRE(SEQ(c, pos));
+		if(s != pos + 1)
+			continue;  /* being pushed or consumed */
+		found = equal ? (*equal)(SLOT(c, pos), src)
+				: !memcmp(SLOT(c, pos), src, c->bSize);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(found && LOAD_RELAXED(SEQ(c, pos)) == s)
+			return -2;
+	}
+	return mpscQueue_push(c, src);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Get an element from the tail of the queue but leave it on the queue.
+ * To be called by the consumer only.
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ * 				pData	address of the pointer which will be set to the
+ * 						beginning of the element in the queue.
+ * Return:		err		 0 success
+ * 						-1 queue empty (or the tail slot not published yet)
+ */
+int32_t mpscQueue_get(struct mpscQueue *c, void **pData)
+{
+	uint32_t tail = c->cons.tail;
+
+	if(LOAD_ACQUIRE(SEQ(c, tail)) != tail + 1)
+		return -1;
+	*pData = SLOT(c, tail);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Remove an element from the tail of the queue. To be used together with
+ * mpscQueue_get().
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ * Return:		err		 0 success
+ * 						-1 queue empty
+ */
+int32_t mpscQueue_consume(struct mpscQueue *c)
+{
+	uint32_t tail = c->cons.tail;
+
+	if(LOAD_ACQUIRE(SEQ(c, tail)) != tail + 1)
+		return -1;
+	/* free for the producer of the next round */
+	STORE_RELEASE(SEQ(c, tail), tail + c->mask + 1);
+	STORE_RELEASE(c->cons.tail, tail + 1);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Get and remove an element from the tail of the queue. To be called by the
+ * consumer only.
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ * 				dest	address where queue content is copied to.
+ * Return:		err		 0 success
+ * 						-1 queue empty
+ */
+int32_t mpscQueue_pop(struct mpscQueue *c, void *dest)
+{
+	void *src;
+
+	if(mpscQueue_get(c, &src))
+		return -1;
+	memcpy(dest, src, c->bSize);
+	return mpscQueue_consume(c);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Tells whether the consumer would get an element. To be called by the
+ * consumer only.
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ * Return:		true if mpscQueue_get() would fail
+ */
+bool mpscQueue_empty(struct mpscQueue *c)
+{
+	uint32_t tail = c->cons.tail;
+
+	return LOAD_ACQUIRE(SEQ(c, tail)) != tail + 1;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Returns number of used slots in the queue, including the ones claimed but
+ * not yet published. The result is only a snapshot.
+ *
+ * Argument:	c		pointer to mpscQueue object.
+ * Return:		number of elements on the queue.
+ */
+uint32_t mpscQueue_load(struct mpscQueue *c)
+{
+	uint32_t tail = LOAD_ACQUIRE(c->cons.tail);
+	uint32_t head = LOAD_ACQUIRE(c->prod.head);
+
+	return head - tail;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
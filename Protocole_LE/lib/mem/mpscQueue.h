@@ -0,0 +1,75 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		:
+ * File			: mpscQueue.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ *
+ *****************************************************************************/
+
+#ifndef SOURCE_LIB_MEM_MPSCQUEUE_H_
+#define SOURCE_LIB_MEM_MPSCQUEUE_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+/* Producer and consumer fields are kept on separate cache lines. */
+#define MPSC_CACHE_LINE			64
+
+/******************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+/* Elements are equal for mpscQueue_push_unique(), NULL: all bytes. */
+typedef bool (*mpscQueueEqual_t)(const void *, const void *);
+
+struct mpscQueue{
+	struct{
+		uint32_t head;  /* head counter, free running, claimed by CAS */
+		uint32_t nDropped;  /* pushes rejected since the queue was full */
+		uint32_t nRetries;  /* head claims lost to another producer */
+	}prod __attribute__((aligned(MPSC_CACHE_LINE)));
+	struct{
+		uint32_t tail;  /* tail counter, free running */
+	}cons __attribute__((aligned(MPSC_CACHE_LINE)));
+	void *buffer;  /* pointer to the buffer */
+	uint32_t *seq;  /* sequence number of each slot */
+	uint32_t mask;  /* maximal number of elements - 1 */
+	uint32_t bSize;  /* byte size. Size of each element in bytes */
+};
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+extern int32_t mpscQueue_init(struct mpscQueue *, void *, uint32_t *,
+								uint32_t, uint32_t);
+extern void mpscQueue_reset(struct mpscQueue *);
+/* producer side, any number of threads */
+extern int32_t mpscQueue_push(struct mpscQueue *, const void *);
+extern int32_t mpscQueue_push_unique(struct mpscQueue *, const void *,
+										mpscQueueEqual_t);
+extern void *mpscQueue_reserve(struct mpscQueue *, uint32_t *);
+extern void mpscQueue_publish(struct mpscQueue *, uint32_t);
+/* consumer side */
+extern int32_t mpscQueue_pop(struct mpscQueue *, void *);
+extern int32_t mpscQueue_get(struct mpscQueue *, void **);
+extern int32_t mpscQueue_consume(struct mpscQueue *);
+extern bool mpscQueue_empty(struct mpscQueue *);
+/* any side */
+extern uint32_t mpscQueue_load(struct mpscQueue *);
+
+
+#endif /* SOURCE_LIB_MEM_MPSCQUEUE_H_ */
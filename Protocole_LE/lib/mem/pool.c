@@ -11,8 +11,18 @@
  *
  ******************************************************************************
  * Description:
- * 
- * 
+ * 		Segregated fit allocator on top of an array of buckets. A memory slot
+ * 		consists out of one or more contiguous buckets. Free slots are kept in
+ * 		doubly linked lists by size class, two levels of bitmaps tell which
+ * 		lists aren't empty: the first level splits the sizes in powers of 2,
+ * 		the second level each power of 2 in POOL_SL_COUNT linear steps. A
+ * 		slot is found with two find first set operations, the rest of it is
+ * 		given back as a free slot. A released slot is merged with its free
+ * 		neighbours, so there are never two adjacent free slots.
+ *
+ * 		The free list links live in the free slots themselves, the size of a
+ * 		free slot is repeated in its last two bytes to find the start of the
+ * 		previous slot when merging.
  *****************************************************************************/
 
 /******************************************************************************
@@ -29,17 +39,39 @@
  *****************************************************************************/
 /* The header defining an allocated memory slot. A memory slot consists out of
  * one or more buckets, where a header is found at the beginning of the memory
- * slot. */
-#define BUCKET_HEADER_SIZE		4
+ * slot. It may be larger than struct bucket, see POOL_HEADER_SIZE. */
+#define BUCKET_HEADER_SIZE		POOL_HEADER_SIZE
+
+#define BUCKET_NONE				0xffff
+
+/* Flags of the bucket header. */
+#define BUCKET_FREE				0x01
+#define BUCKET_PREV_FREE		0x02
 
 /* Header added to the very beginning of the allocated memory. */
 struct bucket{
-	uint8_t size;
+	uint16_t size;  /* Size of the slot in buckets. */
 	uint8_t refCnt;
-	uint8_t idx;
-	void *data;
+	uint8_t flags;
+};
+
+/* A free slot, the links follow the header. */
+struct freeBucket{
+	struct bucket h;
+	uint16_t next;
+	uint16_t prev;
 };
 
+#define BUCKET(self, idx)	\
+	((struct bucket *) ((self)->mem + ((uint32_t) (idx) << (self)->bucketSizeShift)))
+#define FREE_BUCKET(self, idx)	((struct freeBucket *) BUCKET(self, idx))
+#define BUCKET_IDX(self, b)	\
+	((uint16_t) (((uint8_t *) (b) - (self)->mem) >> (self)->bucketSizeShift))
+
+/* Index of the most significant bit set, x must not be 0. */
+#define FLS(x)				(31 - __builtin_clz(x))
+#define FFS(x)				__builtin_ctz(x)
+
 /******************************************************************************
  * FILE SCOPE VARIABLES
  *****************************************************************************/
@@ -49,11 +81,155 @@ struct bucket{
 /******************************************************************************
  * PROTOTYPES (LOCAL)
  *****************************************************************************/
+static void mapping(uint32_t, uint8_t *, uint8_t *);
+static void set_footer(struct pool *, uint16_t, uint16_t);
+static void insert_free(struct pool *, uint16_t, uint16_t);
+static void remove_free(struct pool *, uint16_t);
+static uint16_t find_free(struct pool *, uint32_t);
 
 /******************************************************************************
  * SUBROUTINES (LOCAL)
  *****************************************************************************/
 #if(1)	/* code folding trick */
+
+/*
+ * Size class of a slot.
+ *
+ * Argument:	n		Size of the slot in buckets.
+ * 				fl		Returns the first level index.
+ * 				sl		Returns the second level index.
+ */
+static void mapping(uint32_t n, uint8_t *fl, uint8_t *sl)
+{
+	int32_t f;
+
+	if(n < POOL_SL_COUNT){
+		*fl = 0;
+		*sl = (uint8_t) n;
+	}
+	else{
+		f = FLS(n);
+		*fl = (uint8_t) (f - POOL_SL_SHIFT + 1);
+		*sl = (uint8_t) ((n >> (f - POOL_SL_SHIFT)) ^ POOL_SL_COUNT);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Writes the size of a free slot to its last two bytes.
+ */
+static void set_footer(struct pool *self, uint16_t idx, uint16_t size)
+{
+	uint8_t *end;
+	uint16_t *footer;
+
+	end = (uint8_t *) BUCKET(self, idx + size);
+	footer = (uint16_t *) (end - sizeof(uint16_t));
+	*footer = size;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Marks a slot as free and adds it to the head of its list.
+ *
+ * Argument:	self	Pointer to pool object.
+ * 				idx		First bucket of the slot.
+ * 				size	Size of the slot in buckets.
+ */
+static void insert_free(struct pool *self, uint16_t idx, uint16_t size)
+{
+	uint8_t fl, sl;
+	uint16_t next;
+	struct freeBucket *b;
+
+	mapping(size, &fl, &sl);
+	next = self->freeList[fl][sl];
+	b = FREE_BUCKET(self, idx);
+	b->h.size = size;
+	b->h.refCnt = 0;
+	b->h.flags = (b->h.flags & BUCKET_PREV_FREE) | BUCKET_FREE;
+	b->next = next;
+	b->prev = BUCKET_NONE;
+	if(next != BUCKET_NONE)
+		FREE_BUCKET(self, next)->prev = idx;
+	self->freeList[fl][sl] = idx;
+	self->slBitmap[fl] |= (1 << sl);
+	self->flBitmap |= (1 << fl);
+	set_footer(self, idx, size);
+
+	/* Tell the following slot. */
+	if((uint32_t) idx + size < self->nBuckets)
+		BUCKET(self, idx + size)->flags |= BUCKET_PREV_FREE;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Takes a free slot out of its list. The flags are left to the caller.
+ */
+static void remove_free(struct pool *self, uint16_t idx)
+{
+	uint8_t fl, sl;
+	struct freeBucket *b;
+
+	b = FREE_BUCKET(self, idx);
+	if(b->next != BUCKET_NONE)
+		FREE_BUCKET(self, b->next)->prev = b->prev;
+	if(b->prev != BUCKET_NONE){
+		FREE_BUCKET(self, b->prev)->next = b->next;
+	}
+	else{
+		mapping(b->h.size, &fl, &sl);
+		self->freeList[fl][sl] = b->next;
+		if(b->next == BUCKET_NONE){
+			self->slBitmap[fl] &= ~(1 << sl);
+			if(self->slBitmap[fl] == 0)
+				self->flBitmap &= ~(1 << fl);
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Looks for a free slot of at least n buckets. The size is rounded up to the
+ * next size class, so that every slot of the list found is large enough. If
+ * there is none, the list of the own class is searched first fit, it may hold
+ * a slot large enough (e.g. the whole pool).
+ *
+ * Return:		Index of the slot or BUCKET_NONE.
+ */
+static uint16_t find_free(struct pool *self, uint32_t n)
+{
+	uint8_t fl, sl;
+	uint32_t slMap, flMap, m;
+	uint16_t idx;
+
+	m = n;
+	if(m >= POOL_SL_COUNT)
+		m += (1 << (FLS(m) - POOL_SL_SHIFT)) - 1;
+	mapping(m, &fl, &sl);
+	if(fl < POOL_FL_COUNT){
+		slMap = self->slBitmap[fl] & (~0u << sl);
+		if(slMap == 0){
+			flMap = self->flBitmap & (~0u << (fl + 1));
+			if(flMap != 0){
+				fl = FFS(flMap);
+				slMap = self->slBitmap[fl];
+			}
+		}
+		if(slMap != 0)
+			return self->freeList[fl][FFS(slMap)];
+	}
+
+	mapping(n, &fl, &sl);
+	for(idx=self->freeList[fl][sl]; idx!=BUCKET_NONE;
+			idx=FREE_BUCKET(self, idx)->next){
+		if(BUCKET(self, idx)->size >= n)
+			return idx;
+	}
+	return BUCKET_NONE;
+}
+/*---------------------------------------------------------------------------*/
+
 #endif	/* end code folding */
 
 /******************************************************************************
@@ -66,27 +242,34 @@ struct bucket{
  *
  * Argument:	self	Pointer to pool object.
  * 				mem		Pointer to memory, which will be used for pool_alloc().
- * 				nBuckets  Number of buckets. Maximal 32.
- * 				bucketSizeShift  Bucket size in bytes as power of 2.
+ * 				nBuckets  Number of buckets. Maximal POOL_MAX_BUCKETS.
+ * 				bucketSizeShift  Bucket size in bytes as power of 2. Minimal
+ * 						POOL_MIN_BUCKET_SIZE_S.
  * Return:		 0		success.
  * 				-1		self must not be a NULL pointer.
  * 				-2		mem must not be a NULL pointer.
- * 				-3		nBuckets must not exceed 32.
+ * 				-3		nBuckets must be between 1 and POOL_MAX_BUCKETS.
+ * 				-4		bucketSizeShift too small.
  */
 int32_t pool_init(struct pool *self, void *mem,
-					uint8_t nBuckets,
+					uint16_t nBuckets,
 					uint8_t bucketSizeShift)
 {
 	if(self == NULL)
 		return -1;
 	if(mem == NULL)
 		return -2;
-	if(nBuckets > 32)
+	if((nBuckets == 0) || (nBuckets > POOL_MAX_BUCKETS))
 		return -3;
+	if(bucketSizeShift < POOL_MIN_BUCKET_SIZE_S)
+		return -4;
 	self->mem = (uint8_t *) mem;
 	self->nBuckets = nBuckets;
 	self->bucketSizeShift = bucketSizeShift;
-	self->activeBuckets = 0;
+	self->highWater = 0;
+	self->nAllocs = 0;
+	self->nFails = 0;
+	pool_clear(self);
 	return 0;
 }
 /*---------------------------------------------------------------------------*/
@@ -96,61 +279,91 @@ int32_t pool_init(struct pool *self, void *mem,
  *
  * Argument:	self	Pointer to pool object.
  * 				size	Number of bytes to allocate.
- * Return:		Pointer to allocated memory.
+ * Return:		Pointer to allocated memory, NULL if there is no free slot
+ * 				large enough.
  */
 void *pool_alloc(struct pool *self, uint32_t size)
 {
-	int32_t i;
-	uint32_t mask;
 	uint32_t nBucketsNeeded;
-	uint32_t bucketSize;
+	uint16_t idx, rest;
 	struct bucket *bucket;
-	void *ret = NULL;
-
-	nBucketsNeeded = 1;
-	bucketSize = 1 << self->bucketSizeShift;
-	if(size > (bucketSize - BUCKET_HEADER_SIZE)){
-		size -= (bucketSize - BUCKET_HEADER_SIZE);
-		nBucketsNeeded += (size >> self->bucketSizeShift);
-		if(size & (bucketSize-1))
-			nBucketsNeeded++;
+
+	if(size > ((uint32_t) self->nBuckets << self->bucketSizeShift)){
+		self->nFails++;
+		return NULL;
 	}
-	mask = (1 << nBucketsNeeded) - 1;
-	for(i=0; i<(self->nBuckets - nBucketsNeeded); i++){
-		if(!(self->activeBuckets & mask)){
-			self->activeBuckets |= mask;
-			bucket = (struct bucket *) (self->mem + i * bucketSize);
-			bucket->size = nBucketsNeeded;
-			bucket->idx = i;
-			bucket->refCnt = 1;
-			ret = &bucket->data;
-			break;
-		}
-		mask <<= 1;
+	nBucketsNeeded = (size + BUCKET_HEADER_SIZE + (1 << self->bucketSizeShift) - 1)
+			>> self->bucketSizeShift;
+
+	idx = find_free(self, nBucketsNeeded);
+	if(idx == BUCKET_NONE){
+		self->nFails++;
+		return NULL;
+	}
+	remove_free(self, idx);
+	bucket = BUCKET(self, idx);
+
+	/* Give back the rest of the slot. Its following slot is in use, so
+	 * there is nothing to merge. */
+	rest = bucket->size - nBucketsNeeded;
+	if(rest != 0){
+		BUCKET(self, idx + nBucketsNeeded)->flags = 0;
+		insert_free(self, idx + nBucketsNeeded, rest);
+	}
+	else if((uint32_t) idx + bucket->size < self->nBuckets){
+		BUCKET(self, idx + bucket->size)->flags &= ~BUCKET_PREV_FREE;
 	}
-	return ret;
+
+	bucket->size = nBucketsNeeded;
+	bucket->refCnt = 1;
+	bucket->flags &= ~BUCKET_FREE;
+
+	self->usedBuckets += nBucketsNeeded;
+	if(self->usedBuckets > self->highWater)
+		self->highWater = self->usedBuckets;
+	self->nAllocs++;
+	return (uint8_t *) bucket + BUCKET_HEADER_SIZE;
 }
 /*---------------------------------------------------------------------------*/
 
 /*
- * Release allocated memory.
+ * Release allocated memory. The slot is given back when the reference
+ * counter drops to 0.
  *
  * Argument:	self	Pointer to pool object.
  * 				mem		Pointer to allocated memory.
  */
 void pool_free(struct pool *self, void *mem)
 {
-	uint32_t mask;
-	uint8_t *d;
+	uint16_t idx, size, prevSize, next;
+	uint16_t *footer;
 	struct bucket *bucket;
 
 	if(mem != NULL){
-		d = (uint8_t *) mem;
-		bucket = (struct bucket *) (d - BUCKET_HEADER_SIZE);
+		bucket = (struct bucket *) ((uint8_t *) mem - BUCKET_HEADER_SIZE);
 		bucket->refCnt--;
 		if(bucket->refCnt == 0){
-			mask = ((1 << bucket->size) - 1) << bucket->idx;
-			self->activeBuckets &= ~mask;
+			idx = BUCKET_IDX(self, bucket);
+			size = bucket->size;
+			self->usedBuckets -= size;
+
+			/* Merge with the following slot. */
+			next = idx + size;
+			if((next < self->nBuckets) && (BUCKET(self, next)->flags & BUCKET_FREE)){
+				remove_free(self, next);
+				size += BUCKET(self, next)->size;
+			}
+
+			/* Merge with the previous slot, its size is found at its end. */
+			if(bucket->flags & BUCKET_PREV_FREE){
+				footer = (uint16_t *) ((uint8_t *) bucket - sizeof(uint16_t));
+				prevSize = *footer;
+				idx -= prevSize;
+				size += prevSize;
+				remove_free(self, idx);
+			}
+
+			insert_free(self, idx, size);
 		}
 	}
 }
@@ -174,6 +387,63 @@ void pool_get(void *mem)
 }
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Size of an allocated slot.
+ *
+ * Argument:	mem		Pointer to allocated memory.
+ * Return:		Size of the slot in buckets.
+ */
+uint16_t pool_buckets(void *mem)
+{
+	struct bucket *bucket;
+
+	bucket = (struct bucket *) ((uint8_t *) mem - BUCKET_HEADER_SIZE);
+	return bucket->size;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Same as pool_get(), for slots shared between threads.
+ *
+ * Argument:	mem		Pointer to allocated memory.
+ */
+void pool_get_atomic(void *mem)
+{
+	struct bucket *bucket;
+
+	if(mem != NULL){
+		bucket = (struct bucket *) ((uint8_t *) mem - BUCKET_HEADER_SIZE);
+		__atomic_fetch_add(&bucket->refCnt, 1, __ATOMIC_RELAXED);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Drops a reference of a slot shared between threads. The last reference is
+ * not dropped, the slot is handed back to the caller instead: it still has
+ * a reference counter of 1 and can either be reused as it is or be given
+ * back with pool_free().
+ *
+ * Argument:	mem		Pointer to allocated memory.
+ * Return:		true	mem was the last reference.
+ * 				false	the slot is still referenced.
+ */
+bool pool_put_atomic(void *mem)
+{
+	uint8_t cnt;
+	struct bucket *bucket;
+
+	bucket = (struct bucket *) ((uint8_t *) mem - BUCKET_HEADER_SIZE);
+	cnt = __atomic_load_n(&bucket->refCnt, __ATOMIC_ACQUIRE);
+	while(cnt > 1){
+		if(__atomic_compare_exchange_n(&bucket->refCnt, &cnt, cnt - 1, true,
+				__ATOMIC_RELEASE, __ATOMIC_ACQUIRE))
+			return false;
+	}
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+
 /*
  * Sets all buckets to empty state.
  *
@@ -181,7 +451,49 @@ void pool_get(void *mem)
  */
 void pool_clear(struct pool *self)
 {
-	self->activeBuckets = 0;
+	memset(self->freeList, 0xff, sizeof(self->freeList));
+	memset(self->slBitmap, 0, sizeof(self->slBitmap));
+	self->flBitmap = 0;
+	self->usedBuckets = 0;
+	BUCKET(self, 0)->flags = 0;
+	insert_free(self, 0, self->nBuckets);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Collects the statistics of the pool. Walks all slots, not meant to be
+ * called on every allocation.
+ *
+ * Argument:	self	Pointer to pool object.
+ * 				stats	Returns the statistics.
+ */
+void pool_stats(struct pool *self, struct poolStats *stats)
+{
+	uint32_t idx;
+	uint32_t freeBuckets;
+	struct bucket *bucket;
+
+	memset(stats, 0, sizeof(*stats));
+	freeBuckets = 0;
+	for(idx=0; idx<self->nBuckets; idx+=bucket->size){
+		bucket = BUCKET(self, idx);
+		if(bucket->flags & BUCKET_FREE){
+			stats->nFree++;
+			freeBuckets += bucket->size;
+			if(bucket->size > stats->largestFree)
+				stats->largestFree = bucket->size;
+		}
+		else{
+			stats->nUsed++;
+		}
+	}
+	stats->nBuckets = self->nBuckets;
+	stats->usedBuckets = self->usedBuckets;
+	stats->highWater = self->highWater;
+	if(freeBuckets != 0)
+		stats->fragmentation = (uint16_t) (1000 - (1000 * stats->largestFree) / freeBuckets);
+	stats->nAllocs = self->nAllocs;
+	stats->nFails = self->nFails;
 }
 /*---------------------------------------------------------------------------*/
 
@@ -21,11 +21,34 @@
 /******************************************************************************
  * INCLUDES
  *****************************************************************************/
-
+#include <stdint.h>
+#include <stdbool.h>
 
 /******************************************************************************
  * DEFINES
  *****************************************************************************/
+/* Size of the header in front of the memory of an allocated slot. A slot of
+ * n buckets holds (n << bucketSizeShift) - POOL_HEADER_SIZE bytes. On the
+ * host the memory of a slot is aligned for pointers and 64-bit members if
+ * the pool memory is. */
+#ifdef AOK_HOST
+#define POOL_HEADER_SIZE		8
+#else
+#define POOL_HEADER_SIZE		4
+#endif
+
+/* Maximal number of buckets of a pool. */
+#define POOL_MAX_BUCKETS		0xfffe
+
+/* Smallest bucket size as power of 2, a free slot has to hold its header,
+ * the free list links and the size at its end. */
+#define POOL_MIN_BUCKET_SIZE_S	4
+
+/* Free slots are kept in segregated lists: POOL_FL_COUNT size classes of
+ * powers of 2, each split into (1 << POOL_SL_SHIFT) linear sub classes. */
+#define POOL_SL_SHIFT			2
+#define POOL_SL_COUNT			(1 << POOL_SL_SHIFT)
+#define POOL_FL_COUNT			(16 - POOL_SL_SHIFT + 1)
 
 /******************************************************************************
  * MACROS
@@ -37,23 +60,47 @@
 /* The pool object.
  * Memory allocation for the mem pointer should be done like this:
  * 		uint8_t poolMemory[nBuckets * (1 << bucketSizeShift)];
- * Use pool_init() to initialize the fields of the pool object.
+ * Use pool_init() to initialize the fields of the pool object. On the host
+ * the memory has to be 8-byte aligned, e.g. an array of uint64_t.
  */
 struct pool{
 	uint8_t *mem;
-	uint32_t activeBuckets;  /* A bit field telling whether bucket is used. */
-	uint8_t nBuckets;  /* Number of buckets. */
+	uint16_t nBuckets;  /* Number of buckets. */
 	uint8_t bucketSizeShift;  /* The bucket size in bytes as power of 2. */
+	uint16_t flBitmap;  /* A bit per first level class with free slots. */
+	uint8_t slBitmap[POOL_FL_COUNT];  /* A bit per second level class. */
+	uint16_t freeList[POOL_FL_COUNT][POOL_SL_COUNT];  /* Bucket index. */
+	uint16_t usedBuckets;
+	uint16_t highWater;  /* Maximal number of used buckets. */
+	uint32_t nAllocs;
+	uint32_t nFails;  /* Allocations without a large enough free slot. */
+};
+
+/* Statistics of a pool, see pool_stats(). */
+struct poolStats{
+	uint16_t nBuckets;
+	uint16_t usedBuckets;
+	uint16_t highWater;
+	uint16_t nUsed;  /* Number of allocated slots. */
+	uint16_t nFree;  /* Number of free slots. */
+	uint16_t largestFree;  /* Largest free slot in buckets. */
+	uint16_t fragmentation;  /* 1000 - 1000 * largestFree / free buckets. */
+	uint32_t nAllocs;
+	uint32_t nFails;
 };
 
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
-extern int32_t pool_init(struct pool *, void *, uint8_t, uint8_t);
+extern int32_t pool_init(struct pool *, void *, uint16_t, uint8_t);
 extern void *pool_alloc(struct pool *, uint32_t);
 extern void pool_free(struct pool *, void *);
 extern void pool_get(void *);
 extern void pool_clear(struct pool *);
+extern void pool_stats(struct pool *, struct poolStats *);
+extern uint16_t pool_buckets(void *);
+extern void pool_get_atomic(void *);
+extern bool pool_put_atomic(void *);
 
 
 #endif /* SOURCE_LIB_MEM_POOL_H_ */
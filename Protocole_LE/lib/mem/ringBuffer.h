@@ -0,0 +1,285 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: ringBuffer.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Typed ring buffer for C++, header only. It does the job of xQueue,
+ * 		ucQueue, usQueue, cBuf and usBuf with the element type and the length
+ * 		known at compile time:
+ * 		 -	The length is a power of 2, head and tail are free running 32-bit
+ * 		 	counters masked on access. There is neither a full flag nor a
+ * 		 	wrap-around branch, and no limit of 127 or 255 elements.
+ * 		 -	Elements are copied by assignment, a push of an event is a
+ * 		 	structure copy instead of a memcpy() of a runtime size.
+ * 		 -	push()/pop() of n elements and the read/write spans move whole
+ * 		 	frames with at most two copies.
+ * 		 -	With RING_SPSC, one producer and one consumer thread may use the
+ * 		 	buffer at the same time without lock (acquire/release on the
+ * 		 	counters). RING_UNSYNC is for a single context or for callers
+ * 		 	doing their own locking.
+ *
+ * 		C code reaches a ring through the shim functions declared with
+ * 		RING_BUFFER_SHIM_DECLARE() and defined in a C++ file with
+ * 		RING_BUFFER_SHIM_DEFINE(), which follow the xQueue conventions
+ * 		(0 success, -1 full/empty).
+ *
+ * Example:
+ * 		static RingBuffer<struct event, 64, RING_SPSC> q;
+ *
+ * 		q.push(e);
+ * 		while(q.pop(e))
+ * 			handle(&e);
+ *
+ *****************************************************************************/
+
+#ifndef SOURCE_LIB_MEM_RINGBUFFER_H_
+#define SOURCE_LIB_MEM_RINGBUFFER_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+
+#ifdef __cplusplus
+#include <atomic>
+#include <type_traits>
+#endif
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+/* Declares the C shim of a ring named name, e.g. in a C header:
+ * 		RING_BUFFER_SHIM_DECLARE(rxFrames, struct frame)
+ * 		err = rxFrames_push(&f);
+ */
+#ifdef __cplusplus
+#define RING_BUFFER_SHIM_EXTERN		extern "C"
+#else
+#define RING_BUFFER_SHIM_EXTERN		extern
+#endif
+
+#define RING_BUFFER_SHIM_DECLARE(name, type)	\
+	RING_BUFFER_SHIM_EXTERN int32_t name##_push(const type *);	\
+	RING_BUFFER_SHIM_EXTERN uint32_t name##_push_n(const type *, uint32_t);	\
+	RING_BUFFER_SHIM_EXTERN int32_t name##_pop(type *);	\
+	RING_BUFFER_SHIM_EXTERN uint32_t name##_pop_n(type *, uint32_t);	\
+	RING_BUFFER_SHIM_EXTERN int32_t name##_get(type **);	\
+	RING_BUFFER_SHIM_EXTERN int32_t name##_consume(void);	\
+	RING_BUFFER_SHIM_EXTERN uint32_t name##_load(void);	\
+	RING_BUFFER_SHIM_EXTERN void name##_reset(void);
+
+/* Defines the ring and its C shim in a C++ file. mode is RING_UNSYNC or
+ * RING_SPSC. */
+#define RING_BUFFER_SHIM_DEFINE(name, type, len, mode)	\
+	static RingBuffer<type, len, mode> name##_ring;	\
+	RING_BUFFER_SHIM_EXTERN int32_t name##_push(const type *src)	\
+	{ return name##_ring.push(*src) ? 0 : -1; }	\
+	RING_BUFFER_SHIM_EXTERN uint32_t name##_push_n(const type *src, uint32_t n)	\
+	{ return name##_ring.push(src, n); }	\
+	RING_BUFFER_SHIM_EXTERN int32_t name##_pop(type *dest)	\
+	{ return name##_ring.pop(*dest) ? 0 : -1; }	\
+	RING_BUFFER_SHIM_EXTERN uint32_t name##_pop_n(type *dest, uint32_t n)	\
+	{ return name##_ring.pop(dest, n); }	\
+	RING_BUFFER_SHIM_EXTERN int32_t name##_get(type **pData)	\
+	{ return (*pData = name##_ring.front()) != nullptr ? 0 : -1; }	\
+	RING_BUFFER_SHIM_EXTERN int32_t name##_consume(void)	\
+	{ return name##_ring.consume(1) == 1 ? 0 : -1; }	\
+	RING_BUFFER_SHIM_EXTERN uint32_t name##_load(void)	\
+	{ return name##_ring.size(); }	\
+	RING_BUFFER_SHIM_EXTERN void name##_reset(void)	\
+	{ name##_ring.clear(); }
+
+/******************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+#ifdef __cplusplus
+
+enum RingBufferMode{
+	RING_UNSYNC,  /* single context */
+	RING_SPSC  /* one producer thread, one consumer thread */
+};
+
+template<typename T, uint32_t N, RingBufferMode M = RING_UNSYNC>
+class RingBuffer
+{
+	static_assert(N != 0 && (N & (N - 1)) == 0, "length must be a power of 2");
+	static_assert(N <= 0x80000000u, "length must fit the 32-bit counters");
+
+public:
+	/* Contiguous part of the buffer. */
+	struct Span{
+		T *data;
+		uint32_t len;
+	};
+
+	RingBuffer() : m_head(0), m_tail(0) {}
+	RingBuffer(const RingBuffer &) = delete;
+	RingBuffer &operator=(const RingBuffer &) = delete;
+
+	static constexpr uint32_t capacity() { return N; }
+
+	/* Number of elements, exact for the consumer and the producer. */
+	uint32_t size() const
+	{
+		return m_head.load(Acquire) - m_tail.load(Acquire);
+	}
+	bool empty() const { return size() == 0; }
+	bool full() const { return size() == N; }
+
+	/* Not thread safe, neither side may use the buffer meanwhile. */
+	void clear()
+	{
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+	}
+
+	/*
+	 * Producer side.
+	 */
+	bool push(const T &v)
+	{
+		const uint32_t head = m_head.load(std::memory_order_relaxed);
+
+		if(head - m_tail.load(Acquire) == N)
+			return false;
+		m_buf[head & Mask] = v;
+		m_head.store(head + 1, Release);
+		return true;
+	}
+
+	/* Pushes as many of the n elements as fit, returns that number. */
+	uint32_t push(const T *src, uint32_t n)
+	{
+		Span span[2];
+		const uint32_t len = writeSpans(span);
+
+		if(n > len)
+			n = len;
+		copy(span[0].data, src, n < span[0].len ? n : span[0].len);
+		if(n > span[0].len)
+			copy(span[1].data, src + span[0].len, n - span[0].len);
+		commit(n);
+		return n;
+	}
+
+	/* Free part of the buffer, to be filled in place and published with
+	 * commit(). Returns the total length of the spans. */
+	uint32_t writeSpans(Span span[2])
+	{
+		const uint32_t head = m_head.load(std::memory_order_relaxed);
+		const uint32_t room = N - (head - m_tail.load(Acquire));
+
+		return spans(head, room, span);
+	}
+
+	void commit(uint32_t n)
+	{
+		m_head.store(m_head.load(std::memory_order_relaxed) + n, Release);
+	}
+
+	/*
+	 * Consumer side.
+	 */
+	bool pop(T &v)
+	{
+		const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if(m_head.load(Acquire) == tail)
+			return false;
+		v = m_buf[tail & Mask];
+		m_tail.store(tail + 1, Release);
+		return true;
+	}
+
+	/* Pops up to n elements, returns their number. */
+	uint32_t pop(T *dest, uint32_t n)
+	{
+		Span span[2];
+		const uint32_t len = readSpans(span);
+
+		if(n > len)
+			n = len;
+		copy(dest, span[0].data, n < span[0].len ? n : span[0].len);
+		if(n > span[0].len)
+			copy(dest + span[0].len, span[1].data, n - span[0].len);
+		consume(n);
+		return n;
+	}
+
+	/* Oldest element left on the buffer, nullptr if empty. */
+	T *front()
+	{
+		const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+		if(m_head.load(Acquire) == tail)
+			return nullptr;
+		return &m_buf[tail & Mask];
+	}
+
+	/* Used part of the buffer, oldest first, released with consume().
+	 * Returns the total length of the spans. */
+	uint32_t readSpans(Span span[2])
+	{
+		const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+		const uint32_t used = m_head.load(Acquire) - tail;
+
+		return spans(tail, used, span);
+	}
+
+	/* Removes up to n elements, returns their number. */
+	uint32_t consume(uint32_t n)
+	{
+		const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+		const uint32_t used = m_head.load(Acquire) - tail;
+
+		if(n > used)
+			n = used;
+		m_tail.store(tail + n, Release);
+		return n;
+	}
+
+private:
+	static constexpr uint32_t Mask = N - 1;
+	static constexpr std::memory_order Acquire =
+			M == RING_SPSC ? std::memory_order_acquire : std::memory_order_relaxed;
+	static constexpr std::memory_order Release =
+			M == RING_SPSC ? std::memory_order_release : std::memory_order_relaxed;
+	static constexpr uint32_t CacheLine = M == RING_SPSC ? 64 : alignof(uint32_t);
+
+	uint32_t spans(uint32_t pos, uint32_t len, Span span[2])
+	{
+		const uint32_t idx = pos & Mask;
+		const uint32_t first = N - idx < len ? N - idx : len;
+
+		span[0].data = &m_buf[idx];
+		span[0].len = first;
+		span[1].data = &m_buf[0];
+		span[1].len = len - first;
+		return len;
+	}
+
+	static void copy(T *dest, const T *src, uint32_t n)
+	{
+		for(uint32_t i=0; i<n; i++)
+			dest[i] = src[i];
+	}
+
+	/* Producer and consumer counters on separate cache lines in SPSC mode. */
+	alignas(CacheLine) std::atomic<uint32_t> m_head;
+	alignas(CacheLine) std::atomic<uint32_t> m_tail;
+	T m_buf[N];
+};
+
+#endif /* __cplusplus */
+
+
+#endif /* SOURCE_LIB_MEM_RINGBUFFER_H_ */
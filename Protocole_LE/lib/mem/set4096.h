@@ -0,0 +1,110 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: set4096.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Set of up to 4096 elements (0..4095) with the interface of the
+ * 		set56, for the scheduler built with AOK_SET4096. The elements are
+ * 		held in 64 words of 64 bits, bit w of the summary tells that word w
+ * 		is not empty. The bit scans are done with __builtin_clzll(), a
+ * 		single instruction on the host (LZCNT/BSR, CLZ on ARM), so unlike
+ * 		the set56 no lookup table is loaded.
+ *
+ * 		As with the set56, FIND returns the highest element and must not be
+ * 		used on an empty set. FIND_BELOW returns the highest element below
+ * 		k, or -1, in a signed variable other than k.
+ *
+ *****************************************************************************/
+
+#ifndef SOURCE_LIB_MEM_SET4096_H_
+#define SOURCE_LIB_MEM_SET4096_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+#define SET4096_WORDS			64
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+/* Highest set bit of a non-zero 64-bit word. */
+#define SET4096_MSB(x)			(63 - __builtin_clzll(x))
+
+/*
+ *
+ */
+#define SET4096_INSERT(set, k) \
+	do{ \
+		set.words[(k)>>6] |= (uint64_t) 1 << ((k) & 0x3f); \
+		set.summary |= (uint64_t) 1 << ((k)>>6); \
+	}while(0)
+
+/*
+ *
+ */
+#define SET4096_FIND(set, k) \
+	do{ \
+		k = SET4096_MSB(set.summary); \
+		k = ((k) << 6) + SET4096_MSB(set.words[k]); \
+	}while(0)
+
+/*
+ *
+ */
+#define SET4096_FIND_BELOW(set, k, n) \
+	do{ \
+		uint64_t m_ = set.words[(k)>>6] & \
+				(((uint64_t) 1 << ((k) & 0x3f)) - 1); \
+		if(m_){ \
+			n = ((k) & ~0x3f) + SET4096_MSB(m_); \
+		}else{ \
+			m_ = set.summary & (((uint64_t) 1 << ((k)>>6)) - 1); \
+			if(m_){ \
+				n = SET4096_MSB(m_); \
+				n = ((n) << 6) + SET4096_MSB(set.words[n]); \
+			}else{ \
+				n = -1; \
+			} \
+		} \
+	}while(0)
+
+/*
+ *
+ */
+#define SET4096_REMOVE(set, k) \
+	do{ \
+		set.words[(k)>>6] &= ~((uint64_t) 1 << ((k) & 0x3f)); \
+		if(set.words[(k)>>6] == 0) \
+			set.summary &= ~((uint64_t) 1 << ((k)>>6)); \
+	}while(0)
+
+/*
+ *
+ */
+#define SET4096_EMPTY(set)		(set.summary == 0)
+
+/******************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+/**/
+struct set4096{
+	uint64_t summary;
+	uint64_t words[SET4096_WORDS];
+};
+
+
+#endif /* SOURCE_LIB_MEM_SET4096_H_ */
@@ -47,6 +47,21 @@
 		k = ((k) << 3) + (log2lookup[set.bits[k]] - 1); \
 	}while(0)
 
+/*
+ * Highest element below k into n, -1 if there is none (n signed, not k).
+ */
+#define SET56_FIND_BELOW(set, k, n) \
+	do{ \
+		n = log2lookup[set.bits[(k)>>3] & ((1 << ((k) & 0x7)) - 1)] - 1; \
+		if(n >= 0){ \
+			n += (k) & ~0x7; \
+		}else{ \
+			n = log2lookup[set.bytes & ((1 << ((k)>>3)) - 1)] - 1; \
+			if(n >= 0) \
+				n = ((n) << 3) + (log2lookup[set.bits[n]] - 1); \
+		} \
+	}while(0)
+
 /*
  *
  */
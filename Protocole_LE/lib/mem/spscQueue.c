@@ -0,0 +1,240 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		:
+ * File			: spscQueue.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Single producer / single consumer variant of the xQueue, for queues
+ * 		shared between two threads on a host (e.g. serial I/O thread and GUI
+ * 		thread). Instead of masking interrupts, the counters are handed over
+ * 		with acquire/release atomics, so neither side ever blocks or locks.
+ *
+ * 		Differences to the xQueue:
+ * 		 - The number of slots must be a power of two. Head and tail are free
+ * 		   running 32-bit counters and the slot is found by masking, so no
+ * 		   full flag and no wasted slot are needed.
+ * 		 - The head counter is only written by the producer, the tail counter
+ * 		   only by the consumer. Each side keeps a cached copy of the other
+ * 		   counter and only reloads it when the queue looks full/empty.
+ * 		 - The producer can fill a slot in place (spscQueue_reserve() and
+ * 		   spscQueue_publish()), the consumer can read it in place
+ * 		   (spscQueue_get() and spscQueue_consume()).
+ * 		 - Rejected pushes and the maximal load are counted by the producer.
+ *
+ * Example:
+ * 		static x_t myBuf[16];
+ * 		static struct spscQueue q;
+ *
+ * 		spscQueue_init(&q, myBuf, 16, sizeof(x_t));
+ *
+ * 		producer:	x_t *p = spscQueue_reserve(&q);
+ * 					if(p){ fill(p); spscQueue_publish(&q); }
+ * 		consumer:	x_t *p;
+ * 					while(!spscQueue_get(&q, (void **) &p)){
+ * 						use(p);
+ * 						spscQueue_consume(&q);
+ * 					}
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <string.h>
+
+#include "mem/spscQueue.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define LOAD_ACQUIRE(x)			__atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(x, v)		__atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define LOAD_RELAXED(x)			__atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+#define SLOT(c, idx)			((void *)((uint8_t *)(c)->buffer + \
+									((idx) & (c)->mask) * (c)->bSize))
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Initialize the queue.
+ *
+ * Argument:	c			pointer to spscQueue object
+ * 				buf			pointer to buffer memory
+ * 				len			number of slots the buffer memory is reserved for
+ * 				slotSize	number of bytes for a single slot
+ * Return:		err		 0 success
+ * 						-1 the number of slots must be a power of two
+ */
+int32_t spscQueue_init(struct spscQueue *c, void *buf, uint32_t len,
+						uint32_t slotSize)
+{
+	if(len == 0 || (len & (len - 1)))
+		return -1;
+	c->buffer = buf;
+	c->mask = len - 1;
+	c->bSize = slotSize;
+	c->prod.head = 0;
+	c->prod.tailCache = 0;
+	c->prod.nDropped = 0;
+	c->prod.highWater = 0;
+	c->cons.tail = 0;
+	c->cons.headCache = 0;
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Returns a reference to the next free slot without adding it to the queue.
+ * The slot is added with spscQueue_publish() once it has been written. To be
+ * called by the producer only.
+ *
+ * Argument:	c		pointer to spscQueue object.
+ * Return:		pointer to the slot, NULL if the queue is full
+ */
+void *spscQueue_reserve(struct spscQueue *c)
+{
+	uint32_t head = c->prod.head;
+
+	if(head - c->prod.tailCache > c->mask){
+		c->prod.tailCache = LOAD_ACQUIRE(c->cons.tail);
+		if(head - c->prod.tailCache > c->mask){
+			__atomic_add_fetch(&c->prod.nDropped, 1, __ATOMIC_RELAXED);
+			return NULL;
+		}
+	}
+	return SLOT(c, head);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Adds the slot returned by spscQueue_reserve() to the queue.
+ *
+ * Argument:	c		pointer to spscQueue object.
+ */
+void spscQueue_publish(struct spscQueue *c)
+{
+	uint32_t head = c->prod.head + 1;
+	uint32_t load = head - c->prod.tailCache;
+
+	if(load > c->prod.highWater)
+		__atomic_store_n(&c->prod.highWater, load, __ATOMIC_RELAXED);
+	STORE_RELEASE(c->prod.head, head);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Add element to the head of the queue. To be called by the producer only.
+ *
+ * Argument:	c		pointer to spscQueue object.
+ * 				src 	pointer to data which will be copied into queue. Number
+ * 						of bytes to copy is held in c.bSize
+ * Return:		err		 0 success
+ * 						-1 buffer full
+ */
+int32_t spscQueue_push(struct spscQueue *c, const void *src)
+{
+	void *dest = spscQueue_reserve(c);
+
+	if(dest == NULL)
+		return -1;
+	memcpy(dest, src, c->bSize);
+	spscQueue_publish(c);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Get an element from the tail of the queue but leave it on the queue.
+ * To be called by the consumer only.
+ *
+ * Argument:	c		pointer to spscQueue object.
+ * 				pData	address of the pointer which will be set to the
+ * 						beginning of the element in the queue.
+ * Return:		err		 0 success
+ * 						-1 queue empty
+ */
+int32_t spscQueue_get(struct spscQueue *c, void **pData)
+{
+	uint32_t tail = c->cons.tail;
+
+	if(tail == c->cons.headCache){
+		c->cons.headCache = LOAD_ACQUIRE(c->prod.head);
+		if(tail == c->cons.headCache)
+			return -1;
+	}
+	*pData = SLOT(c, tail);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Remove an element from the tail of the queue. To be used together with
+ * spscQueue_get().
+ *
+ * Argument:	c		pointer to spscQueue object.
+ * Return:		err		 0 success
+ * 						-1 queue empty
+ */
+int32_t spscQueue_consume(struct spscQueue *c)
+{
+	uint32_t tail = c->cons.tail;
+
+	if(tail == c->cons.headCache){
+		c->cons.headCache = LOAD_ACQUIRE(c->prod.head);
+		if(tail == c->cons.headCache)
+			return -1;
+	}
+	STORE_RELEASE(c->cons.tail, tail + 1);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Get and remove an element from the tail of the queue. To be called by the
+ * consumer only.
+ *
+ * Argument:	c		pointer to spscQueue object.
+ * 				dest	address where queue content is copied to.
+ * Return:		err		 0 success
+ * 						-1 queue empty
+ */
+int32_t spscQueue_pop(struct spscQueue *c, void *dest)
+{
+	void *src;
+
+	if(spscQueue_get(c, &src))
+		return -1;
+	memcpy(dest, src, c->bSize);
+	return spscQueue_consume(c);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Returns number of used slots in the queue. Called from the other side,
+ * the result is only a snapshot.
+ *
+ * Argument:	c		pointer to spscQueue object.
+ * Return:		number of elements on the queue.
+ */
+uint32_t spscQueue_load(struct spscQueue *c)
+{
+	uint32_t tail = LOAD_ACQUIRE(c->cons.tail);
+	uint32_t head = LOAD_ACQUIRE(c->prod.head);
+
+	return head - tail;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
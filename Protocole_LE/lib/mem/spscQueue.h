@@ -0,0 +1,67 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		:
+ * File			: spscQueue.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ *
+ *****************************************************************************/
+
+#ifndef SOURCE_LIB_MEM_SPSCQUEUE_H_
+#define SOURCE_LIB_MEM_SPSCQUEUE_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+/* Producer and consumer fields are kept on separate cache lines. */
+#define SPSC_CACHE_LINE			64
+
+/******************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+struct spscQueue{
+	struct{
+		uint32_t head;  /* head counter, free running */
+		uint32_t tailCache;  /* last tail seen by the producer */
+		uint32_t nDropped;  /* pushes rejected since the queue was full */
+		uint32_t highWater;  /* maximal load seen by the producer */
+	}prod __attribute__((aligned(SPSC_CACHE_LINE)));
+	struct{
+		uint32_t tail;  /* tail counter, free running */
+		uint32_t headCache;  /* last head seen by the consumer */
+	}cons __attribute__((aligned(SPSC_CACHE_LINE)));
+	void *buffer;  /* pointer to the buffer */
+	uint32_t mask;  /* maximal number of elements - 1 */
+	uint32_t bSize;  /* byte size. Size of each element in bytes */
+};
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+extern int32_t spscQueue_init(struct spscQueue *, void *, uint32_t, uint32_t);
+/* producer side */
+extern int32_t spscQueue_push(struct spscQueue *, const void *);
+extern void *spscQueue_reserve(struct spscQueue *);
+extern void spscQueue_publish(struct spscQueue *);
+/* consumer side */
+extern int32_t spscQueue_pop(struct spscQueue *, void *);
+extern int32_t spscQueue_get(struct spscQueue *, void **);
+extern int32_t spscQueue_consume(struct spscQueue *);
+/* any side */
+extern uint32_t spscQueue_load(struct spscQueue *);
+
+
+#endif /* SOURCE_LIB_MEM_SPSCQUEUE_H_ */
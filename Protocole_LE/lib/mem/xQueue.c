@@ -62,6 +62,183 @@
 #include "lib/mem/xQueue.h"
 #include "config/projConfig.h"
 
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+/* Free entry of the hash set, slot indices are below 0x80. */
+#define SET_EMPTY				0xff
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static uint32_t load(struct xQueue *);
+static uint32_t advance(struct xQueue *, uint32_t, uint32_t);
+static void *slot(struct xQueue *, uint32_t);
+static uint32_t hash(struct xQueue *, const void *);
+static bool equal(struct xQueue *, const void *, const void *);
+static int32_t set_find(struct xQueue *, const void *);
+static void set_insert(struct xQueue *, uint32_t);
+static void set_remove(struct xQueue *, uint32_t);
+static void set_remove_n(struct xQueue *, uint32_t, uint32_t);
+static void push(struct xQueue *, const void *);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Number of used slots, to be called within the critical section.
+ */
+static uint32_t load(struct xQueue *c)
+{
+	if(XQUEUE_FULL(c))
+	    return c->maxLen;
+	return (c->tail <= c->head) ?
+			(c->head - c->tail) : (c->maxLen + c->head - c->tail);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Counter idx moved by n slots, n must not exceed maxLen.
+ */
+static uint32_t advance(struct xQueue *c, uint32_t idx, uint32_t n)
+{
+	idx += n;
+	return (idx >= c->maxLen) ? (idx - c->maxLen) : idx;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Address of a slot.
+ */
+static void *slot(struct xQueue *c, uint32_t idx)
+{
+	return (void *)(((uintptr_t) c->buffer) + (idx * c->bSize));
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Hash of an element, FNV-1a over its bytes unless the queue has a key.
+ */
+static uint32_t hash(struct xQueue *c, const void *e)
+{
+	uint32_t i, h;
+	const uint8_t *b;
+
+	if(c->key != NULL)
+		return c->key->hash(e);
+	b = (const uint8_t *) e;
+	h = 2166136261u;
+	for(i=0; i<c->bSize; i++){
+		h ^= b[i];
+		h *= 16777619u;
+	}
+	return h ^ (h >> 16);
+}
+/*---------------------------------------------------------------------------*/
+
+static bool equal(struct xQueue *c, const void *a, const void *b)
+{
+	if(c->key != NULL)
+		return c->key->equal(a, b);
+	return memcmp(a, b, c->bSize) == 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Looks for an element equal to e in the hash set (linear probing).
+ *
+ * Return:		index of the set entry, -1 if there is none.
+ */
+static int32_t set_find(struct xQueue *c, const void *e)
+{
+	uint32_t i;
+
+	for(i = hash(c, e) & c->setMask; c->set[i] != SET_EMPTY;
+			i = (i + 1) & c->setMask){
+		if(equal(c, slot(c, c->set[i]), e))
+			return i;
+	}
+	return -1;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Adds the queue slot idx to the hash set. There is always a free entry,
+ * the set is longer than the queue.
+ */
+static void set_insert(struct xQueue *c, uint32_t idx)
+{
+	uint32_t i;
+
+	for(i = hash(c, slot(c, idx)) & c->setMask; c->set[i] != SET_EMPTY;
+			i = (i + 1) & c->setMask)
+		;
+	c->set[i] = idx;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Removes the queue slot idx from the hash set. The entries following in
+ * the probe sequence are moved back into the gap, so that no tombstones are
+ * needed and a lookup still ends at the first free entry.
+ */
+static void set_remove(struct xQueue *c, uint32_t idx)
+{
+	uint32_t i, j, home;
+
+	for(i = hash(c, slot(c, idx)) & c->setMask; c->set[i] != idx;
+			i = (i + 1) & c->setMask)
+		;
+	j = i;
+	while(1){
+		j = (j + 1) & c->setMask;
+		if(c->set[j] == SET_EMPTY)
+			break;
+		home = hash(c, slot(c, c->set[j])) & c->setMask;
+		/* move it if its home isn't cyclically within (i, j] */
+		if(((j > i) && ((home <= i) || (home > j)))
+				|| ((j < i) && ((home <= i) && (home > j)))){
+			c->set[i] = c->set[j];
+			i = j;
+		}
+	}
+	c->set[i] = SET_EMPTY;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Removes n slots starting with the tail from the hash set, if there is one.
+ */
+static void set_remove_n(struct xQueue *c, uint32_t tail, uint32_t n)
+{
+	if(c->set == NULL)
+		return;
+	while(n--){
+		set_remove(c, tail);
+		tail = advance(c, tail, 1);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Adds an element to the head, to be called within the critical section
+ * with a queue that isn't full.
+ */
+static void push(struct xQueue *c, const void *src)
+{
+	memcpy(slot(c, c->head), src, c->bSize);
+	if(c->set != NULL)
+		set_insert(c, c->head);
+	c->head = (c->head + 1 >= c->maxLen) ? 0 : c->head + 1;
+	if(c->head == c->tail)
+		c->head |= 0x80;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
 /******************************************************************************
  * SUBROUTINES (EXPORT)
  *****************************************************************************/
@@ -84,6 +261,9 @@ int32_t xQueue_init(struct xQueue *c, void *buf, uint8_t len, uint8_t slotSize)
     c->bSize = slotSize;
     c->head = 0;
     c->tail = 0;
+    c->set = NULL;
+    c->setMask = 0;
+    c->key = NULL;
     if(len < 0x80)
         return 0;
     else
@@ -91,6 +271,35 @@ int32_t xQueue_init(struct xQueue *c, void *buf, uint8_t len, uint8_t slotSize)
 }
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Attach a hash set to the queue, so that xQueue_push_unique() finds a
+ * duplicate without comparing all queued elements. The set holds the
+ * indices of the used slots and is kept up to date by all functions adding
+ * or removing elements. Call it after xQueue_init(), on an empty queue.
+ *
+ * Argument:	c		pointer to xQueue object.
+ * 				set		memory of the hash set, setLen bytes.
+ * 				setLen	power of 2, greater than the number of slots and
+ * 						at most 256. Twice the number of slots keeps the
+ * 						probe sequences short.
+ * 				key		hash and comparison of the elements, NULL to use
+ * 						all bytes of the elements (including padding).
+ * Return:		err		 0 success
+ * 						-1 invalid setLen
+ */
+int32_t xQueue_init_unique(struct xQueue *c, uint8_t *set, uint32_t setLen,
+                           const struct xQueueKey *key)
+{
+	if((setLen & (setLen - 1)) || (setLen <= c->maxLen) || (setLen > 0x100))
+		return -1;
+	c->set = set;
+	c->setMask = setLen - 1;
+	c->key = key;
+	memset(set, SET_EMPTY, setLen);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
 /*
  * Add element to the head of the queue.
  * If the queue is full, the queue content remains unaltered.
@@ -103,26 +312,36 @@ int32_t xQueue_init(struct xQueue *c, void *buf, uint8_t len, uint8_t slotSize)
  */
 int32_t xQueue_push(struct xQueue *c, const void *src)
 {
-	void *dest;
+    int32_t err;
 
-    if(XQUEUE_FULL(c))
-        return -1;
     INT_GLOB_MASK_SET;
-    dest = (void *)(((uint32_t) c->buffer) + (c->head * c->bSize));
-    memcpy(dest, src, c->bSize);
-    c->head = (c->head + 1 >= c->maxLen) ? 0 : c->head + 1;
-    if(c->head == c->tail)
-        c->head |= 0x80;
+    err = xQueue_push_unlocked(c, src);
     INT_GLOB_MASK_CLEAR;
+    return err;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Same as xQueue_push(), but to be called within the critical section
+ * (INT_GLOB_MASK_SET) of the caller. The mask doesn't nest on the target,
+ * hence a caller adding more to its critical section than the push, e.g. the
+ * kernel marking the AO waiting, must not use xQueue_push().
+ */
+int32_t xQueue_push_unlocked(struct xQueue *c, const void *src)
+{
+    /* checked within the critical section, there may be several producers */
+    if(XQUEUE_FULL(c))
+        return -1;
+    push(c, src);
     return 0;
 }
 /*---------------------------------------------------------------------------*/
 
 /*
  * Add element to the head of the queue uniquely.
- * The element is only added if not already in the queue. The number
- * of buffer entries is computed and it's then run over all these entries.
- * If any compares true, nothing is added to the queue and -2 is returned.
+ * The element is only added if no equal element is on the queue. With a
+ * hash set (see xQueue_init_unique()) this is a lookup in the set,
+ * otherwise all entries are compared.
  *
  * Argument:	c		pointer to xQueue object.
  * 				src 	pointer to data which will be copied into queue. Number
@@ -134,24 +353,38 @@ int32_t xQueue_push(struct xQueue *c, const void *src)
 int32_t xQueue_push_unique(struct xQueue *c, const void *src)
 {
 	int32_t err;
-	int32_t i, i_x;
-	uint32_t flipOver;
-	uint32_t nRiBufEntr;
-	uint32_t bufAddr;
+
+	INT_GLOB_MASK_SET;
+	err = xQueue_push_unique_unlocked(c, src);
+	INT_GLOB_MASK_CLEAR;
+	return err;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Same as xQueue_push_unique(), but to be called within the critical
+ * section of the caller, see xQueue_push_unlocked().
+ */
+int32_t xQueue_push_unique_unlocked(struct xQueue *c, const void *src)
+{
+	uint32_t i, n, idx;
 
 	if(XQUEUE_FULL(c))
-        return -1;
-	nRiBufEntr = (c->tail <= c->head) ?
-            (c->head - c->tail) : (c->maxLen + c->head - c->tail);
-	flipOver = c->maxLen - c->tail;
-	for(i=0; i<nRiBufEntr; i++){
-		i_x = (i >= flipOver) ? (i - c->maxLen) : i;
-		bufAddr = ((uint32_t) c->buffer) + ((c->tail + i_x) * c->bSize);
-		if(memcmp(src, (void*) bufAddr, c->bSize))
+		return -1;
+	if(c->set != NULL){
+		if(set_find(c, src) >= 0)
 			return -2;
+	}else{
+		n = load(c);
+		idx = c->tail;
+		for(i=0; i<n; i++){
+			if(equal(c, slot(c, idx), src))
+				return -2;
+			idx = advance(c, idx, 1);
+		}
 	}
-	err = xQueue_push(c, src);
-    return err;
+	push(c, src);
+	return 0;
 }
 /*---------------------------------------------------------------------------*/
 
@@ -172,8 +405,10 @@ int32_t xQueue_pop(struct xQueue *c, void *dest)
 
     if(c->head != c->tail){
     	INT_GLOB_MASK_SET;
-    	src = (void*)(((uint32_t) c->buffer) + (c->tail * c->bSize));
+    	src = slot(c, c->tail);
         memcpy(dest, src, c->bSize);
+		if(c->set != NULL)
+			set_remove(c, c->tail);
 		c->tail = (c->tail+1 >= c->maxLen) ? 0 : c->tail + 1;
     	c->head &= 0x7f;
     	INT_GLOB_MASK_CLEAR;
@@ -183,6 +418,115 @@ int32_t xQueue_pop(struct xQueue *c, void *dest)
 }
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Add n elements to the head of the queue, with at most two copies within
+ * one critical section. Either all elements are added or none.
+ *
+ * Argument:	c		pointer to xQueue object.
+ * 				src 	pointer to the n elements which will be copied into
+ * 						the queue.
+ * 				n		number of elements.
+ * Return:		err		 0 success
+ * 						-1 not enough free slots
+ */
+int32_t xQueue_push_n(struct xQueue *c, const void *src, uint32_t n)
+{
+	uint32_t i, head, first;
+
+	if(n == 0)
+		return 0;
+    INT_GLOB_MASK_SET;
+    if(n > c->maxLen - load(c)){
+        INT_GLOB_MASK_CLEAR;
+        return -1;
+    }
+    head = c->head;
+    first = c->maxLen - head;
+    if(first > n)
+    	first = n;
+    memcpy(slot(c, head), src, first * c->bSize);
+    if(n > first)
+    	memcpy(c->buffer, (const void *)(((uintptr_t) src) + (first * c->bSize)),
+    			(n - first) * c->bSize);
+    if(c->set != NULL){
+    	for(i=0; i<n; i++)
+    		set_insert(c, advance(c, head, i));
+    }
+    c->head = advance(c, head, n);
+    if(c->head == c->tail)
+        c->head |= 0x80;
+    INT_GLOB_MASK_CLEAR;
+    return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Get and remove up to n elements from the tail of the queue, with at most
+ * two copies within one critical section. Make sure that at least
+ * n * c.bSize memory is reserved at dest.
+ *
+ * Argument:	c		pointer to xQueue object.
+ * 				dest	address where queue content is copied to.
+ * 				n		maximal number of elements.
+ * Return:		number of elements copied to dest, 0 if the queue is empty.
+ */
+uint32_t xQueue_pop_n(struct xQueue *c, void *dest, uint32_t n)
+{
+	uint32_t used, tail, first;
+
+    INT_GLOB_MASK_SET;
+    used = load(c);
+    if(n > used)
+    	n = used;
+    if(n != 0){
+    	tail = c->tail;
+    	first = c->maxLen - tail;
+    	if(first > n)
+    		first = n;
+    	memcpy(dest, slot(c, tail), first * c->bSize);
+    	if(n > first)
+    		memcpy((void *)(((uintptr_t) dest) + (first * c->bSize)), c->buffer,
+    				(n - first) * c->bSize);
+    	set_remove_n(c, tail, n);
+    	c->tail = advance(c, tail, n);
+    	c->head &= 0x7f;
+    }
+    INT_GLOB_MASK_CLEAR;
+    return n;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Get the elements on the queue but leave them on the queue. The elements
+ * are not copied, the queue memory is referenced by up to two spans, oldest
+ * first. The second span is only used if the elements wrap around the end
+ * of the buffer, otherwise its length is 0. The slots are still marked as
+ * used, release them with xQueue_consume_n().
+ *
+ * Argument:	c		pointer to xQueue object.
+ * 				span	array of two spans which will be set.
+ * Return:		total number of elements in the spans, 0 if the queue is
+ * 				empty.
+ */
+uint32_t xQueue_peek(struct xQueue *c, struct xQueueSpan *span)
+{
+	uint32_t used, tail, first;
+
+    INT_GLOB_MASK_SET;
+    used = load(c);
+    tail = c->tail;
+    INT_GLOB_MASK_CLEAR;
+    first = c->maxLen - tail;
+    if(first > used)
+    	first = used;
+    span[0].data = slot(c, tail);
+    span[0].len = first;
+    span[1].data = c->buffer;
+    span[1].len = used - first;
+    return used;
+}
+/*---------------------------------------------------------------------------*/
+
 /*
  * Get an element from the tail of the queue but leave it on the queue.
  * The element is not copied it is only a reference. The slot is still
@@ -199,7 +543,7 @@ int32_t xQueue_get(struct xQueue *c, void **pData)
 	int32_t err = 0;
 
     if(c->head != c->tail)
-    	*pData = (void*)(((uint32_t) c->buffer) + (c->tail * c->bSize));
+    	*pData = slot(c, c->tail);
     else
     	err = -1;
     return err;
@@ -220,6 +564,8 @@ int32_t xQueue_consume(struct xQueue *c)
 
     if(c->head != c->tail){
     	INT_GLOB_MASK_SET;
+		if(c->set != NULL)
+			set_remove(c, c->tail);
 		c->tail = (c->tail+1 >= c->maxLen) ? 0 : c->tail + 1;
         c->head &= 0x7f;
     	INT_GLOB_MASK_CLEAR;
@@ -230,6 +576,32 @@ int32_t xQueue_consume(struct xQueue *c)
 }
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Remove up to n elements from the tail of the queue.
+ * This function is typically used together with xQueue_peek.
+ *
+ * Argument:	c		pointer to xQueue object.
+ * 				n		maximal number of elements.
+ * Return:		number of elements removed.
+ */
+uint32_t xQueue_consume_n(struct xQueue *c, uint32_t n)
+{
+	uint32_t used;
+
+    INT_GLOB_MASK_SET;
+    used = load(c);
+    if(n > used)
+    	n = used;
+    if(n != 0){
+    	set_remove_n(c, c->tail, n);
+    	c->tail = advance(c, c->tail, n);
+    	c->head &= 0x7f;
+    }
+    INT_GLOB_MASK_CLEAR;
+    return n;
+}
+/*---------------------------------------------------------------------------*/
+
 /*
  * Reset the queue to its original empty state.
  *
@@ -239,6 +611,8 @@ void xQueue_reset(struct xQueue *c)
 {
 	c->head = 0;
 	c->tail = 0;
+	if(c->set != NULL)
+		memset(c->set, SET_EMPTY, c->setMask + 1);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -250,12 +624,6 @@ void xQueue_reset(struct xQueue *c)
  */
 uint32_t xQueue_load(struct xQueue *c)
 {
-	uint32_t tmp;
-
-	if(XQUEUE_FULL(c))
-	    return c->maxLen;
-	tmp = (c->tail <= c->head) ?
-			(c->head - c->tail) : (c->maxLen + c->head - c->tail);
-	return tmp;
+	return load(c);
 }
 /*---------------------------------------------------------------------------*/
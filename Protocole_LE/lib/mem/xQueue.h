@@ -22,6 +22,7 @@
  * INCLUDES
  *****************************************************************************/
 #include <stdint.h>
+#include <stdbool.h>
 
 /******************************************************************************
  * MACROS
@@ -35,21 +36,45 @@
 /******************************************************************************
  * TYPEDEFS
  *****************************************************************************/
+/* Contiguous part of the queue, see xQueue_peek(). */
+struct xQueueSpan{
+    void *data;  /* first element */
+    uint32_t len;  /* number of elements */
+};
+
+/* Key of the elements for xQueue_push_unique(), see xQueue_init_unique().
+ * Elements that are equal must have the same hash. */
+struct xQueueKey{
+    uint32_t (*hash)(const void *);
+    bool (*equal)(const void *, const void *);
+};
+
 struct xQueue{
     void * buffer;  /* pointer to the buffer */
     volatile uint8_t tail;  /* tail counter */
     volatile uint8_t head;  /* head counter */
     uint8_t maxLen;  /* maximal number of elements */
     uint8_t bSize;  /* byte size. Size of each element in bytes */
+    uint8_t setMask;  /* length of the hash set - 1 */
+    uint8_t *set;  /* hash set of the queued slots, NULL if not used */
+    const struct xQueueKey *key;  /* NULL: all bytes of the element */
 };
 
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
 extern int32_t xQueue_init(struct xQueue *, void *, uint8_t, uint8_t);
+extern int32_t xQueue_init_unique(struct xQueue *, uint8_t *, uint32_t,
+                                  const struct xQueueKey *);
 extern int32_t xQueue_push(struct xQueue *, const void *);
 extern int32_t xQueue_push_unique(struct xQueue *, const void *);
+extern int32_t xQueue_push_unlocked(struct xQueue *, const void *);
+extern int32_t xQueue_push_unique_unlocked(struct xQueue *, const void *);
+extern int32_t xQueue_push_n(struct xQueue *, const void *, uint32_t);
 extern int32_t xQueue_pop(struct xQueue *, void *);
+extern uint32_t xQueue_pop_n(struct xQueue *, void *, uint32_t);
+extern uint32_t xQueue_peek(struct xQueue *, struct xQueueSpan *);
+extern uint32_t xQueue_consume_n(struct xQueue *, uint32_t);
 extern int32_t xQueue_get(struct xQueue *, void **);
 extern int32_t xQueue_consume(struct xQueue *);
 extern void xQueue_reset(struct xQueue *);
@@ -0,0 +1,230 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: dlinkDecoder.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description: Streaming decoder for the data link layer, used on hosts where
+ *				the bytes arrive in arbitrary chunks (e.g. from a tty) instead
+ *				of the UART FIFO. It runs the same sequence as the uartRxObj:
+ * 				[PREAMBLE(1), PAYLOAD LENGTH(1), PAYLOAD(x), CRC(2)].
+ *
+ *				The decoder is incremental and does not allocate. Bytes are
+ *				fed with dlinkDec_feed() in any portion, down to a single
+ *				byte. The function returns as soon as a frame is complete,
+ *				so the caller has to loop until all bytes are consumed:
+ *
+ *					while(len){
+ *						ret = dlinkDec_feed(&dec, src, len, &n);
+ *						src += n;
+ *						len -= n;
+ *						if(ret == DLINK_DEC_FRAME)
+ *							prot_decode(&dec.rxBuf, &prot);
+ *					}
+ *
+ *				On DLINK_DEC_FRAME, rxBuf.len holds the payload length and
+ *				rxBuf.buf the payload (the CRC is stored behind it). The
+ *				payload remains valid until the next call to dlinkDec_feed().
+ *				Errors are returned as negative numbers, the decoder drops
+ *				the frame and hunts for the next preamble.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "prot/dlinkDecoder.h"
+#include "prot/protocol.h"
+#include "crc/crc16Block.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static void read_payload(struct dlinkDecoder *, const uint8_t *, uint32_t);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Copies characters onto the buffer and calculates the CRC on them.
+ *
+ * Argument:	self	Reference to decoder object.
+ * 				src		Characters to store.
+ * 				len		Number of characters.
+ */
+static void read_payload(struct dlinkDecoder *self, const uint8_t *src,
+							uint32_t len)
+{
+	self->dlink.crc = crc16_ccitt_block(src, len, self->dlink.crc);
+	memcpy(&self->rxBuf.buf[self->rxBuf.pos], src, len);
+	self->rxBuf.pos += len;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Initializes the decoder. The buffer must hold the longest expected payload
+ * plus the CRC (at most 255 + CRC_LEN bytes).
+ *
+ * Argument:	self	Reference to decoder object.
+ * 				buf		Pointer to allocated buffer memory.
+ * 				size	Size of the buffer in bytes.
+ */
+void dlinkDec_init(struct dlinkDecoder *self, uint8_t *buf, uint16_t size)
+{
+	self->rxBuf.buf = buf;
+	self->rxBuf.size = size;
+	self->nFrames = 0;
+	self->nErrors = 0;
+	dlinkDec_reset(self);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Drops a partially received frame and hunts for the next preamble. Typically
+ * used after the line has been idle for too long (the RX timeout of the
+ * uartRxObj).
+ *
+ * Argument:	self	Reference to decoder object.
+ */
+void dlinkDec_reset(struct dlinkDecoder *self)
+{
+	self->state = DLINK_RX_IDLE;
+	ucBuffer_clear(&self->rxBuf);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Feeds received characters into the decoder. Returns as soon as a frame is
+ * complete or an error occurred, or once all characters have been consumed.
+ *
+ * Argument:	self		Reference to decoder object.
+ * 				src			Received characters.
+ * 				len			Number of received characters.
+ * 				consumed	Number of characters taken from src (result).
+ * Return:		DLINK_DEC_FRAME		frame complete, payload on rxBuf
+ * 				DLINK_DEC_PENDING	all characters consumed
+ * 				< 0					frame dropped, see dlinkDecoder.h
+ */
+int32_t dlinkDec_feed(struct dlinkDecoder *self, const uint8_t *src,
+						uint32_t len, uint32_t *consumed)
+{
+	uint32_t i = 0;
+	uint32_t n;
+	int32_t ret = DLINK_DEC_PENDING;
+
+	while(i < len && ret == DLINK_DEC_PENDING){
+		switch(self->state){
+		case DLINK_RX_IDLE:
+			while(i < len && src[i] != PREAMBLE)
+				i++;
+			if(i < len){
+				i++;
+				self->state = DLINK_RX_LEN;
+			}
+			break;
+		case DLINK_RX_LEN:
+			self->dlink.len = src[i++];
+			self->dlink.crc = CRC16_CCITT_INIT_0000;
+			ucBuffer_clear(&self->rxBuf);
+			if(self->dlink.len < DLINK_MIN_PAYLOAD_LEN){
+				ret = DLINK_DEC_ERR_MSGTOOSHORT;
+				self->state = DLINK_RX_IDLE;
+			}else if(self->dlink.len + CRC_LEN > self->rxBuf.size){
+				ret = DLINK_DEC_ERR_MSGTOOLONG;
+				self->state = DLINK_RX_IDLE;
+			}else{
+				self->state = DLINK_RX_BUSY;
+			}
+			break;
+		case DLINK_RX_BUSY:
+			n = self->dlink.len - self->rxBuf.pos;
+			if(n > len - i)
+				n = len - i;
+			read_payload(self, &src[i], n);
+			i += n;
+			if(self->rxBuf.pos == self->dlink.len)
+				self->state = DLINK_RX_EOR;
+			break;
+		case DLINK_RX_EOR:
+			n = self->dlink.len + CRC_LEN - self->rxBuf.pos;
+			if(n > len - i)
+				n = len - i;
+			read_payload(self, &src[i], n);
+			i += n;
+			if(self->rxBuf.pos == self->dlink.len + CRC_LEN){
+				self->state = DLINK_RX_IDLE;
+				if(self->dlink.crc == 0){
+					self->rxBuf.len = self->dlink.len;
+					self->rxBuf.pos = 0;
+					self->nFrames++;
+					ret = DLINK_DEC_FRAME;
+				}else{
+					ret = DLINK_DEC_ERR_CRCMISMATCH;
+				}
+			}
+			break;
+		default:
+			self->state = DLINK_RX_IDLE;
+			break;
+		}
+	}
+	if(ret < 0){
+		ucBuffer_clear(&self->rxBuf);
+		self->nErrors++;
+	}
+	*consumed = i;
+	return ret;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Number of characters at least needed to complete the frame in progress. A
+ * reader may sleep until that many characters are available instead of
+ * waking up for every one of them. Since the length field may be corrupt,
+ * it must not wait for them without timeout.
+ *
+ * Argument:	self	Reference to decoder object.
+ * Return:		Number of characters, 0 if no frame is in progress.
+ */
+uint32_t dlinkDec_missing(const struct dlinkDecoder *self)
+{
+	switch(self->state){
+	case DLINK_RX_LEN:
+		return 1 + DLINK_MIN_PAYLOAD_LEN + CRC_LEN;
+	case DLINK_RX_BUSY:
+	case DLINK_RX_EOR:
+		return self->dlink.len + CRC_LEN - self->rxBuf.pos;
+	default:
+		return 0;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: dlinkDecoder.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ *
+ *****************************************************************************/
+
+#ifndef SOURCE_LIB_PROT_DLINKDECODER_H_
+#define SOURCE_LIB_PROT_DLINKDECODER_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+
+#include "mem/ucBuffer.h"
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+/* Shortest payload accepted: network, transport and 16 bit SID field. */
+#define DLINK_MIN_PAYLOAD_LEN	4
+
+/* Return values of dlinkDec_feed(). */
+enum{
+	DLINK_DEC_ERR_MSGTOOSHORT = -3,  /* length field below minimal payload */
+	DLINK_DEC_ERR_MSGTOOLONG = -2,  /* message exceeds buffer size */
+	DLINK_DEC_ERR_CRCMISMATCH = -1,  /* wrong CRC */
+	DLINK_DEC_PENDING = 0,  /* all bytes consumed, no frame complete */
+	DLINK_DEC_FRAME = 1,  /* frame complete, payload on rxBuf */
+};
+
+/******************************************************************************
+ * MACROS
+ *****************************************************************************/
+
+/******************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+/* Same states as the uartRxObj, without the FIFO level handling. */
+enum dlinkDecState{
+	DLINK_RX_IDLE,  /* hunting for the preamble */
+	DLINK_RX_LEN,  /* preamble found, length field expected */
+	DLINK_RX_BUSY,  /* receiving payload */
+	DLINK_RX_EOR,  /* receiving CRC */
+};
+
+/* The data link layer decoder object. */
+struct dlinkDecoder{
+	struct ucBuffer rxBuf;  /* payload memory, assigned by the holder */
+	struct{
+		uint16_t len;  /* data link layer field 'length' */
+		uint16_t crc;  /* data link layer field 'CRC' */
+	}dlink;
+	uint8_t state;  /* see enum dlinkDecState */
+	uint32_t nFrames;  /* number of frames successfully received */
+	uint32_t nErrors;  /* number of frames dropped */
+};
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+extern void dlinkDec_init(struct dlinkDecoder *, uint8_t *, uint16_t);
+extern void dlinkDec_reset(struct dlinkDecoder *);
+extern int32_t dlinkDec_feed(struct dlinkDecoder *, const uint8_t *, uint32_t,
+								uint32_t *);
+extern uint32_t dlinkDec_missing(const struct dlinkDecoder *);
+
+
+#endif /* SOURCE_LIB_PROT_DLINKDECODER_H_ */
@@ -0,0 +1,332 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: protView.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Zero-copy alternative to prot_decode(). A protView refers to the
+ * 		payload of a message (pointer and length) and parses the layer
+ * 		headers lazily, the first time they are accessed:
+ *
+ * 			struct protView view;
+ * 			protView_init(&view, rxBuf.buf, rxBuf.len);
+ * 			if(protView_process(&view, &prot) == PROT_SUCCESS)
+ * 				...
+ *
+ * 		Only header offsets are stored, the memory is never written and
+ * 		never read beyond len. A parse error is sticky, it is returned by
+ * 		every following access to the same or a deeper layer.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "prot/protView.h"
+#include "prot/protocol.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static int32_t parse_network(struct protView *);
+static int32_t parse_transport(struct protView *);
+static int32_t parse_process(struct protView *);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Network header: NID followed by 0, 2, 4 or 5 address bytes.
+ */
+static int32_t parse_network(struct protView *self)
+{
+	static const uint8_t hLen[] = {1, 3, 5, 6};
+
+	if(self->len < 1)
+		return PROT_ERR_INVALID_LEN;
+	if(self->buf[0] >= sizeof(hLen))
+		return PROT_ERR_INVALID_NID;
+	if(self->len < hLen[self->buf[0]])
+		return PROT_ERR_INVALID_LEN;
+	self->tranOff = hLen[self->buf[0]];
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Transport header: TID followed by 0 or 3 bytes.
+ */
+static int32_t parse_transport(struct protView *self)
+{
+	static const uint8_t hLen[] = {1, 4};
+	uint16_t off = self->tranOff;
+
+	if(self->len < off + 1)
+		return PROT_ERR_INVALID_LEN;
+	if(self->buf[off] >= sizeof(hLen))
+		return PROT_ERR_INVALID_TID;
+	if(self->len < off + hLen[self->buf[off]])
+		return PROT_ERR_INVALID_LEN;
+	self->procOff = off + hLen[self->buf[off]];
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Process header: SID, answers do have a service status field.
+ */
+static int32_t parse_process(struct protView *self)
+{
+	uint16_t off = self->procOff;
+	uint16_t hLen = PROC_H_LEN;
+
+	if(self->len < off + PROC_H_LEN)
+		return PROT_ERR_INVALID_LEN;
+	if(self->buf[off + 1] & SID_ANS_M)
+		hLen++;
+	if(self->len < off + hLen)
+		return PROT_ERR_INVALID_LEN;
+	self->dataOff = off + hLen;
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Sets up a view onto the payload of a message. Nothing is parsed yet.
+ *
+ * Argument:	self	Reference to the view.
+ * 				buf		First byte of the payload (network header).
+ * 				len		Payload length in bytes.
+ */
+void protView_init(struct protView *self, const void *buf, uint16_t len)
+{
+	self->buf = (const uint8_t *) buf;
+	self->len = len;
+	self->tranOff = 0;
+	self->procOff = 0;
+	self->dataOff = 0;
+	self->parsed = PROT_VIEW_NONE;
+	self->err = PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Parses the headers up to and including the given layer. Layers already
+ * parsed are not parsed again.
+ *
+ * Argument:	self	Reference to the view.
+ * 				layer	Last layer to parse.
+ * Return:		PROT_SUCCESS
+ * 				PROT_ERR_INVALID_NID
+ * 				PROT_ERR_INVALID_TID
+ * 				PROT_ERR_INVALID_LEN	header exceeds the payload
+ */
+int32_t protView_parse(struct protView *self, enum protViewLayer layer)
+{
+	int32_t err = PROT_SUCCESS;
+
+	if(self->err)
+		return self->err;
+	while(self->parsed < layer){
+		switch(self->parsed){
+		case PROT_VIEW_NONE:
+			err = parse_network(self);
+			break;
+		case PROT_VIEW_NET:
+			err = parse_transport(self);
+			break;
+		case PROT_VIEW_TRAN:
+			err = parse_process(self);
+			break;
+		default:
+			return PROT_SUCCESS;
+		}
+		if(err){
+			self->err = (uint8_t) err;
+			return err;
+		}
+		self->parsed++;
+	}
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Fills the network layer of dest.
+ *
+ * Return:		PROT_SUCCESS or the error of protView_parse().
+ */
+int32_t protView_network(struct protView *self, struct protocol *dest)
+{
+	const uint8_t *src = self->buf;
+	int32_t err;
+
+	err = protView_parse(self, PROT_VIEW_NET);
+	if(err)
+		return err;
+	dest->netLayer.nid = src[0];
+	switch(src[0]){
+	case 1:
+		dest->netLayer.opt.nid1.destAddr = src[1];
+		dest->netLayer.opt.nid1.srcAddr = src[2];
+		break;
+	case 2:
+		dest->netLayer.opt.nid2.destDev = src[1];
+		dest->netLayer.opt.nid2.destChn = src[2];
+		dest->netLayer.opt.nid2.srcDev = src[3];
+		dest->netLayer.opt.nid2.srcChn = src[4];
+		break;
+	case 3:
+		dest->netLayer.opt.nid3.destAddr = RETRIEVE16(&src[1]);
+		dest->netLayer.opt.nid3.srcAddr = RETRIEVE16(&src[3]);
+		dest->netLayer.opt.nid3.flags = src[5];
+		break;
+	}
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Fills the transport layer of dest.
+ *
+ * Return:		PROT_SUCCESS or the error of protView_parse().
+ */
+int32_t protView_transport(struct protView *self, struct protocol *dest)
+{
+	const uint8_t *src;
+	int32_t err;
+
+	err = protView_parse(self, PROT_VIEW_TRAN);
+	if(err)
+		return err;
+	src = &self->buf[self->tranOff];
+	dest->tranLayer.tid = src[0];
+	if(src[0] == 1){
+		dest->tranLayer.opt.tid1.seqNr = src[1];
+		dest->tranLayer.opt.tid1.winSize = src[2];
+		dest->tranLayer.opt.tid1.flags = src[3];
+	}
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Fills the process layer (SID and, for answers, SST) of dest.
+ *
+ * Return:		PROT_SUCCESS or the error of protView_parse().
+ */
+int32_t protView_process(struct protView *self, struct protocol *dest)
+{
+	const uint8_t *src;
+	int32_t err;
+
+	err = protView_parse(self, PROT_VIEW_PROC);
+	if(err)
+		return err;
+	src = &self->buf[self->procOff];
+	dest->procLayer.sid = RETRIEVE16(src);
+	if(dest->procLayer.sid & SID_ANS_M)
+		dest->procLayer.sst = src[2];
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Returns the service data behind the process header. The data pointer
+ * refers to the memory of the view.
+ *
+ * Argument:	self	Reference to the view.
+ * 				data	Returns the first byte of the service data.
+ * 				len		Returns the number of bytes of service data.
+ * Return:		PROT_SUCCESS or the error of protView_parse().
+ */
+int32_t protView_data(struct protView *self, const uint8_t **data,
+						uint16_t *len)
+{
+	int32_t err;
+
+	err = protView_parse(self, PROT_VIEW_PROC);
+	if(err)
+		return err;
+	*data = &self->buf[self->dataOff];
+	*len = self->len - self->dataOff;
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * A message with NID 2 not directed at this device shall be routed. Only the
+ * network header is parsed.
+ *
+ * Return:		true if the message is to be routed.
+ */
+bool protView_is_routed(struct protView *self)
+{
+	if(protView_parse(self, PROT_VIEW_NET))
+		return false;
+	return self->buf[0] == 2 && self->buf[1] != DEV_ADDR_GEN;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Fills all layers of dest, same results as prot_decode() but the source
+ * memory is neither copied nor cleared on error. dest->data.pData refers to
+ * the memory of the view.
+ *
+ * Argument:	self	Reference to the view.
+ * 				dest	Pointer to protocol structure.
+ * Return:		0		success
+ * 				0xff	routed message, only the network layer is filled
+ * 				...		see the protocol.h error enumeration.
+ */
+int32_t protView_decode(struct protView *self, struct protocol *dest)
+{
+	const uint8_t *data;
+	uint16_t len;
+	int32_t err;
+
+	err = protView_network(self, dest);
+	if(err)
+		return err;
+	if(protView_is_routed(self))
+		return 0xff;
+	err = protView_transport(self, dest);
+	if(err)
+		return err;
+	err = protView_process(self, dest);
+	if(err)
+		return err;
+	err = protView_data(self, &data, &len);
+	if(err)
+		return err;
+	dest->data.pData = (void *) data;
+	dest->data.dLen = (int16_t) len;
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
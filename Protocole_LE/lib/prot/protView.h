@@ -0,0 +1,70 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: protView.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Read-only view onto an encoded message, see protView.c.
+ *
+ *****************************************************************************/
+
+#ifndef SOURCE_LIB_PROT_PROTVIEW_H_
+#define SOURCE_LIB_PROT_PROTVIEW_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "prot/protocol.h"
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+/* Layers of a message in wire order. A layer is parsed once all layers in
+ * front of it are parsed. */
+enum protViewLayer{
+	PROT_VIEW_NONE,
+	PROT_VIEW_NET,  /* network header parsed, tranOff valid */
+	PROT_VIEW_TRAN,  /* transport header parsed, procOff valid */
+	PROT_VIEW_PROC,  /* process header parsed, dataOff valid */
+};
+
+/******************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+/* The view does not own the memory. It is plain data and can be copied, e.g.
+ * onto a queue, as long as the memory it refers to stays valid. */
+struct protView{
+	const uint8_t *buf;  /* network header, first byte of the payload */
+	uint16_t len;  /* payload length, nothing beyond is read */
+	uint8_t tranOff;  /* offset of the transport header */
+	uint8_t procOff;  /* offset of the process header */
+	uint8_t dataOff;  /* offset of the service data */
+	uint8_t parsed;  /* see enum protViewLayer */
+	uint8_t err;  /* sticky error of the layer that failed, 0 if none */
+};
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+extern void protView_init(struct protView *, const void *, uint16_t);
+extern int32_t protView_parse(struct protView *, enum protViewLayer);
+extern int32_t protView_network(struct protView *, struct protocol *);
+extern int32_t protView_transport(struct protView *, struct protocol *);
+extern int32_t protView_process(struct protView *, struct protocol *);
+extern int32_t protView_data(struct protView *, const uint8_t **, uint16_t *);
+extern bool protView_is_routed(struct protView *);
+extern int32_t protView_decode(struct protView *, struct protocol *);
+
+
+#endif /* SOURCE_LIB_PROT_PROTVIEW_H_ */
@@ -25,6 +25,7 @@
 #include "protocol.h"
 #include "prot/services/generator.h"
 #include "mem/ucBuffer.h"
+#include "crc/crc16Block.h"
 //#include "user/routing/route.h"
 
 /******************************************************************************
@@ -41,12 +42,35 @@
 const uint8_t netLayerLen[] = {1, 3, 5, 6};
 const uint8_t tranLayerLen[] = {1, 4};
 
+/* Service tables of the devices, indexed by the device field of the SID. The
+ * tables are defined in the service files and referenced weak, hence a
+ * project only links the services of the devices it talks to. The SIDs of
+ * the other devices are rejected. */
+extern const struct serviceTable generalServices __attribute__((weak));
+extern const struct serviceTable generatorServices __attribute__((weak));
+extern const struct serviceTable batteryServices __attribute__((weak));
+extern const struct serviceTable acdcServices __attribute__((weak));
+extern const struct serviceTable ccServices __attribute__((weak));
+extern const struct serviceTable lampServices __attribute__((weak));
+
+static const struct serviceTable * const serviceTables[(SID_DEV_M >> SID_DEV_S) + 1] = {
+	[SID_DEV_GENERAL] = &generalServices,
+	[SID_DEV_GEN] = &generatorServices,
+	[SID_DEV_BAT] = &batteryServices,
+	[SID_DEV_ACDC] = &acdcServices,
+	[SID_DEV_CC] = &ccServices,
+	[SID_DEV_LAMP] = &lampServices,
+};
+
 /******************************************************************************
  * PROTOTYPES (LOCAL)
  *****************************************************************************/
 int32_t enc_network_layer(struct protocol *, struct ucBuffer *);
 int32_t enc_transport_layer(struct protocol *, struct ucBuffer *);
 int32_t enc_process_layer(struct protocol *, struct ucBuffer *);
+static int32_t enc_layers(struct protocol *, struct ucBuffer *);
+static const struct serviceEntry *service_lookup(const struct serviceTable *,
+													uint16_t);
 
 /******************************************************************************
  * SUBROUTINES (LOCAL)
@@ -54,41 +78,40 @@ int32_t enc_process_layer(struct protocol *, struct ucBuffer *);
 #if(1)	/* code folding trick */
 
 /*
- *
+ * The encoders write their layer at dest->pos and advance pos. They are
+ * called in wire order, hence the message is encoded in a single forward
+ * pass.
  */
 int32_t enc_network_layer(struct protocol *src, struct ucBuffer *dest)
 {
-	int32_t err = 0;
-
-	dest->pos = 0;
+	if(src->netLayer.nid >= sizeof(netLayerLen))
+		return PROT_ERR_INVALID_NID;
+	if(dest->pos + netLayerLen[src->netLayer.nid] > dest->size)
+		return PROT_ERR_INVALID_LEN;
 	switch(src->netLayer.nid){
 	case 0:
-		dest->buf[dest->pos++] = 0;
+		STORE8(dest, 0);
 		break;
 	case 1:
-		dest->buf[dest->pos++] = 1;
-		dest->buf[dest->pos++] = (uint8_t) src->netLayer.opt.nid1.destAddr;
-		dest->buf[dest->pos++] = (uint8_t) src->netLayer.opt.nid1.srcAddr;
+		STORE8(dest, 1);
+		STORE8(dest, src->netLayer.opt.nid1.destAddr);
+		STORE8(dest, src->netLayer.opt.nid1.srcAddr);
 		break;
 	case 2:
-		dest->buf[dest->pos++] = 2;
-		dest->buf[dest->pos++] = (uint8_t) src->netLayer.opt.nid2.destDev;
-		dest->buf[dest->pos++] = (uint8_t) src->netLayer.opt.nid2.destChn;
-		dest->buf[dest->pos++] = (uint8_t) src->netLayer.opt.nid2.srcDev;
-		dest->buf[dest->pos++] = (uint8_t) src->netLayer.opt.nid2.srcChn;
+		STORE8(dest, 2);
+		STORE8(dest, src->netLayer.opt.nid2.destDev);
+		STORE8(dest, src->netLayer.opt.nid2.destChn);
+		STORE8(dest, src->netLayer.opt.nid2.srcDev);
+		STORE8(dest, src->netLayer.opt.nid2.srcChn);
 		break;
 	case 3:
-		dest->buf[dest->pos++] = 3;
-		dest->buf[dest->pos++] = (uint8_t)(src->netLayer.opt.nid3.destAddr & 0xff00) >> 8;
-		dest->buf[dest->pos++] = (uint8_t)(src->netLayer.opt.nid3.destAddr & 0xff);
-		dest->buf[dest->pos++] = (uint8_t)(src->netLayer.opt.nid3.srcAddr & 0xff00) >> 8;
-		dest->buf[dest->pos++] = (uint8_t)(src->netLayer.opt.nid3.srcAddr & 0xff);
-		dest->buf[dest->pos++] = src->netLayer.opt.nid3.flags;
+		STORE8(dest, 3);
+		STORE16(dest, src->netLayer.opt.nid3.destAddr);
+		STORE16(dest, src->netLayer.opt.nid3.srcAddr);
+		STORE8(dest, src->netLayer.opt.nid3.flags);
 		break;
-	default:
-		return PROT_ERR_INVALID_NID;
 	}
-	return err;
+	return PROT_SUCCESS;
 }
 /*---------------------------------------------------------------------------*/
 
@@ -97,41 +120,33 @@ int32_t enc_network_layer(struct protocol *src, struct ucBuffer *dest)
  */
 int32_t enc_transport_layer(struct protocol *src, struct ucBuffer *dest)
 {
-	int32_t err = 0;
-
-	dest->pos = netLayerLen[src->netLayer.nid];
+	if(src->tranLayer.tid >= sizeof(tranLayerLen))
+		return PROT_ERR_INVALID_TID;
+	if(dest->pos + tranLayerLen[src->tranLayer.tid] > dest->size)
+		return PROT_ERR_INVALID_LEN;
 	switch(src->tranLayer.tid){
 	case 0:
-		dest->buf[dest->pos++] = 0;
+		STORE8(dest, 0);
 		break;
 	case 1:
-		dest->buf[dest->pos++] = 1;
-		dest->buf[dest->pos++] = src->tranLayer.opt.tid1.seqNr;
-		dest->buf[dest->pos++] = src->tranLayer.opt.tid1.winSize;
-		dest->buf[dest->pos++] = src->tranLayer.opt.tid1.flags;
+		STORE8(dest, 1);
+		STORE8(dest, src->tranLayer.opt.tid1.seqNr);
+		STORE8(dest, src->tranLayer.opt.tid1.winSize);
+		STORE8(dest, src->tranLayer.opt.tid1.flags);
 		break;
-	default:
-		return PROT_ERR_INVALID_TID;
 	}
-	err = enc_network_layer(src, dest);
-	return err;
+	return PROT_SUCCESS;
 }
 /*---------------------------------------------------------------------------*/
 
 /*
- * Note that the pos field is used to reference the buffer instead of the
- * len field and the len is assigned at the very end, where pos is set
- * back to 0. This way, the buffer is marked as empty during the encoding
- * process.
+ * Writes the SID and calls the service packer for the payload.
  */
 int32_t enc_process_layer(struct protocol *src, struct ucBuffer *dest)
 {
-	int32_t err = 0;
-	uint16_t tmp;
-
-	dest->pos = netLayerLen[src->netLayer.nid] + tranLayerLen[src->tranLayer.tid];
-	dest->buf[dest->pos++] = (uint8_t)((src->procLayer.sid & 0xff00) >> 8);
-	dest->buf[dest->pos++] = (uint8_t)(src->procLayer.sid & 0xff);
+	if(dest->pos + PROC_H_LEN > dest->size)
+		return PROT_ERR_INVALID_LEN;
+	STORE16(dest, src->procLayer.sid);
 
     /* Commented from MV */
 	/* answers do have a service status field */
@@ -141,19 +156,46 @@ int32_t enc_process_layer(struct protocol *src, struct ucBuffer *dest)
     */
 
     /* call the service packer/encrypter */
-	switch((src->procLayer.sid & SID_DEV_M) >> SID_DEV_S){
-	case SID_DEV_GEN:
-		err = generator_service_pack(src, dest);
-		break;
-	default:
-		err = PROT_ERR_INVALID_SID;
-		break;
-	}
-	tmp = dest->pos;
+	return prot_table_pack(
+			serviceTables[(src->procLayer.sid & SID_DEV_M) >> SID_DEV_S],
+			src, dest);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Encodes all layers of the message from dest->pos on.
+ */
+static int32_t enc_layers(struct protocol *src, struct ucBuffer *dest)
+{
+	int32_t err;
+
+	err = enc_network_layer(src, dest);
+	if(err)
+		return err;
 	err = enc_transport_layer(src, dest);
-	dest->len = tmp;
-	dest->pos = 0;
-	return err;
+	if(err)
+		return err;
+	return enc_process_layer(src, dest);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Returns the table entry of the SID or NULL if the service number is not
+ * covered by the table.
+ */
+static const struct serviceEntry *service_lookup(const struct serviceTable *tbl,
+													uint16_t sid)
+{
+	uint16_t serv = (sid & SID_SERV_M) >> SID_SERV_S;
+
+	if(sid & SID_ANS_M){
+		if(serv < tbl->nAns)
+			return &tbl->ans[serv];
+	}else{
+		if(serv < tbl->nReq)
+			return &tbl->req[serv];
+	}
+	return NULL;
 }
 /*---------------------------------------------------------------------------*/
 
@@ -389,21 +431,76 @@ int32_t prot_service_handle(struct protocol *src, void *dest,
 		if(err)
 			return err;
 	}
-	switch(device){
-	case SID_DEV_GEN:
-		err = generator_service_handle(src, dest);
-		break;
-    case SID_DEV_GENERAL:
-	case SID_DEV_BAT:
-	case SID_DEV_ACDC:
-	case SID_DEV_CC:
-    case SID_DEV_LAMP:
-		break;
-	default:
-		err = PROT_ERR_INVALID_SID;
-		break;
-	}
-	return err;
+	return prot_table_handle(serviceTables[device], src, dest);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Packs the service data of the SID in src onto dest, using the service
+ * table of the device. This is the common body of the device_service_pack
+ * functions.
+ *
+ * Argument:	tbl		Service table of the device, NULL if the device's
+ * 						services are not linked.
+ * 				src		Protocol structure holding all information to encrypt
+ * 						a message onto the destination TX buffer.
+ * 				dest	The destination TX buffer.
+ * Return:		err		 0	success
+ * 						PROT_ERR_SERV_ACCESS_DENIED	SID of another device
+ * 						PROT_ERR_INVALID_SID	service not implemented
+ * 						... error of the pack function.
+ */
+int32_t prot_table_pack(const struct serviceTable *tbl, struct protocol *src,
+							struct ucBuffer *dest)
+{
+	const struct serviceEntry *entry;
+
+	if(tbl == NULL)
+		return PROT_ERR_INVALID_SID;
+	if(((src->procLayer.sid & SID_DEV_M) >> SID_DEV_S) != tbl->device)
+		return PROT_ERR_SERV_ACCESS_DENIED;
+	entry = service_lookup(tbl, src->procLayer.sid);
+	if(entry == NULL || !(entry->flags & SERV_PACK))
+		return PROT_ERR_INVALID_SID;
+	if(entry->pack == NULL)
+		return PROT_SUCCESS;
+	return entry->pack(src, dest);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Calls the handle function of the SID in src, using the service table of
+ * the device. The payload length is checked against the table entry before.
+ * This is the common body of the device_service_handle functions.
+ *
+ * Argument:	tbl		Service table of the device, NULL if the device's
+ * 						services are not linked.
+ * 				src		The source data. Use decode() in advance to move the
+ * 						data from the buffer into the protocol struct.
+ * 				dest	The destination object the message is directed at.
+ * Return:		err		 0	success
+ * 						PROT_ERR_SERV_ACCESS_DENIED	SID of another device
+ * 						PROT_ERR_INVALID_SID	service not implemented
+ * 						SERVICE_ERR_INVALID_DATA_LEN
+ * 						... error of the handle function.
+ */
+int32_t prot_table_handle(const struct serviceTable *tbl, struct protocol *src,
+							void *dest)
+{
+	const struct serviceEntry *entry;
+
+	if(tbl == NULL)
+		return PROT_ERR_INVALID_SID;
+	if(((src->procLayer.sid & SID_DEV_M) >> SID_DEV_S) != tbl->device)
+		return PROT_ERR_SERV_ACCESS_DENIED;
+	entry = service_lookup(tbl, src->procLayer.sid);
+	if(entry == NULL || !(entry->flags & SERV_HANDLE))
+		return PROT_ERR_INVALID_SID;
+	if(entry->dLen != SERV_LEN_ANY && src->data.dLen != entry->dLen)
+		return SERVICE_ERR_INVALID_DATA_LEN;
+	if(entry->handle == NULL)
+		return PROT_SUCCESS;
+	return entry->handle(src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -414,8 +511,11 @@ int32_t prot_service_handle(struct protocol *src, void *dest,
  * Note that the very first layer, namely the data link layer,
  * is not included in the struct and therefore also not in the encoded
  * message on the buffer. This layer is added when sending the message
- * with the uartTxObj.
- * For maximal efficiency, each encoding step only adds what it
+ * with the uartTxObj, or use prot_encode_frame() to get the complete frame.
+ * The layers are written in a single forward pass. The pos field is used
+ * while encoding and the len is assigned at the very end, where pos is set
+ * back to 0. This way, the buffer is marked as empty during the encoding
+ * process.
  *
  * Argument:	src		The source data. A protocol structure.
  * 				dest	TX buffer, the destination of the source data.
@@ -427,10 +527,58 @@ int32_t prot_encode(struct protocol *src, struct ucBuffer *dest)
 	int32_t err = 0;
 
 	ucBuffer_clear(dest);
-	err = enc_process_layer(src, dest);
-	if(err != PROT_SUCCESS)
+	err = enc_layers(src, dest);
+	if(err != PROT_SUCCESS){
 		ucBuffer_clear(dest);
-	return err;
+		return err;
+	}
+	dest->len = dest->pos;
+	dest->pos = 0;
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Encodes a message including the data link layer into the memory frame,
+ * ready to be written to the UART:
+ * 	[PREAMBLE(1), PAYLOAD LENGTH(1), PAYLOAD(x), CRC(2)]
+ * All layers are written in a single forward pass. The CRC is computed over
+ * the payload at the end, while it is still in the cache.
+ *
+ * Argument:	src		The source data. A protocol structure.
+ * 				frame	Destination memory. DLINK_H_LEN + 255 bytes are
+ * 						enough for any message.
+ * 				size	Size of frame in bytes.
+ * 				len		Returns the number of bytes of the complete frame.
+ * Return:		err		 0	success
+ * 						PROT_ERR_INVALID_LEN	frame too small
+ * 						... see the protocol.h error enum.
+ */
+int32_t prot_encode_frame(struct protocol *src, uint8_t *frame, uint32_t size,
+							uint32_t *len)
+{
+	int32_t err;
+	uint16_t crc;
+	struct ucBuffer payload;
+
+	*len = 0;
+	if(size <= DLINK_H_LEN)
+		return PROT_ERR_INVALID_LEN;
+	size -= DLINK_H_LEN;
+	payload.buf = &frame[DLINK_H_LEN - CRC_LEN];
+	payload.size = size > DLINK_MAX_PAYLOAD ? DLINK_MAX_PAYLOAD : size;
+	payload.pos = 0;
+	payload.len = 0;
+	err = enc_layers(src, &payload);
+	if(err)
+		return err;
+	frame[0] = PREAMBLE;
+	frame[1] = (uint8_t) payload.pos;
+	crc = crc16_ccitt_block(payload.buf, payload.pos, CRC16_CCITT_INIT_0000);
+	payload.buf[payload.pos++] = (uint8_t)(crc >> 8);
+	payload.buf[payload.pos++] = (uint8_t) crc;
+	*len = payload.pos + DLINK_H_LEN - CRC_LEN;
+	return PROT_SUCCESS;
 }
 /*---------------------------------------------------------------------------*/
 /*Commented from MV*/
@@ -21,6 +21,8 @@
 /******************************************************************************
  * INCLUDES
  *****************************************************************************/
+#include <stddef.h>
+
 #include "mem/ucBuffer.h"
 
 /******************************************************************************
@@ -30,6 +32,10 @@
 #define CRC_LEN					2
 #define DLINK_H_LEN				4
 #define PREAMBLE				0xa5
+#define DLINK_MAX_PAYLOAD		255  /* length field is one byte */
+
+/* Length of the SID field, the header of the process layer. */
+#define PROC_H_LEN				2
 
 /* Error codes used by the encoder and decoder. Should also be used by the
  * service handlers. */
@@ -77,6 +83,14 @@ enum answerSid{
 /*Added to arrange*/
 #define DEV_ADDR_GEN    1
 
+/* Flags and length of the service table entries (struct serviceEntry). */
+#define SERV_PACK				0x01  /* service may be packed */
+#define SERV_HANDLE				0x02  /* service may be handled */
+#define SERV_PACK_HANDLE		(SERV_PACK | SERV_HANDLE)
+#define SERV_LEN_ANY			(-1)  /* payload length checked by handler */
+/* Row of a service accepted in both directions without doing anything. */
+#define SERV_NOP				{NULL, NULL, SERV_LEN_ANY, SERV_PACK_HANDLE}
+
 
 /******************************************************************************
  * MACROS
@@ -110,6 +124,9 @@ enum answerSid{
 #define RETRIEVE16(x)           ((x)[0]<<8 | (x)[1])
 #define RETRIEVE32(x)           ((x)[0]<<24 | (x)[1]<<16 | (x)[2]<<8 | (x)[3])
 
+/* Number of entries of a service table array. */
+#define SERV_N(arr)				(sizeof(arr) / sizeof((arr)[0]))
+
 
 /******************************************************************************
  * TYPEDEFS
@@ -163,6 +180,30 @@ struct protocol{
 	}data;
 };
 
+/* Service dispatch table of a device. The entries are indexed by the service
+ * number of the SID, one array for requests and one for answers. Services
+ * without the SERV_PACK/SERV_HANDLE flag are rejected with
+ * PROT_ERR_INVALID_SID. If the flag is set but the function pointer is NULL,
+ * the service is accepted and nothing else is done. Adding a service is
+ * adding a row to the array, e.g.
+ * 	[SID_SERV_GEN_TEST_FLASH] = {pack_req_test_flash, handle_req_test_flash,
+ * 			1, SERV_PACK_HANDLE},
+ */
+struct serviceEntry{
+	int32_t (*pack)(struct protocol *, struct ucBuffer *);
+	int32_t (*handle)(struct protocol *, void *);
+	int16_t dLen;  /* expected payload length to handle or SERV_LEN_ANY */
+	uint8_t flags;
+};
+/**/
+struct serviceTable{
+	enum deviceSid device;
+	const struct serviceEntry *req;
+	uint16_t nReq;  /* number of entries in req */
+	const struct serviceEntry *ans;
+	uint16_t nAns;  /* number of entries in ans */
+};
+
 /* This type can be used as the filter for the service_handle() function. */
 struct devServList{
 	 uint16_t nDevice;  /* Number of devices appearing in the device field */
@@ -178,7 +219,13 @@ extern int32_t prot_dec_transport_layer(struct protocol *);
 extern int32_t prot_dec_process_layer(struct protocol *);
 extern int32_t prot_decode(struct ucBuffer *, struct protocol *);
 extern int32_t prot_service_handle(struct protocol *, void *, struct devServList *);
+extern int32_t prot_table_pack(const struct serviceTable *, struct protocol *,
+								struct ucBuffer *);
+extern int32_t prot_table_handle(const struct serviceTable *, struct protocol *,
+								void *);
 extern int32_t prot_encode(struct protocol *, struct ucBuffer *);
+extern int32_t prot_encode_frame(struct protocol *, uint8_t *, uint32_t,
+									uint32_t *);
 extern int32_t prot_fillin_error_message(struct protocol *, uint8_t);
 extern int32_t prot_fillin_route_approve_message(struct protocol *, uint8_t);
 
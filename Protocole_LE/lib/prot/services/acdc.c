@@ -33,9 +33,32 @@
 /******************************************************************************
  * PROTOTYPES (LOCAL)
  *****************************************************************************/
-static int32_t handle_reply_get_device_info(struct protocol *, struct psObj *);
-static int32_t handle_reply_get_specific_value(struct protocol *, struct psObj *);
-static int32_t handle_reply_get_live_data(struct protocol *, struct psObj *);
+static int32_t handle_reply_get_device_info(struct protocol *, void *);
+static int32_t handle_reply_get_specific_value(struct protocol *, void *);
+static int32_t handle_reply_get_live_data(struct protocol *, void *);
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/* Requests are packed, answers are handled. */
+static const struct serviceEntry acdcReq[] = {
+	[SID_SERV_ACDC_GET_DEVICE_INFO] = {NULL, NULL, SERV_LEN_ANY, SERV_PACK},
+};
+/**/
+static const struct serviceEntry acdcAns[] = {
+	[SID_SERV_ACDC_GET_DEVICE_INFO] = {NULL, handle_reply_get_device_info,
+			SERV_LEN_ANY, SERV_HANDLE},
+	[SID_SERV_ACDC_GET_SPECIFIC_VALUE] = {NULL, handle_reply_get_specific_value,
+			SERV_LEN_ANY, SERV_HANDLE},
+	[SID_SERV_ACDC_GET_LIVE_DATA] = {NULL, handle_reply_get_live_data,
+			SERV_LEN_ANY, SERV_HANDLE},
+};
+/**/
+const struct serviceTable acdcServices = {
+	SID_DEV_ACDC,
+	acdcReq, SERV_N(acdcReq),
+	acdcAns, SERV_N(acdcAns),
+};
 
 /******************************************************************************
  * SUBROUTINES (LOCAL)
@@ -46,7 +69,7 @@ static int32_t handle_reply_get_live_data(struct protocol *, struct psObj *);
 /*
  *
  */
-int32_t handle_reply_get_device_info(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_get_device_info(struct protocol *src, void *dest)
 {
 //    uint8_t *data = (uint8_t *) src->data.pData;
 //
@@ -65,7 +88,7 @@ int32_t handle_reply_get_device_info(struct protocol *src, struct psObj *dest)
 /*
  *
  */
-int32_t handle_reply_get_specific_value(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_get_specific_value(struct protocol *src, void *dest)
 {
 //    uint8_t *data = (uint8_t *) src->data.pData;
 
@@ -89,8 +112,9 @@ int32_t handle_reply_get_specific_value(struct protocol *src, struct psObj *dest
 /*
  *
  */
-int32_t handle_reply_get_live_data(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_get_live_data(struct protocol *src, void *obj)
 {
+    struct psObj *dest = (struct psObj *) obj;
 //    uint8_t *data = (uint8_t *) src->data.pData;
     struct acdc *acdc = &dest->data.acdc;
 //
@@ -135,27 +159,7 @@ int32_t handle_reply_get_live_data(struct protocol *src, struct psObj *dest)
  */
 int32_t acdc_service_pack(struct protocol *src, struct ucBuffer *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t ans = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_ACDC)
-		return 30;  /* TODO assert() */
-	if(ans){
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		case SID_SERV_ACDC_GET_DEVICE_INFO:
-			break;
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_pack(&acdcServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -171,34 +175,7 @@ int32_t acdc_service_pack(struct protocol *src, struct ucBuffer *dest)
  */
 int32_t acdc_service_handle(struct protocol *src, void *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t reply = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_ACDC)
-		return 30;  /* TODO assert() */
-	if(reply){
-        switch(serv){
-        case SID_SERV_ACDC_GET_DEVICE_INFO:
-            err = handle_reply_get_device_info(src, dest);
-            break;
-        case SID_SERV_ACDC_GET_SPECIFIC_VALUE:
-            err = handle_reply_get_specific_value(src, dest);
-            break;
-        case SID_SERV_ACDC_GET_LIVE_DATA:
-            err = handle_reply_get_live_data(src, dest);
-            break;
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_handle(&acdcServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
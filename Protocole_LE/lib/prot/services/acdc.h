@@ -40,6 +40,8 @@ enum acdcServSid{
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
+extern const struct serviceTable acdcServices;
+
 extern int32_t acdc_service_pack(struct protocol *, struct ucBuffer *);
 extern int32_t acdc_service_handle(struct protocol *, void *);
 
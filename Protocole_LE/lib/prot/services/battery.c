@@ -39,15 +39,64 @@ static int32_t pack_req_set_charging(struct protocol *, struct ucBuffer *);
 static int32_t pack_req_set_user_register(struct protocol *, struct ucBuffer *);
 static int32_t pack_req_set_bat_capacity(struct protocol *, struct ucBuffer *);
 
-static int32_t handle_reply_get_device_info(struct protocol *, struct psObj *);
-static int32_t handle_reply_get_specific_value(struct protocol *, struct psObj *);
-static int32_t handle_reply_get_live_data(struct protocol *, struct psObj *);
-static int32_t handle_reply_get_usage_info(struct protocol *, struct psObj *);
-static int32_t handle_reply_get_bat_registers(struct protocol *, struct psObj *);
-static int32_t handle_reply_clear_error_history(struct protocol *, struct psObj *);
-static int32_t handle_reply_set_charging(struct protocol *, struct psObj *);
-static int32_t handle_reply_set_user_register(struct protocol *, struct psObj *);
-static int32_t handle_reply_set_bat_capacity(struct protocol *, struct psObj *);
+static int32_t handle_reply_get_device_info(struct protocol *, void *);
+static int32_t handle_reply_get_specific_value(struct protocol *, void *);
+static int32_t handle_reply_get_live_data(struct protocol *, void *);
+static int32_t handle_reply_get_usage_info(struct protocol *, void *);
+static int32_t handle_reply_get_bat_registers(struct protocol *, void *);
+static int32_t handle_reply_clear_error_history(struct protocol *, void *);
+static int32_t handle_reply_set_charging(struct protocol *, void *);
+static int32_t handle_reply_set_user_register(struct protocol *, void *);
+static int32_t handle_reply_set_bat_capacity(struct protocol *, void *);
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/* Requests are packed, answers are handled. */
+static const struct serviceEntry batReq[] = {
+	[SID_SERV_BAT_GET_DEVICE_INFO] = {NULL, NULL, SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_GET_SPECIFIC_VALUE] = {NULL, NULL, SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_GET_LIVE_DATA] = {NULL, NULL, SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_GET_USAGE_INFO] = {NULL, NULL, SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_GET_BAT_REGISTERS] = {NULL, NULL, SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_CLEAR_ERROR_HISTORY] = {pack_req_clear_error_history, NULL,
+			SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_SET_CHARGING] = {pack_req_set_charging, NULL,
+			SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_SET_USER_REGISTER] = {pack_req_set_user_register, NULL,
+			SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_SET_BAT_CAPACITY] = {pack_req_set_bat_capacity, NULL,
+			SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_UPDATE] = {NULL, NULL, SERV_LEN_ANY, SERV_PACK},
+};
+/**/
+static const struct serviceEntry batAns[] = {
+	[SID_SERV_BAT_GET_DEVICE_INFO] = {NULL, handle_reply_get_device_info,
+			15, SERV_HANDLE},
+	[SID_SERV_BAT_GET_SPECIFIC_VALUE] = {NULL, handle_reply_get_specific_value,
+			18, SERV_HANDLE},
+	[SID_SERV_BAT_GET_LIVE_DATA] = {NULL, handle_reply_get_live_data,
+			19, SERV_HANDLE},
+	[SID_SERV_BAT_GET_USAGE_INFO] = {NULL, handle_reply_get_usage_info,
+			SERV_LEN_ANY, SERV_HANDLE},
+	[SID_SERV_BAT_GET_BAT_REGISTERS] = {NULL, handle_reply_get_bat_registers,
+			SERV_LEN_ANY, SERV_HANDLE},
+	[SID_SERV_BAT_CLEAR_ERROR_HISTORY] = {NULL, handle_reply_clear_error_history,
+			SERV_LEN_ANY, SERV_HANDLE},
+	[SID_SERV_BAT_SET_CHARGING] = {NULL, handle_reply_set_charging,
+			3, SERV_HANDLE},
+	[SID_SERV_BAT_SET_USER_REGISTER] = {NULL, handle_reply_set_user_register,
+			SERV_LEN_ANY, SERV_HANDLE},
+	[SID_SERV_BAT_SET_BAT_CAPACITY] = {NULL, handle_reply_set_bat_capacity,
+			6, SERV_HANDLE},
+	[SID_SERV_BAT_UPDATE] = {NULL, NULL, SERV_LEN_ANY, SERV_HANDLE},
+};
+/**/
+const struct serviceTable batteryServices = {
+	SID_DEV_BAT,
+	batReq, SERV_N(batReq),
+	batAns, SERV_N(batAns),
+};
 
 /******************************************************************************
  * SUBROUTINES (LOCAL)
@@ -109,12 +158,11 @@ static int32_t pack_req_set_bat_capacity(struct protocol *src, struct ucBuffer *
 /*
  *
  */
-int32_t handle_reply_get_device_info(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_get_device_info(struct protocol *src, void *obj)
 {
+    struct psObj *dest = (struct psObj *) obj;
     uint8_t *data = (uint8_t *) src->data.pData;
 
-	if(src->data.dLen != 15)
-		return SERVICE_ERR_INVALID_DATA_LEN;
 	dest->data.bat.info.serNr = RETRIEVE32(&data[0]);
     dest->data.bat.info.fwVersion = RETRIEVE32(&data[4]);
     dest->data.bat.info.hwVersion = RETRIEVE32(&data[8]);
@@ -128,12 +176,11 @@ int32_t handle_reply_get_device_info(struct protocol *src, struct psObj *dest)
 /*
  *
  */
-int32_t handle_reply_get_specific_value(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_get_specific_value(struct protocol *src, void *obj)
 {
+    struct psObj *dest = (struct psObj *) obj;
     uint8_t *data = (uint8_t *) src->data.pData;
 
-	if(src->data.dLen != 18)
-		return SERVICE_ERR_INVALID_DATA_LEN;
     dest->data.bat.specVal.designCap = RETRIEVE16(&data[0]);
     dest->data.bat.specVal.fullCap = RETRIEVE16(&data[2]);
     dest->data.bat.specVal.vNom = RETRIEVE16(&data[4]);
@@ -152,15 +199,14 @@ int32_t handle_reply_get_specific_value(struct protocol *src, struct psObj *dest
 /*
  *
  */
-int32_t handle_reply_get_live_data(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_get_live_data(struct protocol *src, void *obj)
 {
+    struct psObj *dest = (struct psObj *) obj;
     uint8_t chgs;
     struct event eTmp;
     struct battery *bat = &dest->data.bat;
     uint8_t *data = (uint8_t *) src->data.pData;
 
-	if(src->data.dLen != 19)
-		return SERVICE_ERR_INVALID_DATA_LEN;
 	chgs = bat->liveData.chgs;
     bat->liveData.relRemainCap = RETRIEVE8(&data[0]);
     bat->liveData.vBatPwr = RETRIEVE16(&data[1]);
@@ -201,7 +247,7 @@ int32_t handle_reply_get_live_data(struct protocol *src, struct psObj *dest)
 /*
  * Not implemented! What for...
  */
-int32_t handle_reply_get_usage_info(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_get_usage_info(struct protocol *src, void *dest)
 {
     return PROT_SUCCESS;
 }
@@ -210,7 +256,7 @@ int32_t handle_reply_get_usage_info(struct protocol *src, struct psObj *dest)
 /*
  * Not implemented! What for...
  */
-int32_t handle_reply_get_bat_registers(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_get_bat_registers(struct protocol *src, void *dest)
 {
 	return PROT_SUCCESS;
 }
@@ -219,7 +265,7 @@ int32_t handle_reply_get_bat_registers(struct protocol *src, struct psObj *dest)
 /*
  * Not implemented! What for...
  */
-int32_t handle_reply_clear_error_history(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_clear_error_history(struct protocol *src, void *dest)
 {
     return PROT_SUCCESS;
 }
@@ -228,15 +274,14 @@ int32_t handle_reply_clear_error_history(struct protocol *src, struct psObj *des
 /*
  *
  */
-int32_t handle_reply_set_charging(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_set_charging(struct protocol *src, void *obj)
 {
+    struct psObj *dest = (struct psObj *) obj;
     uint8_t chgs;
     struct event eTmp;
     struct battery *bat = &dest->data.bat;
     uint8_t *data = (uint8_t *) src->data.pData;
 
-	if(src->data.dLen != 3)
-		return SERVICE_ERR_INVALID_DATA_LEN;
     chgs = bat->liveData.chgs;
 	bat->liveData.chgs = RETRIEVE8(&data[0]);
     bat->liveData.chgErr = RETRIEVE16(&data[1]);
@@ -257,7 +302,7 @@ int32_t handle_reply_set_charging(struct protocol *src, struct psObj *dest)
 /*
  * User registers are currently not used!
  */
-int32_t handle_reply_set_user_register(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_set_user_register(struct protocol *src, void *dest)
 {
 	return PROT_SUCCESS;
 }
@@ -266,12 +311,11 @@ int32_t handle_reply_set_user_register(struct protocol *src, struct psObj *dest)
 /*
  *
  */
-int32_t handle_reply_set_bat_capacity(struct protocol *src, struct psObj *dest)
+int32_t handle_reply_set_bat_capacity(struct protocol *src, void *obj)
 {
+    struct psObj *dest = (struct psObj *) obj;
     uint8_t *data = (uint8_t *) src->data.pData;
 
-    if(src->data.dLen != 6)
-        return SERVICE_ERR_INVALID_DATA_LEN;
     dest->data.bat.specVal.designCap = RETRIEVE16(&data[0]);
     dest->data.bat.specVal.fullCap = RETRIEVE16(&data[2]);
     dest->data.bat.liveData.relRemainCap = RETRIEVE16(&data[4]);
@@ -295,44 +339,7 @@ int32_t handle_reply_set_bat_capacity(struct protocol *src, struct psObj *dest)
  */
 int32_t battery_service_pack(struct protocol *src, struct ucBuffer *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t reply = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_BAT)
-		return 30;  /* TODO assert() */
-	if(reply){  /* pack reply */
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{  /* pack request */
-		switch(serv){
-		case SID_SERV_BAT_GET_DEVICE_INFO:
-		case SID_SERV_BAT_GET_SPECIFIC_VALUE:
-		case SID_SERV_BAT_GET_LIVE_DATA:
-		case SID_SERV_BAT_GET_USAGE_INFO:
-		case SID_SERV_BAT_GET_BAT_REGISTERS:
-		case SID_SERV_BAT_UPDATE:
-			break;
-		case SID_SERV_BAT_CLEAR_ERROR_HISTORY:
-			err = pack_req_clear_error_history(src, dest);
-			break;
-		case SID_SERV_BAT_SET_CHARGING:
-			err = pack_req_set_charging(src, dest);
-			break;
-		case SID_SERV_BAT_SET_USER_REGISTER:
-			err = pack_req_set_user_register(src, dest);
-			break;
-		case SID_SERV_BAT_SET_BAT_CAPACITY:
-		    err = pack_req_set_bat_capacity(src, dest);
-			break;
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_pack(&batteryServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -348,60 +355,7 @@ int32_t battery_service_pack(struct protocol *src, struct ucBuffer *dest)
  */
 int32_t battery_service_handle(struct protocol *src, void *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t reply = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_BAT)
-		return 30;  /* TODO assert() */
-
-	/* TODO test purpose only */
-	if(src->procLayer.sst != 0)
-		while(1);
-	/* -- end test -- */
-
-	if(reply){
-		switch(serv){
-		case SID_SERV_BAT_GET_DEVICE_INFO:
-			err = handle_reply_get_device_info(src, dest);
-			break;
-		case SID_SERV_BAT_GET_SPECIFIC_VALUE:
-			err = handle_reply_get_specific_value(src, dest);
-			break;
-		case SID_SERV_BAT_GET_LIVE_DATA:
-			err = handle_reply_get_live_data(src, dest);
-			break;
-		case SID_SERV_BAT_GET_USAGE_INFO:
-			err = handle_reply_get_usage_info(src, dest);
-			break;
-		case SID_SERV_BAT_GET_BAT_REGISTERS:
-			err = handle_reply_get_bat_registers(src, dest);
-			break;
-		case SID_SERV_BAT_CLEAR_ERROR_HISTORY:
-			err = handle_reply_clear_error_history(src, dest);
-			break;
-		case SID_SERV_BAT_SET_CHARGING:
-			err = handle_reply_set_charging(src, dest);
-			break;
-		case SID_SERV_BAT_SET_USER_REGISTER:
-			err = handle_reply_set_user_register(src, dest);
-			break;
-		case SID_SERV_BAT_SET_BAT_CAPACITY:
-			err = handle_reply_set_bat_capacity(src, dest);
-			break;
-		case SID_SERV_BAT_UPDATE:
-			break;
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_handle(&batteryServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
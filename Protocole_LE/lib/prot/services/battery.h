@@ -21,7 +21,7 @@
 /******************************************************************************
  * INCLUDES
  *****************************************************************************/
-#include "lib/prot/protocol.h"
+#include "prot/protocol.h"
 
 /******************************************************************************
  * DEFINES
@@ -46,6 +46,8 @@ enum batServSid{
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
+extern const struct serviceTable batteryServices;
+
 extern int32_t battery_service_pack(struct protocol *, struct ucBuffer *);
 extern int32_t battery_service_handle(struct protocol *, void *);
 
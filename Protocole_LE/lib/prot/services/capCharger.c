@@ -36,6 +36,17 @@ static int32_t handle_reply_get_device_info(struct protocol *, struct cc *);
 static int32_t handle_reply_get_specific_value(struct protocol *, struct cc *);
 static int32_t handle_reply_get_live_data(struct protocol *, struct cc *);
 
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/* No services are dispatched yet. The reply handlers are ready to be added
+ * to an answer table. */
+const struct serviceTable ccServices = {
+	SID_DEV_CC,
+	NULL, 0,
+	NULL, 0,
+};
+
 /******************************************************************************
  * SUBROUTINES (LOCAL)
  *****************************************************************************/
@@ -98,25 +109,7 @@ int32_t handle_reply_get_live_data(struct protocol *src, struct cc *dest)
  */
 int32_t cc_service_pack(struct protocol *src, struct ucBuffer *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t ans = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_CC)
-		return 30;  /* TODO assert() */
-	if(ans){
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_pack(&ccServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -132,25 +125,7 @@ int32_t cc_service_pack(struct protocol *src, struct ucBuffer *dest)
  */
 int32_t cc_service_handle(struct protocol *src, void *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t ans = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_CC)
-		return 30;  /* TODO assert() */
-	if(ans){
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_handle(&ccServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
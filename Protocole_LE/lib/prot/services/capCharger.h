@@ -39,6 +39,8 @@ enum ccSercSid{
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
+extern const struct serviceTable ccServices;
+
 extern int32_t cc_service_pack(struct protocol *, struct ucBuffer *);
 extern int32_t cc_service_handle(struct protocol *, void *);
 
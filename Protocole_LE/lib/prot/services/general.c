@@ -34,6 +34,28 @@
  *****************************************************************************/
 static int32_t handle_reply_get_device(struct protocol *, void *);
 
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static const struct serviceEntry generalReq[] = {
+	[SID_SERV_GENERAL_GET_DEVICE] = SERV_NOP,
+	[SID_SERV_GENERAL_ERROR] = SERV_NOP,
+	[SID_SERV_GENERAL_ROUTE_APPROVE] = SERV_NOP,
+};
+/**/
+static const struct serviceEntry generalAns[] = {
+	[SID_SERV_GENERAL_GET_DEVICE] = {NULL, handle_reply_get_device,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	[SID_SERV_GENERAL_ERROR] = SERV_NOP,
+	[SID_SERV_GENERAL_ROUTE_APPROVE] = SERV_NOP,
+};
+/**/
+const struct serviceTable generalServices = {
+	SID_DEV_GENERAL,
+	generalReq, SERV_N(generalReq),
+	generalAns, SERV_N(generalAns),
+};
+
 /******************************************************************************
  * SUBROUTINES (LOCAL)
  *****************************************************************************/
@@ -89,37 +111,7 @@ int32_t handle_reply_get_device(struct protocol *src, void *dest)
  */
 int32_t general_service_pack(struct protocol *src, struct ucBuffer *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t reply = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_GENERAL)
-		return 30;  /* TODO assert() */
-	if(reply){
-		switch(serv){
-		case SID_SERV_GENERAL_GET_DEVICE:
-			break;
-		case SID_SERV_GENERAL_ERROR:
-			break;
-		case SID_SERV_GENERAL_ROUTE_APPROVE:
-			break;
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		case SID_SERV_GENERAL_GET_DEVICE:
-			break;
-		case SID_SERV_GENERAL_ERROR:
-			break;
-		case SID_SERV_GENERAL_ROUTE_APPROVE:
-			break;
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_pack(&generalServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -135,38 +127,7 @@ int32_t general_service_pack(struct protocol *src, struct ucBuffer *dest)
  */
 int32_t general_service_handle(struct protocol *src, void *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t reply = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_GENERAL)
-		return 30;  /* TODO assert() */
-	if(reply){
-		switch(serv){
-		case SID_SERV_GENERAL_GET_DEVICE:
-			err = handle_reply_get_device(src, dest);
-			break;
-		case SID_SERV_GENERAL_ERROR:
-			break;
-		case SID_SERV_GENERAL_ROUTE_APPROVE:
-			break;
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		case SID_SERV_GENERAL_GET_DEVICE:
-			break;
-		case SID_SERV_GENERAL_ERROR:
-			break;
-		case SID_SERV_GENERAL_ROUTE_APPROVE:
-			break;
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_handle(&generalServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -49,6 +49,8 @@ struct generalServData{
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
+extern const struct serviceTable generalServices;
+
 extern int32_t general_service_pack(struct protocol *, struct ucBuffer *);
 extern int32_t general_service_handle(struct protocol *, void *);
 
@@ -85,6 +85,75 @@ static int32_t handle_req_set_final_flash_mode(struct protocol *, void *);
 static int32_t handle_req_set_model_param(struct protocol *, void *);
 static int32_t handle_req_func_test(struct protocol *, void *);
 
+static int32_t pack_req_test_flash(struct protocol *, struct ucBuffer *);
+static int32_t handle_req_test_flash(struct protocol *, void *);
+static int32_t handle_req_get_bat_test(struct protocol *, void *);
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/* Requests. Services without function are accepted without doing anything,
+ * the handlers of the debug services are not enabled yet. */
+static const struct serviceEntry genReq[] = {
+	[SID_SERV_GEN_GET_DEVICE_INFO] = SERV_NOP,
+	[SID_SERV_GEN_GET_SPECIFIC_VALUE] = SERV_NOP,
+	[SID_SERV_GEN_GET_LIVE_DATA] = SERV_NOP,
+	[SID_SERV_GEN_GET_USAGE_INFO] = SERV_NOP,
+	/* cutoff commands */
+	[SID_SERV_GEN_SET_FLASH_CHANNEL_STATE] = SERV_NOP,
+	[SID_SERV_GEN_SET_FLASH_SEQUENCER_STEP] = SERV_NOP,
+	[SID_SERV_GEN_SET_FLASH_SEQUENCER_STEP_NR] = SERV_NOP,
+	[SID_SERV_GEN_INTERCEPT_FLASH] = SERV_NOP,
+	[SID_SERV_GEN_TEST_FLASH] = {pack_req_test_flash, handle_req_test_flash,
+			1, SERV_PACK_HANDLE},
+	/* --- */
+	[SID_SERV_GEN_SET_CHARGER_SETTINGS] = SERV_NOP,
+	[SID_SERV_GEN_SET_PS_SETTINGS] = SERV_NOP,
+	[SID_SERV_GEN_SET_FLASH_SETTINGS] = SERV_NOP,
+	[SID_SERV_GEN_SET_LAMP_SETTINGS] = {NULL, handle_req_set_lamp_settings,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	[SID_SERV_GEN_SET_TRIGGER_SOURCE] = {NULL, handle_req_set_trigger_source,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	[SID_SERV_GEN_SET_TRIGGER_SETTINGS] = {NULL, handle_req_set_trigger_settings,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	[SID_SERV_GEN_RST_TRIGGER_SETTINGS] = {NULL, handle_req_rst_trigger_settings,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	[SID_SERV_GEN_SW_UPDATE] = {NULL, handle_req_sw_update,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	[SID_SERV_GEN_SLEEP] = {NULL, handle_req_sleep,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	[SID_SERV_GEN_SHUT_DOWN] = {NULL, handle_req_shut_down,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	/* debug & test */
+	[SID_SERV_GEN_SET_HSS_MODE] = SERV_NOP,
+	[SID_SERV_GEN_SET_SINGLE_SHOT_MODE] = SERV_NOP,
+	[SID_SERV_GEN_SET_LITTLE_FLASH_MODE] = SERV_NOP,
+	[SID_SERV_GEN_SET_DUTY_CYCLE_TABLE] = SERV_NOP,
+	[SID_SERV_GEN_GET_FVOLT_DATA] = SERV_NOP,
+	[SID_SERV_GEN_FLASH_DONE] = {NULL, NULL, SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_GEN_SET_IGNITION_TIMING] = SERV_NOP,
+	[SID_SERV_GEN_GET_FLASH_INFO] = SERV_NOP,
+	[SID_SERV_GEN_SET_RAMP_FLASH_MODE] = SERV_NOP,
+	[SID_SERV_GEN_SET_FINAL_FLASH_MODE] = {pack_reply_set_final_flash_mode, NULL,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	[SID_SERV_GEN_SET_MODEL_PARAM] = {pack_reply_set_model_param, NULL,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	/* TODO bat_test */
+	[SID_SERV_GEN_GET_BAT_TEST] = {NULL, handle_req_get_bat_test,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+	[SID_SERV_GEN_SET_BAT_CHARGING] = SERV_NOP,
+	/**/
+	[SID_SERV_GEN_FUNC_TEST] = {pack_reply_func_test, NULL,
+			SERV_LEN_ANY, SERV_PACK_HANDLE},
+};
+
+/* No answers are packed or handled yet. */
+const struct serviceTable generatorServices = {
+	SID_DEV_GEN,
+	genReq, SERV_N(genReq),
+	NULL, 0,
+};
+
 
 /******************************************************************************
  * SUBROUTINES (LOCAL)
@@ -591,8 +660,6 @@ int32_t handle_req_test_flash(struct protocol *src, void *dest)
    int32_t err;
    uint8_t *data = (uint8_t *) src->data.pData;
 
-   if(src->data.dLen != 1)
-       return SERVICE_ERR_INVALID_DATA_LEN;
    chn = data[0];
    src->data.arr[0] = chn;
    err = coTask_test_flash(chn);
@@ -868,6 +935,26 @@ int32_t handle_req_func_test(struct protocol *src, void *dest)
 }
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Channel number to test.
+ */
+int32_t pack_req_test_flash(struct protocol *src, struct ucBuffer *dest)
+{
+    dest->buf[dest->pos++] = src->data.arr[0];
+    return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * TODO bat_test
+ */
+int32_t handle_req_get_bat_test(struct protocol *src, void *dest)
+{
+    src->data.arr[0] = ((uint8_t *) src->data.pData)[0];
+    return 0;
+}
+/*---------------------------------------------------------------------------*/
+
 #endif	/* end code folding */
 
 /******************************************************************************
@@ -884,144 +971,7 @@ int32_t handle_req_func_test(struct protocol *src, void *dest)
  */
 int32_t generator_service_pack(struct protocol *src, struct ucBuffer *dest)
 {
-    int32_t i;
-    uint32_t tmp;
-	struct usBuffer *buf;  /* TODO flash volt debug */
-	int32_t err = PROT_SUCCESS;
-    uint16_t reply = src->procLayer.sid & SID_ANS_M; /* Commented from MV: request from our side */
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_GEN)
-		return 30;  /* TODO assert() */
-    if(!reply){
-		switch(serv){
-		case SID_SERV_GEN_GET_DEVICE_INFO:
-            /* Commented from MV: not implamented now: err = pack_request_get_device_info(src, dest); */
-			break;
-		case SID_SERV_GEN_GET_SPECIFIC_VALUE:
-            /* Commented from MV: not implamented now: err = pack_reply_get_specific_value(src, dest); */
-			break;
-		case SID_SERV_GEN_GET_LIVE_DATA:
-            /* Commented from MV: not implamented now: err = pack_reply_get_live_data(src, dest); */
-			break;
-		case SID_SERV_GEN_GET_USAGE_INFO:
-            /* Commented from MV: not implamented now: err = pack_reply_get_usage_info(src, dest); */
-			break;
-        /* cutoff commands */
-		case SID_SERV_GEN_SET_FLASH_CHANNEL_STATE:
-            /* Commented from MV: not implamented now: err = pack_reply_set_flash_channel_state(src, dest); */
-		    break;
-		case SID_SERV_GEN_SET_FLASH_SEQUENCER_STEP:
-            /* Commented from MV: not implamented now: err = pack_reply_set_flash_sequencer_step(src, dest); */
-            break;
-		case SID_SERV_GEN_SET_FLASH_SEQUENCER_STEP_NR:
-            /* Commented from MV: not implamented now: err = pack_reply_set_flash_sequencer_step_nr(src, dest); */
-            break;
-		case SID_SERV_GEN_INTERCEPT_FLASH:
-            /* Commented from MV: not implamented now: err = pack_reply_intercept_flash(src, dest); */
-            break;
-		case SID_SERV_GEN_TEST_FLASH:
-		    dest->buf[dest->pos++] = src->data.arr[0];
-            break;
-        /* --- */
-		case SID_SERV_GEN_SET_CHARGER_SETTINGS:
-             /* Commented from MV: not implamented now: err = pack_reply_set_charger_settings(src, dest); */
-			break;
-		case SID_SERV_GEN_SET_PS_SETTINGS:
-             /* Commented from MV: not implamented now: err = pack_reply_set_ps_settings(src, dest); */
-			break;
-		case SID_SERV_GEN_SET_FLASH_SETTINGS:
-            /* Commented from MV: err = pack_reply_set_flash_settings(src, dest); */
-			break;
-		case SID_SERV_GEN_SET_LAMP_SETTINGS:
-            /* Commented from MV: err = pack_reply_set_lamp_settings(src, dest); */
-			break;
-		case SID_SERV_GEN_SET_TRIGGER_SOURCE:
-            /* Commented from MV: err = pack_reply_set_trigger_source(src, dest); */
-			break;
-		case SID_SERV_GEN_SET_TRIGGER_SETTINGS:
-            /* Commented from MV: err = pack_reply_set_trigger_settings(src, dest); */
-			break;
-		case SID_SERV_GEN_RST_TRIGGER_SETTINGS:
-            /* Commented from MV: err = pack_reply_rst_trigger_settings(src, dest); */
-			break;
-		case SID_SERV_GEN_SW_UPDATE:
-            /* Commented from MV: err = pack_reply_sw_update(src, dest); */
-			break;
-		case SID_SERV_GEN_SLEEP:
-            /* Commented from MV: err = pack_reply_sleep(src, dest); */
-			break;
-		case SID_SERV_GEN_SHUT_DOWN:
-            /* Commented from MV: err = pack_reply_shut_down(src, dest); */
-			break;
-		/* debug & test */
-		case SID_SERV_GEN_SET_HSS_MODE:
-		case SID_SERV_GEN_SET_SINGLE_SHOT_MODE:
-		case SID_SERV_GEN_SET_LITTLE_FLASH_MODE:
-		case SID_SERV_GEN_SET_DUTY_CYCLE_TABLE:
-		case SID_SERV_GEN_FLASH_DONE:
-		case SID_SERV_GEN_SET_IGNITION_TIMING:
-		case SID_SERV_GEN_SET_RAMP_FLASH_MODE:
-		    break;
-		case SID_SERV_GEN_SET_FINAL_FLASH_MODE:
-		    err = pack_reply_set_final_flash_mode(src, dest);
-			break;
-        case SID_SERV_GEN_SET_MODEL_PARAM:
-            err = pack_reply_set_model_param(src, dest);
-            break;
-        case SID_SERV_GEN_GET_FVOLT_DATA:
-            /* Commented from MV:
-            buf = get_fvolt_data_buffer();
-            if(src->tranLayer.tid == 0){
-                while((dest->pos < dest->size-4) && (buf->pos < buf->len)){
-                    dest->buf[dest->pos++] = buf->buf[buf->pos] >> 8;
-                    dest->buf[dest->pos++] = buf->buf[buf->pos];
-                    buf->pos++;
-                }
-            }else if(src->tranLayer.tid == 1){
-                src->tranLayer.opt.tid1.flags = 0x1;
-                for(i=2; i<src->tranLayer.opt.tid1.winSize/2; i++){
-                    if(buf->pos >= buf->len){
-                        src->tranLayer.opt.tid1.flags = 0x0;
-                        break;
-                    }
-                    if(dest->pos >= dest->size-4)
-                        break;
-                    dest->buf[dest->pos++] = buf->buf[buf->pos] >> 8;
-                    dest->buf[dest->pos++] = buf->buf[buf->pos];
-                    buf->pos++;
-                }
-            }
-            break;
-            */
-        case SID_SERV_GEN_GET_FLASH_INFO:
-            /* Commented from MV:
-            tmp = get_flash_info();  // trigger counter
-            STORE32(dest, tmp);
-            */
-            break;
-        case SID_SERV_GEN_FUNC_TEST:
-            err = pack_reply_func_test(src, dest);
-            break;
-
-		/* TODO bat_test */
-		case SID_SERV_GEN_GET_BAT_TEST:
-			break;
-		case SID_SERV_GEN_SET_BAT_CHARGING:
-			break;
-		/* -- */
-
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-    }else{  /* MV: request for you Dudy :-) */
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_pack(&generatorServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -1037,106 +987,7 @@ int32_t generator_service_pack(struct protocol *src, struct ucBuffer *dest)
  */
 int32_t generator_service_handle(struct protocol *src, void *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t reply = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_GEN)
-		return PROT_ERR_SERV_ACCESS_DENIED;
-	if(reply){
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		case SID_SERV_GEN_GET_DEVICE_INFO:
-		case SID_SERV_GEN_GET_SPECIFIC_VALUE:
-		case SID_SERV_GEN_GET_LIVE_DATA:
-		case SID_SERV_GEN_GET_USAGE_INFO:
-			break;
-		/* cutoff commands */
-		case SID_SERV_GEN_SET_FLASH_CHANNEL_STATE:
-            /* Commented from MV:err = handle_reply_set_flash_channel_state(src, dest); */
-            break;
-		case SID_SERV_GEN_SET_FLASH_SEQUENCER_STEP:
-            /* Commented from MV:err = handle_req_set_flash_sequencer_step(src, dest); */
-            break;
-		case SID_SERV_GEN_SET_FLASH_SEQUENCER_STEP_NR:
-            /* Commented from MV:err = handle_req_set_flash_sequencer_step_nr(src, dest); */
-            break;
-		case SID_SERV_GEN_INTERCEPT_FLASH:
-            /* Commented from MV:err = handle_req_intercept_flash(src, dest); */
-            break;
-		case SID_SERV_GEN_TEST_FLASH:
-            err = handle_req_test_flash(src, dest);
-		    break;
-		/* --- */
-		case SID_SERV_GEN_SET_CHARGER_SETTINGS:
-            /* Commented from MV:err = handle_req_set_charger_settings(src, dest); */
-			break;
-		case SID_SERV_GEN_SET_PS_SETTINGS:
-            /* Commented from MV:err = handle_req_set_ps_settings(src, dest); */
-			break;
-		case SID_SERV_GEN_SET_FLASH_SETTINGS:
-            /* Commented from MV:err = handle_req_set_flash_settings(src, dest); */
-			break;
-		case SID_SERV_GEN_SET_LAMP_SETTINGS:
-			err = handle_req_set_lamp_settings(src, dest);
-			break;
-		case SID_SERV_GEN_SET_TRIGGER_SOURCE:
-			err = handle_req_set_trigger_source(src, dest);
-			break;
-		case SID_SERV_GEN_SET_TRIGGER_SETTINGS:
-			err = handle_req_set_trigger_settings(src, dest);
-			break;
-		case SID_SERV_GEN_RST_TRIGGER_SETTINGS:
-			err = handle_req_rst_trigger_settings(src, dest);
-			break;
-		case SID_SERV_GEN_SW_UPDATE:
-			err = handle_req_sw_update(src, dest);
-			break;
-		case SID_SERV_GEN_SLEEP:
-			err = handle_req_sleep(src, dest);
-			break;
-		case SID_SERV_GEN_SHUT_DOWN:
-			err = handle_req_shut_down(src, dest);
-			break;
-		/* debug */
-		case SID_SERV_GEN_SET_HSS_MODE:
-		case SID_SERV_GEN_SET_SINGLE_SHOT_MODE:
-		case SID_SERV_GEN_SET_LITTLE_FLASH_MODE:
-		case SID_SERV_GEN_SET_DUTY_CYCLE_TABLE:
-		case SID_SERV_GEN_GET_FVOLT_DATA:
-		case SID_SERV_GEN_SET_IGNITION_TIMING:
-        case SID_SERV_GEN_GET_FLASH_INFO:
-        case SID_SERV_GEN_SET_RAMP_FLASH_MODE:
-            break;
-        case SID_SERV_GEN_SET_FINAL_FLASH_MODE:
-            //err = handle_req_set_final_flash_mode(src, dest);
-            break;
-        case SID_SERV_GEN_SET_MODEL_PARAM:
-            //err = handle_req_set_model_param(src, dest);
-            break;
-        case SID_SERV_GEN_FUNC_TEST:
-            //err = handle_req_func_test(src, dest);
-            break;
-
-		/* TODO bat_test */
-		case SID_SERV_GEN_GET_BAT_TEST:
-			src->data.arr[0] = ((uint8_t *) src->data.pData)[0];
-			break;
-		case SID_SERV_GEN_SET_BAT_CHARGING:
-			// TODO
-			break;
-		/* -- */
-
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_handle(&generatorServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
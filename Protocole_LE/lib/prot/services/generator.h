@@ -88,6 +88,8 @@ struct genServData{
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
+extern const struct serviceTable generatorServices;
+
 extern int32_t generator_service_pack(struct protocol *, struct ucBuffer *);
 extern int32_t generator_service_handle(struct protocol *, void *);
 
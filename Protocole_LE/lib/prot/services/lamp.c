@@ -31,6 +31,16 @@
  * PROTOTYPES (LOCAL)
  *****************************************************************************/
 
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/* No services are dispatched yet. */
+const struct serviceTable lampServices = {
+	SID_DEV_LAMP,
+	NULL, 0,
+	NULL, 0,
+};
+
 /******************************************************************************
  * SUBROUTINES (LOCAL)
  *****************************************************************************/
@@ -51,25 +61,7 @@
  */
 int32_t lamp_service_pack(struct protocol *src, struct ucBuffer *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t ans = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_LAMP)
-		return 30;  /* TODO assert() */
-	if(ans){
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_pack(&lampServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -85,25 +77,7 @@ int32_t lamp_service_pack(struct protocol *src, struct ucBuffer *dest)
  */
 int32_t lamp_service_handle(struct protocol *src, void *dest)
 {
-	int32_t err = PROT_SUCCESS;
-	uint16_t ans = src->procLayer.sid & SID_ANS_M;
-	uint16_t serv = (src->procLayer.sid & SID_SERV_M) >> SID_SERV_S;
-	uint16_t device = (src->procLayer.sid & SID_DEV_M) >> SID_DEV_S;
-
-	if(device != SID_DEV_LAMP)
-		return 30;  /* TODO assert() */
-	if(ans){
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}else{
-		switch(serv){
-		default:
-			err = PROT_ERR_INVALID_SID;
-		}
-	}
-	return err;
+	return prot_table_handle(&lampServices, src, dest);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -39,6 +39,8 @@ enum lampSid{
 /******************************************************************************
  * PROTOTYPES
  *****************************************************************************/
+extern const struct serviceTable lampServices;
+
 extern int32_t lamp_service_pack(struct protocol *, struct ucBuffer *);
 extern int32_t lamp_service_handle(struct protocol *, void *);
 
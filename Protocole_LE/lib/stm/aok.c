@@ -25,19 +25,88 @@
 
 #include "lib/stm/aok.h"
 #include "lib/mem/set56.h"
+#ifdef AOK_SET4096
+#include "lib/mem/set4096.h"
+#endif
+#include "config/projConfig.h"
+#ifdef AOK_SMP
+#include "lib/stm/aokSmp.h"
+#endif
 
 /******************************************************************************
  * DEFINES & MACROS & TYPEDEFS
  *****************************************************************************/
+/* Set of the waiting AOs of a priority. The set4096 lifts the limit of 56
+ * AOs per priority and scans with clz instead of the log2lookup table. */
+#ifdef AOK_SET4096
+typedef struct set4096 waitingSet_t;
+#define WAITING_MAX				(SET4096_WORDS * 64)
+#define SET_INSERT(set, k)			SET4096_INSERT(set, k)
+#define SET_REMOVE(set, k)			SET4096_REMOVE(set, k)
+#define SET_FIND(set, k)			SET4096_FIND(set, k)
+#define SET_FIND_BELOW(set, k, n)	SET4096_FIND_BELOW(set, k, n)
+#define SET_EMPTY(set)				SET4096_EMPTY(set)
+typedef uint64_t setWord_t;
+#define SET_SUMMARY(set)			((set).summary)
+#define SET_GROUP(set, g)			((set).words[g])
+#define SET_SHIFT					6
+#define SET_MSB(x)					SET4096_MSB(x)
+#else
+typedef struct set56 waitingSet_t;
+#define WAITING_MAX				56
+#define SET_INSERT(set, k)			SET56_INSERT(set, k)
+#define SET_REMOVE(set, k)			SET56_REMOVE(set, k)
+#define SET_FIND(set, k)			SET56_FIND(set, k)
+#define SET_FIND_BELOW(set, k, n)	SET56_FIND_BELOW(set, k, n)
+#define SET_EMPTY(set)				SET56_EMPTY(set)
+typedef uint8_t setWord_t;
+#define SET_SUMMARY(set)			((set).bytes)
+#define SET_GROUP(set, g)			((set).bits[g])
+#define SET_SHIFT					3
+#define SET_MSB(x)					(log2lookup[x] - 1)
+#endif
+
+/* With AOK_MPSC ao_post() marks the AO waiting without the lock, a set is
+ * read and changed as a whole word, see waiting_insert(). The set4096 is
+ * too large for that and stays under the lock, only the push is lock-free
+ * then. */
+#if defined(AOK_MPSC) && !defined(AOK_SET4096)
+#define WAITING_LOCK_FREE
+union waitingSet{
+	struct set56 set;
+	uint64_t word;
+};
+#endif
+
+/* The scheduler reads the sets and waitingPrio without the lock. On the host
+ * the group bit of an insert is stored with release and read with acquire,
+ * so an AO found through it has its event visible. The target is single
+ * core and reads them plain. */
+#ifdef AOK_HOST
+#define LOAD_ACQUIRE(x)			__atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define LOAD_RELAXED(x)			__atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define STORE_RELEASE(x, v)		__atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define STORE_RELAXED(x, v)		__atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#else
+#define LOAD_ACQUIRE(x)			(x)
+#define LOAD_RELAXED(x)			(x)
+#define STORE_RELEASE(x, v)		((x) = (v))
+#define STORE_RELAXED(x, v)		((x) = (v))
+#endif
+
 /**/
 struct scheduler{
 	struct ao *aos[MAX_NR_AOS];  /* Reference to registered AOs */
-	uint8_t nAoOnPrio[NR_PRIO_LVL];  /* Number of registered AOs on priority [x] */
-	uint8_t aoPrioOffset[NR_PRIO_LVL];  /* Offset in the AO list for priority [x] */
-	volatile struct set56 waitingAoSet[NR_PRIO_LVL];  /**/
+	aoHandle_t nAoOnPrio[NR_PRIO_LVL];  /* Number of registered AOs on priority [x] */
+	aoHandle_t aoPrioOffset[NR_PRIO_LVL];  /* Offset in the AO list for priority [x] */
+#ifdef WAITING_LOCK_FREE
+	union waitingSet waitingAoSet[NR_PRIO_LVL];  /**/
+#else
+	volatile waitingSet_t waitingAoSet[NR_PRIO_LVL];  /**/
+#endif
 	volatile uint8_t waitingPrio;  /* Bit x signals non empty queue in AO having prio x */
 	volatile uint8_t prioMask;  /* Mask holding the currently handled priority */
-	uint8_t nAos;  /* Number of registered AOs */
+	aoHandle_t nAos;  /* Number of registered AOs */
 };
 
 /**/
@@ -54,12 +123,30 @@ static struct event entryEvt = {.sig = STATE_ENTRY_SIG};
 static struct event initEvt = {.sig = STATE_INIT_SIG};
 static struct event exitEvt = {.sig = STATE_EXIT_SIG};
 
+/* Events are equal if sig, data and obj are, see ao_post_unique(). */
+static bool event_equal(const void *, const void *);
+#ifndef AOK_MPSC
+static uint32_t event_hash(const void *);
+static const struct xQueueKey eventKey = {
+	.hash = event_hash,
+	.equal = event_equal
+};
+#endif
+
 /******************************************************************************
  * PROTOTYPES (LOCAL)
  *****************************************************************************/
 static void state_entry_hsm(struct aoHsm *, uint32_t);
 static void dispatch_hsm(struct aoHsm *, struct event *);
 static void dispatch_stm(struct aoStm *, struct event *);
+static int32_t post(struct ao *, struct event *, bool);
+static void run_waiting(void);
+static inline bool waiting_find(uint32_t, uint32_t *);
+static inline bool waiting_find_below(uint32_t, uint32_t, uint32_t *);
+static inline void waiting_insert(struct ao *);
+static inline void waiting_remove(uint32_t, uint32_t, struct ao *);
+static inline void prio_idle(uint32_t);
+static inline void handle_ao(uint32_t, uint32_t);
 
 /******************************************************************************
  * SUBROUTINES (LOCAL)
@@ -150,14 +237,223 @@ static void dispatch_stm(struct aoStm *ao, struct event *e)
 }
 /*---------------------------------------------------------------------------*/
 
+#ifdef WAITING_LOCK_FREE
+/*
+ * Highest AO waiting on a priority. With AOK_MPSC the sets and waitingPrio
+ * are changed by ao_post() without the lock: a post inserts the AO after
+ * its event is published, the scheduler removes it and then checks the
+ * queue again, both sequentially consistent. So either the scheduler sees
+ * the event or the post sees the AO removed and inserts it again. The same
+ * holds for waitingPrio in prio_idle(). An AO may be found waiting with the
+ * event already handled, though.
+ *
+ * Return:		false if no AO is waiting
+ */
+static inline bool waiting_find(uint32_t prio, uint32_t *k)
+{
+	union waitingSet s;
+
+	s.word = __atomic_load_n(&self.waitingAoSet[prio].word, __ATOMIC_SEQ_CST);
+	if(SET_EMPTY(s.set))
+		return false;
+	SET_FIND(s.set, *k);
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Highest AO waiting on a priority below the AO k.
+ *
+ * Return:		false if there is none
+ */
+static inline bool waiting_find_below(uint32_t prio, uint32_t k, uint32_t *next)
+{
+	union waitingSet s;
+	int32_t n;
+
+	s.word = __atomic_load_n(&self.waitingAoSet[prio].word, __ATOMIC_SEQ_CST);
+	SET_FIND_BELOW(s.set, k, n);
+	*next = n;
+	return n >= 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Marks the AO waiting. Called by ao_post() after the push.
+ */
+static inline void waiting_insert(struct ao *ao)
+{
+	union waitingSet s = {.word = 0};
+
+	SET_INSERT(s.set, ao->handle - self.aoPrioOffset[ao->prio]);
+	__atomic_fetch_or(&self.waitingAoSet[ao->prio].word, s.word,
+						__ATOMIC_SEQ_CST);
+	__atomic_fetch_or(&self.waitingPrio, ao->prioMask, __ATOMIC_SEQ_CST);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Removes the AO k from the waiting set if its queue is empty.
+ */
+static inline void waiting_remove(uint32_t prio, uint32_t k, struct ao *ao)
+{
+	union waitingSet s, old;
+
+	if(!AO_QUEUE_EMPTY(ao))
+		return;
+	old.word = __atomic_load_n(&self.waitingAoSet[prio].word,
+								__ATOMIC_RELAXED);
+	do{
+		s = old;
+		SET_REMOVE(s.set, k);
+	}while(!__atomic_compare_exchange_n(&self.waitingAoSet[prio].word,
+			&old.word, s.word, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
+	/* a post in between may have seen the AO still waiting */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(!AO_QUEUE_EMPTY(ao)){
+		s.word = 0;
+		SET_INSERT(s.set, k);
+		__atomic_fetch_or(&self.waitingAoSet[prio].word, s.word,
+							__ATOMIC_SEQ_CST);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Clears the priority in waitingPrio if no AO is waiting on it anymore.
+ */
+static inline void prio_idle(uint32_t prio)
+{
+	if(__atomic_load_n(&self.waitingAoSet[prio].word, __ATOMIC_SEQ_CST))
+		return;
+	__atomic_fetch_and(&self.waitingPrio, (uint8_t) ~self.prioMask,
+						__ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&self.waitingAoSet[prio].word, __ATOMIC_SEQ_CST))
+		__atomic_fetch_or(&self.waitingPrio, self.prioMask, __ATOMIC_SEQ_CST);
+}
+/*---------------------------------------------------------------------------*/
+#else
+/*
+ * Highest AO waiting on a priority. ao_post() pushes and inserts within the
+ * same critical section, the scheduler reads the set without: an insert sets
+ * the bit of the AO before it publishes the one of its group, the group is
+ * read once from the summary loaded.
+ *
+ * Return:		false if no AO is waiting
+ */
+static inline bool waiting_find(uint32_t prio, uint32_t *k)
+{
+	volatile waitingSet_t *set = &self.waitingAoSet[prio];
+	setWord_t m;
+	uint32_t g;
+
+	m = LOAD_ACQUIRE(SET_SUMMARY(*set));
+	if(m == 0)
+		return false;
+	g = SET_MSB(m);
+	m = LOAD_RELAXED(SET_GROUP(*set, g));
+	*k = (g << SET_SHIFT) + SET_MSB(m);
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Highest AO waiting on a priority below the AO k. An AO found in the group
+ * of k may have its event not visible yet, see handle_ao().
+ *
+ * Return:		false if there is none
+ */
+static inline bool waiting_find_below(uint32_t prio, uint32_t k, uint32_t *next)
+{
+	volatile waitingSet_t *set = &self.waitingAoSet[prio];
+	uint32_t g = k >> SET_SHIFT;
+	setWord_t m;
+
+	m = LOAD_RELAXED(SET_GROUP(*set, g)) &
+			(((setWord_t) 1 << (k & ((1 << SET_SHIFT) - 1))) - 1);
+	if(m == 0){
+		m = LOAD_ACQUIRE(SET_SUMMARY(*set)) & (((setWord_t) 1 << g) - 1);
+		if(m == 0)
+			return false;
+		g = SET_MSB(m);
+		m = LOAD_RELAXED(SET_GROUP(*set, g));
+	}
+	*next = (g << SET_SHIFT) + SET_MSB(m);
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Marks the AO waiting. Called by ao_post() within the critical section.
+ */
+static inline void waiting_insert(struct ao *ao)
+{
+	volatile waitingSet_t *set = &self.waitingAoSet[ao->prio];
+	uint32_t k = ao->handle - self.aoPrioOffset[ao->prio];
+	uint32_t g = k >> SET_SHIFT;
+
+	STORE_RELAXED(SET_GROUP(*set, g), SET_GROUP(*set, g) |
+			((setWord_t) 1 << (k & ((1 << SET_SHIFT) - 1))));
+	STORE_RELEASE(SET_SUMMARY(*set), SET_SUMMARY(*set) | ((setWord_t) 1 << g));
+	STORE_RELEASE(self.waitingPrio, self.waitingPrio | ao->prioMask);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Removes the AO k from the waiting set if its queue is empty.
+ */
+static inline void waiting_remove(uint32_t prio, uint32_t k, struct ao *ao)
+{
+	INT_GLOB_MASK_SET;
+	if(AO_QUEUE_EMPTY(ao)){
+		SET_REMOVE(self.waitingAoSet[prio], k);
+	}
+	INT_GLOB_MASK_CLEAR;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Clears the priority in waitingPrio if no AO is waiting on it anymore.
+ */
+static inline void prio_idle(uint32_t prio)
+{
+	INT_GLOB_MASK_SET;
+	if(SET_EMPTY(self.waitingAoSet[prio]))
+		self.waitingPrio &= ~self.prioMask;
+	INT_GLOB_MASK_CLEAR;
+}
+/*---------------------------------------------------------------------------*/
+#endif
+
+/*
+ * Dispatches the next event of the AO k on the priority and removes the AO
+ * from the waiting set if its queue is empty then.
+ */
+static inline void handle_ao(uint32_t prio, uint32_t k)
+{
+	struct ao *ao = self.aos[self.aoPrioOffset[prio] + k];
+	struct event *e;
+
+	if(!AO_QUEUE_GET(ao, &e)){
+		(*ao->dispatch)(ao, e);
+		AO_QUEUE_CONSUME(ao);
+	}else{
+		/* The event was handled before the post marked the AO (AOK_MPSC)
+		 * or isn't visible yet, the AO stays waiting then. */
+	}
+	waiting_remove(prio, k, ao);
+}
+/*---------------------------------------------------------------------------*/
+
 /*
  * Scheduler sub-function.
  * This function gets events from non-empty queues having the same priority.
  * Because most of the time, only a single queue is non-empty, this case is
  * handled separately in a first part. If multiple queues on this priority are
- * non-empty, the while loop is entered, where a copy of the set is used to
- * dispatch events in round robin fashion. Note that the first queue is
- * eventually accessed twice in a row.
+ * non-empty, the while loop is entered, where the set is walked down from
+ * the highest AO to dispatch events in round robin fashion. Note that the
+ * first queue is eventually accessed twice in a row.
  * After an AO is done, the waitingPrio bit-field is checked if a higher
  * priority AO is waiting. If yes, the function returns.
  *
@@ -165,52 +461,136 @@ static void dispatch_stm(struct aoStm *ao, struct event *e)
  */
 static inline void handle_prio(uint32_t prio)
 {
-	int32_t err;
-	uint32_t idx;
-	uint8_t k;
-	struct set56 tmpSet;
-	struct event *e;
-	struct ao *ao;
+	uint32_t k;
 
-	idx = self.aoPrioOffset[prio];
 	/* handle event of first queue */
-	SET56_FIND(self.waitingAoSet[prio], k);
-	ao = self.aos[idx+k];
-	err = xQueue_get(&ao->eventQueue, (void **) &e);
-	if(!err){
-		(*ao->dispatch)(ao, e);
-		xQueue_consume(&ao->eventQueue);
-		if(XQUEUE_EMPTY(&ao->eventQueue)){
-			SET56_REMOVE(self.waitingAoSet[prio], k);
-		}
-	}else{
-		while(1);  // TODO err
-		//SET56_REMOVE(self.waitingAoSet[prio], k);
-	}
+	if(waiting_find(prio, &k))
+		handle_ao(prio, k);
 	/* handle events of all the other queues if any */
-	while(!SET56_EMPTY(self.waitingAoSet[prio])){
-		tmpSet = self.waitingAoSet[prio];
+	while(waiting_find(prio, &k)){
 		do{
 			/* higher priority AO waiting */
-			if(self.waitingPrio >= (self.prioMask<<1))
+			if(LOAD_ACQUIRE(self.waitingPrio) >= (self.prioMask<<1))
 				return;
-			SET56_FIND(tmpSet, k);
-			SET56_REMOVE(tmpSet, k);
-			ao = self.aos[idx+k];
-			err = xQueue_get(&ao->eventQueue, (void **) &e);
-			if(!err){
-				(*ao->dispatch)(ao, e);
-				xQueue_consume(&ao->eventQueue);
-				if(XQUEUE_EMPTY(&ao->eventQueue)){
-					SET56_REMOVE(self.waitingAoSet[prio], k);
-				}
-			}else{
-				while(1);  // TODO err
-				//SET56_REMOVE(self.waitingAoSet[prio], k);
-			}
-		}while(!SET56_EMPTY(tmpSet));
+			handle_ao(prio, k);
+		}while(waiting_find_below(prio, k, &k));
+	}
+	/* an event posted after the last check keeps the priority waiting */
+	prio_idle(prio);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Handles the waiting priorities, the highest first, until no event is
+ * waiting anymore.
+ */
+static void run_waiting(void)
+{
+	uint32_t n;
+	uint32_t prio;
+	uint8_t waiting = LOAD_ACQUIRE(self.waitingPrio);
+
+	do{
+#ifdef AOK_SET4096
+		n = 32 - __builtin_clz(waiting);
+#else
+		n = log2lookup[waiting];
+#endif
+		prio = NR_PRIO_LVL - n;
+		self.prioMask = 1 << (n-1);
+		handle_prio(prio);
+		waiting = LOAD_ACQUIRE(self.waitingPrio);
+	}while(waiting);
+	self.prioMask = 0;
+}
+/*---------------------------------------------------------------------------*/
+
+#ifndef AOK_MPSC
+/*
+ * Hash of sig, data and obj of an event (the padding isn't part of it).
+ */
+static uint32_t event_hash(const void *p)
+{
+	uint32_t h;
+	const struct event *e = (const struct event *) p;
+
+	h = ((uint32_t)(uint16_t) e->sig | ((uint32_t) e->data << 16)) * 0x9e3779b1u;
+	h ^= (uint32_t)((uintptr_t) e->obj * 0x85ebca77u);
+	return h ^ (h >> 15);
+}
+/*---------------------------------------------------------------------------*/
+#endif
+
+static bool event_equal(const void *p, const void *q)
+{
+	const struct event *a = (const struct event *) p;
+	const struct event *b = (const struct event *) q;
+
+	return (a->sig == b->sig) && (a->data == b->data) && (a->obj == b->obj);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Queues the event and marks the AO as waiting. A full queue is fatal, it is
+ * trapped outside of the critical section.
+ *
+ * Return:		 0		success
+ * 				-2		unique and an equal event is already queued
+ */
+static int32_t post(struct ao *ao, struct event *e, bool unique)
+{
+    int32_t err;
+
+	//assert(ao->handle >= self.nAos);
+	//assert(ao != self.aos[ao->handle]);
+#ifdef AOK_MPSC
+	/* lock-free, only unique posts are serialized by the lock */
+	if(unique){
+		INT_GLOB_MASK_SET;
+		err = mpscQueue_push_unique(&ao->eventQueue, e, event_equal);
+		INT_GLOB_MASK_CLEAR;
+	}else{
+		err = mpscQueue_push(&ao->eventQueue, e);
 	}
-	self.waitingPrio &= ~self.prioMask;
+	if(err == -1) while(1){}
+	if(err)
+		return err;
+#if defined(AOK_SMP)
+	aokSmp_ready(ao);
+#elif defined(WAITING_LOCK_FREE)
+	waiting_insert(ao);
+	aokHost_wake();
+#else
+	INT_GLOB_MASK_SET;
+	waiting_insert(ao);
+	INT_GLOB_MASK_CLEAR;
+	aokHost_wake();
+#endif
+	return 0;
+#elif defined(AOK_SMP)
+	err = unique ? xQueue_push_unique(&ao->eventQueue, e)
+			: xQueue_push(&ao->eventQueue, e);
+	if(err == -1) while(1){}
+	if(err == 0)
+		aokSmp_ready(ao);
+	return err;
+#else
+	/* push and insert in one critical section, the mask doesn't nest on the
+	   target, hence the pushes not masking by themselves */
+	INT_GLOB_MASK_SET;
+	err = unique ? xQueue_push_unique_unlocked(&ao->eventQueue, e)
+			: xQueue_push_unlocked(&ao->eventQueue, e);
+	if(err == 0)
+		waiting_insert(ao);
+	INT_GLOB_MASK_CLEAR;
+	if(err == -1) while(1){}
+	if(err)
+		return err;
+#ifdef AOK_HOST
+	aokHost_wake();
+#endif
+	return 0;
+#endif
 }
 /*---------------------------------------------------------------------------*/
 
@@ -235,24 +615,27 @@ static inline void handle_prio(uint32_t prio)
  * depends on whether ao_post() or ao_dispatch() is issued.
  * Note the TASK pragma below. It tells the compiler that this function is
  * entered only once and never left, helping the compiler to save RAM and Flash.
+ * On the host (AOK_HOST) the scheduler sleeps instead of spinning while idle
+ * and returns after aokHost_stop().
  */
 #pragma TASK(ao_scheduler)
 void ao_scheduler(void)
 {
-	uint32_t n;
-	uint32_t prio;
-
+#ifdef AOK_SMP
+	/* AOs are run by a pool of worker threads */
+	aokSmp_run();
+	return;
+#endif
 	while(1){
 		/* Sleep/idle till something happens */
+#ifdef AOK_HOST
+		if(!aokHost_idle(&self.waitingPrio))
+			return;
+#else
 		while(!self.waitingPrio){}
+#endif
 		/* something happened */
-		do{
-			n = log2lookup[self.waitingPrio];
-			prio = NR_PRIO_LVL - n;
-			self.prioMask = 1 << (n-1);
-			handle_prio(prio);
-		}while(self.waitingPrio);
-		self.prioMask = 0;
+		run_waiting();
 		/* Nothing to do at the moment. Check error then sleep. */
 		//assert(entryEvt.sig != STATE_ENTRY_SIG);
 		//assert(initEvt.sig != STATE_INIT_SIG);
@@ -262,10 +645,25 @@ void ao_scheduler(void)
 }
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Dispatches the waiting events until all queues are empty, then returns.
+ * It takes the place of ao_scheduler() where the caller runs the loop,
+ * e.g. a simulation stepping the AOs in virtual time (sim/uartemu). Not for
+ * use together with ao_scheduler().
+ */
+void ao_run_waiting(void)
+{
+	if(self.waitingPrio)
+		run_waiting();
+}
+/*---------------------------------------------------------------------------*/
+
 /*
  * Initialize the event queue.
  * Each active object has an event queue of xQueue type where the events
  * are stored. This function is a wrapper for the xQueue_init() function.
+ * With AOK_MPSC it is a mpscQueue holding the largest power of two events
+ * not above len, at most AOK_MPSC_MAX_EVENTS.
  *
  * Argument:    ao      pointer to active object
  *              mem     pointer to event queue memory
@@ -275,8 +673,44 @@ void ao_scheduler(void)
  */
 int32_t ao_init_event_queue(struct ao *ao, struct event *mem, uint8_t len)
 {
+#ifdef AOK_MPSC
+    uint32_t n = AOK_MPSC_MAX_EVENTS;
+
+    if(len >= 0x80)
+        return -1;
+    while(n > len)
+        n >>= 1;
+    return mpscQueue_init(&ao->eventQueue, (void *) mem, ao->eventSeq,
+                          n, sizeof(struct event));
+#else
     return xQueue_init(&ao->eventQueue, (void *) mem,
                        len, sizeof(struct event));
+#endif
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Assign a hash set to the event queue for ao_post_unique(). Call it after
+ * ao_init_event_queue().
+ *
+ * Argument:    ao      pointer to active object
+ *              set     pointer to the hash set memory, len bytes
+ *              len     power of 2 greater than the event queue length, up
+ *                      to 256. Twice the queue length is a good choice.
+ * Return:       0      success
+ *              -1      invalid length
+ */
+int32_t ao_init_unique(struct ao *ao, uint8_t *set, uint32_t len)
+{
+#ifdef AOK_MPSC
+    /* the queued events are compared one by one, no set needed */
+    (void) ao;
+    (void) set;
+    (void) len;
+    return 0;
+#else
+    return xQueue_init_unique(&ao->eventQueue, set, len, &eventKey);
+#endif
 }
 /*---------------------------------------------------------------------------*/
 
@@ -322,7 +756,7 @@ int32_t ao_init_hsm_state_memory(struct aoHsm *ao, struct hsmState *mem,
  * 				-1		active object is a NULL pointer
  * 				-2		event queue memory is a NULL pointer
  * 				-3		Priority exceeded
- * 				-4		AO list full
+ * 				-4		AO list or priority full
  * 				-5		AO inheriting from aoHsm needs state memory
  */
 int32_t ao_register(struct ao *ao, uint32_t prio, bool hsm)
@@ -336,7 +770,7 @@ int32_t ao_register(struct ao *ao, uint32_t prio, bool hsm)
 		return -2;
 	if(prio >= NR_PRIO_LVL)
 		return -3;
-	if(self.nAos >= MAX_NR_AOS)
+	if(self.nAos >= MAX_NR_AOS || self.nAoOnPrio[prio] >= WAITING_MAX)
 		return -4;
 	/**/
 	for(i=NR_PRIO_LVL-1; i>prio; i--){
@@ -351,7 +785,14 @@ int32_t ao_register(struct ao *ao, uint32_t prio, bool hsm)
 	ao->handle = nAosLow;
 	ao->prio = prio;
 	ao->prioMask = 1 << (NR_PRIO_LVL - prio - 1);
+#ifdef AOK_SMP
+	ao->runState = AO_RUN_IDLE;
+#endif
+#ifdef AOK_MPSC
+	mpscQueue_reset(&ao->eventQueue);  /* make sure event queue empty */
+#else
 	xQueue_reset(&ao->eventQueue);  /* make sure event queue empty */
+#endif
 	/* Assign dispatch function (STM or HSM) and enter initial state */
 	if(hsm){
 		ao->dispatch = (dispatchAo_t) &dispatch_hsm;
@@ -386,16 +827,24 @@ int32_t ao_register(struct ao *ao, uint32_t prio, bool hsm)
  */
 void ao_post(struct ao *ao, struct event *e)
 {
-    int32_t err;
-	uint8_t k;
+	post(ao, e, false);
+}
+/*---------------------------------------------------------------------------*/
 
-	//assert(ao->handle >= self.nAos);
-	//assert(ao != self.aos[ao->handle]);
-	err = xQueue_push(&ao->eventQueue, e);
-	if(err) while(1){}
-	k = ao->handle - self.aoPrioOffset[ao->prio];
-	SET56_INSERT(self.waitingAoSet[ao->prio], k);
-	self.waitingPrio |= ao->prioMask;
+/*
+ * Post an event unless an equal event (same sig, data and obj) is still
+ * waiting in the event queue of the AO, e.g. to not request the same data
+ * twice. The duplicate lookup needs the hash set assigned with
+ * ao_init_unique(), otherwise all queued events are compared.
+ *
+ * Argument:	ao		pointer to the AO
+ * 				event	pointer to the event that will be queued
+ * Return:		 0		posted
+ * 				-2		an equal event is already queued, nothing posted
+ */
+int32_t ao_post_unique(struct ao *ao, struct event *e)
+{
+	return post(ao, e, true);
 }
 /*---------------------------------------------------------------------------*/
 
@@ -422,6 +871,13 @@ void ao_dispatch(struct ao *ao, struct event *e)
 
 	//assert(ao->handle >= self.nAos);
 	//assert(ao != self.aos[ao->handle]);
+#ifdef AOK_HOST
+	/* preempting is only possible from within the scheduler thread */
+	if(!aokHost_in_scheduler()){
+		ao_post(ao, e);
+		return;
+	}
+#endif
 	if(ao->prioMask > self.prioMask){
 		tmp = self.prioMask;  /* backup */
 		self.prioMask = ao->prioMask;
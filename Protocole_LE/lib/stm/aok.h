@@ -23,6 +23,9 @@
  *****************************************************************************/
 #include "lib/stm/event.h"
 #include "lib/mem/xQueue.h"
+#ifdef AOK_MPSC
+#include "lib/mem/mpscQueue.h"
+#endif
 
 /******************************************************************************
  * DEFINES
@@ -32,20 +35,51 @@
 #define NR_PRIO_LVL			8
 
 /* Maximal number of active objects (AO). Using set56, there is a maximum of
- * NR_PRIO_LVL x 56 allowed. */
+ * NR_PRIO_LVL x 56 allowed. The scheduler built with AOK_SET4096 (CONFIG +=
+ * aok_set4096 on the host) keeps the waiting AOs in a set4096 instead, for
+ * up to 4096 AOs. */
+#ifdef AOK_SET4096
+#define MAX_NR_AOS			4096
+#else
 #define MAX_NR_AOS			64
+#endif
+
+/* Lock-free event queues on the host (lib/mem/mpscQueue.c), enabled with
+ * CONFIG += aok_mpsc. Maximal number of events of a queue, the length given
+ * to ao_init_event_queue() is rounded down to a power of two. */
+#ifdef AOK_MPSC
+#ifndef AOK_HOST
+#error "AOK_MPSC needs the host port (AOK_HOST)"
+#endif
+#define AOK_MPSC_MAX_EVENTS	64
+#endif
 
 /******************************************************************************
  * TYPEDEFS
  *****************************************************************************/
+/* Position of an AO in the scheduler list. */
+#if MAX_NR_AOS > 0xff
+typedef uint16_t aoHandle_t;
+#else
+typedef uint8_t aoHandle_t;
+#endif
+
 /* Basic structure of an active object (AO). */
 struct ao{
+#ifdef AOK_MPSC
+	struct mpscQueue eventQueue;
+	uint32_t eventSeq[AOK_MPSC_MAX_EVENTS];  /* slot sequence numbers */
+#else
 	struct xQueue eventQueue;
+#endif
 	void (*dispatch)(struct ao *, struct event *);
-	uint8_t handle;  /* holds the position of the AO in the scheduler list */
+	aoHandle_t handle;  /* holds the position of the AO in the scheduler list */
 	uint8_t prio;  /* AO priority */
 	uint8_t prioMask;  /* AO priority. Redundant priority as shift. */
 	uint8_t objType;  /* This field allows to identify the structure type. */
+#ifdef AOK_SMP
+	uint8_t runState;  /* idle, ready or running, see aokSmp.c */
+#endif
 };
 
 /* Structure of an active object (AO), being a HSM or a STM.
@@ -80,6 +114,23 @@ typedef void (*stmState_t)(struct aoStm *, struct event *);
  * MACROS
  *****************************************************************************/
 
+/*--- Event queue ---*/
+
+/* Access of the kernel (aok.c, aokSmp.c) to the event queue of an AO. The
+ * consumer side is wait-free for both queue types.
+ * Argument:	ao		pointer to AO
+ * 				pe		address of the event pointer
+ */
+#ifdef AOK_MPSC
+#define AO_QUEUE_GET(ao, pe)	mpscQueue_get(&(ao)->eventQueue, (void **)(pe))
+#define AO_QUEUE_CONSUME(ao)	mpscQueue_consume(&(ao)->eventQueue)
+#define AO_QUEUE_EMPTY(ao)		mpscQueue_empty(&(ao)->eventQueue)
+#else
+#define AO_QUEUE_GET(ao, pe)	xQueue_get(&(ao)->eventQueue, (void **)(pe))
+#define AO_QUEUE_CONSUME(ao)	xQueue_consume(&(ao)->eventQueue)
+#define AO_QUEUE_EMPTY(ao)		XQUEUE_EMPTY(&(ao)->eventQueue)
+#endif
+
 /*--- STM ---*/
 
 /* Macro to set the next state. Only needed for state initialization.
@@ -155,11 +206,14 @@ typedef void (*stmState_t)(struct aoStm *, struct event *);
  * PROTOTYPES
  *****************************************************************************/
 extern void ao_scheduler(void);
+extern void ao_run_waiting(void);
 extern int32_t ao_init_event_queue(struct ao *, struct event *, uint8_t);
+extern int32_t ao_init_unique(struct ao *, uint8_t *, uint32_t);
 extern int32_t ao_init_hsm_state_memory(struct aoHsm *, struct hsmState *,
                                         uint8_t);
 extern int32_t ao_register(struct ao *, uint32_t, bool);
 extern void ao_post(struct ao *, struct event *);
+extern int32_t ao_post_unique(struct ao *, struct event *);
 extern void ao_dispatch(struct ao *, struct event *);
 
 
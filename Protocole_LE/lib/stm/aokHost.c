@@ -0,0 +1,283 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: aokHost.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Linux port of the active object kernel (aok.c). The kernel itself is
+ * 		the same as on the target, only the two things that depend on the
+ * 		hardware are replaced:
+ * 		 - The global interrupt mask (INT_GLOB_MASK_SET/CLEAR) becomes a
+ * 		   lock on an atomic word. Threads only wait in the kernel (futex)
+ * 		   if the lock is contended. Like the interrupt mask on the target,
+ * 		   it may be taken again by the thread holding it.
+ * 		 - The scheduler doesn't spin on waitingPrio anymore but sleeps on a
+ * 		   futex while nothing is waiting. ao_post() only enters the kernel
+ * 		   to wake it if the scheduler is actually asleep, so posting to a
+ * 		   busy scheduler costs no system call.
+ *
+ * 		The port is enabled with AOK_HOST, which is defined by the host
+ * 		projConfig.h (host/config/projConfig.h). ao_scheduler() runs in the
+ * 		thread that calls it and returns after aokHost_stop(). Events may be
+ * 		posted from any thread, ao_dispatch() called from another thread than
+ * 		the scheduler falls back to ao_post().
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "lib/stm/aokHost.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+/* lock word */
+enum{
+	LOCK_FREE,
+	LOCK_TAKEN,
+	LOCK_WAITERS,  /* taken and at least one thread may sleep on it */
+};
+
+#define LOCK_SPIN			64  /* tries before sleeping on the lock */
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX()			__builtin_ia32_pause()
+#elif defined(__arm__) || defined(__aarch64__)
+#define CPU_RELAX()			__asm__ volatile("yield")
+#else
+#define CPU_RELAX()			do{}while(0)
+#endif
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static uint32_t lockWord;
+static __thread uint32_t lockNesting;  /* > 0 if this thread holds the lock */
+/**/
+static uint32_t wakeSeq;  /* futex word of the scheduler, bumped by wakes */
+static uint32_t sleeping;  /* number of threads about to sleep or sleeping */
+static uint32_t stopped;
+static __thread bool inScheduler;
+/**/
+static uint32_t nWakeups;
+static uint32_t nContended;
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static void futex_wait(uint32_t *, uint32_t);
+static void futex_wake(uint32_t *, int32_t);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Sleeps as long as *addr holds val. Returns early on signals and spurious
+ * wakes, the callers check their condition again anyway.
+ */
+static void futex_wait(uint32_t *addr, uint32_t val)
+{
+	syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static void futex_wake(uint32_t *addr, int32_t n)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Enter the critical section (INT_GLOB_MASK_SET). The lock word goes to
+ * LOCK_WAITERS as soon as a thread has to sleep, so the unlock knows that it
+ * has to wake somebody.
+ */
+void aokHost_lock(void)
+{
+	uint32_t c;
+	uint32_t i;
+
+	if(lockNesting++)
+		return;
+	for(i=0; i<LOCK_SPIN; i++){
+		c = LOCK_FREE;
+		if(__atomic_compare_exchange_n(&lockWord, &c, LOCK_TAKEN, false,
+				__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return;
+		CPU_RELAX();
+	}
+	__atomic_fetch_add(&nContended, 1, __ATOMIC_RELAXED);
+	c = __atomic_exchange_n(&lockWord, LOCK_WAITERS, __ATOMIC_ACQUIRE);
+	while(c != LOCK_FREE){
+		futex_wait(&lockWord, LOCK_WAITERS);
+		c = __atomic_exchange_n(&lockWord, LOCK_WAITERS, __ATOMIC_ACQUIRE);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Leave the critical section (INT_GLOB_MASK_CLEAR).
+ */
+void aokHost_unlock(void)
+{
+	if(--lockNesting)
+		return;
+	if(__atomic_exchange_n(&lockWord, LOCK_FREE, __ATOMIC_RELEASE) == LOCK_WAITERS)
+		futex_wake(&lockWord, 1);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sleeping is split in three steps so any kind of waiter can use it: take
+ * the wake sequence and announce the sleeper (aokHost_prepare_sleep), check
+ * the own wait condition again, then sleep (aokHost_sleep) or give up
+ * (aokHost_cancel_sleep). The sleeper count is raised before the condition
+ * is checked, posters update the condition before they check the count
+ * (aokHost_wake). With both sides sequentially consistent, either the
+ * waiter sees the update or the poster sees the sleeper and wakes it, so no
+ * post is missed.
+ *
+ * Return:		wake sequence to hand to aokHost_sleep()
+ */
+uint32_t aokHost_prepare_sleep(void)
+{
+	uint32_t seq;
+
+	seq = __atomic_load_n(&wakeSeq, __ATOMIC_ACQUIRE);
+	__atomic_fetch_add(&sleeping, 1, __ATOMIC_SEQ_CST);
+	return seq;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sleep till aokHost_wake() or aokHost_stop() is called after the matching
+ * aokHost_prepare_sleep(). Returns early on spurious wakes.
+ *
+ * Argument:	seq		the value returned by aokHost_prepare_sleep()
+ */
+void aokHost_sleep(uint32_t seq)
+{
+	futex_wait(&wakeSeq, seq);
+	__atomic_fetch_sub(&sleeping, 1, __ATOMIC_RELAXED);
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+void aokHost_cancel_sleep(void)
+{
+	__atomic_fetch_sub(&sleeping, 1, __ATOMIC_RELAXED);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Idle function of the scheduler, replaces the busy wait on waitingPrio.
+ *
+ * Argument:	waitingPrio		the waiting priority field of the scheduler
+ * Return:		true	something is waiting
+ * 				false	the scheduler has been stopped
+ */
+bool aokHost_idle(volatile uint8_t *waitingPrio)
+{
+	uint32_t seq;
+
+	inScheduler = true;
+	while(!aokHost_stopped()){
+		seq = aokHost_prepare_sleep();
+		if(__atomic_load_n(waitingPrio, __ATOMIC_SEQ_CST)){
+			aokHost_cancel_sleep();
+			return true;
+		}
+		aokHost_sleep(seq);
+	}
+	return false;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Wake a sleeper if there is any. Called by ao_post() after the event has
+ * been queued.
+ */
+void aokHost_wake(void)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&sleeping, __ATOMIC_RELAXED)){
+		__atomic_fetch_add(&wakeSeq, 1, __ATOMIC_RELEASE);
+		__atomic_fetch_add(&nWakeups, 1, __ATOMIC_RELAXED);
+		futex_wake(&wakeSeq, 1);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Makes ao_scheduler() return once it is idle, wakes all sleepers.
+ */
+void aokHost_stop(void)
+{
+	__atomic_store_n(&stopped, 1, __ATOMIC_RELEASE);
+	__atomic_fetch_add(&wakeSeq, 1, __ATOMIC_RELEASE);
+	futex_wake(&wakeSeq, INT_MAX);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		true after aokHost_stop()
+ */
+bool aokHost_stopped(void)
+{
+	return __atomic_load_n(&stopped, __ATOMIC_ACQUIRE);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		true if called from the thread running ao_scheduler()
+ */
+bool aokHost_in_scheduler(void)
+{
+	return inScheduler;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		number of times a post had to wake the scheduler
+ */
+uint32_t aokHost_wakeups(void)
+{
+	return __atomic_load_n(&nWakeups, __ATOMIC_RELAXED);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		number of times a thread had to sleep on the lock
+ */
+uint32_t aokHost_contended(void)
+{
+	return __atomic_load_n(&nContended, __ATOMIC_RELAXED);
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
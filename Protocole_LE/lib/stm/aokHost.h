@@ -0,0 +1,48 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: aokHost.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Linux port of the active object kernel, see aokHost.c.
+ *
+ *****************************************************************************/
+
+#ifndef SOURCE_LIB_STM_AOKHOST_H_
+#define SOURCE_LIB_STM_AOKHOST_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+/* critical section, replaces the global interrupt mask */
+extern void aokHost_lock(void);
+extern void aokHost_unlock(void);
+/* idle/wake of the scheduler thread(s) */
+extern uint32_t aokHost_prepare_sleep(void);
+extern void aokHost_sleep(uint32_t);
+extern void aokHost_cancel_sleep(void);
+extern bool aokHost_idle(volatile uint8_t *);
+extern void aokHost_wake(void);
+extern void aokHost_stop(void);
+extern bool aokHost_stopped(void);
+extern bool aokHost_in_scheduler(void);
+/* statistics */
+extern uint32_t aokHost_wakeups(void);
+extern uint32_t aokHost_contended(void);
+
+
+#endif /* SOURCE_LIB_STM_AOKHOST_H_ */
@@ -0,0 +1,395 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: aokSmp.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Multi-core scheduler for the Linux host build (AOK_HOST and
+ * 		AOK_SMP). ao_scheduler() runs a pool of worker threads instead of
+ * 		the single-core loop, everything else of the kernel stays the same.
+ *
+ * 		Each worker has one run queue per priority level holding the AOs
+ * 		that have events waiting, and a bit field telling which of them are
+ * 		non-empty. A worker always takes the highest priority AO it can find:
+ * 		its own if no other worker has a higher priority one waiting,
+ * 		otherwise it steals from the other worker. An idle worker steals
+ * 		anything. Within a priority, AOs are taken round robin, one event
+ * 		per turn, like in the single-core scheduler.
+ *
+ * 		Run to completion: an AO is in at most one run queue, or being run
+ * 		by exactly one worker. This is tracked by ao->runState:
+ * 		 - ao_post() queues the event and moves the AO from idle to ready.
+ * 		   Only the one poster that succeeds puts it into a run queue (of
+ * 		   its home worker, handle % number of workers).
+ * 		 - The worker taking the AO marks it running and dispatches one
+ * 		   event. It then marks it idle and checks the event queue again; if
+ * 		   there are events left (or posted meanwhile, when the posters
+ * 		   couldn't mark it ready), the AO is put back to the worker's own
+ * 		   run queue.
+ * 		Hence events of an AO are dispatched in order and never concurrently,
+ * 		AOs still shouldn't share data other than through events.
+ *
+ * 		Workers sleep through the host port (aokHost_prepare_sleep()) if no
+ * 		run queue holds anything. ao_dispatch() doesn't preempt here, it
+ * 		always posts.
+ *
+ * 		The number of workers is fixed by the first post or the start of the
+ * 		scheduler, whichever comes first. AOs readied before the start wait
+ * 		in the run queue of their home worker.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "lib/stm/aok.h"
+#include "lib/stm/aokSmp.h"
+#include "config/projConfig.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define LOAD_RELAXED(x)			__atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define STORE_RELAXED(x, v)		__atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+
+/* An AO is in at most one run queue, so MAX_NR_AOS slots are enough. */
+struct runQueue{
+	struct ao *aos[MAX_NR_AOS];
+	uint32_t head;  /* free running */
+	uint32_t tail;  /* free running */
+};
+
+/**/
+struct worker{
+	pthread_mutex_t lock;  /* run queues */
+	uint32_t readyPrio;  /* bit x: run queue of priority x not empty */
+	struct runQueue rq[NR_PRIO_LVL];
+	struct aokSmpStats stats;  /* written by the worker only */
+	uint64_t startNs;
+	uint64_t stopNs;
+	pthread_t thread;
+}__attribute__((aligned(64)));
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static struct worker workers[AOK_SMP_MAX_WORKERS];
+static uint32_t nWorkers;
+static pthread_once_t setUp = PTHREAD_ONCE_INIT;
+static bool isSetUp;  /* atomic */
+static bool running;  /* atomic */
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static uint64_t now_ns(void);
+static void set_up(void);
+static void rq_push(struct worker *, struct ao *);
+static struct ao *rq_pop(struct worker *, uint32_t);
+static struct ao *take(struct worker *);
+static bool any_ready(void);
+static void run(struct worker *, struct ao *);
+static void *worker_main(void *);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/**/
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Fixes the number of workers and initializes their locks, once.
+ */
+static void set_up(void)
+{
+	uint32_t i;
+	long nCpu;
+
+	if(nWorkers == 0){
+		nCpu = sysconf(_SC_NPROCESSORS_ONLN);
+		nWorkers = (nCpu < 1) ? 1 : (nCpu > AOK_SMP_MAX_WORKERS) ?
+				AOK_SMP_MAX_WORKERS : (uint32_t) nCpu;
+	}
+	for(i=0; i<AOK_SMP_MAX_WORKERS; i++)
+		pthread_mutex_init(&workers[i].lock, NULL);
+	__atomic_store_n(&isSetUp, true, __ATOMIC_RELEASE);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Append a ready AO to the run queue of its priority.
+ */
+static void rq_push(struct worker *w, struct ao *ao)
+{
+	struct runQueue *rq = &w->rq[ao->prio];
+
+	pthread_mutex_lock(&w->lock);
+	rq->aos[rq->tail++ % MAX_NR_AOS] = ao;
+	STORE_RELAXED(w->readyPrio, w->readyPrio | (1u << ao->prio));
+	pthread_mutex_unlock(&w->lock);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Take the first AO of a run queue.
+ *
+ * Return:		the AO or NULL if the queue has been emptied meanwhile
+ */
+static struct ao *rq_pop(struct worker *w, uint32_t prio)
+{
+	struct runQueue *rq = &w->rq[prio];
+	struct ao *ao = NULL;
+
+	pthread_mutex_lock(&w->lock);
+	if(rq->head != rq->tail){
+		ao = rq->aos[rq->head++ % MAX_NR_AOS];
+		if(rq->head == rq->tail)
+			STORE_RELAXED(w->readyPrio, w->readyPrio & ~(1u << prio));
+	}
+	pthread_mutex_unlock(&w->lock);
+	return ao;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Find the highest priority ready AO, preferring the own run queues on
+ * equal priority. The bit fields are read without lock, a queue found empty
+ * when locking it makes the search start over.
+ *
+ * Return:		the AO or NULL if nothing is ready
+ */
+static struct ao *take(struct worker *w)
+{
+	uint32_t i, tries;
+	uint32_t ready, best;
+	struct worker *victim;
+	struct ao *ao;
+
+	for(tries=0; tries<=nWorkers; tries++){
+		ready = LOAD_RELAXED(w->readyPrio);
+		best = ready ? __builtin_ctz(ready) : NR_PRIO_LVL;
+		victim = w;
+		for(i=0; i<nWorkers; i++){
+			ready = LOAD_RELAXED(workers[i].readyPrio);
+			if(ready && (uint32_t) __builtin_ctz(ready) < best){
+				best = __builtin_ctz(ready);
+				victim = &workers[i];
+			}
+		}
+		if(best == NR_PRIO_LVL)
+			return NULL;
+		ao = rq_pop(victim, best);
+		if(ao != NULL){
+			if(victim != w)
+				STORE_RELAXED(w->stats.nStolen, w->stats.nStolen + 1);
+			return ao;
+		}
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static bool any_ready(void)
+{
+	uint32_t i;
+
+	for(i=0; i<nWorkers; i++){
+		if(__atomic_load_n(&workers[i].readyPrio, __ATOMIC_SEQ_CST))
+			return true;
+	}
+	return false;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Dispatch one event of the AO. The AO is put back to the own run queue if
+ * it has more events.
+ */
+static void run(struct worker *w, struct ao *ao)
+{
+	uint8_t state = AO_RUN_IDLE;
+	struct event *e;
+	uint64_t t0;
+
+	t0 = now_ns();
+	STORE_RELAXED(ao->runState, AO_RUN_RUNNING);
+	if(!AO_QUEUE_GET(ao, &e)){
+		(*ao->dispatch)(ao, e);
+		AO_QUEUE_CONSUME(ao);
+		STORE_RELAXED(w->stats.nDispatched, w->stats.nDispatched + 1);
+	}
+	/* posts seeing the AO running leave it to this check */
+	__atomic_store_n(&ao->runState, AO_RUN_IDLE, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(!AO_QUEUE_EMPTY(ao)){
+		if(__atomic_compare_exchange_n(&ao->runState, &state, AO_RUN_READY,
+				false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+			rq_push(w, ao);
+	}
+	STORE_RELAXED(w->stats.busyNs, w->stats.busyNs + (now_ns() - t0));
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Worker loop, runs till aokHost_stop().
+ */
+static void *worker_main(void *arg)
+{
+	struct worker *w = (struct worker *) arg;
+	struct ao *ao;
+	uint32_t seq;
+
+	while(!aokHost_stopped()){
+		ao = take(w);
+		if(ao != NULL){
+			run(w, ao);
+			continue;
+		}
+		seq = aokHost_prepare_sleep();
+		if(any_ready() || aokHost_stopped()){
+			aokHost_cancel_sleep();
+			continue;
+		}
+		STORE_RELAXED(w->stats.nSleeps, w->stats.nSleeps + 1);
+		aokHost_sleep(seq);
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Set the number of worker threads, before the first post. Without, one
+ * worker per online CPU is used.
+ *
+ * Argument:	n		number of workers
+ * Return:		 0		success
+ * 				-1		workers already set up (posted or running)
+ * 				-2		n is 0 or greater than AOK_SMP_MAX_WORKERS
+ */
+int32_t aokSmp_set_workers(uint32_t n)
+{
+	if(__atomic_load_n(&isSetUp, __ATOMIC_ACQUIRE))
+		return -1;
+	if(n == 0 || n > AOK_SMP_MAX_WORKERS)
+		return -2;
+	nWorkers = n;
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		number of worker threads
+ */
+uint32_t aokSmp_workers(void)
+{
+	return nWorkers;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Run the workers, called by ao_scheduler(). Worker 0 is the calling thread,
+ * the others are started here. Returns after aokHost_stop(), once all
+ * workers are done.
+ */
+void aokSmp_run(void)
+{
+	uint32_t i;
+	uint64_t t;
+
+	pthread_once(&setUp, set_up);
+	t = now_ns();
+	for(i=0; i<nWorkers; i++){
+		memset(&workers[i].stats, 0, sizeof(workers[i].stats));
+		workers[i].startNs = t;
+	}
+	__atomic_store_n(&running, true, __ATOMIC_RELEASE);
+	for(i=1; i<nWorkers; i++)
+		pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+	worker_main(&workers[0]);
+	for(i=1; i<nWorkers; i++)
+		pthread_join(workers[i].thread, NULL);
+	t = now_ns();
+	for(i=0; i<nWorkers; i++)
+		workers[i].stopNs = t;
+	__atomic_store_n(&running, false, __ATOMIC_RELEASE);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Called by ao_post() once the event is queued. Puts the AO into the run
+ * queue of its home worker unless it is ready or running already.
+ *
+ * Argument:	ao		pointer to the AO
+ */
+void aokSmp_ready(struct ao *ao)
+{
+	uint8_t state = AO_RUN_IDLE;
+
+	if(__atomic_compare_exchange_n(&ao->runState, &state, AO_RUN_READY,
+			false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)){
+		pthread_once(&setUp, set_up);
+		rq_push(&workers[ao->handle % nWorkers], ao);
+		aokHost_wake();
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Read the statistics of a worker.
+ *
+ * Argument:	worker	worker index
+ * 				stats	destination
+ * Return:		 0		success
+ * 				-1		no such worker
+ */
+int32_t aokSmp_stats(uint32_t worker, struct aokSmpStats *stats)
+{
+	struct worker *w;
+
+	if(!__atomic_load_n(&isSetUp, __ATOMIC_ACQUIRE) || worker >= nWorkers)
+		return -1;
+	w = &workers[worker];
+	stats->busyNs = LOAD_RELAXED(w->stats.busyNs);
+	if(__atomic_load_n(&running, __ATOMIC_ACQUIRE))
+		stats->totalNs = now_ns() - w->startNs;
+	else
+		stats->totalNs = w->stopNs - w->startNs;
+	stats->nDispatched = LOAD_RELAXED(w->stats.nDispatched);
+	stats->nStolen = LOAD_RELAXED(w->stats.nStolen);
+	stats->nSleeps = LOAD_RELAXED(w->stats.nSleeps);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
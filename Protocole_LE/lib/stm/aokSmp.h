@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: aokSmp.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Multi-core scheduler of the Linux host build, see aokSmp.c.
+ *
+ *****************************************************************************/
+
+#ifndef SOURCE_LIB_STM_AOKSMP_H_
+#define SOURCE_LIB_STM_AOKSMP_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lib/stm/aok.h"
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+/* Maximal number of worker threads. */
+#define AOK_SMP_MAX_WORKERS		16
+
+/* struct ao runState */
+enum aoRunState{
+	AO_RUN_IDLE,  /* event queue empty or events not noticed yet */
+	AO_RUN_READY,  /* in exactly one run queue */
+	AO_RUN_RUNNING,  /* dispatched by exactly one worker */
+};
+
+/******************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+/* Worker statistics. Utilization is busyNs/totalNs. */
+struct aokSmpStats{
+	uint64_t busyNs;  /* time spent dispatching events */
+	uint64_t totalNs;  /* time since the worker started, till it stopped */
+	uint32_t nDispatched;  /* events dispatched */
+	uint32_t nStolen;  /* AOs taken from the run queue of another worker */
+	uint32_t nSleeps;  /* times the worker went to sleep */
+};
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+extern int32_t aokSmp_set_workers(uint32_t);
+extern uint32_t aokSmp_workers(void);
+extern void aokSmp_run(void);
+extern void aokSmp_ready(struct ao *);
+extern int32_t aokSmp_stats(uint32_t, struct aokSmpStats *);
+
+
+#endif /* SOURCE_LIB_STM_AOKSMP_H_ */
@@ -27,7 +27,10 @@
 /******************************************************************************
  * DEFINES & MACROS & TYPEDEFS
  *****************************************************************************/
-#define EPOOL_NBUCKETS			32
+/* 4 kB by default, the project configuration may choose another size. */
+#ifndef EPOOL_NBUCKETS
+#define EPOOL_NBUCKETS			256
+#endif
 #define EPOOL_BUCKET_SIZE_S		4
 
 /******************************************************************************
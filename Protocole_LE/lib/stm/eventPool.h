@@ -30,14 +30,31 @@
 /******************************************************************************
  * MACROS
  *****************************************************************************/
+/* On the host the event pool is shared by several threads, the functions
+ * are found in eventPoolHost.c. */
+#ifndef AOK_HOST
 #define epool_alloc(size)		pool_alloc(&ePoolObj, size)
 #define epool_free(mem)			pool_free(&ePoolObj, mem)
 #define epool_get(mem)			pool_get(mem)
 #define epool_clear()			pool_clear(&ePoolObj)
+#define epool_stats(stats)		pool_stats(&ePoolObj, stats)
+#endif
 
 /******************************************************************************
  * TYPEDEFS
  *****************************************************************************/
+#ifdef AOK_HOST
+/* Counters of the host event pool, see epool_sync_stats(). */
+struct epoolSyncStats{
+	uint32_t nLocks;  /* Pool lock taken. */
+	uint32_t nContended;  /* Pool lock found taken by another thread. */
+	uint32_t nCacheHits;  /* Allocations served by the thread cache. */
+	uint32_t nCacheMisses;
+	uint32_t nFails;  /* Allocations without memory. */
+	uint32_t inUse;  /* Slots handed out and not freed. */
+	uint32_t inUseHighWater;
+};
+#endif
 
 /******************************************************************************
  * PROTOTYPES
@@ -48,5 +65,14 @@ extern struct pool ePoolObj;
 /**/
 extern void epool_init(void);
 
+#ifdef AOK_HOST
+extern void *epool_alloc(uint32_t);
+extern void epool_free(void *);
+extern void epool_get(void *);
+extern void epool_clear(void);
+extern void epool_stats(struct poolStats *);
+extern void epool_sync_stats(struct epoolSyncStats *);
+#endif
+
 
 #endif /* SOURCE_LIB_STM_EVENTPOOL_H_ */
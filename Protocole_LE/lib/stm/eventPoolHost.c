@@ -0,0 +1,353 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: eventPoolHost.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:	Linux implementation of the event pool (eventPool.h), built
+ * 				instead of eventPool.c on the host (see host.pri), where event
+ * 				data is allocated in one thread (e.g. the serial thread) and
+ * 				released in another (e.g. the UI thread).
+ *
+ * 				 -	The reference counter is changed atomically, a slot can be
+ * 				 	shared between threads with epool_get()/epool_free()
+ * 				 	without lock.
+ * 				 -	Each thread keeps a cache of released slots for the small
+ * 				 	sizes (up to EPOOL_CACHE_CLASSES buckets), allocations of
+ * 				 	these sizes are served from it without lock. The cache
+ * 				 	is refilled and emptied by EPOOL_CACHE_BATCH slots at once,
+ * 				 	so a thread only allocating or only releasing takes the
+ * 				 	pool lock once per batch.
+ * 				 -	Other sizes and the batches go to the pool under a mutex.
+ *
+ * 				Slots in a thread cache count as used in the pool statistics.
+ * 				The cache of a thread is given back when the thread exits.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "lib/stm/eventPool.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+/* 64 kB by default, the project configuration may choose another size. */
+#ifndef EPOOL_NBUCKETS
+#define EPOOL_NBUCKETS			4096
+#endif
+#define EPOOL_BUCKET_SIZE_S		4
+
+/* Thread cache: slot sizes 1 .. EPOOL_CACHE_CLASSES buckets, up to
+ * EPOOL_CACHE_DEPTH slots per size. */
+#define EPOOL_CACHE_CLASSES		4
+#define EPOOL_CACHE_DEPTH		16
+#define EPOOL_CACHE_BATCH		8
+
+#define COUNT(x)				__atomic_add_fetch(&(x), 1, __ATOMIC_RELAXED)
+#define LOAD_RELAXED(x)			__atomic_load_n(&(x), __ATOMIC_RELAXED)
+
+/* Released slots of one size, with a reference counter of 1. */
+struct cacheClass{
+	uint32_t n;
+	void *slot[EPOOL_CACHE_DEPTH];
+};
+
+struct cache{
+	bool registered;
+	struct cacheClass cls[EPOOL_CACHE_CLASSES];
+};
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/**/
+struct pool ePoolObj;
+
+/* 64-bit words, the slots are aligned alike, see POOL_HEADER_SIZE */
+static uint64_t poolMemory[(EPOOL_NBUCKETS << EPOOL_BUCKET_SIZE_S) / sizeof(uint64_t)];
+
+/**/
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t cacheKey;
+static __thread struct cache cache;
+
+/**/
+static struct epoolSyncStats syncStats;
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static void lock(void);
+static void unlock(void);
+static void count_in_use(int32_t);
+static void flush(struct cacheClass *, uint32_t);
+static void cache_exit(void *);
+static void create_key(void);
+static struct cache *get_cache(void);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Takes the pool lock and counts whether another thread had it.
+ */
+static void lock(void)
+{
+	if(pthread_mutex_trylock(&poolLock) != 0){
+		COUNT(syncStats.nContended);
+		pthread_mutex_lock(&poolLock);
+	}
+	COUNT(syncStats.nLocks);
+}
+/*---------------------------------------------------------------------------*/
+
+static void unlock(void)
+{
+	pthread_mutex_unlock(&poolLock);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Counts slots handed out (n > 0) or given back (n < 0).
+ */
+static void count_in_use(int32_t n)
+{
+	uint32_t inUse, highWater;
+
+	inUse = __atomic_add_fetch(&syncStats.inUse, n, __ATOMIC_RELAXED);
+	highWater = LOAD_RELAXED(syncStats.inUseHighWater);
+	while(inUse > highWater){
+		if(__atomic_compare_exchange_n(&syncStats.inUseHighWater, &highWater,
+				inUse, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Gives up to n slots of a cache class back to the pool. The lock has to be
+ * taken.
+ */
+static void flush(struct cacheClass *cls, uint32_t n)
+{
+	while((n != 0) && (cls->n != 0)){
+		pool_free(&ePoolObj, cls->slot[--cls->n]);
+		n--;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Destructor of the cache key, called when a thread that used the pool
+ * exits.
+ */
+static void cache_exit(void *arg)
+{
+	uint32_t i;
+	struct cache *c = (struct cache *) arg;
+
+	lock();
+	for(i=0; i<EPOOL_CACHE_CLASSES; i++)
+		flush(&c->cls[i], EPOOL_CACHE_DEPTH);
+	unlock();
+	c->registered = false;
+}
+/*---------------------------------------------------------------------------*/
+
+static void create_key(void)
+{
+	pthread_key_create(&cacheKey, cache_exit);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Cache of the calling thread, registered for cache_exit() on first use.
+ */
+static struct cache *get_cache(void)
+{
+	if(!cache.registered){
+		pthread_once(&keyOnce, create_key);
+		pthread_setspecific(cacheKey, &cache);
+		cache.registered = true;
+	}
+	return &cache;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ *
+ */
+void epool_init(void)
+{
+	int32_t err;
+
+	lock();
+	err = pool_init(&ePoolObj, (void *) poolMemory,
+			EPOOL_NBUCKETS, EPOOL_BUCKET_SIZE_S);
+	unlock();
+	(void) err;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Allocate memory for event data, thread safe.
+ *
+ * Argument:	size	Number of bytes to allocate.
+ * Return:		Pointer to allocated memory, NULL if the pool is exhausted.
+ */
+void *epool_alloc(uint32_t size)
+{
+	uint32_t n;
+	void *mem;
+	struct cacheClass *cls;
+
+	n = (size + POOL_HEADER_SIZE + (1 << EPOOL_BUCKET_SIZE_S) - 1)
+			>> EPOOL_BUCKET_SIZE_S;
+	if(n > EPOOL_CACHE_CLASSES){
+		lock();
+		mem = pool_alloc(&ePoolObj, size);
+		unlock();
+	}
+	else{
+		cls = &get_cache()->cls[n - 1];
+		if(cls->n != 0){
+			COUNT(syncStats.nCacheHits);
+		}
+		else{
+			/* Refill with slots of the full class size, so that they fit
+			 * every request of this class. */
+			COUNT(syncStats.nCacheMisses);
+			size = (n << EPOOL_BUCKET_SIZE_S) - POOL_HEADER_SIZE;
+			lock();
+			while(cls->n < EPOOL_CACHE_BATCH){
+				mem = pool_alloc(&ePoolObj, size);
+				if(mem == NULL)
+					break;
+				cls->slot[cls->n++] = mem;
+			}
+			unlock();
+		}
+		mem = (cls->n != 0) ? cls->slot[--cls->n] : NULL;
+	}
+
+	if(mem == NULL)
+		COUNT(syncStats.nFails);
+	else
+		count_in_use(1);
+	return mem;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Release allocated memory, thread safe. The slot may have been allocated
+ * by another thread.
+ *
+ * Argument:	mem		Pointer to allocated memory.
+ */
+void epool_free(void *mem)
+{
+	uint32_t n;
+	struct cacheClass *cls;
+
+	if((mem == NULL) || !pool_put_atomic(mem))
+		return;
+
+	count_in_use(-1);
+	n = pool_buckets(mem);
+	if(n > EPOOL_CACHE_CLASSES){
+		lock();
+		pool_free(&ePoolObj, mem);
+		unlock();
+	}
+	else{
+		cls = &get_cache()->cls[n - 1];
+		if(cls->n == EPOOL_CACHE_DEPTH){
+			lock();
+			flush(cls, EPOOL_CACHE_BATCH);
+			unlock();
+		}
+		cls->slot[cls->n++] = mem;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Increase the reference counter, thread safe.
+ *
+ * Argument:	mem		Pointer to allocated memory.
+ */
+void epool_get(void *mem)
+{
+	pool_get_atomic(mem);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sets all buckets to empty state. No other thread must use the pool at
+ * the same time or hold slots in its cache.
+ */
+void epool_clear(void)
+{
+	uint32_t i;
+	struct cache *c;
+
+	c = get_cache();
+	for(i=0; i<EPOOL_CACHE_CLASSES; i++)
+		c->cls[i].n = 0;
+	lock();
+	pool_clear(&ePoolObj);
+	unlock();
+	__atomic_store_n(&syncStats.inUse, 0, __ATOMIC_RELAXED);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Statistics of the pool, see pool_stats().
+ */
+void epool_stats(struct poolStats *stats)
+{
+	lock();
+	pool_stats(&ePoolObj, stats);
+	unlock();
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Counters of the thread safe layer.
+ */
+void epool_sync_stats(struct epoolSyncStats *stats)
+{
+	stats->nLocks = LOAD_RELAXED(syncStats.nLocks);
+	stats->nContended = LOAD_RELAXED(syncStats.nContended);
+	stats->nCacheHits = LOAD_RELAXED(syncStats.nCacheHits);
+	stats->nCacheMisses = LOAD_RELAXED(syncStats.nCacheMisses);
+	stats->nFails = LOAD_RELAXED(syncStats.nFails);
+	stats->inUse = LOAD_RELAXED(syncStats.inUse);
+	stats->inUseHighWater = LOAD_RELAXED(syncStats.inUseHighWater);
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
@@ -0,0 +1,793 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		:
+ * File			: timerDeamonHost.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:	Linux implementation of the timer deamon (timerDeamon.h),
+ * 				built instead of timerDeamon.c on the host (see host.pri).
+ *
+ * 				Instead of the wide timer and the timer slot arrays, the
+ * 				software timers are kept in a hierarchical timing wheel
+ * 				driven by a single timerfd:
+ * 				 -	The time is counted in microseconds since timerD_init()
+ * 				 	(CLOCK_MONOTONIC), each timer holds its absolute expiry.
+ * 				 -	There are TD_LEVELS wheels of 64 slots, wheel n covers
+ * 				 	64^(n+1) us. A timer is put into the wheel of the highest
+ * 				 	6-bit digit in which its expiry differs from the wheel
+ * 				 	time, hence starting and stopping a timer is a list
+ * 				 	insert/remove, independent of the number of timers.
+ * 				 -	A bit field per wheel tells which slots hold timers. The
+ * 				 	next expiry is found with count-trailing-zeros on these
+ * 				 	(one step per wheel) and the timerfd is armed for it, so
+ * 				 	there is no periodic tick.
+ * 				 -	When the wheel time advances, the passed slots of each
+ * 				 	wheel are emptied and their timers either expire or move
+ * 				 	down to a finer wheel.
+ * 				See also W. Ahern's timeout.c, which uses the same scheme.
+ *
+ * 				The timerfd is served by a thread started in timerD_init().
+ * 				Callbacks are called in this thread, without lock, like they
+ * 				are called from the timer ISR on the target; they may use the
+ * 				timer API and ao_post(). The API is thread safe.
+ *
+ * 				Differences to the target:
+ * 				 -	Up to TD_MAX_TIMERS timers, ids are indices.
+ * 				 -	timerD_create_timer() returns -1 instead of looping forever
+ * 				 	if no timer is left.
+ * 				 -	A periodic timer keeps its phase, expiries missed while the
+ * 				 	process didn't run are skipped.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
+
+#include "lib/timer/timerDeamon.h"
+#include "lib/stm/event.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#ifndef TD_MAX_TIMERS
+#define TD_MAX_TIMERS			4096
+#endif
+
+/* timing wheel */
+#define TD_WHEEL_BIT			6
+#define TD_WHEEL_LEN			(1u << TD_WHEEL_BIT)
+#define TD_WHEEL_MASK			(TD_WHEEL_LEN - 1)
+#define TD_LEVELS				6  /* 36 bit, periods are 32 bit */
+
+/* level of a timer not in the wheel */
+#define TD_LEVEL_NONE			0xff
+
+/**/
+#define TD_CONFIG_KILL_S		1
+
+/* Enum for the cState timer variable */
+enum timerState{
+	TD_TIMER_EMPTY,
+	TD_TIMER_STOPPED,
+	TD_TIMER_RUNNING,
+};
+
+/* Enum for the timer start function */
+enum{
+	 TIMER_START_NORMAL,
+	 TIMER_START_RESTART,
+	 TIMER_START_RESUME,
+};
+
+/* doubly linked list node, lists have a sentinel node */
+struct tdNode{
+	struct tdNode *next;
+	struct tdNode *prev;
+};
+
+struct timer{
+	struct tdNode node;  /* slot list or free list, must be first */
+	uint64_t expires;  /* absolute expiry [us] */
+	uint32_t period;  /* the period of the timer [us] */
+	uint32_t rt;  /* remaining time of a stopped timer */
+	struct{
+		timerCb_t func;  /* callback function */
+		void *handle;  /* handle passed to the callback function */
+		struct event e;  /* event passed to the callback function */
+	}cb;
+	int16_t *idCb;  /* pointer to the timer id */
+	uint8_t cState;  /* config state 0:empty, 1:stopped, 2:running */
+	uint8_t cPeriodic: 1;  /* config type 0:single shot, 1:periodic */
+	uint8_t cKill: 1;  /* config kill 1:timer slot set empty after usage */
+	uint8_t level;  /* wheel holding the timer or TD_LEVEL_NONE */
+	uint8_t slot;
+};
+
+struct timerDeamon{
+	struct timer timers[TD_MAX_TIMERS];
+	struct tdNode wheel[TD_LEVELS][TD_WHEEL_LEN];
+	uint64_t pending[TD_LEVELS];  /* bit x: slot x of the wheel not empty */
+	struct tdNode expired;  /* expired timers, to be called back */
+	struct tdNode free;
+	uint64_t now;  /* wheel time [us] */
+	uint64_t armed;  /* expiry the timerfd is armed for, 0 if disarmed */
+	uint64_t t0;  /* CLOCK_MONOTONIC at init [us] */
+	int fd;
+	pthread_mutex_t lock;
+	pthread_t thread;
+};
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/* zero, in the .bss, the lock and fd are set up by self_init() */
+static struct timerDeamon self;
+static pthread_once_t selfOnce = PTHREAD_ONCE_INIT;
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static void list_init(struct tdNode *);
+static void list_add(struct tdNode *, struct tdNode *);
+static void list_del(struct tdNode *);
+static bool list_empty(struct tdNode *);
+
+static uint64_t clock_us(void);
+static int32_t fls64(uint64_t);
+static uint64_t rotr64(uint64_t, uint32_t);
+static uint64_t rotl64(uint64_t, uint32_t);
+
+static void wheel_insert(struct timer *);
+static void wheel_remove(struct timer *);
+static void wheel_update(uint64_t);
+static uint64_t wheel_next(void);
+static void arm(void);
+static void expire(struct timer *);
+static void *timer_thread(void *);
+static void self_init(void);
+static void self_lock(void);
+static struct timer *get_timer(int16_t);
+static int32_t start_timer(int16_t, uint32_t);
+static int32_t stop_timer(struct timer *);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/**/
+static void list_init(struct tdNode *l)
+{
+	l->next = l;
+	l->prev = l;
+}
+/*---------------------------------------------------------------------------*/
+
+/* Append n to the list l. */
+static void list_add(struct tdNode *l, struct tdNode *n)
+{
+	n->prev = l->prev;
+	n->next = l;
+	l->prev->next = n;
+	l->prev = n;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static void list_del(struct tdNode *n)
+{
+	n->prev->next = n->next;
+	n->next->prev = n->prev;
+	n->next = n;
+	n->prev = n;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static bool list_empty(struct tdNode *l)
+{
+	return l->next == l;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		CLOCK_MONOTONIC in microseconds
+ */
+static uint64_t clock_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		position of the most significant set bit, 1..64, x != 0
+ */
+static int32_t fls64(uint64_t x)
+{
+	return 64 - __builtin_clzll(x);
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static uint64_t rotr64(uint64_t x, uint32_t n)
+{
+	n &= 63;
+	return n ? (x >> n) | (x << (64 - n)) : x;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static uint64_t rotl64(uint64_t x, uint32_t n)
+{
+	n &= 63;
+	return n ? (x << n) | (x >> (64 - n)) : x;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Put a running timer into the wheel of the highest 6-bit digit its expiry
+ * differs from the wheel time. Timers of the higher wheels are put one slot
+ * before their digit, since that slot is passed one rotation of the lower
+ * wheels before the expiry. Expired timers go to the expired list.
+ */
+static void wheel_insert(struct timer *t)
+{
+	uint64_t rem;
+	uint32_t level, slot;
+
+	if(t->expires <= self.now){
+		t->level = TD_LEVEL_NONE;
+		list_add(&self.expired, &t->node);
+		return;
+	}
+	rem = t->expires - self.now;
+	level = (fls64(rem) - 1) / TD_WHEEL_BIT;
+	if(level >= TD_LEVELS)
+		level = TD_LEVELS - 1;
+	slot = TD_WHEEL_MASK & ((t->expires >> (level * TD_WHEEL_BIT)) - !!level);
+	t->level = level;
+	t->slot = slot;
+	list_add(&self.wheel[level][slot], &t->node);
+	self.pending[level] |= (uint64_t) 1 << slot;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Remove a timer from the wheel or the expired list.
+ */
+static void wheel_remove(struct timer *t)
+{
+	struct tdNode *l;
+
+	list_del(&t->node);
+	if(t->level != TD_LEVEL_NONE){
+		l = &self.wheel[t->level][t->slot];
+		if(list_empty(l))
+			self.pending[t->level] &= ~((uint64_t) 1 << t->slot);
+	}
+	t->level = TD_LEVEL_NONE;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Advance the wheel time to now. The slots passed in every wheel are emptied
+ * and their timers are put in again, relative to the new wheel time: they
+ * either expire or move to a lower wheel.
+ *
+ * Argument:	now		new wheel time [us]
+ */
+static void wheel_update(uint64_t now)
+{
+	uint64_t elapsed, passed, pending;
+	uint32_t level, slot, oSlot, nSlot;
+	struct tdNode todo;
+	struct timer *t;
+
+	if(now <= self.now)
+		return;
+	list_init(&todo);
+	elapsed = now - self.now;
+	for(level=0; level<TD_LEVELS; level++){
+		if((elapsed >> (level * TD_WHEEL_BIT)) > TD_WHEEL_MASK){
+			pending = ~(uint64_t) 0;
+		}else{
+			passed = TD_WHEEL_MASK & (elapsed >> (level * TD_WHEEL_BIT));
+			oSlot = TD_WHEEL_MASK & (self.now >> (level * TD_WHEEL_BIT));
+			nSlot = TD_WHEEL_MASK & (now >> (level * TD_WHEEL_BIT));
+			pending = rotl64(((uint64_t) 1 << passed) - 1, oSlot);
+			pending |= rotr64(rotl64(((uint64_t) 1 << passed) - 1, nSlot), passed);
+			pending |= (uint64_t) 1 << nSlot;
+		}
+		while(pending & self.pending[level]){
+			slot = __builtin_ctzll(pending & self.pending[level]);
+			/* move the whole slot list to todo */
+			while(!list_empty(&self.wheel[level][slot])){
+				t = (struct timer *) self.wheel[level][slot].next;
+				list_del(&t->node);
+				list_add(&todo, &t->node);
+			}
+			self.pending[level] &= ~((uint64_t) 1 << slot);
+		}
+		/* the next wheel only ticks if this one wrapped around */
+		if(!(pending & 0x1))
+			break;
+		if(elapsed < ((uint64_t) TD_WHEEL_LEN << (level * TD_WHEEL_BIT)))
+			elapsed = (uint64_t) TD_WHEEL_LEN << (level * TD_WHEEL_BIT);
+	}
+	self.now = now;
+	while(!list_empty(&todo)){
+		t = (struct timer *) todo.next;
+		list_del(&t->node);
+		wheel_insert(t);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Lower bound of the time to the next expiry. A higher wheel slot may hold
+ * timers expiring later than its start, the wheel is then updated earlier
+ * than needed and the timers move down.
+ *
+ * Return:		time to the next expiry [us], UINT64_MAX if none
+ */
+static uint64_t wheel_next(void)
+{
+	uint64_t t = UINT64_MAX;
+	uint64_t dt;
+	uint64_t relMask = 0;
+	uint32_t level, slot;
+
+	if(!list_empty(&self.expired))
+		return 0;
+	for(level=0; level<TD_LEVELS; level++){
+		if(self.pending[level]){
+			slot = TD_WHEEL_MASK & (self.now >> (level * TD_WHEEL_BIT));
+			dt = (uint64_t) (__builtin_ctzll(rotr64(self.pending[level], slot))
+					+ !!level) << (level * TD_WHEEL_BIT);
+			dt -= relMask & self.now;
+			if(dt < t)
+				t = dt;
+		}
+		relMask <<= TD_WHEEL_BIT;
+		relMask |= TD_WHEEL_MASK;
+	}
+	return t;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Arm the timerfd for the next expiry, unless it is armed for that already.
+ */
+static void arm(void)
+{
+	struct itimerspec its;
+	uint64_t next, dt;
+
+	dt = wheel_next();
+	next = (dt == UINT64_MAX) ? 0 : self.now + (dt ? dt : 1);
+	if(next == self.armed)
+		return;
+	self.armed = next;
+	memset(&its, 0, sizeof(its));
+	if(next != 0){
+		next += self.t0;
+		its.it_value.tv_sec = next / 1000000u;
+		its.it_value.tv_nsec = (next % 1000000u) * 1000;
+	}
+	timerfd_settime(self.fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Update an expired timer according to its configuration.
+ */
+static void expire(struct timer *t)
+{
+	if(t->cPeriodic == 1){
+		t->expires += t->period;
+		/* overrun: skip the missed periods, keeping the phase */
+		if(t->expires <= self.now)
+			t->expires += ((self.now - t->expires) / t->period + 1)
+							* t->period;
+		wheel_insert(t);
+	}else if(t->cKill == 1){
+		t->cState = TD_TIMER_EMPTY;
+		if(t->idCb != NULL)
+			*t->idCb = -1;
+		list_add(&self.free, &t->node);
+	}else{
+		t->cState = TD_TIMER_STOPPED;
+		t->rt = 0;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sets up the lock and marks the deamon uninitialized, once.
+ */
+static void self_init(void)
+{
+	pthread_mutex_init(&self.lock, NULL);
+	self.fd = -1;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Takes the deamon lock, the API may be called before timerD_init().
+ */
+static void self_lock(void)
+{
+	pthread_once(&selfOnce, self_init);
+	pthread_mutex_lock(&self.lock);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Serves the timerfd. The callbacks are called without lock, a timer may be
+ * stopped, restarted or killed meanwhile, the callback gets a copy.
+ */
+static void *timer_thread(void *arg)
+{
+	uint64_t n;
+	struct timer *t;
+	timerCb_t func;
+	void *handle;
+	struct event eTmp;
+
+	(void) arg;
+	while(1){
+		if(read(self.fd, &n, sizeof(n)) < 0)
+			continue;
+		pthread_mutex_lock(&self.lock);
+		self.armed = 0;
+		wheel_update(clock_us() - self.t0);
+		while(!list_empty(&self.expired)){
+			t = (struct timer *) self.expired.next;
+			list_del(&t->node);
+			expire(t);
+			func = t->cb.func;
+			handle = t->cb.handle;
+			eTmp = t->cb.e;  /* send a copy since it might be rendered */
+			if(func != NULL){
+				pthread_mutex_unlock(&self.lock);
+				func(handle, &eTmp);
+				pthread_mutex_lock(&self.lock);
+			}
+		}
+		arm();
+		pthread_mutex_unlock(&self.lock);
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		the timer or NULL if the id is invalid
+ */
+static struct timer *get_timer(int16_t id)
+{
+	if(id < 0 || id >= TD_MAX_TIMERS)
+		return NULL;
+	return &self.timers[id];
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Internal function to start a timer, see timerDeamon.c. Called with lock.
+ *
+ * Argument:	id		The id returned by the timerD_create_timer() function.
+ * 				type	TIMER_START_NORMAL	If already running, do nothing.
+ * 						TIMER_START_RESTART	If already running, reload period.
+ * 						TIMER_START_RESUME	If stopped resumes at remaining time.
+ * Return:		err		 0	success
+ * 						-1	invalid id
+ * 						-2	timer empty
+ * 						-3	timer already running
+ * 						-4	timer can not be resumed if remaining time is 0
+ */
+static int32_t start_timer(int16_t id, uint32_t type)
+{
+	struct timer *t = get_timer(id);
+	uint32_t rt;
+
+	if(t == NULL)
+		return -1;
+	if(t->cState == TD_TIMER_EMPTY)
+		return -2;
+	switch(type){
+	case TIMER_START_NORMAL:
+		if(t->cState == TD_TIMER_RUNNING)
+			return -3;
+		rt = t->period;
+		break;
+	case TIMER_START_RESTART:
+		rt = t->period;
+		break;
+	case TIMER_START_RESUME:
+	default:
+		if(t->cState == TD_TIMER_RUNNING)
+			return -3;
+		if(t->rt == 0)
+			return -4;
+		rt = t->rt;
+		break;
+	}
+	if(t->cState == TD_TIMER_RUNNING)
+		wheel_remove(t);
+	wheel_update(clock_us() - self.t0);
+	t->expires = self.now + rt;
+	t->cState = TD_TIMER_RUNNING;
+	wheel_insert(t);
+	arm();
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Stop a timer and keep its remaining time. Called with lock.
+ */
+static int32_t stop_timer(struct timer *t)
+{
+	uint64_t now;
+
+	if(t->cState == TD_TIMER_EMPTY)
+		return -2;
+	if(t->cState != TD_TIMER_RUNNING)
+		return 0;
+	now = clock_us() - self.t0;
+	wheel_remove(t);
+	t->rt = (t->expires > now) ? (uint32_t) (t->expires - now) : 0;
+	t->cState = TD_TIMER_STOPPED;
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Sets up the wheel and starts the timer thread. If the timerfd or the thread
+ * can't be created, the deamon stays uninitialized and timerD_create_timer()
+ * fails.
+ */
+void timerD_init(void)
+{
+	uint32_t i, j;
+
+	self_lock();
+	if(self.fd >= 0){
+		pthread_mutex_unlock(&self.lock);
+		return;
+	}
+	for(i=0; i<TD_LEVELS; i++){
+		for(j=0; j<TD_WHEEL_LEN; j++)
+			list_init(&self.wheel[i][j]);
+		self.pending[i] = 0;
+	}
+	list_init(&self.expired);
+	list_init(&self.free);
+	for(i=0; i<TD_MAX_TIMERS; i++){
+		self.timers[i].cState = TD_TIMER_EMPTY;
+		self.timers[i].level = TD_LEVEL_NONE;
+		list_add(&self.free, &self.timers[i].node);
+	}
+	self.t0 = clock_us();
+	self.now = 0;
+	self.armed = 0;
+	self.fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if(self.fd >= 0 && pthread_create(&self.thread, NULL, timer_thread, NULL)){
+		close(self.fd);
+		self.fd = -1;
+	}
+	pthread_mutex_unlock(&self.lock);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Creates a new timer, see timerDeamon.c.
+ *
+ * Return:		id		positive numbers are valid id's,
+ * 						negative are error codes:
+ * 						-1 no free timer slot
+ * 						-2 period must not be 0
+ */
+int16_t timerD_create_timer(uint32_t period, uint8_t config, int16_t *idCb,
+							timerCb_t cb, void *handle, struct event *e)
+{
+	struct timer *t;
+	int16_t id;
+
+	if(idCb != NULL)
+		*idCb = -1;
+	if(period == 0)
+		return -2;
+	self_lock();
+	if(self.fd < 0 || list_empty(&self.free)){
+		pthread_mutex_unlock(&self.lock);
+		return -1;
+	}
+	t = (struct timer *) self.free.next;
+	list_del(&t->node);
+	id = (int16_t) (t - self.timers);
+	t->period = period;
+	t->rt = period;
+	t->cb.func = cb;
+	t->cb.handle = handle;
+	if(e != NULL)
+		t->cb.e = *e;
+	else
+		memset(&t->cb.e, 0, sizeof(t->cb.e));
+	t->cPeriodic = config & 0x1;
+	t->cKill = (config >> TD_CONFIG_KILL_S) & 0x1;
+	t->cState = TD_TIMER_STOPPED;
+	t->level = TD_LEVEL_NONE;
+	t->idCb = idCb;
+	if(idCb != NULL)
+		*idCb = id;
+	pthread_mutex_unlock(&self.lock);
+	return id;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Set the timing and configuration of an allocated timer, see
+ * timerDeamon.c. The timer is stopped.
+ *
+ * Return:      err      0  success
+ *                      -1  invalid id
+ *                      -2  timer empty
+ *                      -3  period must not be 0
+ */
+int32_t timerD_set_timer(int16_t id, uint32_t period, uint8_t config,
+                         timerCb_t cb, void *handle, struct event *e)
+{
+	struct timer *t = get_timer(id);
+	int32_t err;
+
+	if(period == 0)
+		return -3;
+	if(t == NULL)
+		return -1;
+	self_lock();
+	err = stop_timer(t);
+	if(!err){
+		t->period = period;
+		t->rt = period;
+		t->cb.func = cb;
+		t->cb.handle = handle;
+		if(e != NULL)
+			t->cb.e = *e;
+		t->cPeriodic = config & 0x1;
+		t->cKill = (config >> TD_CONFIG_KILL_S) & 0x1;
+	}
+	pthread_mutex_unlock(&self.lock);
+	return err;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Starts a timer with its period, see timerDeamon.c.
+ *
+ * Return:		err		 0	success
+ * 						-1	invalid id
+ * 						-2	timer empty
+ * 						-3	timer already running
+ */
+int32_t timerD_start_timer(int16_t id)
+{
+	int32_t err;
+
+	self_lock();
+	err = start_timer(id, TIMER_START_NORMAL);
+	pthread_mutex_unlock(&self.lock);
+	return err;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Restarts a timer with its period, see timerDeamon.c.
+ *
+ * Return:		err		 0	success
+ * 						-1	invalid id
+ * 						-2	timer empty
+ */
+int32_t timerD_restart_timer(int16_t id)
+{
+	int32_t err;
+
+	self_lock();
+	err = start_timer(id, TIMER_START_RESTART);
+	pthread_mutex_unlock(&self.lock);
+	return err;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Resumes a stopped timer at its remaining time, see timerDeamon.c.
+ *
+ * Return:		err		 0	success
+ * 						-1	invalid id
+ * 						-2	timer empty
+ * 						-3	timer already running
+ * 						-4	timer can not be resumed if remaining time is 0
+ */
+int32_t timerD_resume_timer(int16_t id)
+{
+	int32_t err;
+
+	self_lock();
+	err = start_timer(id, TIMER_START_RESUME);
+	pthread_mutex_unlock(&self.lock);
+	return err;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Stops a timer, see timerDeamon.c. The timerfd is left armed, an early
+ * wake only updates the wheel.
+ *
+ * Return:		err		 0	success
+ * 						-1	invalid id
+ * 						-2	timer empty
+ */
+int32_t timerD_stop_timer(int16_t id)
+{
+	struct timer *t = get_timer(id);
+	int32_t err;
+
+	if(t == NULL)
+		return -1;
+	self_lock();
+	err = stop_timer(t);
+	pthread_mutex_unlock(&self.lock);
+	return err;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Kills a timer, its id may be handed out again.
+ *
+ * Return:		err		 0	success
+ * 						-1	invalid id
+ */
+int32_t timerD_kill_timer(int16_t id)
+{
+	struct timer *t = get_timer(id);
+
+	if(t == NULL)
+		return -1;
+	self_lock();
+	if(t->cState != TD_TIMER_EMPTY){
+		stop_timer(t);
+		t->cState = TD_TIMER_EMPTY;
+		if(t->idCb != NULL)
+			*t->idCb = -1;
+		list_add(&self.free, &t->node);
+	}
+	pthread_mutex_unlock(&self.lock);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
@@ -0,0 +1,7 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    crc16bench \
+    protbench \
+    mpscbench \
+    setbench
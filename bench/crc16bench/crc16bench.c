@@ -0,0 +1,139 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: crc16bench.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Throughput of the crc16_ccitt_block() kernels against the byte-wise
+ * 		crc16_ccitt_byte_calc() loop, for frame sizes and a firmware image
+ * 		sized block. Every kernel is checked against the byte-wise result
+ * 		first.
+ *
+ * 		Usage: crc16bench [seconds per measurement, default 0.2]
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "crc/crc16Lookup.h"
+#include "crc/crc16Block.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define MAX_BLOCK_LEN			(1024 * 1024)
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static const uint32_t blockLen[] = {8, 16, 64, 255, 4096, MAX_BLOCK_LEN};
+static uint8_t data[MAX_BLOCK_LEN];
+static volatile uint16_t sink;
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint16_t byte_calc(const uint8_t *p, uint32_t len)
+{
+	uint16_t crc = CRC16_CCITT_INIT_0000;
+
+	while(len--)
+		crc16_ccitt_byte_calc(&crc, *p++);
+	return crc;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Runs the kernel (or the byte-wise loop if kernel < 0) for at least the
+ * given time and returns the throughput in MB/s.
+ */
+static double measure(int32_t kernel, uint32_t len, double seconds)
+{
+	uint64_t n = 0;
+	uint64_t i, batch;
+	double t0, t;
+
+	batch = (4 * 1024 * 1024) / len + 1;
+	t0 = now();
+	do{
+		for(i=0; i<batch; i++){
+			if(kernel < 0)
+				sink = byte_calc(data, len);
+			else
+				sink = crc16_ccitt_block(data, len, CRC16_CCITT_INIT_0000);
+		}
+		n += batch;
+		t = now() - t0;
+	}while(t < seconds);
+	return (double) n * len / t / 1e6;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	double seconds = 0.2;
+	uint32_t i, l;
+	int32_t k;
+
+	if(argc > 1)
+		seconds = atof(argv[1]);
+	srand(1);
+	for(i=0; i<MAX_BLOCK_LEN; i++)
+		data[i] = (uint8_t) rand();
+
+	printf("%-8s", "bytes");
+	printf("%10s", "bytewise");
+	for(k=CRC16_KERNEL_BYTE; k<CRC16_KERNEL_AUTO; k++)
+		printf("%10s", crc16_ccitt_kernel_name((enum crc16Kernel) k));
+	printf("   [MB/s]\n");
+
+	for(l=0; l<sizeof(blockLen)/sizeof(blockLen[0]); l++){
+		printf("%-8u", (unsigned) blockLen[l]);
+		printf("%10.1f", measure(-1, blockLen[l], seconds));
+		for(k=CRC16_KERNEL_BYTE; k<CRC16_KERNEL_AUTO; k++){
+			if(crc16_ccitt_select((enum crc16Kernel) k)){
+				printf("%10s", "n/a");
+				continue;
+			}
+			if(crc16_ccitt_block(data, blockLen[l], CRC16_CCITT_INIT_0000)
+					!= byte_calc(data, blockLen[l])){
+				printf("%10s", "MISMATCH");
+				return 1;
+			}
+			printf("%10.1f", measure(k, blockLen[l], seconds));
+		}
+		printf("\n");
+	}
+	crc16_ccitt_select(CRC16_KERNEL_AUTO);
+	printf("auto: %s\n", crc16_ccitt_kernel_name(crc16_ccitt_kernel()));
+	return 0;
+}
@@ -0,0 +1,19 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+TARGET = crc16bench
+
+QMAKE_CFLAGS_RELEASE -= -O2
+QMAKE_CFLAGS_RELEASE += -O3
+
+INCLUDEPATH += "../../Protocole_LE/lib"
+
+HEADERS += \
+    ../../Protocole_LE/lib/crc/crc16Lookup.h \
+    ../../Protocole_LE/lib/crc/crc16Block.h
+
+SOURCES += \
+    crc16bench.c \
+    ../../Protocole_LE/lib/crc/crc16Lookup.c \
+    ../../Protocole_LE/lib/crc/crc16Block.c
@@ -0,0 +1,378 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: mpscbench.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Posts per second into a single event queue from 1 to 8 producer
+ * 		threads, with one consumer thread:
+ * 			xQueue/lock		xQueue_push() and xQueue_pop(), each taking the
+ * 							kernel lock (INT_GLOB_MASK_SET on the host)
+ * 			mpscQueue		mpscQueue_push() and mpscQueue_pop(), lock-free
+ * 			ao_post/...		ao_post() to an AO dispatched by ao_scheduler().
+ * 							It runs the kernel as built: "mpsc" with
+ * 							CONFIG += aok_mpsc, "lock" without, so build both
+ * 							to compare them.
+ *
+ * 		The queues hold 64 events. The producers of the raw queues yield
+ * 		when the queue is full. ao_post() must not find the queue full, so
+ * 		each producer keeps at most 64/producers events in flight there.
+ *
+ * 		Reported are the posts per second of all producers together, the
+ * 		wall time per post, the pushes found the queue full and the
+ * 		contention, both per 1000 posts. Contention is the number of times
+ * 		a thread had to sleep on the lock (aokHost_contended()) for the
+ * 		lock, the number of lost head claims for the mpscQueue.
+ *
+ * 		Usage: mpscbench [-t seconds per run, default 0.5]
+ * 						[-p maximal number of producers, default 8]
+ * 						[-f substring of the benchmark names to run]
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lib/mem/xQueue.h"
+#include "lib/mem/mpscQueue.h"
+#include "lib/stm/aok.h"
+#include "lib/stm/event.h"
+#include "config/projConfig.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define QUEUE_LEN				64
+#define MAX_PRODUCERS			8
+
+#define LOAD_ACQUIRE(x)			__atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(x, v)		__atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+#ifdef AOK_MPSC
+#define AO_POST_NAME			"ao_post/mpsc"
+#else
+#define AO_POST_NAME			"ao_post/lock"
+#endif
+
+struct producer{
+	pthread_t thread;
+	uint32_t id;
+	uint64_t nPosts;
+	uint64_t nFull;
+}__attribute__((aligned(64)));
+
+struct bench{
+	const char *name;
+	void (*setup)(uint32_t);  /* number of producers */
+	int32_t (*push)(struct producer *, struct event *);  /* 0 posted */
+	bool (*pop)(void);  /* NULL: no consumer thread */
+	uint32_t (*contention)(void);
+};
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static void setup_xqueue(uint32_t);
+static int32_t push_xqueue(struct producer *, struct event *);
+static bool pop_xqueue(void);
+static void setup_mpsc(uint32_t);
+static int32_t push_mpsc(struct producer *, struct event *);
+static bool pop_mpsc(void);
+static uint32_t contention_mpsc(void);
+static void setup_ao_post(uint32_t);
+static int32_t push_ao_post(struct producer *, struct event *);
+static uint32_t contention_ao_post(void);
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static const struct bench benches[] = {
+	{"xQueue/lock", setup_xqueue, push_xqueue, pop_xqueue, aokHost_contended},
+	{"mpscQueue", setup_mpsc, push_mpsc, pop_mpsc, contention_mpsc},
+	{AO_POST_NAME, setup_ao_post, push_ao_post, NULL, contention_ao_post},
+};
+
+static const struct bench *bench;
+static struct producer producers[MAX_PRODUCERS];
+static uint32_t go;
+static uint32_t stop;
+
+static struct xQueue xq;
+static struct event xqMem[QUEUE_LEN];
+
+static struct mpscQueue mq;
+static struct event mqMem[QUEUE_LEN];
+static uint32_t mqSeq[QUEUE_LEN];
+
+/* the AO of ao_post, done[] counts the events of each producer */
+static struct aoStm sink;
+static struct event sinkMem[QUEUE_LEN];
+static uint64_t done[MAX_PRODUCERS];
+static uint32_t window;
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static void setup_xqueue(uint32_t nProducers)
+{
+	(void) nProducers;
+	xQueue_init(&xq, xqMem, QUEUE_LEN, sizeof(struct event));
+}
+/*---------------------------------------------------------------------------*/
+
+static int32_t push_xqueue(struct producer *p, struct event *e)
+{
+	(void) p;
+	return xQueue_push(&xq, e);
+}
+/*---------------------------------------------------------------------------*/
+
+static bool pop_xqueue(void)
+{
+	struct event e;
+
+	return !xQueue_pop(&xq, &e);
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static void setup_mpsc(uint32_t nProducers)
+{
+	(void) nProducers;
+	mpscQueue_init(&mq, mqMem, mqSeq, QUEUE_LEN, sizeof(struct event));
+}
+/*---------------------------------------------------------------------------*/
+
+static int32_t push_mpsc(struct producer *p, struct event *e)
+{
+	(void) p;
+	return mpscQueue_push(&mq, e);
+}
+/*---------------------------------------------------------------------------*/
+
+static bool pop_mpsc(void)
+{
+	struct event e;
+
+	return !mpscQueue_pop(&mq, &e);
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t contention_mpsc(void)
+{
+	return __atomic_load_n(&mq.prod.nRetries, __ATOMIC_RELAXED);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * State of the AO, counts the events per producer (event data).
+ */
+static void sink_state(struct aoStm *me, struct event *e)
+{
+	(void) me;
+	if(e->sig >= FIRST_USER_SIG)
+		__atomic_add_fetch(&done[e->data], 1, __ATOMIC_RELEASE);
+}
+/*---------------------------------------------------------------------------*/
+
+static void setup_ao_post(uint32_t nProducers)
+{
+	uint32_t i;
+
+	window = (QUEUE_LEN - 1) / nProducers;
+	for(i=0; i<MAX_PRODUCERS; i++)
+		STORE_RELEASE(done[i], 0);
+}
+/*---------------------------------------------------------------------------*/
+
+static int32_t push_ao_post(struct producer *p, struct event *e)
+{
+	if(p->nPosts - LOAD_ACQUIRE(done[p->id]) >= window)
+		return -1;
+	ao_post(&sink.super, e);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t contention_ao_post(void)
+{
+#ifdef AOK_MPSC
+	return __atomic_load_n(&sink.super.eventQueue.prod.nRetries,
+							__ATOMIC_RELAXED);
+#else
+	return aokHost_contended();
+#endif
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static void *producer_main(void *arg)
+{
+	struct producer *p = (struct producer *) arg;
+	struct event e = {.sig = FIRST_USER_SIG, .data = p->id};
+
+	while(!LOAD_ACQUIRE(go)){}
+	while(!LOAD_ACQUIRE(stop)){
+		if(bench->push(p, &e)){
+			p->nFull++;
+			sched_yield();
+		}else{
+			p->nPosts++;
+		}
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static void *consumer_main(void *arg)
+{
+	(void) arg;
+	while(!LOAD_ACQUIRE(stop)){
+		if(!bench->pop())
+			sched_yield();
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static void *scheduler_main(void *arg)
+{
+	(void) arg;
+	ao_scheduler();
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Runs the benchmark with the given number of producers for the given time
+ * and prints a line.
+ */
+static void measure(const struct bench *b, uint32_t nProducers, double seconds)
+{
+	struct timespec ts;
+	pthread_t consumer;
+	uint64_t t0, t1, nPosts = 0, nFull = 0;
+	uint32_t i, c0;
+
+	bench = b;
+	b->setup(nProducers);
+	STORE_RELEASE(go, 0);
+	STORE_RELEASE(stop, 0);
+	if(b->pop)
+		pthread_create(&consumer, NULL, consumer_main, NULL);
+	for(i=0; i<nProducers; i++){
+		producers[i].id = i;
+		producers[i].nPosts = 0;
+		producers[i].nFull = 0;
+		pthread_create(&producers[i].thread, NULL, producer_main,
+						&producers[i]);
+	}
+	c0 = b->contention();
+	ts.tv_sec = (time_t) seconds;
+	ts.tv_nsec = (long)((seconds - ts.tv_sec) * 1e9);
+	t0 = now();
+	STORE_RELEASE(go, 1);
+	nanosleep(&ts, NULL);
+	STORE_RELEASE(stop, 1);
+	t1 = now();
+	for(i=0; i<nProducers; i++){
+		pthread_join(producers[i].thread, NULL);
+		nPosts += producers[i].nPosts;
+		nFull += producers[i].nFull;
+	}
+	if(b->pop)
+		pthread_join(consumer, NULL);
+	/* the scheduler keeps running, let it finish this run's events */
+	for(i=0; i<nProducers && !b->pop; i++){
+		while(LOAD_ACQUIRE(done[i]) != producers[i].nPosts)
+			sched_yield();
+	}
+	if(nPosts == 0)
+		nPosts = 1;
+	printf("%-16s%6u%14.0f%10.1f%10.1f%14.2f\n", b->name, nProducers,
+			nPosts * 1e9 / (t1 - t0), (double)(t1 - t0) / nPosts,
+			nFull * 1000.0 / nPosts,
+			(b->contention() - c0) * 1000.0 / nPosts);
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	const char *filter = NULL;
+	double seconds = 0.5;
+	uint32_t maxProducers = MAX_PRODUCERS;
+	uint32_t i, n;
+	pthread_t scheduler;
+	int opt;
+
+	while((opt = getopt(argc, argv, "t:p:f:")) != -1){
+		switch(opt){
+		case 't': seconds = atof(optarg); break;
+		case 'p': maxProducers = atoi(optarg); break;
+		case 'f': filter = optarg; break;
+		default:
+			fprintf(stderr, "usage: %s [-t seconds] [-p producers] "
+					"[-f filter]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(maxProducers < 1 || maxProducers > MAX_PRODUCERS){
+		fprintf(stderr, "1 to %u producers\n", MAX_PRODUCERS);
+		return 2;
+	}
+
+	ao_init_event_queue(&sink.super, sinkMem, QUEUE_LEN);
+	STM_SET_STATE(&sink, sink_state);
+	ao_register(&sink.super, 0, false);
+	pthread_create(&scheduler, NULL, scheduler_main, NULL);
+
+	printf("%-16s%6s%14s%10s%10s%14s\n", "benchmark", "prod", "posts/s",
+			"ns/post", "full/k", "contended/k");
+	for(i=0; i<sizeof(benches)/sizeof(benches[0]); i++){
+		if(filter && !strstr(benches[i].name, filter))
+			continue;
+		for(n=1; n<=maxProducers; n++)
+			measure(&benches[i], n, seconds);
+	}
+
+	aokHost_stop();
+	pthread_join(scheduler, NULL);
+	return 0;
+}
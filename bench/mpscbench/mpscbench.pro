@@ -0,0 +1,20 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+TARGET = mpscbench
+
+QMAKE_CFLAGS_RELEASE -= -O2
+QMAKE_CFLAGS_RELEASE += -O3
+
+# The kernel as built for the host. ao_post() takes the lock unless built
+# with CONFIG += aok_mpsc, run both builds to compare.
+include(../../Protocole_LE/host/host.pri)
+
+!aok_mpsc {
+    HEADERS += ../../Protocole_LE/lib/mem/mpscQueue.h
+    SOURCES += ../../Protocole_LE/lib/mem/mpscQueue.c
+}
+
+SOURCES += \
+    mpscbench.c
@@ -0,0 +1,650 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: protbench.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Throughput and latency of the protocol stack, from the CRC and the
+ * 		memory primitives up to full frame round trips through the
+ * 		generator simulator (sim/gensim/simDevice.c).
+ *
+ * 		Every benchmark is run in samples of a fixed batch of operations
+ * 		until the minimal time has passed. Reported are the mean time per
+ * 		operation, the operations per second (frames/s for the frame
+ * 		benchmarks) and the 50/99/99.9 percentiles of the sample time
+ * 		divided by the batch (p50/b, p99/b, p999/b). With a batch of 1 they
+ * 		are single operation latencies; for the others they are averaged
+ * 		over the batch, as timing a single 20 ns operation is not possible
+ * 		without disturbing it. The tail of a single operation is hidden by
+ * 		the average then.
+ *
+ * 		The round trip benchmarks:
+ * 			sim/inproc		request encoded, decoded, answered and the
+ * 							answer decoded, without I/O
+ * 			sim/pty/rtt		request written to a pty, answered by the
+ * 							simulator thread on the other side, answer read
+ * 							and decoded; one request at a time
+ * 			sim/pty/win16	same with 16 requests in flight
+ *
+ * 		Usage: protbench [-t seconds per benchmark, default 0.5]
+ * 						[-f substring of the benchmark names to run]
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "crc/crc16Block.h"
+#include "lib/mem/pool.h"
+#include "lib/mem/xQueue.h"
+#include "lib/stm/event.h"
+#include "prot/dlinkDecoder.h"
+#include "prot/protocol.h"
+#include "prot/protView.h"
+#include "prot/services/battery.h"
+#include "simDevice.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define MIN_SAMPLES				1000
+#define MAX_SAMPLES				(1 << 20)
+#define STREAM_FRAMES			64  /* frames of the dlink stream benchmark */
+#define QUEUE_LEN				64
+#define BULK_LEN				16
+#define POOL_NBUCKETS			4096
+#define POOL_SHIFT				4
+#define POOL_LIVE				32  /* allocations held by pool/mixed */
+#define PTY_WINDOW				16
+
+struct bench{
+	const char *name;
+	uint32_t batch;  /* operations per sample */
+	uint32_t bytes;  /* bytes per operation for MB/s, 0 if not applicable */
+	void (*setup)(void);
+	void (*run)(uint32_t);  /* runs the given number of operations */
+};
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static int32_t pack_req_set_charging(struct protocol *, struct ucBuffer *);
+static void setup_frames(void);
+static void setup_pool(void);
+static void setup_queue(void);
+static void setup_pty(void);
+static void run_crc16(uint32_t);
+static void run_crc64(uint32_t);
+static void run_crc255(uint32_t);
+static void run_encode(uint32_t);
+static void run_encode_frame(uint32_t);
+static void run_decode(uint32_t);
+static void run_view_decode(uint32_t);
+static void run_dlink_stream(uint32_t);
+static void run_queue(uint32_t);
+static void run_queue_bulk(uint32_t);
+static void run_pool_fixed(uint32_t);
+static void run_pool_mixed(uint32_t);
+static void run_sim_inproc(uint32_t);
+static void run_sim_pty(uint32_t);
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/* Battery services of the benchmark. The ones of the firmware can't be
+ * linked on the host; protocol.c references the tables weak and takes this
+ * one instead. */
+static const struct serviceEntry batReq[] = {
+	[SID_SERV_BAT_GET_LIVE_DATA] = {NULL, NULL, SERV_LEN_ANY, SERV_PACK},
+	[SID_SERV_BAT_SET_CHARGING] = {pack_req_set_charging, NULL,
+			SERV_LEN_ANY, SERV_PACK},
+};
+/**/
+const struct serviceTable batteryServices = {
+	SID_DEV_BAT,
+	batReq, SERV_N(batReq),
+	NULL, 0,
+};
+
+static const struct bench benches[] = {
+	{"crc16/16", 64, 16, setup_frames, run_crc16},
+	{"crc16/64", 64, 64, setup_frames, run_crc64},
+	{"crc16/255", 16, 255, setup_frames, run_crc255},
+	{"prot_encode/set_charging", 64, 0, setup_frames, run_encode},
+	{"prot_encode_frame/set_charging", 64, 0, setup_frames, run_encode_frame},
+	{"prot_decode/live_data", 64, 0, setup_frames, run_decode},
+	{"protView_decode/live_data", 64, 0, setup_frames, run_view_decode},
+	{"dlink_decode/stream", STREAM_FRAMES, 0, setup_frames, run_dlink_stream},
+	{"xQueue/push_pop", 64, 0, setup_queue, run_queue},
+	{"xQueue/push_n_pop_n", 64, 0, setup_queue, run_queue_bulk},
+	{"pool/alloc_free/32", 64, 0, setup_pool, run_pool_fixed},
+	{"pool/alloc_free/mixed", 64, 0, setup_pool, run_pool_mixed},
+	{"sim/inproc", 16, 0, setup_frames, run_sim_inproc},
+	{"sim/pty/rtt", 1, 0, setup_pty, run_sim_pty},
+	{"sim/pty/win16", PTY_WINDOW, 0, setup_pty, run_sim_pty},
+};
+
+static uint8_t data[256];
+static volatile uint32_t sink;
+
+/* request and answer of the frame benchmarks */
+static struct protocol req;
+static uint8_t reqFrame[SIM_FRAME_MAX];
+static uint32_t reqLen;
+static uint8_t ansFrame[SIM_FRAME_MAX];
+static uint32_t ansLen;
+static uint8_t stream[STREAM_FRAMES * SIM_FRAME_MAX];
+static uint32_t streamLen;
+
+static struct simDevice dev;
+static struct dlinkDecoder decoder;
+static uint8_t rxMem[DLINK_MAX_PAYLOAD];
+
+static struct xQueue queue;
+static struct event queueMem[QUEUE_LEN];
+
+static struct pool pool;
+static uint64_t poolMem[(POOL_NBUCKETS << POOL_SHIFT) / sizeof(uint64_t)];
+static uint32_t lcg = 1;
+
+/* the display side of the pty, the simulator thread serves the master */
+static int ptyClient = -1;
+static int ptyServer;
+static struct dlinkDecoder ptyDecoder;
+static uint8_t ptyRxMem[DLINK_MAX_PAYLOAD];
+
+static uint64_t samples[MAX_SAMPLES];
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a;
+	uint64_t y = *(const uint64_t *) b;
+
+	return x < y ? -1 : x > y;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * charge start(1)/stop(0)
+ */
+static int32_t pack_req_set_charging(struct protocol *src,
+										struct ucBuffer *dest)
+{
+	if(dest->pos + 1 > dest->size)
+		return PROT_ERR_INVALID_LEN;
+	STORE8(dest, src->data.arr[0]);
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Decodes a complete frame with the given decoder, returns the view of the
+ * payload or -1 if the bytes don't make a frame.
+ */
+static int32_t dlink_frame(struct dlinkDecoder *dec, const uint8_t *frame,
+							uint32_t len, struct protView *view)
+{
+	uint32_t consumed;
+
+	ucBuffer_clear(&dec->rxBuf);
+	if(dlinkDec_feed(dec, frame, len, &consumed) != DLINK_DEC_FRAME)
+		return -1;
+	protView_init(view, dec->rxBuf.buf, dec->rxBuf.len);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Request: battery live data with a tid1 header as sent by the display.
+ * Answer: the simulator's answer to it.
+ */
+static void setup_frames(void)
+{
+	struct protView view;
+	uint32_t i;
+
+	for(i=0; i<sizeof(data); i++)
+		data[i] = (uint8_t) (i * 151 + 7);
+	simDev_init(&dev, 1);
+	dlinkDec_init(&decoder, rxMem, sizeof(rxMem));
+
+	memset(&req, 0, sizeof(req));
+	req.netLayer.nid = 0;
+	req.tranLayer.tid = 1;
+	req.tranLayer.opt.tid1.seqNr = 1;
+	req.tranLayer.opt.tid1.winSize = PTY_WINDOW;
+	req.procLayer.sid = PROT_SID(SID_DEV_BAT, SID_SERV_BAT_GET_LIVE_DATA,
+			SID_REQ);
+	prot_encode_frame(&req, reqFrame, sizeof(reqFrame), &reqLen);
+	dlink_frame(&decoder, reqFrame, reqLen, &view);
+	simDev_answer(&dev, &view, ansFrame, sizeof(ansFrame), &ansLen);
+
+	streamLen = 0;
+	for(i=0; i<STREAM_FRAMES; i++){
+		memcpy(&stream[streamLen], ansFrame, ansLen);
+		streamLen += ansLen;
+	}
+
+	/* the encode benchmarks */
+	req.procLayer.sid = PROT_SID(SID_DEV_BAT, SID_SERV_BAT_SET_CHARGING,
+			SID_REQ);
+	req.data.arr[0] = 1;
+}
+/*---------------------------------------------------------------------------*/
+
+static void setup_queue(void)
+{
+	xQueue_init(&queue, queueMem, QUEUE_LEN, sizeof(struct event));
+}
+/*---------------------------------------------------------------------------*/
+
+static void setup_pool(void)
+{
+	pool_init(&pool, poolMem, POOL_NBUCKETS, POOL_SHIFT);
+}
+/*---------------------------------------------------------------------------*/
+
+static void run_crc16(uint32_t n)
+{
+	while(n--)
+		sink = crc16_ccitt_block(data, 16, CRC16_CCITT_INIT_0000);
+}
+/*---------------------------------------------------------------------------*/
+
+static void run_crc64(uint32_t n)
+{
+	while(n--)
+		sink = crc16_ccitt_block(data, 64, CRC16_CCITT_INIT_0000);
+}
+/*---------------------------------------------------------------------------*/
+
+static void run_crc255(uint32_t n)
+{
+	while(n--)
+		sink = crc16_ccitt_block(data, 255, CRC16_CCITT_INIT_0000);
+}
+/*---------------------------------------------------------------------------*/
+
+static void run_encode(uint32_t n)
+{
+	struct ucBuffer buf = {.buf = data, .size = sizeof(data)};
+
+	while(n--){
+		prot_encode(&req, &buf);
+		sink = buf.len;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+static void run_encode_frame(uint32_t n)
+{
+	uint32_t len;
+
+	while(n--){
+		prot_encode_frame(&req, data, sizeof(data), &len);
+		sink = len;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Decodes the payload of the answer, without the data link layer.
+ */
+static void run_decode(uint32_t n)
+{
+	struct ucBuffer src = {.buf = &ansFrame[DLINK_H_LEN - CRC_LEN],
+			.len = ansLen - DLINK_H_LEN, .size = ansLen - DLINK_H_LEN};
+	struct protocol dec;
+
+	while(n--){
+		prot_decode(&src, &dec);
+		sink = dec.procLayer.sid;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+static void run_view_decode(uint32_t n)
+{
+	struct protView view;
+	struct protocol dec;
+
+	while(n--){
+		protView_init(&view, &ansFrame[DLINK_H_LEN - CRC_LEN],
+				ansLen - DLINK_H_LEN);
+		protView_decode(&view, &dec);
+		sink = dec.procLayer.sid;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Feeds STREAM_FRAMES answers in chunks of 256 bytes, as SerialPortReader
+ * does; an operation is a frame.
+ */
+static void run_dlink_stream(uint32_t n)
+{
+	struct protView view;
+	const uint8_t *p;
+	uint32_t left, chunk, len, consumed;
+
+	for(; n >= STREAM_FRAMES; n -= STREAM_FRAMES){
+		p = stream;
+		left = streamLen;
+		while(left){
+			chunk = left < 256 ? left : 256;
+			left -= chunk;
+			while(chunk){
+				len = chunk;
+				if(dlinkDec_feed(&decoder, p, len, &consumed)
+						== DLINK_DEC_FRAME){
+					protView_init(&view, decoder.rxBuf.buf,
+							decoder.rxBuf.len);
+					sink = protView_parse(&view, PROT_VIEW_PROC);
+					ucBuffer_clear(&decoder.rxBuf);
+				}
+				p += consumed;
+				chunk -= consumed;
+			}
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+static void run_queue(uint32_t n)
+{
+	struct event e = {1, 2, NULL};
+
+	while(n--){
+		xQueue_push(&queue, &e);
+		xQueue_pop(&queue, &e);
+	}
+	sink = e.data;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * An operation is an element.
+ */
+static void run_queue_bulk(uint32_t n)
+{
+	struct event e[BULK_LEN];
+
+	memset(e, 0, sizeof(e));
+	for(; n >= BULK_LEN; n -= BULK_LEN){
+		xQueue_push_n(&queue, e, BULK_LEN);
+		sink = xQueue_pop_n(&queue, e, BULK_LEN);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+static void run_pool_fixed(uint32_t n)
+{
+	void *p;
+
+	while(n--){
+		p = pool_alloc(&pool, 32);
+		pool_free(&pool, p);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sizes of 8 to 263 bytes, the last POOL_LIVE allocations are held, hence
+ * the pool is fragmented as in the event pool.
+ */
+static void run_pool_mixed(uint32_t n)
+{
+	static void *live[POOL_LIVE];
+	static uint32_t idx;
+
+	while(n--){
+		lcg = lcg * 1664525u + 1013904223u;
+		if(live[idx])
+			pool_free(&pool, live[idx]);
+		live[idx] = pool_alloc(&pool, 8 + (lcg >> 24));
+		idx = (idx + 1) % POOL_LIVE;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Display and device side in one thread: request encoded, decoded by the
+ * device, answered, answer decoded by the display.
+ */
+static void run_sim_inproc(uint32_t n)
+{
+	uint8_t reqBuf[SIM_FRAME_MAX], ansBuf[SIM_FRAME_MAX];
+	struct protView view;
+	struct protocol dec;
+	uint32_t len;
+
+	req.procLayer.sid = PROT_SID(SID_DEV_BAT, SID_SERV_BAT_GET_LIVE_DATA,
+			SID_REQ);
+	while(n--){
+		req.tranLayer.opt.tid1.seqNr++;
+		prot_encode_frame(&req, reqBuf, sizeof(reqBuf), &len);
+		dlink_frame(&decoder, reqBuf, len, &view);
+		simDev_answer(&dev, &view, ansBuf, sizeof(ansBuf), &len);
+		dlink_frame(&decoder, ansBuf, len, &view);
+		protView_decode(&view, &dec);
+		sink = dec.tranLayer.opt.tid1.seqNr;
+	}
+	req.procLayer.sid = PROT_SID(SID_DEV_BAT, SID_SERV_BAT_SET_CHARGING,
+			SID_REQ);
+}
+/*---------------------------------------------------------------------------*/
+
+static void write_all(int fd, const uint8_t *p, uint32_t len)
+{
+	ssize_t n;
+
+	while(len){
+		n = write(fd, p, len);
+		if(n <= 0)
+			continue;
+		p += n;
+		len -= n;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * The device side of the pty, answers every request on the master.
+ */
+static void *sim_thread(void *arg)
+{
+	static struct simDevice simDev;
+	static struct dlinkDecoder simDec;
+	static uint8_t simRxMem[DLINK_MAX_PAYLOAD];
+	uint8_t chunk[4096], frame[SIM_FRAME_MAX];
+	struct protView view;
+	const uint8_t *p;
+	uint32_t len, consumed;
+	ssize_t n;
+
+	(void) arg;
+	simDev_init(&simDev, 2);
+	dlinkDec_init(&simDec, simRxMem, sizeof(simRxMem));
+	while((n = read(ptyServer, chunk, sizeof(chunk))) > 0){
+		p = chunk;
+		while(n){
+			if(dlinkDec_feed(&simDec, p, n, &consumed) == DLINK_DEC_FRAME){
+				protView_init(&view, simDec.rxBuf.buf, simDec.rxBuf.len);
+				if(simDev_answer(&simDev, &view, frame, sizeof(frame), &len)
+						== PROT_SUCCESS)
+					write_all(ptyServer, frame, len);
+				ucBuffer_clear(&simDec.rxBuf);
+			}
+			p += consumed;
+			n -= consumed;
+		}
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Opens the pty and starts the simulator thread, once.
+ */
+static void setup_pty(void)
+{
+	struct termios tio;
+	pthread_t thread;
+
+	setup_frames();
+	req.procLayer.sid = PROT_SID(SID_DEV_BAT, SID_SERV_BAT_GET_LIVE_DATA,
+			SID_REQ);
+	if(ptyClient >= 0)
+		return;
+	ptyServer = posix_openpt(O_RDWR | O_NOCTTY);
+	if(ptyServer < 0 || grantpt(ptyServer) || unlockpt(ptyServer)){
+		perror("pty");
+		exit(1);
+	}
+	ptyClient = open(ptsname(ptyServer), O_RDWR | O_NOCTTY);
+	if(ptyClient < 0 || tcgetattr(ptyClient, &tio)){
+		perror("pty");
+		exit(1);
+	}
+	cfmakeraw(&tio);
+	tcsetattr(ptyClient, TCSANOW, &tio);
+	dlinkDec_init(&ptyDecoder, ptyRxMem, sizeof(ptyRxMem));
+	pthread_create(&thread, NULL, sim_thread, NULL);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Writes the batch of requests at once and waits for all answers.
+ */
+static void run_sim_pty(uint32_t n)
+{
+	uint8_t buf[PTY_WINDOW * SIM_FRAME_MAX], chunk[4096];
+	struct protView view;
+	struct protocol dec;
+	const uint8_t *p;
+	uint32_t i, len, frameLen, consumed, answers = 0;
+	ssize_t r;
+
+	for(len=0, i=0; i<n && i<PTY_WINDOW; i++){
+		req.tranLayer.opt.tid1.seqNr++;
+		prot_encode_frame(&req, &buf[len], SIM_FRAME_MAX, &frameLen);
+		len += frameLen;
+	}
+	write_all(ptyClient, buf, len);
+	while(answers < i){
+		r = read(ptyClient, chunk, sizeof(chunk));
+		for(p=chunk; r > 0; p+=consumed, r-=consumed){
+			if(dlinkDec_feed(&ptyDecoder, p, r, &consumed) != DLINK_DEC_FRAME)
+				continue;
+			protView_init(&view, ptyDecoder.rxBuf.buf, ptyDecoder.rxBuf.len);
+			protView_decode(&view, &dec);
+			ucBuffer_clear(&ptyDecoder.rxBuf);
+			answers++;
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Runs the benchmark in samples of a batch until the minimal time has
+ * passed and prints a line of results.
+ */
+static void measure(const struct bench *b, double seconds)
+{
+	uint64_t t0, t, start, end, ops = 0;
+	uint32_t nSamples = 0;
+	double nsOp;
+
+	b->setup();
+	b->run(b->batch);  /* warm up */
+	start = now();
+	end = start + (uint64_t)(seconds * 1e9);
+	t = start;
+	do{
+		t0 = t;
+		b->run(b->batch);
+		t = now();
+		samples[nSamples++] = t - t0;
+		ops += b->batch;
+	}while((t < end || nSamples < MIN_SAMPLES) && nSamples < MAX_SAMPLES);
+
+	qsort(samples, nSamples, sizeof(samples[0]), cmp_u64);
+	nsOp = (double)(t - start) / ops;
+	printf("%-32s%6u%10.1f%12.0f%9.1f%9.1f%9.1f", b->name,
+			(unsigned) b->batch, nsOp, 1e9 / nsOp,
+			(double) samples[nSamples / 2] / b->batch,
+			(double) samples[(uint64_t) nSamples * 99 / 100] / b->batch,
+			(double) samples[(uint64_t) nSamples * 999 / 1000] / b->batch);
+	if(b->bytes)
+		printf("%9.1f", b->bytes * 1e3 / nsOp);
+	printf("\n");
+	fflush(stdout);
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	const char *filter = NULL;
+	double seconds = 0.5;
+	uint32_t i;
+	int opt;
+
+	while((opt = getopt(argc, argv, "t:f:")) != -1){
+		switch(opt){
+		case 't': seconds = atof(optarg); break;
+		case 'f': filter = optarg; break;
+		default:
+			fprintf(stderr, "usage: %s [-t seconds] [-f filter]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	printf("%-32s%6s%10s%12s%9s%9s%9s%9s\n", "benchmark", "batch", "ns/op",
+			"ops/s", "p50/b", "p99/b", "p999/b", "MB/s");
+	for(i=0; i<sizeof(benches)/sizeof(benches[0]); i++){
+		if(filter && !strstr(benches[i].name, filter))
+			continue;
+		measure(&benches[i], seconds);
+	}
+	printf("p50/b, p99/b, p999/b: ns per operation of a batch, "
+			"single operation latencies for batch 1 only\n");
+	return 0;
+}
@@ -0,0 +1,32 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+TARGET = protbench
+
+QMAKE_CFLAGS_RELEASE -= -O2
+QMAKE_CFLAGS_RELEASE += -O3
+
+# xQueue and pool as built for the host, with their locks
+include(../../Protocole_LE/host/host.pri)
+
+INCLUDEPATH += "../../Protocole_LE/lib" "../../sim/gensim"
+
+HEADERS += \
+    ../../sim/gensim/simDevice.h \
+    ../../Protocole_LE/lib/mem/ucBuffer.h \
+    ../../Protocole_LE/lib/prot/protocol.h \
+    ../../Protocole_LE/lib/prot/dlinkDecoder.h \
+    ../../Protocole_LE/lib/prot/protView.h \
+    ../../Protocole_LE/lib/crc/crc16Lookup.h \
+    ../../Protocole_LE/lib/crc/crc16Block.h
+
+SOURCES += \
+    protbench.c \
+    ../../sim/gensim/simDevice.c \
+    ../../Protocole_LE/lib/mem/ucBuffer.c \
+    ../../Protocole_LE/lib/prot/protocol.c \
+    ../../Protocole_LE/lib/prot/dlinkDecoder.c \
+    ../../Protocole_LE/lib/prot/protView.c \
+    ../../Protocole_LE/lib/crc/crc16Lookup.c \
+    ../../Protocole_LE/lib/crc/crc16Block.c
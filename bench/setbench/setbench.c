@@ -0,0 +1,393 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: setbench.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Time per operation of the waiting sets of the scheduler: the set56
+ * 		with its log2lookup table against the set4096 with clz, the latter
+ * 		holding the same 56 elements and spread over all 4096. The
+ * 		operations as used by lib/stm/aok.c:
+ * 			insert+remove	insert and remove of a random element
+ * 			find			highest element of a set
+ * 			walk/elem		find, then find_below down to the last element,
+ * 							per element (the round robin of handle_prio())
+ * 			prio			highest priority of waitingPrio, log2lookup
+ * 							against clz
+ *
+ * 		The finds and walks run over 256 sets of n random elements each, so
+ * 		the sets don't stay in registers. All sets are checked against each
+ * 		other first.
+ *
+ * 		Usage: setbench [-t seconds per measurement, default 0.2]
+ * 						[-n elements per set, default 4]
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lib/mem/set56.h"
+#include "lib/mem/set4096.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define NSETS					256
+#define NKEYS					1024
+#define BATCH					4096
+
+/* a set and the range of its elements */
+enum{
+	SET_56,
+	SET_4096_56,
+	SET_4096,
+	NR_SETS
+};
+
+/* runs a batch, returns the number of operations done */
+typedef uint32_t (*run_t)(uint32_t);
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static uint32_t run_insert56(uint32_t);
+static uint32_t run_insert4096s(uint32_t);
+static uint32_t run_insert4096(uint32_t);
+static uint32_t run_find56(uint32_t);
+static uint32_t run_find4096s(uint32_t);
+static uint32_t run_find4096(uint32_t);
+static uint32_t run_walk56(uint32_t);
+static uint32_t run_walk4096s(uint32_t);
+static uint32_t run_walk4096(uint32_t);
+static uint32_t run_prio_lookup(uint32_t);
+static uint32_t run_prio_clz(uint32_t);
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static const struct{
+	const char *name;
+	run_t run[NR_SETS];
+}ops[] = {
+	{"insert+remove", {run_insert56, run_insert4096s, run_insert4096}},
+	{"find", {run_find56, run_find4096s, run_find4096}},
+	{"walk/elem", {run_walk56, run_walk4096s, run_walk4096}},
+	{"prio", {run_prio_lookup, run_prio_clz, NULL}},
+};
+
+static const char *setName[NR_SETS] = {"set56", "set4096/56", "set4096"};
+
+static struct set56 sets56[NSETS];
+static struct set4096 sets4096s[NSETS];  /* elements below 56 */
+static struct set4096 sets4096[NSETS];
+static struct set56 set56;
+static struct set4096 set4096s;
+static struct set4096 set4096;
+static uint16_t keys56[NKEYS];
+static uint16_t keys4096[NKEYS];
+static uint8_t prios[NKEYS];  /* waitingPrio, not 0 */
+static volatile uint32_t sink;
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static uint32_t run_insert56(uint32_t n)
+{
+	uint32_t i, k;
+
+	for(i=0; i<n; i++){
+		k = keys56[i & (NKEYS-1)];
+		SET56_INSERT(set56, k);
+		SET56_REMOVE(set56, keys56[(i + 1) & (NKEYS-1)]);
+	}
+	sink = set56.bytes;
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t run_insert4096s(uint32_t n)
+{
+	uint32_t i, k;
+
+	for(i=0; i<n; i++){
+		k = keys56[i & (NKEYS-1)];
+		SET4096_INSERT(set4096s, k);
+		SET4096_REMOVE(set4096s, keys56[(i + 1) & (NKEYS-1)]);
+	}
+	sink = (uint32_t) set4096s.summary;
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t run_insert4096(uint32_t n)
+{
+	uint32_t i, k;
+
+	for(i=0; i<n; i++){
+		k = keys4096[i & (NKEYS-1)];
+		SET4096_INSERT(set4096, k);
+		SET4096_REMOVE(set4096, keys4096[(i + 1) & (NKEYS-1)]);
+	}
+	sink = (uint32_t) set4096.summary;
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static uint32_t run_find56(uint32_t n)
+{
+	uint32_t i, k, acc = 0;
+
+	for(i=0; i<n; i++){
+		SET56_FIND(sets56[i & (NSETS-1)], k);
+		acc += k;
+	}
+	sink = acc;
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t run_find4096s(uint32_t n)
+{
+	uint32_t i, k, acc = 0;
+
+	for(i=0; i<n; i++){
+		SET4096_FIND(sets4096s[i & (NSETS-1)], k);
+		acc += k;
+	}
+	sink = acc;
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t run_find4096(uint32_t n)
+{
+	uint32_t i, k, acc = 0;
+
+	for(i=0; i<n; i++){
+		SET4096_FIND(sets4096[i & (NSETS-1)], k);
+		acc += k;
+	}
+	sink = acc;
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static uint32_t run_walk56(uint32_t nSets)
+{
+	uint32_t i, nOps = 0, acc = 0;
+	int32_t k, n;
+
+	for(i=0; i<nSets; i++){
+		SET56_FIND(sets56[i & (NSETS-1)], k);
+		do{
+			acc += k;
+			nOps++;
+			SET56_FIND_BELOW(sets56[i & (NSETS-1)], k, n);
+			k = n;
+		}while(k >= 0);
+	}
+	sink = acc;
+	return nOps;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t run_walk4096s(uint32_t nSets)
+{
+	uint32_t i, nOps = 0, acc = 0;
+	int32_t k, n;
+
+	for(i=0; i<nSets; i++){
+		SET4096_FIND(sets4096s[i & (NSETS-1)], k);
+		do{
+			acc += k;
+			nOps++;
+			SET4096_FIND_BELOW(sets4096s[i & (NSETS-1)], k, n);
+			k = n;
+		}while(k >= 0);
+	}
+	sink = acc;
+	return nOps;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t run_walk4096(uint32_t nSets)
+{
+	uint32_t i, nOps = 0, acc = 0;
+	int32_t k, n;
+
+	for(i=0; i<nSets; i++){
+		SET4096_FIND(sets4096[i & (NSETS-1)], k);
+		do{
+			acc += k;
+			nOps++;
+			SET4096_FIND_BELOW(sets4096[i & (NSETS-1)], k, n);
+			k = n;
+		}while(k >= 0);
+	}
+	sink = acc;
+	return nOps;
+}
+/*---------------------------------------------------------------------------*/
+
+/**/
+static uint32_t run_prio_lookup(uint32_t n)
+{
+	uint32_t i, acc = 0;
+
+	for(i=0; i<n; i++)
+		acc += log2lookup[prios[i & (NKEYS-1)]];
+	sink = acc;
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t run_prio_clz(uint32_t n)
+{
+	uint32_t i, acc = 0;
+
+	for(i=0; i<n; i++)
+		acc += 32 - __builtin_clz(prios[i & (NKEYS-1)]);
+	sink = acc;
+	return n;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Fills the sets with n random elements each and checks that the sets agree
+ * on find and walk.
+ *
+ * Return:		true if they do
+ */
+static bool setup(uint32_t n)
+{
+	uint32_t i, j, k, k4;
+	int32_t a, b, na, nb;
+
+	srand(1);
+	for(i=0; i<NKEYS; i++){
+		keys56[i] = rand() % 56;
+		keys4096[i] = rand() % 4096;
+		prios[i] = 1 + rand() % 255;
+		if(log2lookup[prios[i]] != 32 - __builtin_clz(prios[i]))
+			return false;
+	}
+	for(i=0; i<NSETS; i++){
+		for(j=0; j<n; j++){
+			k = rand() % 56;
+			SET56_INSERT(sets56[i], k);
+			SET4096_INSERT(sets4096s[i], k);
+			k = rand() % 4096;
+			SET4096_INSERT(sets4096[i], k);
+		}
+		SET56_FIND(sets56[i], k);
+		SET4096_FIND(sets4096s[i], k4);
+		if(k != k4)
+			return false;
+		a = b = k;
+		while(a >= 0){
+			SET56_FIND_BELOW(sets56[i], a, na);
+			SET4096_FIND_BELOW(sets4096s[i], b, nb);
+			a = na;
+			b = nb;
+			if(a != b)
+				return false;
+		}
+	}
+	return true;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Runs the batches for at least the given time and returns the time per
+ * operation in ns.
+ */
+static double measure(run_t run, double seconds)
+{
+	uint64_t n = 0;
+	double t0, t;
+
+	run(BATCH);  /* warm up */
+	t0 = now();
+	do{
+		n += run(BATCH);
+		t = now() - t0;
+	}while(t < seconds);
+	return t * 1e9 / n;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	double seconds = 0.2;
+	uint32_t nElements = 4;
+	uint32_t i, s;
+	int opt;
+
+	while((opt = getopt(argc, argv, "t:n:")) != -1){
+		switch(opt){
+		case 't': seconds = atof(optarg); break;
+		case 'n': nElements = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-t seconds] [-n elements]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(nElements < 1 || nElements > 56){
+		fprintf(stderr, "1 to 56 elements\n");
+		return 2;
+	}
+	if(!setup(nElements)){
+		printf("MISMATCH\n");
+		return 1;
+	}
+
+	printf("%-16s", "op");
+	for(s=0; s<NR_SETS; s++)
+		printf("%12s", setName[s]);
+	printf("   [ns/op, %u elements]\n", (unsigned) nElements);
+	for(i=0; i<sizeof(ops)/sizeof(ops[0]); i++){
+		printf("%-16s", ops[i].name);
+		for(s=0; s<NR_SETS; s++){
+			if(ops[i].run[s] == NULL)
+				printf("%12s", "n/a");
+			else
+				printf("%12.2f", measure(ops[i].run[s], seconds));
+		}
+		printf("\n");
+	}
+	return 0;
+}
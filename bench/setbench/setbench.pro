@@ -0,0 +1,18 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+TARGET = setbench
+
+QMAKE_CFLAGS_RELEASE -= -O2
+QMAKE_CFLAGS_RELEASE += -O3
+
+INCLUDEPATH += "../../Protocole_LE"
+
+HEADERS += \
+    ../../Protocole_LE/lib/mem/set56.h \
+    ../../Protocole_LE/lib/mem/set4096.h
+
+SOURCES += \
+    setbench.c \
+    ../../Protocole_LE/lib/mem/set56.c
@@ -7,19 +7,42 @@ TEMPLATE = app
 
 HEADERS += \
     serialportreader.h \
-    textdata.h \
     serialportwriter.h \
+    serialworker.h \
+    serialcapture.h \
+    serialreplay.h \
+    serialtty.h \
+    seriallink.h \
+    serialtransport.h \
+    livedata.h \
     Protocole_LE/lib/mem/ucBuffer.h \
     Protocole_LE/lib/prot/protocol.h \
+    Protocole_LE/lib/prot/dlinkDecoder.h \
+    Protocole_LE/lib/prot/protView.h \
+    Protocole_LE/lib/crc/crc16Lookup.h \
+    Protocole_LE/lib/crc/crc16Block.h \
+    Protocole_LE/lib/mem/spscQueue.h \
+    Protocole_LE/lib/mem/ringBuffer.h \
     Protocole_LE/lib/prot/services/generator.h
 
 SOURCES += \
     main.cpp \
     serialportreader.cpp \
-    textdata.cpp \
     serialportwriter.cpp \
+    serialworker.cpp \
+    serialcapture.cpp \
+    serialreplay.cpp \
+    serialtty.cpp \
+    seriallink.cpp \
+    serialtransport.cpp \
+    livedata.cpp \
     Protocole_LE/lib/mem/ucBuffer.c \
     Protocole_LE/lib/prot/protocol.c \
+    Protocole_LE/lib/prot/dlinkDecoder.c \
+    Protocole_LE/lib/prot/protView.c \
+    Protocole_LE/lib/crc/crc16Lookup.c \
+    Protocole_LE/lib/crc/crc16Block.c \
+    Protocole_LE/lib/mem/spscQueue.c \
     Protocole_LE/lib/prot/services/generator.c
 
 target.path = $$[QT_INSTALL_EXAMPLES]/serialport/creaderasync
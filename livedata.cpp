@@ -0,0 +1,120 @@
+#include "livedata.h"
+
+#include <QQuickWindow>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#include "Protocole_LE/lib/prot/services/battery.h"
+#include "Protocole_LE/lib/prot/services/generator.h"
+#ifdef __cplusplus
+}
+#endif
+
+QT_USE_NAMESPACE
+
+/* indexed by LiveData::Field */
+static void (LiveData::* const notifySignal[LiveData::FieldCount])() = {
+    &LiveData::batteryLevelChanged,
+    &LiveData::packVoltageChanged,
+    &LiveData::flashEnergyChanged,
+    &LiveData::chargerStateChanged,
+};
+
+LiveData::LiveData(QObject *parent)
+    : QObject(parent)
+    , m_dirty(0)
+    , m_scheduled(false)
+    , m_updates(0)
+    , m_notifies(0)
+{
+    for (int i = 0; i < FieldCount; i++) {
+        m_value[i] = 0;
+        m_pending[i] = 0;
+    }
+
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &LiveData::flush);
+}
+
+LiveData::~LiveData()
+{
+}
+
+/*
+ * Publishes from QQuickWindow::afterAnimating, which the window emits in the
+ * GUI thread once per frame, before the scene graph is synchronized.
+ */
+void LiveData::setWindow(QQuickWindow *window)
+{
+    if (m_window)
+        disconnect(m_window, nullptr, this, nullptr);
+    m_window = window;
+    if (m_window)
+        connect(m_window, &QQuickWindow::afterAnimating, this, &LiveData::flush);
+}
+
+/* A field set back to its published value within a frame is not dirty anymore. */
+void LiveData::stage(Field field, int value)
+{
+    m_updates++;
+    m_pending[field] = value;
+    if (value == m_value[field]) {
+        m_dirty &= ~(1u << field);
+        return;
+    }
+    m_dirty |= 1u << field;
+    schedule();
+}
+
+void LiveData::schedule()
+{
+    if (m_scheduled)
+        return;
+    m_scheduled = true;
+    if (m_window)
+        m_window->update();
+    else
+        m_timer.start(FramePeriod);
+}
+
+void LiveData::flush()
+{
+    quint32 dirty = m_dirty;
+
+    m_dirty = 0;
+    m_scheduled = false;
+    while (dirty) {
+        const int field = __builtin_ctz(dirty);
+
+        dirty &= dirty - 1;
+        m_value[field] = m_pending[field];
+        m_notifies++;
+        emit (this->*notifySignal[field])();
+    }
+}
+
+/*
+ * Takes the live data answers of the battery, see handle_reply_get_live_data()
+ * of the battery services for the layout, and of the generator: flash
+ * energy(2), number of flashes(4), charger state(1). The charger state is
+ * the one of the battery answer.
+ */
+void LiveData::handleFrame(const struct protocol &frame)
+{
+    const uint8_t *data = static_cast<const uint8_t *>(frame.data.pData);
+
+    if (frame.procLayer.sid == PROT_SID(SID_DEV_BAT, SID_SERV_BAT_GET_LIVE_DATA, SID_ANS)) {
+        if (frame.data.dLen < 19)
+            return;
+        setBatteryLevel(RETRIEVE8(&data[0]));
+        setPackVoltage(RETRIEVE16(&data[3]));
+        setChargerState(RETRIEVE8(&data[16]));
+    } else if (frame.procLayer.sid == PROT_SID(SID_DEV_GEN, SID_SERV_GEN_GET_LIVE_DATA, SID_ANS)) {
+        if (frame.data.dLen < 7)
+            return;
+        setFlashEnergy(RETRIEVE16(&data[0]));
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef LIVEDATA_H
+#define LIVEDATA_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+class QQuickWindow;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#include "Protocole_LE/lib/prot/protocol.h"
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Typed live data for QML. Decoded values are staged and published at most
+ * once per frame, right before the scene graph is synchronized: a value
+ * written several times within a frame notifies once, a value that ends up
+ * unchanged doesn't notify at all. Without a window, a timer of one frame
+ * period is used instead.
+ */
+class LiveData : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int batteryLevel READ batteryLevel NOTIFY batteryLevelChanged)
+    Q_PROPERTY(int packVoltage READ packVoltage NOTIFY packVoltageChanged)
+    Q_PROPERTY(int flashEnergy READ flashEnergy NOTIFY flashEnergyChanged)
+    Q_PROPERTY(int chargerState READ chargerState NOTIFY chargerStateChanged)
+public:
+    enum Field {
+        BatteryLevel,   /* relative remaining capacity, % */
+        PackVoltage,    /* battery pack voltage as reported by the battery */
+        FlashEnergy,    /* energy of the last flash */
+        ChargerState,   /* charger status byte of the battery (chgs) */
+        FieldCount
+    };
+
+    enum {
+        FramePeriod = 16 /* ms, fallback without a window */
+    };
+
+    explicit LiveData(QObject *parent = nullptr);
+    ~LiveData();
+
+    void setWindow(QQuickWindow *window);
+
+    int batteryLevel() const { return m_value[BatteryLevel]; }
+    int packVoltage() const { return m_value[PackVoltage]; }
+    int flashEnergy() const { return m_value[FlashEnergy]; }
+    int chargerState() const { return m_value[ChargerState]; }
+
+    void setBatteryLevel(int level) { stage(BatteryLevel, level); }
+    void setPackVoltage(int voltage) { stage(PackVoltage, voltage); }
+    void setFlashEnergy(int energy) { stage(FlashEnergy, energy); }
+    void setChargerState(int state) { stage(ChargerState, state); }
+
+    quint32 updates() const { return m_updates; }
+    quint32 notifies() const { return m_notifies; }
+
+public slots:
+    void handleFrame(const struct protocol &frame);
+
+signals:
+    void batteryLevelChanged();
+    void packVoltageChanged();
+    void flashEnergyChanged();
+    void chargerStateChanged();
+
+private slots:
+    void flush();
+
+private:
+    void stage(Field field, int value);
+    void schedule();
+
+    QPointer<QQuickWindow>  m_window;
+    QTimer                  m_timer;
+    int                     m_value[FieldCount];    /* published */
+    int                     m_pending[FieldCount];  /* staged for the next frame */
+    quint32                 m_dirty;                /* bit per field */
+    bool                    m_scheduled;
+    quint32                 m_updates;
+    quint32                 m_notifies;
+};
+
+#endif // LIVEDATA_H
@@ -49,9 +49,9 @@
 ****************************************************************************/
 
 
-#include "serialportreader.h"
-#include "serialportwriter.h"
-#include "textdata.h"
+#include "seriallink.h"
+#include "serialtransport.h"
+#include "livedata.h"
 #include <QtSerialPort/QSerialPort>
 #include <QTextStream>
 #include <QCoreApplication>
@@ -61,6 +61,7 @@
 #include <QObject>
 #include <QDebug>
 
+#include <QCommandLineParser>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QTimer>
@@ -83,21 +84,41 @@ int main(int argc, char *argv[])
 {
     QGuiApplication app(argc, argv);
     QQuickView view;
-    view.setSource(QUrl("qrc:/Display.qml"));
-    view.show();
-
-    QObject *object = view.rootObject();
-    QObject *energy = object->findChild<QObject*>("myenergy"); /*Return the Child of the Object*/
 
     /* To display message on the terminal */
     QTextStream standardOutput(stdout); /*interface to write text*/
 
-    /* Port configuration */
-    QSerialPort serialPort;
-    QString serialPortName = "/dev/ttymxc1";
-    serialPort.setPortName(serialPortName);
+    /* port, record and replay of the serial traffic, see serialcapture.h */
+    QCommandLineParser parser;
+    const QCommandLineOption portOption("port", "Serial port <name>, e.g. the pty of sim/gensim.", "name", "/dev/ttymxc1");
+    const QCommandLineOption backendOption("backend", "Serial port <backend>: qserialport or tty (raw termios/epoll, see serialtty.h).", "backend", "qserialport");
+    const QCommandLineOption captureOption("capture", "Capture the serial traffic to <file>.", "file");
+    const QCommandLineOption replayOption("replay", "Replay <file> instead of opening the port.", "file");
+    const QCommandLineOption fastOption("fast", "Replay as fast as possible.");
+    parser.addHelpOption();
+    parser.addOption(portOption);
+    parser.addOption(backendOption);
+    parser.addOption(captureOption);
+    parser.addOption(replayOption);
+    parser.addOption(fastOption);
+    parser.process(app);
+
+    /* Port configuration, the port itself is served by the serial I/O thread */
+    QString serialPortName = parser.value(portOption);
     int serialPortBaudRate = QSerialPort::Baud115200;
-    serialPort.setBaudRate(serialPortBaudRate);
+    SerialLink serialLink(serialPortName, serialPortBaudRate);
+    if (parser.value(backendOption) == "tty") {
+        serialLink.setBackend(SerialWorker::TtyBackend);
+    } else if (parser.value(backendOption) != "qserialport") {
+        standardOutput << QObject::tr("Unknown backend %1").arg(parser.value(backendOption)) << endl;
+        return 1;
+    }
+    SerialTransport serialTransport(&serialLink);
+
+    /* live data shown by QML, published once per frame */
+    LiveData liveData;
+    liveData.setWindow(&view);
+    QObject::connect(&serialLink, &SerialLink::frameReceived, &liveData, &LiveData::handleFrame);
 
     /*add protocole*/
     uint8_t bufMem[256];
@@ -111,20 +132,30 @@ int main(int argc, char *argv[])
     prot.tranLayer.tid = 0;
     prot_encode(&prot,&buf);
 
-    serialPort.open(QIODevice::WriteOnly);
+    QObject::connect(&serialLink, &SerialLink::opened, [&standardOutput, serialPortName](bool ok, const QString &error) {
+        if (!ok)
+            standardOutput << QObject::tr("Failed to open port %1, error: %2").arg(serialPortName).arg(error) << endl;
+    });
+    QObject::connect(&serialLink, &SerialLink::replayFinished, [&standardOutput](quint32 records, qint64 bytes, qint64 elapsedNs) {
+        standardOutput << QObject::tr("Replayed %1 records, %2 bytes in %3 ms")
+                          .arg(records).arg(bytes).arg(elapsedNs / 1000000) << endl;
+    });
+    if (parser.isSet(captureOption))
+        serialLink.setCaptureFile(parser.value(captureOption));
+    if (parser.isSet(replayOption))
+        serialLink.setReplayFile(parser.value(replayOption), parser.isSet(fastOption));
+    serialLink.open();
 
-    SerialPortWriter serialPortWriter(&serialPort);
     const char t_data[] = {0xa5,0x05,0x00,0x00,0x10,0x18,0xff,0xd7,'I'};
-    view.rootContext()->setContextProperty("myserialPortWriter", &serialPortWriter);
+    view.rootContext()->setContextProperty("myserialPortWriter", &serialLink);
+    view.rootContext()->setContextProperty("myserialTransport", &serialTransport);
+    view.rootContext()->setContextProperty("myliveData", &liveData);
     view.rootContext()->setContextProperty("myt_data", &t_data);
-    serialPortWriter.write(t_data, 9);
-    
+    serialLink.write(t_data, 9);
 
-    if (energy)
-    {
-        //TextData *ttext = new TextData(energy, nullptr);
-        //QObject::connect(&serialPortReader, SIGNAL(newValueReady(QString)),ttext , SLOT(updateValue(QString)));
-    }
+    /* the context properties have to be set before the bindings are created */
+    view.setSource(QUrl("qrc:/Display.qml"));
+    view.show();
 
     return app.exec();
 }
@@ -0,0 +1,177 @@
+#include "serialcapture.h"
+
+#include <QDateTime>
+#include <QObject>
+#include <QtEndian>
+
+#include <string.h>
+
+QT_USE_NAMESPACE
+
+static const char captureMagic[4] = {'S', 'C', 'A', 'P'};
+
+SerialCapture::SerialCapture()
+    : m_map(nullptr)
+    , m_mapped(0)
+    , m_pos(0)
+    , m_records(0)
+{
+}
+
+SerialCapture::~SerialCapture()
+{
+    close();
+}
+
+/* Creates the file, an existing one is truncated. */
+bool SerialCapture::open(const QString &path)
+{
+    close();
+
+    QMutexLocker locker(&m_lock);
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        return false;
+    m_pos = 0;
+    m_records = 0;
+    if (!grow(HeaderSize)) {
+        m_file.close();
+        return false;
+    }
+
+    memcpy(m_map, captureMagic, sizeof(captureMagic));
+    qToLittleEndian<quint16>(Version, m_map + 4);
+    qToLittleEndian<quint16>(HeaderSize, m_map + 6);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), m_map + 8);
+    qToLittleEndian<qint64>(0, m_map + 16);
+    m_pos = HeaderSize;
+    m_clock.start();
+    return true;
+}
+
+/* Takes the lock, append() may still run on the tty thread. */
+void SerialCapture::close()
+{
+    QMutexLocker locker(&m_lock);
+
+    if (!m_file.isOpen())
+        return;
+    if (m_map)
+        m_file.unmap(m_map);
+    m_map = nullptr;
+    m_file.resize(m_pos);
+    m_file.close();
+    m_mapped = 0;
+}
+
+/*
+ * The record is written in place, the direction last: it is what a reader
+ * checks to tell a record from the zeroed tail.
+ */
+bool SerialCapture::append(Direction dir, const char *data, qint64 len)
+{
+    QMutexLocker locker(&m_lock);
+    uchar *rec;
+
+    if (!m_map || len > 0xffff)
+        return false;
+    if (m_pos + RecordHeaderSize + len > m_mapped && !grow(RecordHeaderSize + len))
+        return false;
+
+    rec = m_map + m_pos;
+    qToLittleEndian<qint64>(m_clock.nsecsElapsed(), rec);
+    qToLittleEndian<quint16>(quint16(len), rec + 8);
+    rec[11] = 0;
+    memcpy(rec + RecordHeaderSize, data, size_t(len));
+    rec[10] = quint8(dir);
+
+    m_pos += RecordHeaderSize + len;
+    m_records++;
+    return true;
+}
+
+/* Extends the file by at least need bytes and maps it again. */
+bool SerialCapture::grow(qint64 need)
+{
+    const qint64 size = m_mapped + qMax(need, qint64(ChunkSize));
+
+    if (m_map)
+        m_file.unmap(m_map);
+    m_map = nullptr;
+    if (!m_file.resize(size))
+        return false;
+    m_map = m_file.map(0, size);
+    if (!m_map)
+        return false;
+    m_mapped = size;
+    return true;
+}
+
+SerialCaptureReader::SerialCaptureReader()
+    : m_map(nullptr)
+    , m_size(0)
+    , m_pos(0)
+    , m_startTime(0)
+{
+}
+
+SerialCaptureReader::~SerialCaptureReader()
+{
+    close();
+}
+
+bool SerialCaptureReader::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size >= SerialCapture::HeaderSize)
+        m_map = m_file.map(0, m_size);
+    if (!m_map || memcmp(m_map, captureMagic, sizeof(captureMagic)) != 0
+            || qFromLittleEndian<quint16>(m_map + 4) != SerialCapture::Version) {
+        m_error = QObject::tr("%1 is not a serial capture").arg(path);
+        close();
+        return false;
+    }
+
+    m_pos = qFromLittleEndian<quint16>(m_map + 6);
+    m_startTime = qFromLittleEndian<qint64>(m_map + 8);
+    return true;
+}
+
+void SerialCaptureReader::close()
+{
+    if (m_map)
+        m_file.unmap(const_cast<uchar *>(m_map));
+    m_map = nullptr;
+    m_file.close();
+    m_size = 0;
+    m_pos = 0;
+}
+
+/* Returns false at the end of the capture, record.data points into the file. */
+bool SerialCaptureReader::next(SerialCapture::Record &record)
+{
+    const uchar *rec;
+
+    if (!m_map || m_pos + SerialCapture::RecordHeaderSize > m_size)
+        return false;
+
+    rec = m_map + m_pos;
+    record.timestamp = qFromLittleEndian<qint64>(rec);
+    record.len = qFromLittleEndian<quint16>(rec + 8);
+    record.dir = SerialCapture::Direction(rec[10]);
+    record.data = rec + SerialCapture::RecordHeaderSize;
+
+    if (record.dir == SerialCapture::End
+            || m_pos + SerialCapture::RecordHeaderSize + record.len > m_size)
+        return false;
+    m_pos += SerialCapture::RecordHeaderSize + record.len;
+    return true;
+}
@@ -0,0 +1,103 @@
+#ifndef SERIALCAPTURE_H
+#define SERIALCAPTURE_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+
+/*
+ * Capture of the serial traffic, append-only and memory-mapped.
+ *
+ * File layout, all fields little endian:
+ *
+ *   header  magic "SCAP"(4) version(2) header size(2) start UTC ms(8)
+ *           reserved(8)
+ *   record  timestamp ns(8) length(2) direction(1) reserved(1) data(length)
+ *
+ * The timestamp is taken from the monotonic clock, relative to the start of
+ * the capture. RX records hold the bytes as they were read from the port,
+ * in the chunks delivered by the driver; TX records hold a whole frame as it
+ * was handed to the port.
+ *
+ * The file grows in chunks of ChunkSize bytes, which are mapped and written
+ * in place. It is cut to the used size on close(). After a crash the tail
+ * of the last chunk is left zeroed, a reader stops at the first record with
+ * direction 0.
+ *
+ * append() may be called from several threads, e.g. with a SerialTty the RX
+ * records are appended from the tty thread.
+ */
+class SerialCapture
+{
+public:
+    enum Direction {
+        End = 0,
+        Rx = 1,
+        Tx = 2
+    };
+
+    struct Record {
+        qint64 timestamp;   /* ns since the start of the capture */
+        Direction dir;
+        const uchar *data;  /* points into the mapped file */
+        int len;
+    };
+
+    enum {
+        Version = 1,
+        HeaderSize = 24,
+        RecordHeaderSize = 12,
+        ChunkSize = 4 << 20
+    };
+
+    SerialCapture();
+    ~SerialCapture();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+    QString errorString() const { return m_file.errorString(); }
+
+    bool append(Direction dir, const char *data, qint64 len);
+
+    quint32 records() const { return m_records; }
+    qint64 size() const { return m_pos; }
+
+private:
+    bool grow(qint64 need);
+
+    QFile           m_file;
+    QElapsedTimer   m_clock;
+    QMutex          m_lock;     /* guards the mapping: append(), open(), close() */
+    uchar           *m_map;
+    qint64          m_mapped;   /* file and mapping size */
+    qint64          m_pos;      /* end of the last record */
+    quint32         m_records;
+};
+
+/* Sequential reader of a capture file. */
+class SerialCaptureReader
+{
+public:
+    SerialCaptureReader();
+    ~SerialCaptureReader();
+
+    bool open(const QString &path);
+    void close();
+    QString errorString() const { return m_error; }
+
+    bool next(SerialCapture::Record &record);
+    void rewind() { m_pos = SerialCapture::HeaderSize; }
+    qint64 startTime() const { return m_startTime; }
+
+private:
+    QFile           m_file;
+    QString         m_error;
+    const uchar     *m_map;
+    qint64          m_size;
+    qint64          m_pos;
+    qint64          m_startTime; /* UTC ms */
+};
+
+#endif // SERIALCAPTURE_H
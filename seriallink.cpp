@@ -0,0 +1,161 @@
+#include "seriallink.h"
+
+#include <QTimer>
+
+QT_USE_NAMESPACE
+
+SerialLink::SerialLink(const QString &portName, qint32 baudRate, QObject *parent)
+    : QObject(parent)
+    , m_worker(new SerialWorker(portName, baudRate, &m_rxRing))
+    , m_txQueueDepth(0)
+    , m_backPressure(false)
+{
+    spscQueue_init(&m_rxRing.queue, m_rxRing.mem, SerialRxRing::Len, sizeof(SerialFrame));
+    m_rxRing.notifyPending.store(false);
+
+    m_thread.setObjectName("serial-io");
+    m_worker->moveToThread(&m_thread);
+
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &SerialWorker::framesAvailable, this, &SerialLink::drainRx);
+    connect(m_worker, &SerialWorker::opened, this, &SerialLink::opened);
+    connect(m_worker, &SerialWorker::txQueueDepthChanged, this, &SerialLink::setTxQueueDepth);
+    connect(m_worker, &SerialWorker::backPressureChanged, this, &SerialLink::setBackPressure);
+    connect(m_worker, &SerialWorker::replayFinished, this, &SerialLink::replayFinished);
+
+    m_thread.start(QThread::TimeCriticalPriority);
+}
+
+SerialLink::~SerialLink()
+{
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void SerialLink::setCaptureFile(const QString &path)
+{
+    QTimer::singleShot(0, m_worker, [this, path]() { m_worker->setCaptureFile(path); });
+}
+
+void SerialLink::setReplayFile(const QString &path, bool fast)
+{
+    QTimer::singleShot(0, m_worker, [this, path, fast]() { m_worker->setReplayFile(path, fast); });
+}
+
+void SerialLink::setBackend(SerialWorker::Backend backend)
+{
+    QTimer::singleShot(0, m_worker, [this, backend]() { m_worker->setBackend(backend); });
+}
+
+void SerialLink::open()
+{
+    QTimer::singleShot(0, m_worker, [this]() { m_worker->open(); });
+}
+
+/*
+ * Wraps a completion callback so it is run in the thread of the link and not
+ * in the I/O thread.
+ */
+SerialLink::Callback SerialLink::toThisThread(Callback done)
+{
+    if (!done)
+        return Callback();
+    return [this, done](bool ok) {
+        QTimer::singleShot(0, this, [done, ok]() { done(ok); });
+    };
+}
+
+void SerialLink::write(const char *writeData, qint64 len, Callback done)
+{
+    write(QByteArray(writeData, int(len)), done);
+}
+
+/* Writes an already encoded frame, it is shared with the I/O thread, not copied. */
+void SerialLink::write(const QByteArray &frame, Callback done)
+{
+    const Callback cb = toThisThread(done);
+
+    QTimer::singleShot(0, m_worker, [this, frame, cb]() { m_worker->write(frame, 0, cb); });
+}
+
+/*
+ * The message is encoded here, in the caller's thread, since the service
+ * data referenced by prot is owned by the caller.
+ */
+void SerialLink::send(const struct protocol &prot, Callback done)
+{
+    QByteArray data;
+
+    if (!SerialPortWriter::encode(prot, data)) {
+        if (done)
+            done(false);
+        return;
+    }
+
+    const quint16 key = SerialPortWriter::coalesceKey(prot);
+    const Callback cb = toThisThread(done);
+
+    QTimer::singleShot(0, m_worker, [this, data, key, cb]() { m_worker->write(data, key, cb); });
+}
+
+void SerialLink::writeTest()
+{
+    const char t_data[] = {char(0xa5),0x05,0x00,0x00,0x10,0x18,char(0xff),char(0xd7),'I'};
+
+    write(t_data, 9);
+}
+
+/*
+ * Empties the RX ring. The notify flag is cleared first, a frame published
+ * while draining will trigger another framesAvailable(). Clearing the flag
+ * and reading the queue must not be reordered (store->load, see
+ * SerialWorker::handleFrame()), which release/acquire doesn't guarantee.
+ */
+void SerialLink::drainRx()
+{
+    SerialFrame *frame;
+    struct protView view;
+    struct protocol prot;
+
+    m_rxRing.notifyPending.store(false, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!spscQueue_get(&m_rxRing.queue, reinterpret_cast<void **>(&frame))) {
+        /* decoded in place, the headers have been checked by the reader */
+        protView_init(&view, frame->data, frame->len);
+        if (protView_decode(&view, &prot) == PROT_SUCCESS)
+            emit frameReceived(prot);
+        spscQueue_consume(&m_rxRing.queue);
+    }
+    emit rxStatsChanged();
+}
+
+int SerialLink::rxQueueDepth() const
+{
+    return int(spscQueue_load(const_cast<struct spscQueue *>(&m_rxRing.queue)));
+}
+
+int SerialLink::rxHighWater() const
+{
+    return int(__atomic_load_n(&m_rxRing.queue.prod.highWater, __ATOMIC_RELAXED));
+}
+
+int SerialLink::rxDropped() const
+{
+    return int(__atomic_load_n(&m_rxRing.queue.prod.nDropped, __ATOMIC_RELAXED));
+}
+
+void SerialLink::setTxQueueDepth(int depth)
+{
+    if (m_txQueueDepth == depth)
+        return;
+    m_txQueueDepth = depth;
+    emit txQueueDepthChanged(depth);
+}
+
+void SerialLink::setBackPressure(bool backPressure)
+{
+    if (m_backPressure == backPressure)
+        return;
+    m_backPressure = backPressure;
+    emit backPressureChanged(backPressure);
+}
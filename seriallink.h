@@ -0,0 +1,71 @@
+#ifndef SERIALLINK_H
+#define SERIALLINK_H
+
+#include <QObject>
+#include <QThread>
+#include <QString>
+
+#include "serialworker.h"
+#include "serialportwriter.h"
+
+/*
+ * GUI side of the serial link. The port, the frame decoder and the write
+ * queue run in a dedicated I/O thread (SerialWorker), decoded frames are
+ * handed over through a lock-free single producer/single consumer ring and
+ * emitted here, in the thread of the SerialLink.
+ */
+class SerialLink : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int rxQueueDepth READ rxQueueDepth NOTIFY rxStatsChanged)
+    Q_PROPERTY(int rxHighWater READ rxHighWater NOTIFY rxStatsChanged)
+    Q_PROPERTY(int rxDropped READ rxDropped NOTIFY rxStatsChanged)
+    Q_PROPERTY(int txQueueDepth READ txQueueDepth NOTIFY txQueueDepthChanged)
+    Q_PROPERTY(bool backPressure READ backPressure NOTIFY backPressureChanged)
+public:
+    typedef SerialPortWriter::Callback Callback;
+
+    explicit SerialLink(const QString &portName, qint32 baudRate, QObject *parent = nullptr);
+    ~SerialLink();
+
+    /* to be called before open(), see SerialWorker */
+    void setCaptureFile(const QString &path);
+    void setReplayFile(const QString &path, bool fast);
+    void setBackend(SerialWorker::Backend backend);
+    void open();
+    void write(const char *writeData, qint64 len, Callback done = Callback());
+    void write(const QByteArray &frame, Callback done = Callback());
+    void send(const struct protocol &prot, Callback done = Callback());
+    Q_INVOKABLE void writeTest();
+
+    int rxQueueDepth() const;
+    int rxHighWater() const;
+    int rxDropped() const;
+    int txQueueDepth() const { return m_txQueueDepth; }
+    bool backPressure() const { return m_backPressure; }
+
+signals:
+    /* frame.data.pData is only valid during the emission */
+    void frameReceived(const struct protocol &frame);
+    void opened(bool ok, const QString &error);
+    void rxStatsChanged();
+    void txQueueDepthChanged(int depth);
+    void backPressureChanged(bool backPressure);
+    void replayFinished(quint32 records, qint64 bytes, qint64 elapsedNs);
+
+private slots:
+    void drainRx();
+    void setTxQueueDepth(int depth);
+    void setBackPressure(bool backPressure);
+
+private:
+    Callback toThisThread(Callback done);
+
+    QThread         m_thread;
+    SerialWorker    *m_worker;
+    SerialRxRing    m_rxRing;
+    int             m_txQueueDepth;
+    bool            m_backPressure;
+};
+
+#endif // SERIALLINK_H
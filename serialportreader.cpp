@@ -49,26 +49,52 @@
 ****************************************************************************/
 
 #include "serialportreader.h"
+#include "serialcapture.h"
+#include "serialtty.h"
 
 #include <QCoreApplication>
-#include <QDebug>
 
 QT_USE_NAMESPACE
 
 SerialPortReader::SerialPortReader(QSerialPort *serialPort, QObject *parent)
     : QObject(parent)
     , m_serialPort(serialPort)
+    , m_tty(nullptr)
+    , m_capture(nullptr)
     , m_standardOutput(stdout)
 {
+    dlinkDec_init(&m_decoder, m_rxMem, sizeof(m_rxMem));
+
+    /* without port, the data is fed by the owner */
+    if (!m_serialPort)
+        return;
+
     /*sender,signal - receiver,methond*/
     connect(m_serialPort, &QSerialPort::readyRead, this, &SerialPortReader::handleReadyRead);
     /**/
     connect(m_serialPort, static_cast<void (QSerialPort::*)(QSerialPort::SerialPortError)>(&QSerialPort::error),
             this, &SerialPortReader::handleError);
-    /*affiche les valeurs*/
-    connect(&m_timer, &QTimer::timeout, this, &SerialPortReader::handleTimeout);
+}
+
+SerialPortReader::SerialPortReader(SerialTty *tty, QObject *parent)
+    : QObject(parent)
+    , m_serialPort(nullptr)
+    , m_tty(tty)
+    , m_capture(nullptr)
+    , m_standardOutput(stdout)
+{
+    dlinkDec_init(&m_decoder, m_rxMem, sizeof(m_rxMem));
 
-    m_timer.start(50); /*Temps d'enregistrement*/
+    m_tty->setReadHandler([this](const char *data, qint64 len) {
+        if (m_capture)
+            m_capture->append(SerialCapture::Rx, data, len);
+        decode(reinterpret_cast<const uint8_t *>(data), quint32(len));
+    });
+    /* wake the tty thread once the frame in progress is complete */
+    m_tty->setMinReadHandler([this]() { return dlinkDec_missing(&m_decoder); });
+    m_tty->setErrorHandler([this]() {
+        QMetaObject::invokeMethod(this, "handleTtyError", Qt::QueuedConnection);
+    });
 }
 
 SerialPortReader::~SerialPortReader()
@@ -77,26 +103,49 @@ SerialPortReader::~SerialPortReader()
 
 void SerialPortReader::handleReadyRead()
 {
-    /*readAll: read data from the device*/
-    /*append ajoute les chaînes*/
-    m_serialPort->setReadBufferSize(1);
-    qDebug() << "Buffer Size " << m_serialPort->readBufferSize();
-    m_readData = m_serialPort->readAll(); /*m_readData est un attribut*/
-
-    if (!m_timer.isActive())
-        m_timer.start(50);
+    /* Drain the port in fixed chunks, the decoder keeps its state across
+     * calls so frames may be split at any byte. */
+    char chunk[256];
+    qint64 n;
+
+    while ((n = m_serialPort->read(chunk, sizeof(chunk))) > 0) {
+        if (m_capture)
+            m_capture->append(SerialCapture::Rx, chunk, n);
+        decode(reinterpret_cast<const uint8_t *>(chunk), quint32(n));
+    }
+}
+
+void SerialPortReader::feed(const char *data, qint64 len)
+{
+    decode(reinterpret_cast<const uint8_t *>(data), quint32(len));
 }
 
-void SerialPortReader::handleTimeout()
+void SerialPortReader::decode(const uint8_t *data, quint32 len)
 {
-    if (m_readData.isEmpty()) {
-        m_standardOutput << QObject::tr("No data was currently available for reading from port %1").arg(m_serialPort->portName()) << endl;
-    } else {
-        m_standardOutput << QObject::tr("Data successfully received from port %1").arg(m_serialPort->portName()) << endl;
-        m_standardOutput << m_readData << endl;
-        m_ttext = m_readData;
-        qDebug() << "m_ttext " << m_ttext;
-        emit newValueReady(m_ttext);
+    struct protView view;
+    uint32_t consumed;
+    int32_t ret;
+
+    while (len) {
+        ret = dlinkDec_feed(&m_decoder, data, len, &consumed);
+        data += consumed;
+        len -= consumed;
+
+        if (ret == DLINK_DEC_FRAME) {
+            /* The headers are checked in place, nothing is copied. Routed
+               messages are not for us. */
+            protView_init(&view, m_decoder.rxBuf.buf, m_decoder.rxBuf.len);
+            if (!protView_is_routed(&view)) {
+                ret = protView_parse(&view, PROT_VIEW_PROC);
+                if (ret != PROT_SUCCESS)
+                    emit frameError(ret);
+                else
+                    emit frameReceived(view);
+            }
+            ucBuffer_clear(&m_decoder.rxBuf);
+        } else if (ret < 0) {
+            emit frameError(ret);
+        }
     }
 }
 
@@ -108,3 +157,8 @@ void SerialPortReader::handleError(QSerialPort::SerialPortError serialPortError)
     }
 }
 
+void SerialPortReader::handleTtyError()
+{
+    m_standardOutput << QObject::tr("An I/O error occurred on port %1, error: %2").arg(m_tty->portName()).arg(m_tty->errorString()) << endl;
+    QCoreApplication::exit(1);
+}
@@ -54,10 +54,22 @@
 #include <QtSerialPort/QSerialPort>
 
 #include <QTextStream>
-#include <QTimer>
-#include <QByteArray>
 #include <QObject>
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#include "Protocole_LE/lib/prot/protocol.h"
+#include "Protocole_LE/lib/prot/dlinkDecoder.h"
+#include "Protocole_LE/lib/prot/protView.h"
+#ifdef __cplusplus
+}
+#endif
+
+class SerialCapture;
+class SerialTty;
+
 QT_USE_NAMESPACE
 
 QT_BEGIN_NAMESPACE
@@ -70,23 +82,40 @@ class SerialPortReader : public QObject
 
 public:
     explicit SerialPortReader(QSerialPort *serialPort, QObject *parent = nullptr); /*constructeur*/
+    /* The bytes are decoded in the thread of the tty, which emits the
+     * signals, see SerialTty. To be created before the tty is opened. */
+    explicit SerialPortReader(SerialTty *tty, QObject *parent = nullptr);
     ~SerialPortReader();
 
+    /* bytes as read from the port, e.g. from a replayed capture */
+    void feed(const char *data, qint64 len);
+    void setCapture(SerialCapture *capture) { m_capture = capture; }
+
+    quint32 framesReceived() const { return m_decoder.nFrames; }
+    quint32 framesDropped() const { return m_decoder.nErrors; }
+
 signals:
-    void newValueReady(QString m_newValueReady);
+    /* Emitted once per frame with valid headers. The view refers to the
+     * decoder buffer and is only valid during the emission. */
+    void frameReceived(const struct protView &frame);
+    /* Negative: data link error (dlinkDecoder.h), positive: decoder error
+     * (protocol.h). */
+    void frameError(int error);
 
 private slots:
     void handleReadyRead();
-    void handleTimeout();
     void handleError(QSerialPort::SerialPortError error);
+    void handleTtyError();
 
 private:
-    QByteArray  m_readData;
+    void decode(const uint8_t *data, quint32 len);
+
     QSerialPort *m_serialPort;
+    SerialTty *m_tty;
+    SerialCapture *m_capture;
     QTextStream m_standardOutput;
-    QTimer      m_timer;
-    QString m_ttext;
-    QObject *m_text;
+    struct dlinkDecoder m_decoder;
+    uint8_t m_rxMem[255 + CRC_LEN];
 };
 
 #endif
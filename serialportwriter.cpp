@@ -1,60 +1,291 @@
 #include "serialportwriter.h"
+#include "serialcapture.h"
+#include "serialtty.h"
 
 #include <QCoreApplication>
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#include "Protocole_LE/lib/prot/services/generator.h"
+#ifdef __cplusplus
+}
+#endif
+
 QT_USE_NAMESPACE
 
 SerialPortWriter::SerialPortWriter(QSerialPort *serialPort, QObject *parent)
     : QObject(parent)
     , m_serialPort(serialPort)
+    , m_tty(nullptr)
+    , m_capture(nullptr)
+    , m_standardOutput(stdout)
+    , m_pending(0)
+    , m_inFlight(0)
+    , m_maxInFlight(1)
+    , m_rejected(0)
+    , m_coalesced(0)
+{
+    init();
+
+    connect(m_serialPort, &QSerialPort::bytesWritten, this, &SerialPortWriter::handleBytesWritten);
+    connect(m_serialPort, static_cast<void (QSerialPort::*)(QSerialPort::SerialPortError)>(&QSerialPort::error),
+            this, &SerialPortWriter::handleError);
+}
+
+/* The written bytes are reported from the tty thread and counted here. */
+SerialPortWriter::SerialPortWriter(SerialTty *tty, QObject *parent)
+    : QObject(parent)
+    , m_serialPort(nullptr)
+    , m_tty(tty)
+    , m_capture(nullptr)
     , m_standardOutput(stdout)
+    , m_pending(0)
+    , m_inFlight(0)
+    , m_maxInFlight(MaxTtyInFlight)
+    , m_rejected(0)
+    , m_coalesced(0)
+{
+    init();
+
+    m_tty->setWrittenHandler([this](qint64 bytes) {
+        QMetaObject::invokeMethod(this, "handleBytesWritten", Qt::QueuedConnection, Q_ARG(qint64, bytes));
+    });
+}
+
+void SerialPortWriter::init()
 {
     m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &SerialPortWriter::handleTimeout);
 }
 
 SerialPortWriter::~SerialPortWriter()
 {
 }
 
-void SerialPortWriter::write(const char *writeData, qint64 len)
+/*
+ * Setter services that carry the complete target state. If such a frame is
+ * still waiting in the queue, a newer one simply replaces its content.
+ */
+quint16 SerialPortWriter::coalesceKey(const struct protocol &prot)
+{
+    const quint16 sid = prot.procLayer.sid;
+
+    if (prot.netLayer.nid != 0 || (sid & SID_ANS_M))
+        return 0;
+    if (((sid & SID_DEV_M) >> SID_DEV_S) != SID_DEV_GEN)
+        return 0;
+
+    switch ((sid & SID_SERV_M) >> SID_SERV_S) {
+    case SID_SERV_GEN_SET_CHARGER_SETTINGS:
+    case SID_SERV_GEN_SET_PS_SETTINGS:
+    case SID_SERV_GEN_SET_FLASH_SETTINGS:
+    case SID_SERV_GEN_SET_LAMP_SETTINGS:
+    case SID_SERV_GEN_SET_TRIGGER_SOURCE:
+    case SID_SERV_GEN_SET_TRIGGER_SETTINGS:
+        return sid;
+    default:
+        return 0;
+    }
+}
+
+bool SerialPortWriter::write(const char *writeData, qint64 len, Callback done,
+                             quint16 key)
+{
+    return enqueue(QByteArray(writeData, int(len)), key, done);
+}
+
+/* The frame is queued as it is, implicitly shared and without a copy. */
+bool SerialPortWriter::write(const QByteArray &data, Callback done, quint16 key)
 {
-    const qint64 bytesWritten = m_serialPort->write(writeData, len);
+    return enqueue(data, key, done);
+}
 
-    if (bytesWritten == -1) {
-        m_standardOutput << QObject::tr("Failed to write the data to port %1, error: %2")
-                          .arg(m_serialPort->portName()).arg(m_serialPort->errorString()) << endl;
-        QCoreApplication::exit(1);
-    } else if (!m_serialPort->waitForBytesWritten(5000)) {
-        m_standardOutput << QObject::tr("Operation timed out or an error "
-                                      "occurred for port %1, error: %2")
-                          .arg(m_serialPort->portName()).arg(m_serialPort->errorString()) << endl;
-        QCoreApplication::exit(1);
+bool SerialPortWriter::send(const struct protocol &prot, Callback done)
+{
+    QByteArray frame;
+
+    if (!encode(prot, frame)) {
+        if (done)
+            done(false);
+        return false;
     }
+    return enqueue(frame, coalesceKey(prot), done);
+}
 
-    m_standardOutput << QObject::tr("Data successfully sent to port %1")
-                      .arg(m_serialPort->portName()) << endl;
+/*
+ * Encodes the message including the data link layer
+ * [PREAMBLE(1), PAYLOAD LENGTH(1), PAYLOAD(x), CRC(2)] straight into the
+ * memory of frame, which can be handed to QSerialPort::write as it is.
+ */
+bool SerialPortWriter::encode(const struct protocol &prot, QByteArray &frame)
+{
+    struct protocol src = prot;
+    uint32_t len;
 
-    m_timer.start(5000);
+    frame.resize(DLINK_H_LEN + DLINK_MAX_PAYLOAD);
+    if (prot_encode_frame(&src, reinterpret_cast<uint8_t *>(frame.data()),
+                          uint32_t(frame.size()), &len) != PROT_SUCCESS) {
+        frame.clear();
+        return false;
+    }
+    frame.resize(int(len));
+    return true;
 }
 
 void SerialPortWriter::writeTest()
 {
-    const char t_data[] = {0xa5,0x05,0x00,0x00,0x10,0x18,0xff,0xd7,'I'};
-    const qint64 bytesWritten = m_serialPort->write(t_data, 9);
+    const char t_data[] = {char(0xa5),0x05,0x00,0x00,0x10,0x18,char(0xff),char(0xd7),'I'};
+
+    write(t_data, 9);
+}
+
+bool SerialPortWriter::enqueue(const QByteArray &data, quint16 key, Callback done)
+{
+    /* The frames on the wire can't be replaced anymore */
+    if (key != 0) {
+        for (int i = m_inFlight; i < m_queue.size(); i++) {
+            Frame &frame = m_queue[i];
+            if (frame.key == key) {
+                frame.data = data;
+                if (done)
+                    frame.done.push_back(done);
+                m_coalesced++;
+                return true;
+            }
+        }
+    }
+
+    if (m_queue.size() >= MaxQueueDepth) {
+        m_rejected++;
+        if (done)
+            done(false);
+        return false;
+    }
+
+    Frame frame;
+    frame.data = data;
+    frame.key = key;
+    if (done)
+        frame.done.push_back(done);
+    m_queue.enqueue(frame);
+
+    emit queueDepthChanged(m_queue.size());
+    if (m_queue.size() == MaxQueueDepth)
+        emit backPressureChanged(true);
+
+    startNext();
+    return true;
+}
+
+void SerialPortWriter::startNext()
+{
+    while (m_inFlight < m_maxInFlight && m_inFlight < m_queue.size()) {
+        const Frame &frame = m_queue.at(m_inFlight);
+        bool ok;
+
+        if (m_inFlight++ == 0)
+            m_pending = frame.data.size();
+        if (m_capture)
+            m_capture->append(SerialCapture::Tx, frame.data.constData(), frame.data.size());
+        if (m_tty)
+            ok = m_tty->write(frame.data);
+        else
+            ok = m_serialPort->write(frame.data) != -1;
+
+        if (!ok) {
+            m_standardOutput << QObject::tr("Failed to write the data to port %1, error: %2")
+                              .arg(portName()).arg(portError()) << endl;
+            finishInFlight(false);
+        } else {
+            m_timer.start(WriteTimeout);
+        }
+    }
+}
+
+/* Completes the head frame, the timeout restarts for the next one. */
+void SerialPortWriter::finish(bool ok)
+{
+    Frame frame = m_queue.dequeue();
+    const bool wasFull = m_queue.size() + 1 == MaxQueueDepth;
+
+    if (--m_inFlight > 0) {
+        m_pending = m_queue.head().data.size();
+        m_timer.start(WriteTimeout);
+    } else {
+        m_pending = 0;
+        m_timer.stop();
+    }
+
+    emit queueDepthChanged(m_queue.size());
+    if (wasFull)
+        emit backPressureChanged(false);
+
+    for (const Callback &done : frame.done)
+        done(ok);
+}
+
+void SerialPortWriter::finishInFlight(bool ok)
+{
+    while (m_inFlight > 0)
+        finish(ok);
+}
+
+/* The bytes may span several frames in flight. */
+void SerialPortWriter::handleBytesWritten(qint64 bytes)
+{
+    bool done = false;
+
+    while (m_inFlight > 0 && bytes > 0) {
+        const qint64 n = qMin(bytes, m_pending);
+
+        bytes -= n;
+        m_pending -= n;
+        if (m_pending <= 0) {
+            finish(true);
+            done = true;
+        }
+    }
+    if (done)
+        startNext();
+}
+
+void SerialPortWriter::handleTimeout()
+{
+    const QString error = QObject::tr("Operation timed out for port %1, error: %2")
+                          .arg(portName()).arg(portError());
 
-    if (bytesWritten == -1) {
-        m_standardOutput << QObject::tr("Failed to write the data to port %1, error: %2")
-                          .arg(m_serialPort->portName()).arg(m_serialPort->errorString()) << endl;
-        QCoreApplication::exit(1);
-    } else if (!m_serialPort->waitForBytesWritten(5000)) {
-        m_standardOutput << QObject::tr("Operation timed out or an error "
-                                      "occurred for port %1, error: %2")
-                          .arg(m_serialPort->portName()).arg(m_serialPort->errorString()) << endl;
-        QCoreApplication::exit(1);
+    m_standardOutput << error << endl;
+    emit writeError(error);
+
+    /* drop what is left of the frames, otherwise their bytes would be
+       counted for the next ones */
+    if (m_tty)
+        m_tty->clearOutput();
+    else
+        m_serialPort->clear(QSerialPort::Output);
+    finishInFlight(false);
+    startNext();
+}
+
+void SerialPortWriter::handleError(QSerialPort::SerialPortError serialPortError)
+{
+    if (serialPortError == QSerialPort::WriteError) {
+        const QString error = QObject::tr("An I/O error occurred while writing the data to port %1, error: %2")
+                              .arg(m_serialPort->portName()).arg(m_serialPort->errorString());
+
+        m_standardOutput << error << endl;
+        emit writeError(error);
     }
+}
 
-    m_standardOutput << QObject::tr("Data successfully sent to port %1")
-                      .arg(m_serialPort->portName()) << endl;
+QString SerialPortWriter::portName() const
+{
+    return m_tty ? m_tty->portName() : m_serialPort->portName();
+}
 
-    m_timer.start(5000);
+QString SerialPortWriter::portError() const
+{
+    return m_tty ? m_tty->errorString() : m_serialPort->errorString();
 }
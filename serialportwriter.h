@@ -7,23 +7,101 @@
 #include <QTimer>
 #include <QByteArray>
 #include <QObject>
+#include <QQueue>
 
+#include <functional>
+#include <vector>
+
+class SerialCapture;
+class SerialTty;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#include "Protocole_LE/lib/prot/protocol.h"
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Non-blocking outbound frame queue. Frames are written one after the other,
+ * the next one is started from the bytesWritten signal of the port, so the
+ * caller (typically the QML thread) never waits on the UART.
+ *
+ * On a SerialTty, up to MaxTtyInFlight frames are handed over at once so
+ * that the tty thread can batch them.
+ */
 class SerialPortWriter : public QObject
 {
     Q_OBJECT
+    Q_PROPERTY(int queueDepth READ queueDepth NOTIFY queueDepthChanged)
+    Q_PROPERTY(bool backPressure READ backPressure NOTIFY backPressureChanged)
 public:
+    /* Called once the frame left the port (ok) or has been dropped. */
+    typedef std::function<void(bool ok)> Callback;
+
+    enum {
+        MaxQueueDepth = 32,
+        MaxTtyInFlight = 16,
+        WriteTimeout = 5000 /* ms */
+    };
+
     explicit SerialPortWriter(QSerialPort *serialPort, QObject *parent = nullptr);
+    explicit SerialPortWriter(SerialTty *tty, QObject *parent = nullptr);
     ~SerialPortWriter();
-    void write(const char *writeData, qint64 len);
+    bool write(const char *writeData, qint64 len, Callback done = Callback(),
+               quint16 key = 0);
+    bool write(const QByteArray &data, Callback done = Callback(), quint16 key = 0);
+    bool send(const struct protocol &prot, Callback done = Callback());
     Q_INVOKABLE void writeTest();
+
+    void setCapture(SerialCapture *capture) { m_capture = capture; }
+
+    static bool encode(const struct protocol &prot, QByteArray &frame);
+    static quint16 coalesceKey(const struct protocol &prot);
+
+    int queueDepth() const { return m_queue.size(); }
+    bool backPressure() const { return m_queue.size() >= MaxQueueDepth; }
+    quint32 framesRejected() const { return m_rejected; }
+    quint32 framesCoalesced() const { return m_coalesced; }
+
 signals:
+    void queueDepthChanged(int depth);
+    void backPressureChanged(bool backPressure);
+    void writeError(const QString &error);
 
-public slots:
+private slots:
+    void handleBytesWritten(qint64 bytes);
+    void handleTimeout();
+    void handleError(QSerialPort::SerialPortError error);
 
 private:
+    struct Frame {
+        QByteArray data;
+        quint16 key; /* coalescing key, 0 if the frame must not be merged */
+        std::vector<Callback> done;
+    };
+
+    void init();
+    bool enqueue(const QByteArray &data, quint16 key, Callback done);
+    void startNext();
+    void finish(bool ok);
+    void finishInFlight(bool ok);
+    QString portName() const;
+    QString portError() const;
+
     QSerialPort     *m_serialPort;
+    SerialTty       *m_tty;
+    SerialCapture   *m_capture;
     QTextStream     m_standardOutput;
     QTimer          m_timer;
+    QQueue<Frame>   m_queue;    /* head is the frame on the wire */
+    qint64          m_pending;  /* bytes of the head frame not written yet */
+    int             m_inFlight; /* frames at the head handed to the port */
+    int             m_maxInFlight;
+    quint32         m_rejected;
+    quint32         m_coalesced;
 };
 
 #endif // SERIALPORTWRITER_H
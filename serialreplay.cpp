@@ -0,0 +1,78 @@
+#include "serialreplay.h"
+#include "serialportreader.h"
+
+QT_USE_NAMESPACE
+
+SerialReplay::SerialReplay(SerialPortReader *reader, QObject *parent)
+    : QObject(parent)
+    , m_reader(reader)
+    , m_pending(false)
+    , m_fast(false)
+    , m_offset(0)
+    , m_records(0)
+    , m_bytes(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &SerialReplay::feed);
+}
+
+SerialReplay::~SerialReplay()
+{
+}
+
+bool SerialReplay::open(const QString &path)
+{
+    return m_capture.open(path);
+}
+
+void SerialReplay::start()
+{
+    m_capture.rewind();
+    m_records = 0;
+    m_bytes = 0;
+    m_pending = m_capture.next(m_next);
+    m_offset = m_pending ? m_next.timestamp : 0;
+    m_clock.start();
+    feed();
+}
+
+/*
+ * Feeds the records that are due and arms the timer for the next one. At
+ * the original pace a record is due once as much time has passed since the
+ * start as it had since the first record.
+ */
+void SerialReplay::feed()
+{
+    int n = 0;
+
+    while (m_pending) {
+        if (m_fast) {
+            if (n == Batch) {
+                m_timer.start(0);
+                return;
+            }
+            if (m_backlogFull && m_backlogFull()) {
+                m_timer.start(BacklogPoll);
+                return;
+            }
+        } else {
+            const qint64 due = m_next.timestamp - m_offset - m_clock.nsecsElapsed();
+
+            if (due > 0) {
+                m_timer.start(int((due + 999999) / 1000000));
+                return;
+            }
+        }
+
+        if (m_next.dir == SerialCapture::Rx) {
+            m_reader->feed(reinterpret_cast<const char *>(m_next.data), m_next.len);
+            m_records++;
+            m_bytes += m_next.len;
+            n++;
+        }
+        m_pending = m_capture.next(m_next);
+    }
+
+    emit finished(m_records, m_bytes, m_clock.nsecsElapsed());
+}
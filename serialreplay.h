@@ -0,0 +1,64 @@
+#ifndef SERIALREPLAY_H
+#define SERIALREPLAY_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QTimer>
+
+#include <functional>
+
+#include "serialcapture.h"
+
+class SerialPortReader;
+
+/*
+ * Feeds the RX records of a capture into a reader, in place of the serial
+ * port. The records are either fed at the pace they were captured at or as
+ * fast as possible; then at most Batch records are fed per pass of the
+ * event loop, and feeding pauses while the consumer is behind (see
+ * setBacklogFull()). TX records are skipped.
+ */
+class SerialReplay : public QObject
+{
+    Q_OBJECT
+public:
+    /* returns true while frames should not be fed */
+    typedef std::function<bool()> BacklogFull;
+
+    enum {
+        Batch = 64,
+        BacklogPoll = 1 /* ms */
+    };
+
+    explicit SerialReplay(SerialPortReader *reader, QObject *parent = nullptr);
+    ~SerialReplay();
+
+    bool open(const QString &path);
+    QString errorString() const { return m_capture.errorString(); }
+    void setFast(bool fast) { m_fast = fast; }
+    void setBacklogFull(BacklogFull full) { m_backlogFull = full; }
+
+    void start();
+
+signals:
+    void finished(quint32 records, qint64 bytes, qint64 elapsedNs);
+
+private slots:
+    void feed();
+
+private:
+    SerialPortReader        *m_reader;
+    SerialCaptureReader     m_capture;
+    SerialCapture::Record   m_next;
+    bool                    m_pending;  /* m_next not fed yet */
+    bool                    m_fast;
+    BacklogFull             m_backlogFull;
+    QTimer                  m_timer;
+    QElapsedTimer           m_clock;
+    qint64                  m_offset;   /* timestamp of the first record */
+    quint32                 m_records;
+    qint64                  m_bytes;
+};
+
+#endif // SERIALREPLAY_H
@@ -0,0 +1,217 @@
+#include "serialtransport.h"
+
+QT_USE_NAMESPACE
+
+SerialTransport::SerialTransport(SerialLink *link, QObject *parent)
+    : QObject(parent)
+    , m_link(link)
+    , m_window(DefaultWindow)
+    , m_nextSeqNr(0)
+    , m_srtt(0)
+    , m_rttvar(0)
+    , m_rto(InitialRto * 1000)
+    , m_retransmits(0)
+    , m_timeouts(0)
+{
+    m_clock.start();
+    m_tick.setInterval(TickInterval);
+
+    connect(m_link, &SerialLink::frameReceived, this, &SerialTransport::handleFrame);
+    connect(&m_tick, &QTimer::timeout, this, &SerialTransport::handleTick);
+}
+
+SerialTransport::~SerialTransport()
+{
+}
+
+void SerialTransport::setWindow(int window)
+{
+    window = qBound(1, window, int(MaxWindow));
+    if (m_window == window)
+        return;
+    m_window = window;
+    emit windowChanged(window);
+    fillWindow();
+}
+
+/*
+ * Encodes the request right away, the service data referenced by prot is
+ * owned by the caller. The request waits in the backlog until the window has
+ * room for it, its sequence number is stamped into the frame only then: a
+ * request retransmitted for several timeouts keeps its number while newer
+ * ones complete, so the numbers can't be handed out in request order.
+ */
+bool SerialTransport::request(const struct protocol &prot, ReplyCallback done)
+{
+    const struct protocol none = {};
+    struct protocol req = prot;
+    struct protView view;
+    Request r;
+
+    if (m_backlog.size() >= MaxBacklog) {
+        if (done)
+            done(false, none, 0);
+        return false;
+    }
+
+    req.tranLayer.tid = 1;
+    req.tranLayer.opt.tid1.seqNr = 0;
+    req.tranLayer.opt.tid1.winSize = quint8(m_window);
+    req.tranLayer.opt.tid1.flags = 0;
+    if (!SerialPortWriter::encode(req, r.frame)) {
+        if (done)
+            done(false, none, 0);
+        return false;
+    }
+    protView_init(&view, r.frame.constData() + DLINK_H_LEN - CRC_LEN,
+                  quint8(r.frame.at(1)));
+    protView_parse(&view, PROT_VIEW_NET);
+
+    r.sid = prot.procLayer.sid;
+    r.tranOff = view.tranOff;
+    r.seqNr = 0;
+    r.retries = 0;
+    r.sentAt = 0;
+    r.done = done;
+    m_backlog.enqueue(r);
+
+    fillWindow();
+    return true;
+}
+
+void SerialTransport::fillWindow()
+{
+    const int before = m_inFlight.size();
+
+    while (m_inFlight.size() < m_window && !m_backlog.isEmpty()) {
+        Request r = m_backlog.dequeue();
+
+        stamp(r, nextSeqNr());
+        transmit(r);
+        m_inFlight.insert(r.seqNr, r);
+    }
+
+    if (!m_inFlight.isEmpty() && !m_tick.isActive())
+        m_tick.start();
+    if (m_inFlight.size() != before)
+        emit inFlightChanged(m_inFlight.size());
+}
+
+/* Next sequence number not used by a request in the window. */
+quint8 SerialTransport::nextSeqNr()
+{
+    while (m_inFlight.contains(m_nextSeqNr))
+        m_nextSeqNr++;
+    return m_nextSeqNr++;
+}
+
+/*
+ * Writes the sequence number and the current window size into the transport
+ * header of the encoded frame and updates the CRC.
+ */
+void SerialTransport::stamp(Request &req, quint8 seqNr)
+{
+    char *payload = req.frame.data() + DLINK_H_LEN - CRC_LEN;
+    const int len = quint8(req.frame.at(1));
+    quint16 crc;
+
+    payload[req.tranOff + 1] = char(seqNr);
+    payload[req.tranOff + 2] = char(m_window);
+    crc = crc16_ccitt_block(payload, uint32_t(len), CRC16_CCITT_INIT_0000);
+    payload[len] = char(crc >> 8);
+    payload[len + 1] = char(crc);
+    req.seqNr = seqNr;
+}
+
+void SerialTransport::transmit(Request &req)
+{
+    req.sentAt = m_clock.nsecsElapsed() / 1000;
+    /* a frame rejected by the write queue is recovered by the retransmission */
+    m_link->write(req.frame);
+}
+
+/* Takes the request out of the window before the callback may add new ones. */
+void SerialTransport::complete(Request req, bool ok, const struct protocol &reply)
+{
+    const qint64 rtt = ok ? m_clock.nsecsElapsed() / 1000 - req.sentAt : 0;
+
+    if (ok) {
+        /* Karn: the reply of a retransmitted request can't be assigned to a
+           transmission, it is reported but not used for the estimator */
+        if (req.retries == 0)
+            sampleRtt(rtt);
+        emit replyReceived(req.sid, req.seqNr, rtt, req.retries);
+    }
+
+    if (m_inFlight.isEmpty() && m_backlog.isEmpty())
+        m_tick.stop();
+    emit inFlightChanged(m_inFlight.size());
+
+    if (req.done)
+        req.done(ok, reply, rtt);
+    fillWindow();
+}
+
+/* RFC 6298 estimator, srtt and rttvar in us. */
+void SerialTransport::sampleRtt(qint64 rttUs)
+{
+    if (m_srtt == 0) {
+        m_srtt = rttUs;
+        m_rttvar = rttUs / 2;
+    } else {
+        const qint64 err = rttUs > m_srtt ? rttUs - m_srtt : m_srtt - rttUs;
+
+        m_rttvar += (err - m_rttvar) / 4;
+        m_srtt += (rttUs - m_srtt) / 8;
+    }
+    m_rto = qBound(qint64(MinRto) * 1000, m_srtt + 4 * m_rttvar, qint64(MaxRto) * 1000);
+    emit rttChanged();
+}
+
+void SerialTransport::handleFrame(const struct protocol &frame)
+{
+    if (frame.tranLayer.tid != 1 || !(frame.procLayer.sid & SID_ANS_M))
+        return;
+
+    const quint8 seqNr = frame.tranLayer.opt.tid1.seqNr;
+    QHash<quint8, Request>::iterator it = m_inFlight.find(seqNr);
+
+    /* late reply of a request given up, or of another service */
+    if (it == m_inFlight.end() || (it->sid | SID_ANS_M) != frame.procLayer.sid)
+        return;
+
+    const Request req = *it;
+    m_inFlight.erase(it);
+    complete(req, true, frame);
+}
+
+/*
+ * Retransmits the requests whose timeout expired, the timeout doubles with
+ * each retry. A request is given up after MaxRetries retransmissions.
+ */
+void SerialTransport::handleTick()
+{
+    const struct protocol none = {};
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+    QList<Request> failed;
+
+    for (QHash<quint8, Request>::iterator it = m_inFlight.begin(); it != m_inFlight.end();) {
+        const qint64 timeout = qMin(m_rto << it->retries, qint64(MaxRto) * 1000);
+
+        if (now - it->sentAt < timeout) {
+            ++it;
+        } else if (it->retries < MaxRetries) {
+            it->retries++;
+            m_retransmits++;
+            transmit(*it);
+            ++it;
+        } else {
+            m_timeouts++;
+            failed.append(*it);
+            it = m_inFlight.erase(it);
+        }
+    }
+
+    for (const Request &req : failed)
+        complete(req, false, none);
+}
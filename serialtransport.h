@@ -0,0 +1,116 @@
+#ifndef SERIALTRANSPORT_H
+#define SERIALTRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QQueue>
+#include <QTimer>
+
+#include <functional>
+
+#include "seriallink.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#include "Protocole_LE/lib/prot/protView.h"
+#include "Protocole_LE/lib/crc/crc16Block.h"
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Sliding window on top of the serial link. Requests are sent with a tid1
+ * transport layer (sequence number, window size), up to window() of them
+ * are on the wire at the same time and the replies are matched by their
+ * sequence number, so polling several devices costs about one round trip
+ * instead of the sum of them. A request without reply is retransmitted with
+ * the same sequence number after a timeout derived from the measured round
+ * trip times (RFC 6298, Karn's rule).
+ */
+class SerialTransport : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int window READ window WRITE setWindow NOTIFY windowChanged)
+    Q_PROPERTY(int inFlight READ inFlight NOTIFY inFlightChanged)
+    Q_PROPERTY(int srtt READ srtt NOTIFY rttChanged)
+    Q_PROPERTY(int rto READ rto NOTIFY rttChanged)
+public:
+    /*
+     * Called once per request, with the reply (ok) or after the last
+     * retransmission timed out. reply.data.pData is only valid during the
+     * call, rtt is the time between the last transmission and the reply.
+     */
+    typedef std::function<void(bool ok, const struct protocol &reply, qint64 rttUs)> ReplyCallback;
+
+    enum {
+        DefaultWindow = 4,
+        MaxWindow = 16,
+        MaxBacklog = 64,
+        MaxRetries = 3,
+        InitialRto = 200,  /* ms, until the first round trip has been measured */
+        MinRto = 20,       /* ms */
+        MaxRto = 2000,     /* ms */
+        TickInterval = 5   /* ms */
+    };
+
+    explicit SerialTransport(SerialLink *link, QObject *parent = nullptr);
+    ~SerialTransport();
+
+    bool request(const struct protocol &prot, ReplyCallback done);
+
+    int window() const { return m_window; }
+    void setWindow(int window);
+    int inFlight() const { return m_inFlight.size(); }
+    int srtt() const { return int(m_srtt / 1000); }
+    int rto() const { return int(m_rto / 1000); }
+    quint32 retransmits() const { return m_retransmits; }
+    quint32 timeouts() const { return m_timeouts; }
+
+signals:
+    void windowChanged(int window);
+    void inFlightChanged(int inFlight);
+    void rttChanged();
+    /* per request round trip time, for statistics */
+    void replyReceived(quint16 sid, quint8 seqNr, qint64 rttUs, int retries);
+
+private slots:
+    void handleFrame(const struct protocol &frame);
+    void handleTick();
+
+private:
+    struct Request {
+        QByteArray frame;  /* encoded once, retransmitted as it is */
+        quint16 sid;
+        quint8 tranOff;    /* offset of the transport header in the payload */
+        quint8 seqNr;      /* assigned when the request enters the window */
+        int retries;
+        qint64 sentAt;     /* us, last transmission */
+        ReplyCallback done;
+    };
+
+    void fillWindow();
+    quint8 nextSeqNr();
+    void stamp(Request &req, quint8 seqNr);
+    void transmit(Request &req);
+    void complete(Request req, bool ok, const struct protocol &reply);
+    void sampleRtt(qint64 rttUs);
+
+    SerialLink              *m_link;
+    QElapsedTimer           m_clock;
+    QTimer                  m_tick;
+    QQueue<Request>         m_backlog;
+    QHash<quint8, Request>  m_inFlight;  /* by sequence number */
+    int                     m_window;
+    quint8                  m_nextSeqNr;
+    qint64                  m_srtt;      /* us, 0 until the first sample */
+    qint64                  m_rttvar;    /* us */
+    qint64                  m_rto;       /* us */
+    quint32                 m_retransmits;
+    quint32                 m_timeouts;
+};
+
+#endif // SERIALTRANSPORT_H
@@ -0,0 +1,374 @@
+#include "serialtty.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <linux/serial.h>
+
+QT_USE_NAMESPACE
+
+static bool toSpeed(qint32 baudRate, speed_t *speed)
+{
+    switch (baudRate) {
+    case 9600:      *speed = B9600; return true;
+    case 19200:     *speed = B19200; return true;
+    case 38400:     *speed = B38400; return true;
+    case 57600:     *speed = B57600; return true;
+    case 115200:    *speed = B115200; return true;
+    case 230400:    *speed = B230400; return true;
+    case 460800:    *speed = B460800; return true;
+    case 921600:    *speed = B921600; return true;
+    default:        return false;
+    }
+}
+
+SerialTty::SerialTty()
+    : m_baudRate(115200)
+    , m_fd(-1)
+    , m_epollFd(-1)
+    , m_eventFd(-1)
+    , m_stop(false)
+    , m_error(0)
+    , m_txOffset(0)
+    , m_vmin(1)
+    , m_vminTimeout(-1)
+    , m_writeWait(false)
+    , m_clearOutput(false)
+{
+}
+
+SerialTty::~SerialTty()
+{
+    close();
+}
+
+QString SerialTty::errorString() const
+{
+    return QString::fromLocal8Bit(strerror(m_error.load()));
+}
+
+/*
+ * Opens the tty raw, 8N1 without flow control, and starts the I/O thread.
+ */
+bool SerialTty::open()
+{
+    speed_t speed;
+
+    m_error = 0;
+    if (!toSpeed(m_baudRate, &speed)) {
+        m_error = EINVAL;
+        return false;
+    }
+
+    m_fd = ::open(m_portName.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0 || !configure(speed)) {
+        m_error = errno;
+        close();
+        return false;
+    }
+
+    m_stop = false;
+    m_thread = std::thread(&SerialTty::run, this);
+    return true;
+}
+
+bool SerialTty::configure(speed_t speed)
+{
+    struct serial_struct serial;
+    struct epoll_event ev;
+
+    if (tcgetattr(m_fd, &m_termios) < 0)
+        return false;
+    cfmakeraw(&m_termios);
+    m_termios.c_cflag |= CLOCAL | CREAD;
+    m_termios.c_cflag &= ~(CSTOPB | CRTSCTS);
+    m_termios.c_cc[VMIN] = 1;
+    m_termios.c_cc[VTIME] = 0;
+    if (cfsetspeed(&m_termios, speed) < 0 || tcsetattr(m_fd, TCSANOW, &m_termios) < 0)
+        return false;
+
+    /* Lets the driver push received bytes to the line discipline right
+       away. Not supported by every driver (nor by a pty), so it is optional. */
+    if (ioctl(m_fd, TIOCGSERIAL, &serial) == 0) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        ioctl(m_fd, TIOCSSERIAL, &serial);
+    }
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epollFd < 0 || m_eventFd < 0)
+        return false;
+
+    ev.events = EPOLLIN;
+    ev.data.fd = m_fd;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_fd, &ev) < 0)
+        return false;
+    ev.data.fd = m_eventFd;
+    return epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_eventFd, &ev) == 0;
+}
+
+void SerialTty::close()
+{
+    if (m_thread.joinable()) {
+        m_stop = true;
+        kick();
+        m_thread.join();
+    }
+    if (m_eventFd >= 0)
+        ::close(m_eventFd);
+    if (m_epollFd >= 0)
+        ::close(m_epollFd);
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_eventFd = m_epollFd = m_fd = -1;
+
+    m_txQueue.clear();
+    m_txIn.clear();
+    m_txOffset = 0;
+    m_vmin = 1;
+    m_vminTimeout = -1;
+    m_writeWait = false;
+}
+
+bool SerialTty::write(const QByteArray &frame)
+{
+    bool wake;
+
+    if (m_fd < 0)
+        return false;
+
+    /* one wake-up per batch, the thread takes all frames at once */
+    {
+        std::lock_guard<std::mutex> lock(m_txLock);
+        wake = m_txIn.empty();
+        m_txIn.push_back(frame);
+    }
+    if (wake)
+        kick();
+    return true;
+}
+
+/*
+ * The frames passed to write() so far are dropped right here, the ones
+ * already taken by the thread once it wakes up, before it takes any newer
+ * frame.
+ */
+void SerialTty::clearOutput()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_txLock);
+        m_txIn.clear();
+        m_clearOutput = true;
+    }
+    kick();
+}
+
+void SerialTty::kick()
+{
+    const uint64_t one = 1;
+
+    if (::write(m_eventFd, &one, sizeof(one)) < 0) {
+        /* the counter can't overflow, the thread is already woken up */
+    }
+}
+
+void SerialTty::fail(int error)
+{
+    m_error = error;
+    if (m_errorHandler)
+        m_errorHandler();
+}
+
+/* The I/O thread. Returns on close() or on a failure of the tty. */
+void SerialTty::run()
+{
+    struct epoll_event events[2];
+    uint64_t count;
+    qint64 n;
+    int nEvents;
+
+    while (!m_stop.load(std::memory_order_acquire)) {
+        nEvents = epoll_wait(m_epollFd, events, 2, m_vminTimeout);
+        if (nEvents < 0) {
+            if (errno == EINTR)
+                continue;
+            fail(errno);
+            return;
+        }
+
+        /* The frame did not complete in time. Whatever came is passed on,
+           if nothing did, the next byte wakes the thread up again. */
+        if (nEvents == 0) {
+            if ((n = readAll()) < 0)
+                return;
+            if (n == 0)
+                setMinRead(1);
+            continue;
+        }
+
+        for (int i = 0; i < nEvents; i++) {
+            if (events[i].data.fd == m_eventFd) {
+                if (::read(m_eventFd, &count, sizeof(count)) < 0) {
+                    /* nothing to clear, EAGAIN */
+                }
+                takeWrites();
+                if (!writeAll())
+                    return;
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && readAll() < 0)
+                return;
+            if ((events[i].events & EPOLLOUT) && !writeAll())
+                return;
+        }
+    }
+}
+
+/*
+ * Reads all bytes available with readv() into the free part of the ring,
+ * across its end, and passes them on in place. Then sets VMIN for the rest
+ * of the frame in progress. Returns the number of bytes, -1 on failure.
+ */
+qint64 SerialTty::readAll()
+{
+    RingBuffer<char, RxRingLen>::Span span[2];
+    struct iovec iov[2];
+    quint32 room;
+    qint64 total = 0;
+    ssize_t n;
+
+    for (;;) {
+        room = m_rxRing.writeSpans(span);
+        iov[0].iov_base = span[0].data;
+        iov[0].iov_len = span[0].len;
+        iov[1].iov_base = span[1].data;
+        iov[1].iov_len = span[1].len;
+
+        n = readv(m_fd, iov, span[1].len ? 2 : 1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                break;
+            fail(errno);
+            return -1;
+        }
+        if (n == 0)
+            break;
+
+        m_rxRing.commit(quint32(n));
+        m_rxRing.readSpans(span);
+        m_readHandler(span[0].data, span[0].len);
+        if (span[1].len)
+            m_readHandler(span[1].data, span[1].len);
+        m_rxRing.consume(quint32(n));
+        total += n;
+
+        if (quint32(n) < room)
+            break;
+    }
+
+    if (total)
+        setMinRead(m_minReadHandler ? m_minReadHandler() : 1);
+    return total;
+}
+
+/*
+ * Sets VMIN, at most 255, only if it changes. While VMIN is above 1, the
+ * wait is bounded by twice the time of VMIN characters of 10 bits.
+ */
+void SerialTty::setMinRead(quint32 n)
+{
+    n = qBound<quint32>(1, n, 255);
+    if (n == m_vmin)
+        return;
+
+    m_termios.c_cc[VMIN] = cc_t(n);
+    if (tcsetattr(m_fd, TCSANOW, &m_termios) < 0) {
+        m_termios.c_cc[VMIN] = cc_t(m_vmin);
+        return;
+    }
+    m_vmin = n;
+    m_vminTimeout = n > 1 ? int(qMax<qint64>(1, (2 * 10 * 1000 * qint64(n) + m_baudRate - 1) / m_baudRate))
+                          : -1;
+}
+
+/* Moves the frames passed to write() onto the queue of the thread. */
+void SerialTty::takeWrites()
+{
+    std::lock_guard<std::mutex> lock(m_txLock);
+
+    if (m_clearOutput) {
+        m_clearOutput = false;
+        m_txQueue.clear();
+        m_txOffset = 0;
+        tcflush(m_fd, TCOFLUSH);
+    }
+    for (QByteArray &frame : m_txIn)
+        m_txQueue.push_back(std::move(frame));
+    m_txIn.clear();
+}
+
+/*
+ * Writes the queued frames, up to MaxWriteBatch with one writev(). If the
+ * tty takes no more, EPOLLOUT is armed and the rest written once it drained.
+ * Returns false on failure.
+ */
+bool SerialTty::writeAll()
+{
+    struct iovec iov[MaxWriteBatch];
+    std::deque<QByteArray>::const_iterator it;
+    qint64 n;
+    int nIov;
+
+    while (!m_txQueue.empty()) {
+        nIov = 0;
+        for (it = m_txQueue.begin(); it != m_txQueue.end() && nIov < MaxWriteBatch; ++it, nIov++) {
+            const qint64 offset = nIov ? 0 : m_txOffset;
+
+            iov[nIov].iov_base = const_cast<char *>(it->constData()) + offset;
+            iov[nIov].iov_len = size_t(it->size() - offset);
+        }
+
+        n = writev(m_fd, iov, nIov);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN) {
+                setWriteWait(true);
+                return true;
+            }
+            fail(errno);
+            return false;
+        }
+
+        if (m_writtenHandler)
+            m_writtenHandler(n);
+        n += m_txOffset;
+        while (!m_txQueue.empty() && n >= m_txQueue.front().size()) {
+            n -= m_txQueue.front().size();
+            m_txQueue.pop_front();
+        }
+        m_txOffset = n;
+    }
+
+    setWriteWait(false);
+    return true;
+}
+
+void SerialTty::setWriteWait(bool wait)
+{
+    struct epoll_event ev;
+
+    if (wait == m_writeWait)
+        return;
+    ev.events = wait ? EPOLLIN | EPOLLOUT : EPOLLIN;
+    ev.data.fd = m_fd;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_MOD, m_fd, &ev) == 0)
+        m_writeWait = wait;
+}
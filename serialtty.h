@@ -0,0 +1,111 @@
+#ifndef SERIALTTY_H
+#define SERIALTTY_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <termios.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Protocole_LE/lib/mem/ringBuffer.h"
+
+/*
+ * Serial port on a raw tty, without QSerialPort and the Qt event loop.
+ *
+ * The tty is served by a thread of its own that sleeps in epoll_wait(),
+ * reads with readv() into a preallocated ring and hands the bytes to the
+ * read handler in place. The handlers are called in that thread.
+ *
+ * Wake-ups follow the frames: the minimum read handler tells how many bytes
+ * the frame in progress still needs, which is set as VMIN, so the thread is
+ * woken once the frame is complete and not for every FIFO burst of the
+ * UART. As the length field of a frame may be corrupt, the wait for VMIN
+ * bytes is bounded by about twice their time on the wire.
+ *
+ * Frames passed to write() are queued and written in batches with
+ * writev(), the written handler is called with the number of bytes that
+ * left the tty.
+ */
+class SerialTty
+{
+public:
+    typedef std::function<void(const char *data, qint64 len)> ReadHandler;
+    typedef std::function<void(qint64 bytes)> WrittenHandler;
+    typedef std::function<quint32()> MinReadHandler;
+    typedef std::function<void()> ErrorHandler;
+
+    enum {
+        RxRingLen = 4096,   /* power of two */
+        MaxWriteBatch = 64  /* frames per writev() */
+    };
+
+    SerialTty();
+    ~SerialTty();
+
+    void setPortName(const QString &name) { m_portName = name; }
+    void setBaudRate(qint32 baudRate) { m_baudRate = baudRate; }
+
+    /* to be set before open() */
+    void setReadHandler(ReadHandler handler) { m_readHandler = handler; }
+    void setWrittenHandler(WrittenHandler handler) { m_writtenHandler = handler; }
+    void setMinReadHandler(MinReadHandler handler) { m_minReadHandler = handler; }
+    void setErrorHandler(ErrorHandler handler) { m_errorHandler = handler; }
+
+    bool open();
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+
+    QString portName() const { return m_portName; }
+    QString errorString() const;
+
+    /* May be called from any thread. The frame is shared, not copied. */
+    bool write(const QByteArray &frame);
+    /* Drops the frames not written yet, asynchronously. */
+    void clearOutput();
+
+private:
+    bool configure(speed_t speed);
+    void run();
+    qint64 readAll();
+    bool writeAll();
+    void takeWrites();
+    void setMinRead(quint32 n);
+    void setWriteWait(bool wait);
+    void fail(int error);
+    void kick();
+
+    QString         m_portName;
+    qint32          m_baudRate;
+    int             m_fd;
+    int             m_epollFd;
+    int             m_eventFd;      /* wakes the thread for writes and stop */
+    std::thread     m_thread;
+    std::atomic<bool> m_stop;
+    std::atomic<int>  m_error;      /* errno of the last failure */
+
+    ReadHandler     m_readHandler;
+    WrittenHandler  m_writtenHandler;
+    MinReadHandler  m_minReadHandler;
+    ErrorHandler    m_errorHandler;
+
+    /* I/O thread only */
+    struct termios  m_termios;
+    RingBuffer<char, RxRingLen> m_rxRing;
+    std::deque<QByteArray> m_txQueue;
+    qint64          m_txOffset;     /* bytes of the head frame written */
+    quint32         m_vmin;
+    int             m_vminTimeout;  /* ms, -1 while VMIN is 1 */
+    bool            m_writeWait;    /* EPOLLOUT armed */
+
+    std::mutex      m_txLock;
+    std::vector<QByteArray> m_txIn; /* frames passed to write() */
+    bool            m_clearOutput;
+};
+
+#endif // SERIALTTY_H
@@ -0,0 +1,172 @@
+#include "serialworker.h"
+#include "serialportreader.h"
+#include "serialreplay.h"
+#include "serialtty.h"
+
+#include <string.h>
+
+QT_USE_NAMESPACE
+
+SerialWorker::SerialWorker(const QString &portName, qint32 baudRate,
+                           SerialRxRing *rxRing, QObject *parent)
+    : QObject(parent)
+    , m_portName(portName)
+    , m_baudRate(baudRate)
+    , m_rxRing(rxRing)
+    , m_serialPort(nullptr)
+    , m_tty(nullptr)
+    , m_reader(nullptr)
+    , m_writer(nullptr)
+    , m_replay(nullptr)
+    , m_replayFast(false)
+    , m_backend(QSerialPortBackend)
+{
+}
+
+SerialWorker::~SerialWorker()
+{
+    /* stops the tty thread before the reader and writer are deleted */
+    delete m_tty;
+}
+
+void SerialWorker::setReplayFile(const QString &path, bool fast)
+{
+    m_replayPath = path;
+    m_replayFast = fast;
+}
+
+/*
+ * Creates the port, reader and writer. Must run in the serial I/O thread so
+ * that the port notifications are delivered there.
+ */
+void SerialWorker::open()
+{
+    if (!m_replayPath.isEmpty()) {
+        openReplay();
+        return;
+    }
+    if (m_backend == TtyBackend) {
+        openTty();
+        return;
+    }
+
+    m_serialPort = new QSerialPort(this);
+    m_serialPort->setPortName(m_portName);
+    m_serialPort->setBaudRate(m_baudRate);
+
+    if (!m_serialPort->open(QIODevice::ReadWrite)) {
+        emit opened(false, m_serialPort->errorString());
+        return;
+    }
+
+    m_reader = new SerialPortReader(m_serialPort, this);
+    m_writer = new SerialPortWriter(m_serialPort, this);
+    openCapture();
+
+    connect(m_reader, &SerialPortReader::frameReceived, this, &SerialWorker::handleFrame);
+    connect(m_writer, &SerialPortWriter::queueDepthChanged, this, &SerialWorker::txQueueDepthChanged);
+    connect(m_writer, &SerialPortWriter::backPressureChanged, this, &SerialWorker::backPressureChanged);
+
+    emit opened(true, QString());
+}
+
+/*
+ * Opens the port as a SerialTty. The reader and the writer have to be set
+ * up first, the tty thread starts reading right away. The frames are
+ * received in that thread and put on the RX ring directly, it is the only
+ * producer then.
+ */
+void SerialWorker::openTty()
+{
+    m_tty = new SerialTty;
+    m_tty->setPortName(m_portName);
+    m_tty->setBaudRate(m_baudRate);
+
+    m_reader = new SerialPortReader(m_tty, this);
+    m_writer = new SerialPortWriter(m_tty, this);
+    openCapture();
+
+    connect(m_reader, &SerialPortReader::frameReceived, this, &SerialWorker::handleFrame,
+            Qt::DirectConnection);
+    connect(m_writer, &SerialPortWriter::queueDepthChanged, this, &SerialWorker::txQueueDepthChanged);
+    connect(m_writer, &SerialPortWriter::backPressureChanged, this, &SerialWorker::backPressureChanged);
+
+    if (!m_tty->open()) {
+        emit opened(false, m_tty->errorString());
+        return;
+    }
+    emit opened(true, QString());
+}
+
+void SerialWorker::openCapture()
+{
+    if (m_capturePath.isEmpty())
+        return;
+
+    if (m_capture.open(m_capturePath)) {
+        m_reader->setCapture(&m_capture);
+        m_writer->setCapture(&m_capture);
+    } else {
+        qWarning("Failed to open the capture %s: %s", qPrintable(m_capturePath),
+                 qPrintable(m_capture.errorString()));
+    }
+}
+
+/*
+ * Replays a capture instead of opening the port. There is no writer, every
+ * write fails. In fast mode the replay waits while the RX ring is more than
+ * half full, so that the GUI can keep up and no frame is dropped.
+ */
+void SerialWorker::openReplay()
+{
+    SerialRxRing *ring = m_rxRing;
+
+    m_reader = new SerialPortReader(static_cast<QSerialPort *>(nullptr), this);
+    m_replay = new SerialReplay(m_reader, this);
+    if (!m_replay->open(m_replayPath)) {
+        emit opened(false, m_replay->errorString());
+        return;
+    }
+
+    connect(m_reader, &SerialPortReader::frameReceived, this, &SerialWorker::handleFrame);
+    connect(m_replay, &SerialReplay::finished, this, &SerialWorker::replayFinished);
+    m_replay->setFast(m_replayFast);
+    m_replay->setBacklogFull([ring]() {
+        return spscQueue_load(&ring->queue) > SerialRxRing::Len / 2;
+    });
+
+    emit opened(true, QString());
+    m_replay->start();
+}
+
+void SerialWorker::write(const QByteArray &data, quint16 coalesceKey,
+                         SerialPortWriter::Callback done)
+{
+    if (!m_writer) {
+        if (done)
+            done(false);
+        return;
+    }
+    m_writer->write(data, done, coalesceKey);
+}
+
+/*
+ * Copies the payload onto the RX ring, the decoder buffer is reused for the
+ * next frame. The GUI is only woken up if it is not
+ * already about to drain the ring.
+ */
+void SerialWorker::handleFrame(const struct protView &view)
+{
+    SerialFrame *frame = static_cast<SerialFrame *>(spscQueue_reserve(&m_rxRing->queue));
+
+    if (!frame)
+        return; /* counted as dropped by the queue */
+
+    frame->len = quint16(qMin<int>(view.len, sizeof(frame->data)));
+    memcpy(frame->data, view.buf, frame->len);
+    spscQueue_publish(&m_rxRing->queue);
+
+    /* seq_cst: pairs with the store and fence of SerialLink::drainRx() */
+    if (!m_rxRing->notifyPending.exchange(true, std::memory_order_seq_cst))
+        emit framesAvailable();
+}
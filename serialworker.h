@@ -0,0 +1,108 @@
+#ifndef SERIALWORKER_H
+#define SERIALWORKER_H
+
+#include <QtSerialPort/QSerialPort>
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+#include <atomic>
+
+#include "serialportwriter.h"
+#include "serialcapture.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+#include "Protocole_LE/lib/prot/protView.h"
+#include "Protocole_LE/lib/mem/spscQueue.h"
+#ifdef __cplusplus
+}
+#endif
+
+class SerialPortReader;
+class SerialReplay;
+class SerialTty;
+
+/* One frame on the RX ring, the payload as it was received. The consumer
+ * decodes it in place with a protView. */
+struct SerialFrame {
+    quint16 len;
+    quint8 data[255];
+};
+
+/* RX ring shared by the serial worker (producer) and the GUI (consumer). */
+struct SerialRxRing {
+    enum { Len = 64 }; /* power of two */
+
+    struct spscQueue queue;
+    SerialFrame mem[Len];
+    std::atomic<bool> notifyPending; /* framesAvailable() sent, not drained */
+};
+
+/*
+ * Owns the serial port, the frame decoder and the write queue. Lives in the
+ * serial I/O thread, all its methods have to be called from there.
+ *
+ * The traffic can be captured to a file (setCaptureFile()). With a replay
+ * file (setReplayFile()) no port is opened, the RX records of the capture
+ * are fed into the decoder instead.
+ *
+ * The port is a QSerialPort by default. With the TtyBackend it is a
+ * SerialTty instead, whose thread reads and decodes the frames and puts
+ * them on the RX ring itself.
+ */
+class SerialWorker : public QObject
+{
+    Q_OBJECT
+public:
+    enum Backend {
+        QSerialPortBackend,
+        TtyBackend
+    };
+
+    explicit SerialWorker(const QString &portName, qint32 baudRate,
+                          SerialRxRing *rxRing, QObject *parent = nullptr);
+    ~SerialWorker();
+
+    void write(const QByteArray &data, quint16 coalesceKey, SerialPortWriter::Callback done);
+
+    /* to be set before open() */
+    void setCaptureFile(const QString &path) { m_capturePath = path; }
+    void setReplayFile(const QString &path, bool fast);
+    void setBackend(Backend backend) { m_backend = backend; }
+
+public slots:
+    void open();
+
+signals:
+    void opened(bool ok, const QString &error);
+    void framesAvailable();
+    void txQueueDepthChanged(int depth);
+    void backPressureChanged(bool backPressure);
+    void replayFinished(quint32 records, qint64 bytes, qint64 elapsedNs);
+
+private:
+    void handleFrame(const struct protView &view);
+    void openTty();
+    void openReplay();
+    void openCapture();
+
+    QString           m_portName;
+    qint32            m_baudRate;
+    SerialRxRing      *m_rxRing;
+    QSerialPort       *m_serialPort;
+    SerialTty         *m_tty;
+    SerialPortReader  *m_reader;
+    SerialPortWriter  *m_writer;
+    SerialReplay      *m_replay;
+    SerialCapture     m_capture;
+    QString           m_capturePath;
+    QString           m_replayPath;
+    bool              m_replayFast;
+    Backend           m_backend;
+};
+
+#endif // SERIALWORKER_H
@@ -0,0 +1,632 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: gensim.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Generator simulator on a pseudo terminal, to run the display without
+ * 		hardware and at rates far above what a single device produces.
+ *
+ * 		The requests on the pty are decoded with the data link layer decoder
+ * 		and answered by simDevice.c after the reply latency, plus or minus
+ * 		a uniformly distributed jitter; with jitter the answers may overtake
+ * 		each other. On top, the flood pushes unsolicited answers at a fixed
+ * 		rate, by default the battery live data the display shows.
+ *
+ * 		With the error rate, every frame sent is hit by one of the enabled
+ * 		errors with that probability:
+ * 			crc		one bit of the CRC flipped
+ * 			drop	frame not sent
+ * 			trunc	only a part of the frame sent
+ * 			noise	up to 8 random bytes sent in front of the frame
+ *
+ * 		Frames that don't fit into the TX buffer, because the reader is
+ * 		slower than the flood, are dropped and counted.
+ *
+ * 		Usage: gensim [options], see usage(). The display is started with
+ * 		--port set to the printed pty or the --link path.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "simDevice.h"
+#include "prot/dlinkDecoder.h"
+#include "prot/protView.h"
+#include "prot/services/battery.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define MAX_PENDING				4096  /* answers waiting for their latency */
+#define TX_BUF_SIZE				(1024 * 1024)
+#define FLOOD_PERIOD_NS			1000000  /* flood frames are sent per ms */
+#define MAX_NOISE				8
+
+enum simError{
+	ERR_CRC = 0x01,
+	ERR_DROP = 0x02,
+	ERR_TRUNC = 0x04,
+	ERR_NOISE = 0x08,
+	ERR_ALL = 0x0f,
+};
+
+/* epoll data of the descriptors */
+enum{
+	EV_PTY,
+	EV_REPLY,
+	EV_FLOOD,
+	EV_STATS,
+};
+
+struct pending{
+	uint64_t due;  /* ns, CLOCK_MONOTONIC */
+	uint16_t len;
+	uint8_t frame[SIM_FRAME_MAX];
+};
+
+struct counters{
+	uint64_t rxBytes;
+	uint32_t rxFrames;
+	uint32_t rxErrors;
+	uint32_t answers;
+	uint32_t pushed;
+	uint32_t injected;
+	uint32_t dropped;  /* TX buffer or pending queue full */
+	uint64_t txBytes;
+};
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static const struct option options[] = {
+	{"link", required_argument, NULL, 'l'},
+	{"latency", required_argument, NULL, 'd'},
+	{"jitter", required_argument, NULL, 'j'},
+	{"error-rate", required_argument, NULL, 'e'},
+	{"errors", required_argument, NULL, 'E'},
+	{"flood", required_argument, NULL, 'f'},
+	{"flood-sid", required_argument, NULL, 's'},
+	{"seed", required_argument, NULL, 'S'},
+	{"duration", required_argument, NULL, 't'},
+	{"quiet", no_argument, NULL, 'q'},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0},
+};
+
+/* configuration */
+static const char *linkPath;
+static uint64_t latency = 2000000;  /* ns */
+static uint64_t jitter;  /* ns */
+static double errorRate;
+static uint32_t errors = ERR_ALL;
+static double floodRate;  /* frames/s */
+static uint16_t floodSid = PROT_SID(SID_DEV_BAT, SID_SERV_BAT_GET_LIVE_DATA,
+		SID_REQ);
+static uint32_t seed = 1;
+static double duration;  /* s, 0 runs until interrupted */
+static bool quiet;
+
+static struct simDevice dev;
+static struct dlinkDecoder decoder;
+static uint8_t rxMem[DLINK_MAX_PAYLOAD];
+
+/* min heap on due */
+static struct pending pending[MAX_PENDING];
+static uint32_t nPending;
+
+static uint8_t txBuf[TX_BUF_SIZE];
+static uint32_t txHead;  /* first byte not written yet */
+static uint32_t txTail;  /* end of the data */
+static bool txBlocked;  /* pty full, waiting for EPOLLOUT */
+
+static struct counters total, interval;
+static volatile sig_atomic_t stop;
+static int ptyFd, replyFd, epollFd;
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  -l, --link PATH        symlink to the pty, e.g. /tmp/ttyGEN\n"
+		"  -d, --latency US       reply latency, default 2000\n"
+		"  -j, --jitter US        reply latency +- US, uniform, default 0\n"
+		"  -e, --error-rate P     probability of an error per frame, 0..1\n"
+		"  -E, --errors LIST      crc,drop,trunc,noise, default all\n"
+		"  -f, --flood RATE       unsolicited frames per second, default 0\n"
+		"  -s, --flood-sid SID    request SID (hex) of the flood frames,\n"
+		"                         default 0x%04x, battery live data\n"
+		"  -S, --seed N           seed of the error and jitter generator\n"
+		"  -t, --duration S       stop after S seconds\n"
+		"  -q, --quiet            no statistics every second\n",
+		name, (unsigned) floodSid);
+}
+/*---------------------------------------------------------------------------*/
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+
+/* xorshift32, reproducible with --seed */
+static uint32_t rnd(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+/*---------------------------------------------------------------------------*/
+
+static double rnd_unit(void)
+{
+	return rnd() / 4294967296.0;
+}
+/*---------------------------------------------------------------------------*/
+
+static void on_signal(int sig)
+{
+	(void) sig;
+	stop = 1;
+}
+/*---------------------------------------------------------------------------*/
+
+static int32_t parse_errors(const char *list)
+{
+	static const char * const names[] = {"crc", "drop", "trunc", "noise"};
+	char buf[64];
+	char *tok, *save;
+	uint32_t i;
+
+	errors = 0;
+	snprintf(buf, sizeof(buf), "%s", list);
+	for(tok=strtok_r(buf, ",", &save); tok; tok=strtok_r(NULL, ",", &save)){
+		for(i=0; i<4 && strcmp(tok, names[i]); i++)
+			;
+		if(i == 4)
+			return -1;
+		errors |= 1u << i;
+	}
+	return errors ? 0 : -1;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Opens the pty pair. The slave is kept open, raw, so that the master does
+ * not see a hangup while the display is not connected.
+ */
+static int32_t open_pty(void)
+{
+	struct termios tio;
+	const char *name;
+	int slave;
+
+	ptyFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if(ptyFd < 0 || grantpt(ptyFd) || unlockpt(ptyFd))
+		return -1;
+	name = ptsname(ptyFd);
+	if(!name)
+		return -1;
+	slave = open(name, O_RDWR | O_NOCTTY);
+	if(slave < 0 || tcgetattr(slave, &tio))
+		return -1;
+	cfmakeraw(&tio);
+	if(tcsetattr(slave, TCSANOW, &tio))
+		return -1;
+	if(linkPath){
+		unlink(linkPath);
+		if(symlink(name, linkPath)){
+			perror(linkPath);
+			return -1;
+		}
+	}
+	printf("%s%s%s\n", name, linkPath ? " -> " : "", linkPath ? linkPath : "");
+	fflush(stdout);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+static void epoll_set(int fd, uint32_t events, uint64_t data, int op)
+{
+	struct epoll_event ev;
+
+	ev.events = events;
+	ev.data.u64 = data;
+	epoll_ctl(epollFd, op, fd, &ev);
+}
+/*---------------------------------------------------------------------------*/
+
+static int timer_start(int fd, uint64_t first, uint64_t period, bool abs)
+{
+	struct itimerspec its;
+
+	its.it_value.tv_sec = first / 1000000000u;
+	its.it_value.tv_nsec = first % 1000000000u;
+	its.it_interval.tv_sec = period / 1000000000u;
+	its.it_interval.tv_nsec = period % 1000000000u;
+	return timerfd_settime(fd, abs ? TFD_TIMER_ABSTIME : 0, &its, NULL);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Writes the TX buffer to the pty as far as it takes it.
+ */
+static void tx_flush(void)
+{
+	ssize_t n;
+
+	while(txHead < txTail){
+		n = write(ptyFd, &txBuf[txHead], txTail - txHead);
+		if(n < 0){
+			if(errno == EINTR)
+				continue;
+			break;
+		}
+		txHead += n;
+		total.txBytes += n;
+		interval.txBytes += n;
+	}
+	if(txHead == txTail){
+		txHead = txTail = 0;
+		if(txBlocked)
+			epoll_set(ptyFd, EPOLLIN, EV_PTY, EPOLL_CTL_MOD);
+		txBlocked = false;
+	}else if(!txBlocked){
+		epoll_set(ptyFd, EPOLLIN | EPOLLOUT, EV_PTY, EPOLL_CTL_MOD);
+		txBlocked = true;
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Appends a frame to the TX buffer, hit by an error with the error rate.
+ * The buffer is written by tx_flush().
+ */
+static void tx_frame(const uint8_t *frame, uint32_t len)
+{
+	uint8_t buf[MAX_NOISE + SIM_FRAME_MAX];
+	uint32_t i, n = 0, pick;
+
+	memcpy(buf, frame, len);
+	if(errorRate > 0 && rnd_unit() < errorRate){
+		/* one of the enabled errors */
+		pick = rnd() % __builtin_popcount(errors);
+		for(i=0; pick || !(errors & (1u << i)); i++){
+			if(errors & (1u << i))
+				pick--;
+		}
+		total.injected++;
+		interval.injected++;
+		switch(1u << i){
+		case ERR_CRC:
+			buf[len - 1] ^= 1u << (rnd() & 7);
+			break;
+		case ERR_DROP:
+			return;
+		case ERR_TRUNC:
+			len = 1 + rnd() % (len - 1);
+			break;
+		case ERR_NOISE:
+			n = 1 + rnd() % MAX_NOISE;
+			memmove(&buf[n], buf, len);
+			for(i=0; i<n; i++)
+				buf[i] = (uint8_t) rnd();
+			break;
+		}
+	}
+	len += n;
+
+	if(txHead && TX_BUF_SIZE - txTail < len){
+		memmove(txBuf, &txBuf[txHead], txTail - txHead);
+		txTail -= txHead;
+		txHead = 0;
+	}
+	if(TX_BUF_SIZE - txTail < len){
+		total.dropped++;
+		interval.dropped++;
+		return;
+	}
+	memcpy(&txBuf[txTail], buf, len);
+	txTail += len;
+}
+/*---------------------------------------------------------------------------*/
+
+static void reply_arm(void)
+{
+	if(nPending)
+		timer_start(replyFd, pending[0].due, 0, true);
+	else
+		timer_start(replyFd, 0, 0, false);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Queues an answer until its due time, sends it right away without latency.
+ */
+static void reply_queue(const uint8_t *frame, uint32_t len)
+{
+	int64_t delay = latency;
+	struct pending tmp;
+	uint32_t i, p;
+
+	if(jitter)
+		delay += (int64_t)(rnd() % (2 * jitter + 1)) - (int64_t) jitter;
+	if(delay <= 0){
+		tx_frame(frame, len);
+		return;
+	}
+	if(nPending == MAX_PENDING){
+		total.dropped++;
+		interval.dropped++;
+		return;
+	}
+
+	/* sift up */
+	i = nPending++;
+	pending[i].due = now() + delay;
+	pending[i].len = len;
+	memcpy(pending[i].frame, frame, len);
+	while(i && pending[p = (i - 1) / 2].due > pending[i].due){
+		tmp = pending[p];
+		pending[p] = pending[i];
+		pending[i] = tmp;
+		i = p;
+	}
+	if(i == 0)
+		reply_arm();
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sends the answers that are due.
+ */
+static void reply_due(void)
+{
+	uint64_t t = now();
+	struct pending tmp;
+	uint32_t i, c;
+
+	while(nPending && pending[0].due <= t){
+		tx_frame(pending[0].frame, pending[0].len);
+		pending[0] = pending[--nPending];
+		/* sift down */
+		i = 0;
+		while((c = 2 * i + 1) < nPending){
+			if(c + 1 < nPending && pending[c + 1].due < pending[c].due)
+				c++;
+			if(pending[i].due <= pending[c].due)
+				break;
+			tmp = pending[c];
+			pending[c] = pending[i];
+			pending[i] = tmp;
+			i = c;
+		}
+	}
+	reply_arm();
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Decodes the requests read from the pty and queues their answers.
+ */
+static void rx(void)
+{
+	uint8_t chunk[4096];
+	uint8_t frame[SIM_FRAME_MAX];
+	const uint8_t *data;
+	struct protView view;
+	uint32_t len, consumed;
+	int32_t ret;
+	ssize_t n;
+
+	while((n = read(ptyFd, chunk, sizeof(chunk))) > 0){
+		total.rxBytes += n;
+		interval.rxBytes += n;
+		data = chunk;
+		while(n){
+			ret = dlinkDec_feed(&decoder, data, n, &consumed);
+			data += consumed;
+			n -= consumed;
+			if(ret == DLINK_DEC_FRAME){
+				total.rxFrames++;
+				interval.rxFrames++;
+				protView_init(&view, decoder.rxBuf.buf, decoder.rxBuf.len);
+				if(simDev_answer(&dev, &view, frame, sizeof(frame), &len)
+						== PROT_SUCCESS){
+					total.answers++;
+					interval.answers++;
+					reply_queue(frame, len);
+				}
+				ucBuffer_clear(&decoder.rxBuf);
+			}else if(ret < 0){
+				total.rxErrors++;
+				interval.rxErrors++;
+			}
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Pushes the flood frames due since the last call. The fraction of a frame
+ * is carried over, so any rate is met on average.
+ */
+static void flood(void)
+{
+	static uint64_t last;
+	static double carry;
+	uint8_t frame[SIM_FRAME_MAX];
+	uint64_t t = now();
+	uint32_t len;
+
+	if(last)
+		carry += floodRate * (t - last) * 1e-9;
+	last = t;
+	while(carry >= 1){
+		carry -= 1;
+		if(simDev_push(&dev, floodSid, frame, sizeof(frame), &len))
+			continue;
+		total.pushed++;
+		interval.pushed++;
+		tx_frame(frame, len);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+static void print_counters(const char *what, const struct counters *c,
+							double seconds)
+{
+	fprintf(stderr, "%s: rx %u frames %u errors %.1f kB/s | "
+			"tx %u answers %u pushed %u injected %u dropped %.1f kB/s\n",
+			what, c->rxFrames, c->rxErrors, c->rxBytes / seconds / 1e3,
+			c->answers, c->pushed, c->injected, c->dropped,
+			c->txBytes / seconds / 1e3);
+}
+/*---------------------------------------------------------------------------*/
+
+static void drain(int fd)
+{
+	uint64_t expirations;
+
+	while(read(fd, &expirations, sizeof(expirations)) > 0)
+		;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	struct epoll_event ev[8];
+	struct sigaction sa;
+	uint8_t frame[SIM_FRAME_MAX];
+	uint32_t len;
+	int floodFd, statsFd;
+	uint64_t t0, end = 0;
+	int i, n, opt;
+
+	while((opt = getopt_long(argc, argv, "l:d:j:e:E:f:s:S:t:qh", options,
+			NULL)) != -1){
+		switch(opt){
+		case 'l': linkPath = optarg; break;
+		case 'd': latency = strtoull(optarg, NULL, 0) * 1000; break;
+		case 'j': jitter = strtoull(optarg, NULL, 0) * 1000; break;
+		case 'e': errorRate = atof(optarg); break;
+		case 'E':
+			if(parse_errors(optarg)){
+				fprintf(stderr, "invalid error list: %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'f': floodRate = atof(optarg); break;
+		case 's': floodSid = (uint16_t) strtoul(optarg, NULL, 16); break;
+		case 'S': seed = (uint32_t) strtoul(optarg, NULL, 0) | 1; break;
+		case 't': duration = atof(optarg); break;
+		case 'q': quiet = true; break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+
+	simDev_init(&dev, seed);
+	dlinkDec_init(&decoder, rxMem, sizeof(rxMem));
+	if(floodRate > 0 && simDev_push(&dev, floodSid, frame, sizeof(frame),
+			&len)){
+		fprintf(stderr, "SID 0x%04x is not simulated\n", (unsigned) floodSid);
+		return 2;
+	}
+	if(open_pty()){
+		perror("pty");
+		return 1;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	epollFd = epoll_create1(0);
+	replyFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	floodFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	statsFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	epoll_set(ptyFd, EPOLLIN, EV_PTY, EPOLL_CTL_ADD);
+	epoll_set(replyFd, EPOLLIN, EV_REPLY, EPOLL_CTL_ADD);
+	epoll_set(floodFd, EPOLLIN, EV_FLOOD, EPOLL_CTL_ADD);
+	epoll_set(statsFd, EPOLLIN, EV_STATS, EPOLL_CTL_ADD);
+	if(floodRate > 0)
+		timer_start(floodFd, FLOOD_PERIOD_NS, FLOOD_PERIOD_NS, false);
+	timer_start(statsFd, 1000000000u, 1000000000u, false);
+
+	t0 = now();
+	if(duration > 0)
+		end = t0 + (uint64_t)(duration * 1e9);
+	while(!stop && (!end || now() < end)){
+		n = epoll_wait(epollFd, ev, 8, -1);
+		for(i=0; i<n; i++){
+			switch(ev[i].data.u64){
+			case EV_PTY:
+				if(ev[i].events & EPOLLIN)
+					rx();
+				break;
+			case EV_REPLY:
+				drain(replyFd);
+				reply_due();
+				break;
+			case EV_FLOOD:
+				drain(floodFd);
+				flood();
+				break;
+			case EV_STATS:
+				drain(statsFd);
+				if(!quiet)
+					print_counters("1s", &interval, 1.0);
+				memset(&interval, 0, sizeof(interval));
+				break;
+			}
+		}
+		tx_flush();
+	}
+
+	print_counters("total", &total, (now() - t0) * 1e-9);
+	if(linkPath)
+		unlink(linkPath);
+	return 0;
+}
@@ -0,0 +1,25 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+TARGET = gensim
+
+INCLUDEPATH += "../../Protocole_LE" "../../Protocole_LE/lib"
+
+HEADERS += \
+    simDevice.h \
+    ../../Protocole_LE/lib/mem/ucBuffer.h \
+    ../../Protocole_LE/lib/prot/protocol.h \
+    ../../Protocole_LE/lib/prot/dlinkDecoder.h \
+    ../../Protocole_LE/lib/prot/protView.h \
+    ../../Protocole_LE/lib/crc/crc16Lookup.h \
+    ../../Protocole_LE/lib/crc/crc16Block.h
+
+SOURCES += \
+    gensim.c \
+    simDevice.c \
+    ../../Protocole_LE/lib/mem/ucBuffer.c \
+    ../../Protocole_LE/lib/prot/dlinkDecoder.c \
+    ../../Protocole_LE/lib/prot/protView.c \
+    ../../Protocole_LE/lib/crc/crc16Lookup.c \
+    ../../Protocole_LE/lib/crc/crc16Block.c
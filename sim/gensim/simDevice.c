@@ -0,0 +1,575 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: simDevice.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Answers the requests of the display like a generator with battery,
+ * 		ACDC and lamp would. The answers are written as complete frames:
+ * 			[PREAMBLE(1), PAYLOAD LENGTH(1), PAYLOAD(x), CRC(2)]
+ * 		The network and transport header of the request are echoed, the
+ * 		addresses swapped, hence a tid1 answer carries the sequence number
+ * 		of its request. The SID is followed by the service status, then the
+ * 		service data in the layout the handle_reply_* functions of the
+ * 		service files read.
+ *
+ * 		Requests of a simulated device without an entry in the answer table
+ * 		are acknowledged with an empty payload. Requests of other devices
+ * 		are not answered.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "simDevice.h"
+#include "crc/crc16Block.h"
+#include "prot/services/battery.h"
+#include "prot/services/general.h"
+#include "prot/services/generator.h"
+#include "prot/services/lamp.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+/* Same as in acdc.h, which can't be included here as it pulls in the
+ * firmware's power supply task. */
+enum{
+	SIM_SERV_ACDC_GET_DEVICE_INFO,
+	SIM_SERV_ACDC_GET_SPECIFIC_VALUE,
+	SIM_SERV_ACDC_GET_LIVE_DATA,
+};
+
+/* Request SID without the answer bit. */
+#define SIM_SID(dev, serv)		PROT_SID(dev, serv, SID_REQ)
+
+/* Writes the service data of an answer and returns its length. The request
+ * data is passed for the setters. */
+typedef uint32_t (*simFill)(struct simDevice *, const uint8_t *, uint16_t,
+							uint8_t *);
+
+struct simService{
+	uint16_t sid;
+	simFill fill;
+};
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static uint32_t fill_device(struct simDevice *, const uint8_t *, uint16_t,
+							uint8_t *);
+static uint32_t fill_device_info(struct simDevice *, const uint8_t *, uint16_t,
+							uint8_t *);
+static uint32_t fill_gen_live_data(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static uint32_t fill_gen_flash_info(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static uint32_t fill_gen_test_flash(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static uint32_t fill_bat_specific_value(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static uint32_t fill_bat_live_data(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static uint32_t fill_bat_set_charging(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static uint32_t fill_bat_set_capacity(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static uint32_t fill_acdc_specific_value(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static uint32_t fill_acdc_live_data(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static uint32_t fill_lamp_live_data(struct simDevice *, const uint8_t *,
+							uint16_t, uint8_t *);
+static void drift(struct simDevice *);
+static const struct simService *service_lookup(uint16_t);
+static uint32_t answer_header(const struct protView *, uint8_t *);
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+/* design capacity(mAh), full capacity(mAh), nominal voltage(mV), nominal
+ * energy(Wh), nominal and maximal discharge current(mA), nominal charge
+ * current(mA) */
+static const uint16_t batSpec[] = {5200, 5000, 25200, 131, 20000, 40000, 4000};
+/* nominal power(W), nominal output voltage(mV) */
+static const uint16_t acdcSpec[] = {300, 29400};
+/**/
+static const struct simService services[] = {
+	{SIM_SID(SID_DEV_GENERAL, SID_SERV_GENERAL_GET_DEVICE), fill_device},
+	/* generator */
+	{SIM_SID(SID_DEV_GEN, SID_SERV_GEN_GET_DEVICE_INFO), fill_device_info},
+	{SIM_SID(SID_DEV_GEN, SID_SERV_GEN_GET_LIVE_DATA), fill_gen_live_data},
+	{SIM_SID(SID_DEV_GEN, SID_SERV_GEN_GET_USAGE_INFO), fill_gen_flash_info},
+	{SIM_SID(SID_DEV_GEN, SID_SERV_GEN_GET_FLASH_INFO), fill_gen_flash_info},
+	{SIM_SID(SID_DEV_GEN, SID_SERV_GEN_TEST_FLASH), fill_gen_test_flash},
+	/* battery */
+	{SIM_SID(SID_DEV_BAT, SID_SERV_BAT_GET_DEVICE_INFO), fill_device_info},
+	{SIM_SID(SID_DEV_BAT, SID_SERV_BAT_GET_SPECIFIC_VALUE),
+			fill_bat_specific_value},
+	{SIM_SID(SID_DEV_BAT, SID_SERV_BAT_GET_LIVE_DATA), fill_bat_live_data},
+	{SIM_SID(SID_DEV_BAT, SID_SERV_BAT_SET_CHARGING), fill_bat_set_charging},
+	{SIM_SID(SID_DEV_BAT, SID_SERV_BAT_SET_BAT_CAPACITY),
+			fill_bat_set_capacity},
+	/* ACDC */
+	{SIM_SID(SID_DEV_ACDC, SIM_SERV_ACDC_GET_DEVICE_INFO), fill_device_info},
+	{SIM_SID(SID_DEV_ACDC, SIM_SERV_ACDC_GET_SPECIFIC_VALUE),
+			fill_acdc_specific_value},
+	{SIM_SID(SID_DEV_ACDC, SIM_SERV_ACDC_GET_LIVE_DATA), fill_acdc_live_data},
+	/* lamp */
+	{SIM_SID(SID_DEV_LAMP, SID_SERV_LAMP_GET_DEVICE_INFO), fill_device_info},
+	{SIM_SID(SID_DEV_LAMP, SID_SERV_LAMP_GET_LIVE_DATA), fill_lamp_live_data},
+};
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * General device query, the simulator is a generator.
+ */
+static uint32_t fill_device(struct simDevice *self, const uint8_t *req,
+							uint16_t reqLen, uint8_t *data)
+{
+	(void) self;
+	(void) req;
+	(void) reqLen;
+	data[0] = SID_DEV_GEN;
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Same layout for all devices, see handle_reply_get_device_info() of the
+ * battery services.
+ */
+static uint32_t fill_device_info(struct simDevice *self, const uint8_t *req,
+							uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 15};
+	struct ucBuffer *dest = &b;
+
+	(void) req;
+	(void) reqLen;
+	STORE32(dest, self->serNr);
+	STORE32(dest, self->fwVersion);
+	STORE32(dest, self->hwVersion);
+	STORE8(dest, 26);  /* year */
+	STORE8(dest, 10);  /* month */
+	STORE8(dest, 17);  /* day */
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * flash energy(2), number of flashes(4), charger state(1)
+ */
+static uint32_t fill_gen_live_data(struct simDevice *self, const uint8_t *req,
+							uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 7};
+	struct ucBuffer *dest = &b;
+
+	(void) req;
+	(void) reqLen;
+	STORE16(dest, self->flashEnergy);
+	STORE32(dest, self->nFlashes);
+	STORE8(dest, self->bat.chgs);
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint32_t fill_gen_flash_info(struct simDevice *self, const uint8_t *req,
+							uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 4};
+	struct ucBuffer *dest = &b;
+
+	(void) req;
+	(void) reqLen;
+	STORE32(dest, self->nFlashes);
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Every test flash takes a little from the battery.
+ */
+static uint32_t fill_gen_test_flash(struct simDevice *self, const uint8_t *req,
+							uint16_t reqLen, uint8_t *data)
+{
+	(void) req;
+	(void) reqLen;
+	(void) data;
+	self->nFlashes++;
+	if(self->bat.relRemainCap > 5 && (self->nFlashes & 0x3f) == 0)
+		self->bat.relRemainCap--;
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * See handle_reply_get_specific_value() of the battery services.
+ */
+static uint32_t fill_bat_specific_value(struct simDevice *self,
+							const uint8_t *req, uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 18};
+	struct ucBuffer *dest = &b;
+	uint32_t i;
+
+	(void) self;
+	(void) req;
+	(void) reqLen;
+	for(i=0; i<SERV_N(batSpec); i++)
+		STORE16(dest, batSpec[i]);
+	STORE8(dest, 0);  /* discharge temperature thresholds, degC */
+	STORE8(dest, 60);
+	STORE8(dest, 5);  /* charge temperature thresholds, degC */
+	STORE8(dest, 45);
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * See handle_reply_get_live_data() of the battery services.
+ */
+static uint32_t fill_bat_live_data(struct simDevice *self, const uint8_t *req,
+							uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 19};
+	struct ucBuffer *dest = &b;
+
+	(void) req;
+	(void) reqLen;
+	drift(self);
+	STORE8(dest, self->bat.relRemainCap);
+	STORE16(dest, self->bat.vPack);  /* power voltage */
+	STORE16(dest, self->bat.vPack);
+	STORE16(dest, (self->bat.chgs ? self->bat.vPack + 400 : 0));  /* charge */
+	STORE16(dest, (uint16_t) self->bat.iBat);
+	STORE16(dest, self->bat.tCell);
+	STORE16(dest, (self->bat.tCell + 20));  /* FET temperature */
+	STORE8(dest, 1);  /* outputs */
+	STORE16(dest, 0);  /* output errors */
+	STORE8(dest, self->bat.chgs);
+	STORE16(dest, 0);  /* charger errors */
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Takes charge start(1)/stop(0), see pack_req_set_charging(), and answers
+ * with the charger state and errors.
+ */
+static uint32_t fill_bat_set_charging(struct simDevice *self,
+							const uint8_t *req, uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 3};
+	struct ucBuffer *dest = &b;
+
+	if(reqLen >= 1)
+		self->bat.chgs = req[0] ? 1 : 0;
+	STORE8(dest, self->bat.chgs);
+	STORE16(dest, 0);
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * See handle_reply_set_bat_capacity() of the battery services.
+ */
+static uint32_t fill_bat_set_capacity(struct simDevice *self,
+							const uint8_t *req, uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 6};
+	struct ucBuffer *dest = &b;
+
+	(void) req;
+	(void) reqLen;
+	STORE16(dest, batSpec[0]);
+	STORE16(dest, batSpec[1]);
+	STORE16(dest, self->bat.relRemainCap);
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * nominal power(2), nominal output voltage(2)
+ */
+static uint32_t fill_acdc_specific_value(struct simDevice *self,
+							const uint8_t *req, uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 4};
+	struct ucBuffer *dest = &b;
+
+	(void) self;
+	(void) req;
+	(void) reqLen;
+	STORE16(dest, acdcSpec[0]);
+	STORE16(dest, acdcSpec[1]);
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * 15 bytes as expected by the (disabled) length check of the ACDC services:
+ * output voltage(2), output current(2), temperature(2), mains voltage(2),
+ * state(1), errors(2), reserved(4)
+ */
+static uint32_t fill_acdc_live_data(struct simDevice *self,
+							const uint8_t *req, uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 15};
+	struct ucBuffer *dest = &b;
+
+	(void) req;
+	(void) reqLen;
+	drift(self);
+	STORE16(dest, self->acdc.vOut);
+	STORE16(dest, (self->bat.chgs ? 4000 : 0));
+	STORE16(dest, self->acdc.temp);
+	STORE16(dest, 230);
+	STORE8(dest, self->bat.chgs);
+	STORE16(dest, 0);
+	STORE32(dest, 0);
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * lamp temperature(2), flash energy(2)
+ */
+static uint32_t fill_lamp_live_data(struct simDevice *self, const uint8_t *req,
+							uint16_t reqLen, uint8_t *data)
+{
+	struct ucBuffer b = {.buf = data, .size = 4};
+	struct ucBuffer *dest = &b;
+
+	(void) req;
+	(void) reqLen;
+	STORE16(dest, (self->bat.tCell + 150));
+	STORE16(dest, self->flashEnergy);
+	return dest->pos;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Moves the live data a step: the battery discharges slowly or charges when
+ * the charger is on, the temperatures follow the current.
+ */
+static void drift(struct simDevice *self)
+{
+	uint32_t n = self->nAnswers;
+
+	self->bat.iBat = self->bat.chgs ? 4000 : -(int16_t)(800 + (n & 0xff));
+	if((n & 0xff) == 0){
+		if(self->bat.chgs && self->bat.relRemainCap < 100)
+			self->bat.relRemainCap++;
+		else if(!self->bat.chgs && self->bat.relRemainCap > 0)
+			self->bat.relRemainCap--;
+	}
+	self->bat.vPack = 22000 + 60 * self->bat.relRemainCap + (n & 0x1f);
+	self->bat.tCell = 2981 + ((n >> 4) & 0x3f);
+	self->acdc.vOut = self->bat.chgs ? 29400 : 0;
+	self->acdc.temp = 3030 + ((n >> 6) & 0x1f);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Returns the answer table entry of the request SID or NULL.
+ */
+static const struct simService *service_lookup(uint16_t sid)
+{
+	uint32_t i;
+
+	for(i=0; i<sizeof(services)/sizeof(services[0]); i++){
+		if(services[i].sid == sid)
+			return &services[i];
+	}
+	return NULL;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Copies the network and transport header of the request to hdr, with the
+ * source and destination swapped. Returns the number of bytes written.
+ */
+static uint32_t answer_header(const struct protView *req, uint8_t *hdr)
+{
+	const uint8_t *src = req->buf;
+
+	memcpy(hdr, src, req->procOff);
+	switch(src[0]){
+	case 1:  /* destAddr, srcAddr */
+		hdr[1] = src[2];
+		hdr[2] = src[1];
+		break;
+	case 2:  /* destDev, destChn, srcDev, srcChn */
+	case 3:  /* destAddr(2), srcAddr(2), flags */
+		hdr[1] = src[3];
+		hdr[2] = src[4];
+		hdr[3] = src[1];
+		hdr[4] = src[2];
+		break;
+	default:
+		break;
+	}
+	return req->procOff;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Argument:	self	The device.
+ * 				seed	Makes the serial number, to tell simulators apart.
+ */
+void simDev_init(struct simDevice *self, uint32_t seed)
+{
+	memset(self, 0, sizeof(*self));
+	self->serNr = 0x20180000 + (seed & 0xffff);
+	self->fwVersion = 0x00020100;
+	self->hwVersion = 0x00000003;
+	self->bat.relRemainCap = 87;
+	self->flashEnergy = 1200;
+	drift(self);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Completes a frame whose payload has been written to frame[2..]: writes the
+ * preamble, the length and the CRC behind the payload.
+ *
+ * Argument:	frame	At least len + DLINK_H_LEN bytes.
+ * 				len		Payload length, at most DLINK_MAX_PAYLOAD.
+ * Return:		Length of the complete frame.
+ */
+uint32_t simDev_frame(uint8_t *frame, uint32_t len)
+{
+	uint16_t crc;
+
+	frame[0] = PREAMBLE;
+	frame[1] = (uint8_t) len;
+	crc = crc16_ccitt_block(&frame[DLINK_H_LEN - CRC_LEN], len,
+			CRC16_CCITT_INIT_0000);
+	frame[len + DLINK_H_LEN - CRC_LEN] = (uint8_t)(crc >> 8);
+	frame[len + DLINK_H_LEN - CRC_LEN + 1] = (uint8_t) crc;
+	return len + DLINK_H_LEN;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Builds the answer frame of a request.
+ *
+ * Argument:	self	The device.
+ * 				req		The request, decoded in place.
+ * 				frame	Destination, SIM_FRAME_MAX bytes are always enough.
+ * 				size	Size of frame in bytes.
+ * 				len		Returns the length of the frame.
+ * Return:		err		 0	success
+ * 						SIM_NO_ANSWER	not a request of a simulated device
+ * 						PROT_ERR_INVALID_LEN	frame too small
+ * 						... see the protocol.h error enum.
+ */
+int32_t simDev_answer(struct simDevice *self, struct protView *req,
+						uint8_t *frame, uint32_t size, uint32_t *len)
+{
+	const struct simService *serv;
+	struct protocol hdr;
+	const uint8_t *reqData;
+	uint16_t reqLen;
+	uint8_t *payload = &frame[DLINK_H_LEN - CRC_LEN];
+	uint32_t n;
+	int32_t err;
+
+	*len = 0;
+	err = protView_process(req, &hdr);
+	if(err)
+		return err;
+	if(hdr.procLayer.sid & SID_ANS_M)
+		return SIM_NO_ANSWER;
+	switch((hdr.procLayer.sid & SID_DEV_M) >> SID_DEV_S){
+	case SID_DEV_GENERAL:
+	case SID_DEV_GEN:
+	case SID_DEV_BAT:
+	case SID_DEV_ACDC:
+	case SID_DEV_LAMP:
+		break;
+	default:
+		self->nUnknown++;
+		return SIM_NO_ANSWER;
+	}
+	if(size < SIM_FRAME_MAX)
+		return PROT_ERR_INVALID_LEN;
+	protView_data(req, &reqData, &reqLen);
+
+	n = answer_header(req, payload);
+	payload[n++] = (uint8_t)((hdr.procLayer.sid | SID_ANS) >> 8);
+	payload[n++] = (uint8_t)(hdr.procLayer.sid | SID_ANS);
+	payload[n++] = PROT_SUCCESS;  /* service status */
+	serv = service_lookup(hdr.procLayer.sid);
+	if(serv)
+		n += serv->fill(self, reqData, reqLen, &payload[n]);
+	else
+		self->nUnknown++;
+	self->nAnswers++;
+	*len = simDev_frame(frame, n);
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Builds an unsolicited answer, without network and transport addressing,
+ * as pushed by the devices on their own.
+ *
+ * Argument:	self	The device.
+ * 				sid		Request SID of a service in the answer table.
+ * 				frame	Destination, SIM_FRAME_MAX bytes are always enough.
+ * 				size	Size of frame in bytes.
+ * 				len		Returns the length of the frame.
+ * Return:		err		 0	success
+ * 						PROT_ERR_INVALID_SID	service not simulated
+ * 						PROT_ERR_INVALID_LEN	frame too small
+ */
+int32_t simDev_push(struct simDevice *self, uint16_t sid, uint8_t *frame,
+						uint32_t size, uint32_t *len)
+{
+	const struct simService *serv = service_lookup(sid & ~SID_ANS_M);
+	uint8_t *payload = &frame[DLINK_H_LEN - CRC_LEN];
+	uint32_t n = 0;
+
+	*len = 0;
+	if(!serv)
+		return PROT_ERR_INVALID_SID;
+	if(size < SIM_FRAME_MAX)
+		return PROT_ERR_INVALID_LEN;
+	payload[n++] = 0;  /* nid */
+	payload[n++] = 0;  /* tid */
+	payload[n++] = (uint8_t)((serv->sid | SID_ANS) >> 8);
+	payload[n++] = (uint8_t)(serv->sid | SID_ANS);
+	payload[n++] = PROT_SUCCESS;  /* service status */
+	n += serv->fill(self, NULL, 0, &payload[n]);
+	self->nAnswers++;
+	*len = simDev_frame(frame, n);
+	return PROT_SUCCESS;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
@@ -0,0 +1,77 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: simDevice.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Simulated generator with battery, ACDC and lamp, see simDevice.c.
+ *
+ *****************************************************************************/
+
+#ifndef SIM_GENSIM_SIMDEVICE_H_
+#define SIM_GENSIM_SIMDEVICE_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "prot/protocol.h"
+#include "prot/protView.h"
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+/* Largest frame on the wire: preamble, length, payload and CRC. */
+#define SIM_FRAME_MAX			(DLINK_H_LEN + DLINK_MAX_PAYLOAD)
+
+/* Return values of simDev_answer() besides the protocol.h errors. */
+#define SIM_NO_ANSWER			(-1)  /* not a request, or not for us */
+
+/******************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+/* State of the simulated devices. The live data drifts a little with every
+ * answer so that a display shows movement. */
+struct simDevice{
+	uint32_t serNr;
+	uint32_t fwVersion;
+	uint32_t hwVersion;
+	struct{
+		uint8_t relRemainCap;  /* % */
+		uint16_t vPack;  /* mV */
+		int16_t iBat;  /* mA */
+		uint16_t tCell;  /* 0.1 K */
+		uint8_t chgs;  /* charger state, bit 0: charging */
+	}bat;
+	struct{
+		uint16_t vOut;  /* mV */
+		uint16_t temp;  /* 0.1 K */
+	}acdc;
+	uint16_t flashEnergy;  /* Ws */
+	uint32_t nFlashes;
+	uint32_t nAnswers;
+	uint32_t nUnknown;  /* requests of services not simulated */
+};
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+extern void simDev_init(struct simDevice *, uint32_t);
+extern int32_t simDev_answer(struct simDevice *, struct protView *, uint8_t *,
+								uint32_t, uint32_t *);
+extern int32_t simDev_push(struct simDevice *, uint16_t, uint8_t *, uint32_t,
+								uint32_t *);
+extern uint32_t simDev_frame(uint8_t *, uint32_t);
+
+
+#endif /* SIM_GENSIM_SIMDEVICE_H_ */
@@ -0,0 +1,50 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: projConfig.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Project configuration of the UART emulator (uartemu.pro). The kernel
+ * 		is built as on the target, without AOK_HOST: a single thread runs
+ * 		the interrupts and the AOs one after the other in virtual time, so
+ * 		there is nothing to mask.
+ *
+ *****************************************************************************/
+
+#ifndef UARTEMU_CONFIG_PROJCONFIG_H_
+#define UARTEMU_CONFIG_PROJCONFIG_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+/* Interrupts are emulated between the dispatches, never within. */
+#define INT_GLOB_MASK_SET
+#define INT_GLOB_MASK_CLEAR
+
+/* Object types (ao.objType) of the emulated drivers. */
+enum{
+	OBJTYPE_NONE,
+	OBJTYPE_RX_OBJ,
+	OBJTYPE_TX_OBJ,
+};
+
+/* First signal an object sends to others. */
+#define RXOBJ_PUBLIC_SIG		0x0100
+#define TXOBJ_PUBLIC_SIG		0x0110
+
+
+#endif /* UARTEMU_CONFIG_PROJCONFIG_H_ */
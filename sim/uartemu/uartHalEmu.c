@@ -0,0 +1,532 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: uartHalEmu.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Emulated implementation of the UART HAL (driver/com/uartHal.h) in
+ * 		virtual time, see uartHalEmu.h.
+ *
+ * 		The RX interrupt has the semantics of the host implementation
+ * 		(uartHalHost.c): it is raised when the RX FIFO fill reaches the
+ * 		level and dropped when the fill falls below it. Setting a level
+ * 		raises it again if the fill is at or above the new level. The RX
+ * 		timeout is raised 32 bit times after the last character if the
+ * 		FIFO isn't empty, and dropped once it is.
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "config/projConfig.h"
+#include "driver/com/uartHal.h"
+#include "driver/com/uartRxObj.h"
+#include "driver/com/uartTxObj.h"
+#include "lib/stm/aok.h"
+#include "lib/stm/event.h"
+#include "uartHalEmu.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#define CHR_BITS				10  /* 8N1 */
+#define RT_BITS					32  /* RX timeout */
+
+struct uartHalEmuPort{
+	struct ao *rx;
+	struct ao *tx;
+	uartHalEmuLine_t line;
+	void *lineHandle;
+	uint64_t chrTime;  /* ns */
+	/* interrupts */
+	uint32_t im;
+	uint32_t ris;
+	bool irqArmed;  /* handled at irqAt */
+	uint64_t irqAt;
+	/* RX */
+	uint8_t rxFifo[UART_HAL_FIFO_LEN];
+	uint32_t rxHead;
+	uint32_t rxCount;
+	uint32_t rxLevel;
+	bool rxAbove;  /* fill at or above the level */
+	bool rtArmed;  /* RX timeout at rtAt */
+	uint64_t rtAt;
+	/* TX */
+	uint8_t txFifo[UART_HAL_FIFO_LEN];
+	uint32_t txHead;
+	uint32_t txCount;
+	bool txShift;  /* a character is in the serializer until txAt */
+	uint8_t txChr;
+	uint64_t txAt;
+	struct uartHalEmuStats stats;
+};
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static struct uartHalEmuPort ports[UART_HAL_EMU_PORTS];
+static uint64_t emuTime;  /* ns */
+static uint64_t latMin;  /* ns */
+static uint64_t latMax;  /* ns */
+static uint32_t seed = 1;
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static uint32_t rnd(void);
+static uint64_t latency(void);
+static void irq_check(struct uartHalEmuPort *);
+static void rx_update(struct uartHalEmuPort *);
+static void tx_shift(struct uartHalEmuPort *);
+static void tx_done(struct uartHalEmuPort *);
+static void irq(uint32_t);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/* xorshift32, reproducible with the seed of uartHalEmu_set_latency() */
+static uint32_t rnd(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+/*---------------------------------------------------------------------------*/
+
+static uint64_t latency(void)
+{
+	if(latMax <= latMin)
+		return latMin;
+	return latMin + rnd() % (latMax - latMin + 1);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Arms the interrupt if one is pending and unmasked, it is handled after
+ * the latency.
+ */
+static void irq_check(struct uartHalEmuPort *p)
+{
+	if(!p->irqArmed && (p->ris & p->im)){
+		p->irqArmed = true;
+		p->irqAt = emuTime + latency();
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+static void rx_update(struct uartHalEmuPort *p)
+{
+	if(p->rxCount >= p->rxLevel){
+		if(!p->rxAbove)
+			p->ris |= UART_HAL_INT_RX;
+		p->rxAbove = true;
+	}else{
+		p->rxAbove = false;
+		p->ris &= ~UART_HAL_INT_RX;
+	}
+	if(p->rxCount == 0){
+		p->ris &= ~UART_HAL_INT_RT;
+		p->rtArmed = false;
+	}
+	if(p->rxCount > p->stats.rxMaxFill)
+		p->stats.rxMaxFill = p->rxCount;
+	irq_check(p);
+}
+/*---------------------------------------------------------------------------*/
+
+/* Moves the next character of the TX FIFO into the serializer. */
+static void tx_shift(struct uartHalEmuPort *p)
+{
+	p->txChr = p->txFifo[p->txHead];
+	p->txHead = (p->txHead + 1) % UART_HAL_FIFO_LEN;
+	p->txCount--;
+	p->txShift = true;
+	p->txAt = emuTime + p->chrTime;
+}
+/*---------------------------------------------------------------------------*/
+
+/* The stop bit of the character in the serializer is sent. */
+static void tx_done(struct uartHalEmuPort *p)
+{
+	p->txShift = false;
+	if(p->line != NULL)
+		p->line(p->lineHandle, p->txChr, emuTime);
+	if(p->txCount){
+		tx_shift(p);
+	}else{
+		p->ris |= UART_HAL_INT_TX;  /* EOT */
+		irq_check(p);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/* Handles the interrupt of a port, then runs the AOs. */
+static void irq(uint32_t port)
+{
+	struct uartHalEmuPort *p = &ports[port];
+	uint32_t mis;
+
+	p->irqArmed = false;
+	mis = p->ris & p->im;
+	if(!mis)
+		return;  /* dropped meanwhile */
+	if(mis & (UART_HAL_INT_RX | UART_HAL_INT_RT | UART_HAL_INT_ERR))
+		p->stats.rxIrq++;
+	if(mis & UART_HAL_INT_TX)
+		p->stats.txIrq++;
+	uartHal_isr(port);
+	ao_run_waiting();
+	irq_check(p);
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * SUBROUTINES (EXPORT)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Opens a port, 8N1. The RX and TX FIFO are empty and all interrupts
+ * masked.
+ *
+ * Argument:	port		Port number, below UART_HAL_EMU_PORTS.
+ * 				baud		Baudrate.
+ * 				line		Called with the characters sent, may be NULL.
+ * 				handle		Passed to line.
+ * Return:		 0			success
+ * 				-1			invalid port or baudrate
+ */
+int32_t uartHalEmu_open(uint32_t port, uint32_t baud, uartHalEmuLine_t line,
+						void *handle)
+{
+	struct uartHalEmuPort *p;
+
+	if(port >= UART_HAL_EMU_PORTS || baud == 0)
+		return -1;
+	p = &ports[port];
+	memset(p, 0, sizeof(*p));
+	p->line = line;
+	p->lineHandle = handle;
+	p->chrTime = (CHR_BITS * 1000000000ull + baud/2) / baud;
+	p->rxLevel = 8;
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sets the interrupt latency of all ports, uniformly distributed.
+ *
+ * Argument:	min		Shortest latency in ns.
+ * 				max		Longest latency in ns.
+ * 				s		Seed of the generator, not 0.
+ */
+void uartHalEmu_set_latency(uint64_t min, uint64_t max, uint32_t s)
+{
+	latMin = min;
+	latMax = max;
+	seed = s ? s : 1;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Return:		the virtual time in ns
+ */
+uint64_t uartHalEmu_now(void)
+{
+	return emuTime;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Argument:	port	Port number.
+ * Return:		the time of a character on the line in ns
+ */
+uint64_t uartHalEmu_chr_time(uint32_t port)
+{
+	return ports[port].chrTime;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Advances the virtual time to t, sending characters, raising the RX
+ * timeouts and handling the interrupts due until then in their order.
+ *
+ * Argument:	t		Virtual time in ns.
+ */
+void uartHalEmu_run_until(uint64_t t)
+{
+	struct uartHalEmuPort *p;
+	uint64_t next;
+	uint32_t i, port;
+	enum{NONE, TX, RT, IRQ} what;
+
+	while(1){
+		next = UINT64_MAX;
+		what = NONE;
+		port = 0;
+		for(i=0; i<UART_HAL_EMU_PORTS; i++){
+			p = &ports[i];
+			if(p->txShift && p->txAt < next){
+				next = p->txAt;
+				what = TX;
+				port = i;
+			}
+			if(p->rtArmed && p->rtAt < next){
+				next = p->rtAt;
+				what = RT;
+				port = i;
+			}
+			if(p->irqArmed && p->irqAt < next){
+				next = p->irqAt;
+				what = IRQ;
+				port = i;
+			}
+		}
+		if(what == NONE || next > t){
+			if(t > emuTime)
+				emuTime = t;
+			return;
+		}
+		if(next > emuTime)
+			emuTime = next;
+		p = &ports[port];
+		switch(what){
+		case NONE:
+			break;
+		case TX:
+			tx_done(p);
+			break;
+		case RT:
+			p->rtArmed = false;
+			if(p->rxCount){
+				p->ris |= UART_HAL_INT_RT;
+				irq_check(p);
+			}
+			break;
+		case IRQ:
+			irq(port);
+			break;
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * The stop bit of a character on the RX line is received now. If the RX
+ * FIFO is full, the character is lost and an overrun is raised.
+ *
+ * Argument:	port	Port number.
+ * 				chr		The character.
+ */
+void uartHalEmu_receive(uint32_t port, uint8_t chr)
+{
+	struct uartHalEmuPort *p = &ports[port];
+
+	if(p->rxCount == UART_HAL_FIFO_LEN){
+		p->stats.overrun++;
+		p->ris |= UART_HAL_INT_OE;
+	}else{
+		p->rxFifo[(p->rxHead + p->rxCount) % UART_HAL_FIFO_LEN] = chr;
+		p->rxCount++;
+	}
+	p->rtArmed = true;
+	p->rtAt = emuTime + p->chrTime * RT_BITS / CHR_BITS;
+	rx_update(p);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Argument:	port	Port number.
+ * Return:		the counters of the port
+ */
+const struct uartHalEmuStats *uartHalEmu_stats(uint32_t port)
+{
+	return &ports[port].stats;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * UART HAL
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+/*
+ * Nothing to take over, there is no DMA.
+ */
+void uartHal_claim(uint32_t port, uint32_t dir)
+{
+	(void) port;
+	(void) dir;
+}
+/*---------------------------------------------------------------------------*/
+
+void uartHal_attach_rx(uint32_t port, struct ao *ao)
+{
+	ports[port].rx = ao;
+}
+/*---------------------------------------------------------------------------*/
+
+void uartHal_attach_tx(uint32_t port, struct ao *ao)
+{
+	ports[port].tx = ao;
+}
+/*---------------------------------------------------------------------------*/
+
+bool uartHal_rx_empty(uint32_t port)
+{
+	return ports[port].rxCount == 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Reading the empty FIFO is counted as underrun, the objects must not do
+ * it (see FIFO_REMAINDER in uartRxObj.c).
+ */
+uint8_t uartHal_read(uint32_t port)
+{
+	struct uartHalEmuPort *p = &ports[port];
+	uint8_t chr;
+
+	if(p->rxCount == 0){
+		p->stats.underrun++;
+		return 0;
+	}
+	chr = p->rxFifo[p->rxHead];
+	p->rxHead = (p->rxHead + 1) % UART_HAL_FIFO_LEN;
+	p->rxCount--;
+	rx_update(p);
+	return chr;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * The levels of the TM4C: 2, 4, 8, 12 and 14 for any other value.
+ */
+void uartHal_set_rx_level(uint32_t port, uint32_t level)
+{
+	struct uartHalEmuPort *p = &ports[port];
+
+	switch(level){
+	case 2:
+	case 4:
+	case 8:
+	case 12:
+		p->rxLevel = level;
+		break;
+	default:
+		p->rxLevel = 14;
+		break;
+	}
+	p->rxAbove = false;
+	rx_update(p);
+}
+/*---------------------------------------------------------------------------*/
+
+void uartHal_write(uint32_t port, uint8_t chr)
+{
+	struct uartHalEmuPort *p = &ports[port];
+
+	if(p->txCount == UART_HAL_FIFO_LEN){
+		p->stats.txDropped++;
+		return;
+	}
+	p->txFifo[(p->txHead + p->txCount) % UART_HAL_FIFO_LEN] = chr;
+	p->txCount++;
+	p->ris &= ~UART_HAL_INT_TX;
+	if(!p->txShift)
+		tx_shift(p);
+}
+/*---------------------------------------------------------------------------*/
+
+bool uartHal_tx_busy(uint32_t port)
+{
+	return ports[port].txShift || ports[port].txCount;
+}
+/*---------------------------------------------------------------------------*/
+
+void uartHal_int_enable(uint32_t port, uint32_t mask)
+{
+	ports[port].im |= mask;
+	irq_check(&ports[port]);
+}
+/*---------------------------------------------------------------------------*/
+
+void uartHal_int_disable(uint32_t port, uint32_t mask)
+{
+	ports[port].im &= ~mask;
+}
+/*---------------------------------------------------------------------------*/
+
+void uartHal_int_clear(uint32_t port, uint32_t mask)
+{
+	ports[port].ris &= ~mask;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Same as on the target: clears the pending interrupts, masks RX and RX
+ * timeout and posts the events to the attached objects.
+ */
+void uartHal_isr(uint32_t port)
+{
+	struct uartHalEmuPort *p = &ports[port];
+	uint32_t mis;
+	struct event e;
+
+	mis = p->ris & p->im;
+	p->ris &= ~mis;
+	p->im &= ~(mis & (UART_HAL_INT_RX | UART_HAL_INT_RT));
+
+	if(p->rx != NULL){
+		if(mis & UART_HAL_INT_ERR){
+			e.sig = RX_ERROR_SIG;
+			e.data = (mis & UART_HAL_INT_ERR) >> UART_HAL_ERR_S;
+			ao_post(p->rx, &e);
+		}
+		if(mis & UART_HAL_INT_RX){
+			e.sig = RX_SIG;
+			ao_post(p->rx, &e);
+		}
+		if(mis & UART_HAL_INT_RT){
+			e.sig = RX_TIMEOUT_SIG;
+			ao_post(p->rx, &e);
+		}
+	}
+	if(p->tx != NULL && (mis & UART_HAL_INT_TX)){
+		e.sig = TX_SIG;
+		ao_post(p->tx, &e);
+	}
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * There is no transceiver.
+ */
+void uartHal_set_pin(uint32_t baseNPin, bool level)
+{
+	(void) baseNPin;
+	(void) level;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
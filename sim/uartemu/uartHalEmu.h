@@ -0,0 +1,79 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: uartHalEmu.h
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		Emulated UART behind the UART HAL (driver/com/uartHal.h), running
+ * 		in virtual time. A port is a number below UART_HAL_EMU_PORTS.
+ *
+ * 		The emulation follows the TM4C UART in FIFO and EOT mode: 16
+ * 		character RX and TX FIFOs, the RX level interrupt, the RX timeout
+ * 		after 32 bit times without a character, overrun when a character is
+ * 		received into a full RX FIFO (it is lost) and the TX interrupt once
+ * 		the last stop bit has left the serializer.
+ *
+ * 		An interrupt is handled after the latency, drawn uniformly from
+ * 		the range set with uartHalEmu_set_latency(). It stands for the
+ * 		interrupt entry plus the time until the AO runs. The handler is
+ * 		uartHal_isr(), then the AOs run to idle with ao_run_waiting(), in
+ * 		no time. Interrupts are handled one after the other, as by a
+ * 		single core.
+ *
+ * 		Time only advances in uartHalEmu_run_until(). The caller feeds the
+ * 		RX line with uartHalEmu_receive() and gets the characters sent on
+ * 		the TX line through the line callback.
+ *
+ *****************************************************************************/
+
+#ifndef UARTEMU_UARTHALEMU_H_
+#define UARTEMU_UARTHALEMU_H_
+
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+ * DEFINES
+ *****************************************************************************/
+#define UART_HAL_EMU_PORTS		2
+
+/******************************************************************************
+ * TYPEDEFS
+ *****************************************************************************/
+/* A character left the TX line, t is the end of its stop bit in ns. */
+typedef void (*uartHalEmuLine_t)(void *, uint8_t, uint64_t);
+
+/* Counters of a port, they are never reset. */
+struct uartHalEmuStats{
+	uint32_t rxIrq;  /* interrupts handled with RX, RX timeout or error */
+	uint32_t txIrq;  /* interrupts handled with TX */
+	uint32_t overrun;  /* characters lost, RX FIFO full */
+	uint32_t underrun;  /* reads of the empty RX FIFO */
+	uint32_t txDropped;  /* writes to the full TX FIFO */
+	uint32_t rxMaxFill;  /* highest RX FIFO fill */
+};
+
+/******************************************************************************
+ * PROTOTYPES
+ *****************************************************************************/
+extern int32_t uartHalEmu_open(uint32_t, uint32_t, uartHalEmuLine_t, void *);
+extern void uartHalEmu_set_latency(uint64_t, uint64_t, uint32_t);
+extern uint64_t uartHalEmu_now(void);
+extern uint64_t uartHalEmu_chr_time(uint32_t);
+extern void uartHalEmu_run_until(uint64_t);
+extern void uartHalEmu_receive(uint32_t, uint8_t);
+extern const struct uartHalEmuStats *uartHalEmu_stats(uint32_t);
+
+
+#endif /* UARTEMU_UARTHALEMU_H_ */
@@ -0,0 +1,495 @@
+/******************************************************************************
+ * Copyright	: (c) Bron Elektronik AG
+ * Project		: generator2018
+ * File			: uartemu.c
+ * Date			: 17.10.2026
+ * Author		: leichelberger
+ ******************************************************************************
+ * Known Bugs (_FIXME):
+ *
+ * Enhancement (_TODO):
+ *
+ ******************************************************************************
+ * Description:
+ * 		UART FIFO emulator, to tune the FIFO parameters of the RX and TX
+ * 		objects (driver/com) offline, for a baudrate and an interrupt
+ * 		latency.
+ *
+ * 		The real uartRxObj and uartTxObj state machines run on the emulated
+ * 		UART of uartHalEmu.c in virtual time. Frames of each payload length
+ * 		of the sweep are received on one port and sent on another, one
+ * 		after the other with a gap, the interrupt latency is drawn for every
+ * 		interrupt. Per payload length it reports:
+ * 			rx irq		interrupts per frame received
+ * 			overrun		frames that lost a character, FIFO full, in %
+ * 			err			frames not received, in % (overruns included)
+ * 			done		last stop bit to RX_DONE_SIG, mean and max in us
+ * 			tx irq		interrupts per frame sent
+ * 			idle		time the line was idle within a frame, waiting for
+ * 						the TX object to refill the FIFO, mean and max in us
+ * 			eot			last stop bit to TX_DONE_SIG, mean in us
+ *
+ * 		The FIFO parameters are compiled in, see uartemu.pro, e.g.:
+ * 			qmake MAX_RX_BUF_DEPTH=12 FIFO_REMAINDER=3 && make
+ * 			./uartemu -b 921600 -l 5:40
+ *
+ * 		Usage: uartemu [options], see usage().
+ *
+ *****************************************************************************/
+
+/******************************************************************************
+ * INCLUDES
+ *****************************************************************************/
+#include <getopt.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config/projConfig.h"
+#include "driver/com/uartRxObj.h"
+#include "driver/com/uartTxObj.h"
+#include "lib/crc/crc16Lookup.h"
+#include "lib/prot/protocol.h"
+#include "lib/stm/aok.h"
+#include "uartHalEmu.h"
+
+/******************************************************************************
+ * DEFINES & MACROS & TYPEDEFS
+ *****************************************************************************/
+#if !defined(MAX_RX_BUF_DEPTH) || !defined(FIFO_REMAINDER) \
+		|| !defined(IDLE_RX_LEVEL) || !defined(TX_CHUNK)
+#error "the FIFO parameters are set by uartemu.pro"
+#endif
+
+#define PORT_RX					0
+#define PORT_TX					1
+#define MIN_PAYLOAD				4  /* the shortest frame is 8 characters */
+#define MAX_PAYLOAD				255
+#define BUF_SIZE				(MAX_PAYLOAD + CRC_LEN)
+#define TIMEOUT_CHRS			64  /* frame given up, no callback */
+
+enum mode{
+	MODE_RX = 0x01,
+	MODE_TX = 0x02,
+	MODE_BOTH = 0x03,
+};
+
+struct result{
+	uint32_t frames;
+	/* RX */
+	uint32_t rxIrq;
+	uint32_t rxOverrun;  /* frames */
+	uint32_t rxErr;  /* frames */
+	uint32_t rxDone;  /* frames */
+	uint64_t rxDoneSum;  /* ns */
+	uint64_t rxDoneMax;  /* ns */
+	/* TX */
+	uint32_t txIrq;
+	uint32_t txErr;  /* frames */
+	uint32_t txDone;  /* frames */
+	uint64_t txIdleSum;  /* ns */
+	uint64_t txIdleMax;  /* ns */
+	uint64_t txEotSum;  /* ns */
+};
+
+/******************************************************************************
+ * FILE SCOPE VARIABLES
+ *****************************************************************************/
+static const struct option options[] = {
+	{"baud", required_argument, NULL, 'b'},
+	{"latency", required_argument, NULL, 'l'},
+	{"length", required_argument, NULL, 'n'},
+	{"frames", required_argument, NULL, 'f'},
+	{"gap", required_argument, NULL, 'g'},
+	{"mode", required_argument, NULL, 'm'},
+	{"seed", required_argument, NULL, 'S'},
+	{"help", no_argument, NULL, 'h'},
+	{NULL, 0, NULL, 0},
+};
+
+/* configuration */
+static uint32_t baud = 115200;
+static uint64_t latMin = 5000;  /* ns */
+static uint64_t latMax = 20000;  /* ns */
+static uint32_t lenMin = MIN_PAYLOAD;
+static uint32_t lenMax = 64;
+static uint32_t lenStep = 4;
+static uint32_t nFrames = 1000;
+static uint64_t gap = 100000;  /* ns */
+static uint32_t mode = MODE_BOTH;
+static uint32_t seed = 1;
+
+static struct uartRxObj rxObj;
+static struct uartTxObj txObj;
+static uint8_t rxMem[BUF_SIZE];
+static uint8_t txMem[BUF_SIZE];
+
+/* outcome of the frame in progress */
+static int32_t rxSig;  /* RX_DONE_SIG, RX_ERR_SIG or 0 */
+static uint64_t rxAt;
+static int32_t txSig;  /* TX_DONE_SIG, TX_ERR_SIG or 0 */
+static uint64_t txAt;
+static uint32_t txChrs;  /* characters on the TX line */
+static uint64_t txFirst;  /* start bit of the first one */
+static uint64_t txLast;  /* stop bit of the last one */
+
+/******************************************************************************
+ * PROTOTYPES (LOCAL)
+ *****************************************************************************/
+static void usage(const char *);
+static uint32_t rnd(void);
+static int32_t parse_latency(const char *);
+static int32_t parse_length(const char *);
+static void rx_cb(void *, struct event *);
+static void tx_cb(void *, struct event *);
+static void tx_line(void *, uint8_t, uint64_t);
+static void rx_frame(uint32_t, struct result *);
+static void tx_frame(uint32_t, struct result *);
+static void print_result(const char *, const struct result *);
+static void add_result(struct result *, const struct result *);
+
+/******************************************************************************
+ * SUBROUTINES (LOCAL)
+ *****************************************************************************/
+#if(1)	/* code folding trick */
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  -b, --baud N           baudrate, default 115200\n"
+		"  -l, --latency US[:US]  interrupt latency, uniform from the first\n"
+		"                         to the second, default 5:20\n"
+		"  -n, --length N[:N[:N]] payload lengths from, to and step,\n"
+		"                         default 4:64:4\n"
+		"  -f, --frames N         frames per length and direction,\n"
+		"                         default 1000\n"
+		"  -g, --gap US           idle line between frames, default 100\n"
+		"  -m, --mode MODE        rx, tx or both, default both\n"
+		"  -S, --seed N           seed of the latency and payload generator\n",
+		name);
+}
+/*---------------------------------------------------------------------------*/
+
+/* xorshift32, reproducible with --seed */
+static uint32_t rnd(void)
+{
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+/*---------------------------------------------------------------------------*/
+
+static int32_t parse_latency(const char *arg)
+{
+	char *end;
+	double min, max;
+
+	min = max = strtod(arg, &end);
+	if(*end == ':')
+		max = strtod(end + 1, &end);
+	if(*end || min < 0 || max < min)
+		return -1;
+	latMin = (uint64_t)(min * 1000);
+	latMax = (uint64_t)(max * 1000);
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+static int32_t parse_length(const char *arg)
+{
+	char *end;
+
+	lenMin = lenMax = (uint32_t) strtoul(arg, &end, 0);
+	lenStep = 1;
+	if(*end == ':')
+		lenMax = (uint32_t) strtoul(end + 1, &end, 0);
+	if(*end == ':')
+		lenStep = (uint32_t) strtoul(end + 1, &end, 0);
+	if(*end || lenMin < MIN_PAYLOAD || lenMax > MAX_PAYLOAD
+			|| lenMax < lenMin || lenStep == 0)
+		return -1;
+	return 0;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Callback of the RX object. The frame is taken right away, the buffer is
+ * free for the next one.
+ */
+static void rx_cb(void *handle, struct event *e)
+{
+	(void) handle;
+	if(e->sig == RX_RECEIVING_SIG || rxSig)
+		return;
+	rxSig = e->sig;
+	rxAt = uartHalEmu_now();
+	rxObj.rxBuf.len = 0;
+}
+/*---------------------------------------------------------------------------*/
+
+static void tx_cb(void *handle, struct event *e)
+{
+	(void) handle;
+	txSig = e->sig;
+	txAt = uartHalEmu_now();
+}
+/*---------------------------------------------------------------------------*/
+
+static void tx_line(void *handle, uint8_t chr, uint64_t t)
+{
+	(void) handle;
+	(void) chr;
+	if(txChrs++ == 0)
+		txFirst = t - uartHalEmu_chr_time(PORT_TX);
+	txLast = t;
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Receives a frame with a random payload. The first start bit is at a
+ * random phase within a character time, so that the latencies hit all
+ * positions of the frame.
+ */
+static void rx_frame(uint32_t len, struct result *r)
+{
+	const struct uartHalEmuStats *stats = uartHalEmu_stats(PORT_RX);
+	uint8_t frame[DLINK_H_LEN + MAX_PAYLOAD];
+	uint64_t chr = uartHalEmu_chr_time(PORT_RX);
+	uint64_t start, last, settle;
+	uint32_t irq0, overrun0, i, n;
+	uint16_t crc = CRC16_CCITT_INIT_0000;
+
+	n = 0;
+	frame[n++] = PREAMBLE;
+	frame[n++] = len;
+	for(i=0; i<len; i++){
+		frame[n] = rnd();
+		crc16_ccitt_byte_calc(&crc, frame[n++]);
+	}
+	frame[n++] = crc >> 8;
+	frame[n++] = crc;
+
+	irq0 = stats->rxIrq;
+	overrun0 = stats->overrun;
+	rxSig = 0;
+	start = uartHalEmu_now() + rnd() % chr;
+	for(i=0; i<n; i++){
+		uartHalEmu_run_until(start + (i+1) * chr);
+		uartHalEmu_receive(PORT_RX, frame[i]);
+	}
+	last = uartHalEmu_now();
+	while(!rxSig && uartHalEmu_now() < last + TIMEOUT_CHRS * chr)
+		uartHalEmu_run_until(uartHalEmu_now() + chr);
+
+	/* after an error, the object waits for the RX timeout */
+	settle = last + 4 * chr + 2 * latMax;
+	uartHalEmu_run_until(uartHalEmu_now() > settle ? uartHalEmu_now()
+			: settle);
+
+	r->rxIrq += stats->rxIrq - irq0;
+	if(stats->overrun != overrun0)
+		r->rxOverrun++;
+	if(rxSig == RX_DONE_SIG){
+		r->rxDone++;
+		r->rxDoneSum += rxAt - last;
+		if(rxAt - last > r->rxDoneMax)
+			r->rxDoneMax = rxAt - last;
+	}else{
+		r->rxErr++;
+	}
+	uartHalEmu_run_until(uartHalEmu_now() + gap);
+}
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Sends a frame with a random payload.
+ */
+static void tx_frame(uint32_t len, struct result *r)
+{
+	const struct uartHalEmuStats *stats = uartHalEmu_stats(PORT_TX);
+	uint64_t chr = uartHalEmu_chr_time(PORT_TX);
+	uint64_t go, idle;
+	uint32_t irq0, i;
+	struct event e;
+
+	for(i=0; i<len; i++)
+		txMem[i] = rnd();
+	txObj.txBuf.len = len;
+	txObj_set_buffered_unsent(&txObj);
+
+	irq0 = stats->txIrq;
+	txSig = 0;
+	txChrs = 0;
+	go = uartHalEmu_now();
+	e.sig = TX_GO_SIG;
+	ao_post((struct ao *) &txObj, &e);
+	ao_run_waiting();
+	while(!txSig && uartHalEmu_now() < go + (len + TIMEOUT_CHRS) * chr)
+		uartHalEmu_run_until(uartHalEmu_now() + chr);
+
+	r->txIrq += stats->txIrq - irq0;
+	if(txSig == TX_DONE_SIG && txChrs == len + DLINK_H_LEN){
+		idle = txLast - txFirst - txChrs * chr;
+		r->txDone++;
+		r->txIdleSum += idle;
+		if(idle > r->txIdleMax)
+			r->txIdleMax = idle;
+		r->txEotSum += txAt - txLast;
+	}else{
+		r->txErr++;
+	}
+	uartHalEmu_run_until(uartHalEmu_now() + gap);
+}
+/*---------------------------------------------------------------------------*/
+
+static void print_result(const char *what, const struct result *r)
+{
+	printf("%5s |", what);
+	if(mode & MODE_RX)
+		printf(" %6.2f %7.3f %7.3f %8.1f %8.1f |",
+				(double) r->rxIrq / r->frames,
+				100.0 * r->rxOverrun / r->frames,
+				100.0 * r->rxErr / r->frames,
+				r->rxDone ? r->rxDoneSum / 1e3 / r->rxDone : 0.0,
+				r->rxDoneMax / 1e3);
+	if(mode & MODE_TX)
+		printf(" %6.2f %8.1f %8.1f %8.1f %5u |",
+				(double) r->txIrq / r->frames,
+				r->txDone ? r->txIdleSum / 1e3 / r->txDone : 0.0,
+				r->txIdleMax / 1e3,
+				r->txDone ? r->txEotSum / 1e3 / r->txDone : 0.0,
+				r->txErr);
+	printf("\n");
+}
+/*---------------------------------------------------------------------------*/
+
+static void add_result(struct result *sum, const struct result *r)
+{
+	sum->frames += r->frames;
+	sum->rxIrq += r->rxIrq;
+	sum->rxOverrun += r->rxOverrun;
+	sum->rxErr += r->rxErr;
+	sum->rxDone += r->rxDone;
+	sum->rxDoneSum += r->rxDoneSum;
+	if(r->rxDoneMax > sum->rxDoneMax)
+		sum->rxDoneMax = r->rxDoneMax;
+	sum->txIrq += r->txIrq;
+	sum->txErr += r->txErr;
+	sum->txDone += r->txDone;
+	sum->txIdleSum += r->txIdleSum;
+	if(r->txIdleMax > sum->txIdleMax)
+		sum->txIdleMax = r->txIdleMax;
+	sum->txEotSum += r->txEotSum;
+}
+/*---------------------------------------------------------------------------*/
+
+#endif	/* end code folding */
+
+/******************************************************************************
+ * MAIN
+ *****************************************************************************/
+int main(int argc, char *argv[])
+{
+	const struct uartHalEmuStats *rxStats, *txStats;
+	struct result r, total;
+	char what[8];
+	uint32_t len, i;
+	int opt;
+
+	while((opt = getopt_long(argc, argv, "b:l:n:f:g:m:S:h", options,
+			NULL)) != -1){
+		switch(opt){
+		case 'b': baud = (uint32_t) strtoul(optarg, NULL, 0); break;
+		case 'l':
+			if(parse_latency(optarg)){
+				fprintf(stderr, "invalid latency: %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'n':
+			if(parse_length(optarg)){
+				fprintf(stderr, "invalid lengths: %s, payload %u to %u\n",
+						optarg, MIN_PAYLOAD, MAX_PAYLOAD);
+				return 2;
+			}
+			break;
+		case 'f': nFrames = (uint32_t) strtoul(optarg, NULL, 0); break;
+		case 'g': gap = (uint64_t)(atof(optarg) * 1000); break;
+		case 'm':
+			if(!strcmp(optarg, "rx"))
+				mode = MODE_RX;
+			else if(!strcmp(optarg, "tx"))
+				mode = MODE_TX;
+			else if(!strcmp(optarg, "both"))
+				mode = MODE_BOTH;
+			else{
+				fprintf(stderr, "invalid mode: %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'S': seed = (uint32_t) strtoul(optarg, NULL, 0) | 1; break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+	if(nFrames == 0 || uartHalEmu_open(PORT_RX, baud, NULL, NULL)
+			|| uartHalEmu_open(PORT_TX, baud, tx_line, NULL)){
+		usage(argv[0]);
+		return 2;
+	}
+	uartHalEmu_set_latency(latMin, latMax, seed);
+
+	rxObj_init_buffer(&rxObj, rxMem, sizeof(rxMem));
+	rx_init(&rxObj, 1, PORT_RX, rx_cb, NULL, 8);
+	txObj_init_buffer(&txObj, txMem, sizeof(txMem));
+	tx_init(&txObj, 2, PORT_TX, tx_cb, NULL, 8);
+
+	printf("# %u baud, %.3f us/chr, latency %.1f to %.1f us, %u frames "
+			"per length\n", baud, uartHalEmu_chr_time(PORT_RX) / 1e3,
+			latMin / 1e3, latMax / 1e3, nFrames);
+	printf("# MAX_RX_BUF_DEPTH %u, FIFO_REMAINDER %u, IDLE_RX_LEVEL %u, "
+			"TX_CHUNK %u\n", MAX_RX_BUF_DEPTH, FIFO_REMAINDER, IDLE_RX_LEVEL,
+			TX_CHUNK);
+	printf("%5s |", "len");
+	if(mode & MODE_RX)
+		printf(" %6s %7s %7s %8s %8s |", "rx irq", "ovr %", "err %",
+				"done us", "max us");
+	if(mode & MODE_TX)
+		printf(" %6s %8s %8s %8s %5s |", "tx irq", "idle us", "max us",
+				"eot us", "err");
+	printf("\n");
+
+	memset(&total, 0, sizeof(total));
+	for(len=lenMin; len<=lenMax; len+=lenStep){
+		memset(&r, 0, sizeof(r));
+		r.frames = nFrames;
+		for(i=0; i<nFrames; i++){
+			if(mode & MODE_RX)
+				rx_frame(len, &r);
+			if(mode & MODE_TX)
+				tx_frame(len, &r);
+		}
+		snprintf(what, sizeof(what), "%u", len);
+		print_result(what, &r);
+		add_result(&total, &r);
+	}
+	print_result("all", &total);
+
+	rxStats = uartHalEmu_stats(PORT_RX);
+	txStats = uartHalEmu_stats(PORT_TX);
+	if(mode & MODE_RX)
+		printf("# RX FIFO fill max %u, %u characters lost\n",
+				rxStats->rxMaxFill, rxStats->overrun);
+	if(rxStats->underrun)
+		printf("# %u reads of the empty RX FIFO, characters lost or "
+				"FIFO_REMAINDER too small\n", rxStats->underrun);
+	if(txStats->txDropped)
+		printf("# %u writes to the full TX FIFO, TX_CHUNK too big\n",
+				txStats->txDropped);
+	return 0;
+}
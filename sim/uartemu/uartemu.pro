@@ -0,0 +1,44 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+TARGET = uartemu
+
+# FIFO parameters of the RX and TX object (driver/com/uartRxObj.c and
+# uartTxObj.c) under test, the firmware's by default. Override on the qmake
+# command line, e.g. qmake MAX_RX_BUF_DEPTH=12 FIFO_REMAINDER=3
+isEmpty(MAX_RX_BUF_DEPTH): MAX_RX_BUF_DEPTH = 14
+isEmpty(FIFO_REMAINDER): FIFO_REMAINDER = 4
+isEmpty(IDLE_RX_LEVEL): IDLE_RX_LEVEL = 8
+isEmpty(TX_CHUNK): TX_CHUNK = 15
+DEFINES += \
+    MAX_RX_BUF_DEPTH=$$MAX_RX_BUF_DEPTH \
+    FIFO_REMAINDER=$$FIFO_REMAINDER \
+    IDLE_RX_LEVEL=$$IDLE_RX_LEVEL \
+    TX_CHUNK=$$TX_CHUNK
+
+# The kernel as on the target (no AOK_HOST), with the emulator's
+# config/projConfig.h, found first.
+INCLUDEPATH += . "../../Protocole_LE" "../../Protocole_LE/lib"
+
+HEADERS += \
+    config/projConfig.h \
+    uartHalEmu.h \
+    ../../Protocole_LE/driver/com/uartHal.h \
+    ../../Protocole_LE/driver/com/uartRxObj.h \
+    ../../Protocole_LE/driver/com/uartTxObj.h \
+    ../../Protocole_LE/lib/stm/aok.h \
+    ../../Protocole_LE/lib/stm/event.h \
+    ../../Protocole_LE/lib/mem/xQueue.h \
+    ../../Protocole_LE/lib/mem/set56.h \
+    ../../Protocole_LE/lib/crc/crc16Lookup.h
+
+SOURCES += \
+    uartemu.c \
+    uartHalEmu.c \
+    ../../Protocole_LE/driver/com/uartRxObj.c \
+    ../../Protocole_LE/driver/com/uartTxObj.c \
+    ../../Protocole_LE/lib/stm/aok.c \
+    ../../Protocole_LE/lib/mem/xQueue.c \
+    ../../Protocole_LE/lib/mem/set56.c \
+    ../../Protocole_LE/lib/crc/crc16Lookup.c